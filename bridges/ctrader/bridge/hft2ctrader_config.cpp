@@ -144,7 +144,7 @@ void hft2ctrader_config::xml_parse(const std::string &xml_file_name)
     }
 
     //
-    // <market bridge="IC Markets" sessid="icmarkets-session" >
+    // <market bridge="IC Markets" sessid="icmarkets-session" pipeline="32" framing="binary" lanes="true">
     //     <auth account="demo">
     //         <client-id>XXXXXXX</client-id>
     //         <client-secret>XXXXXX</client-secret>
@@ -193,6 +193,72 @@ void hft2ctrader_config::xml_parse(const std::string &xml_file_name)
 
             session_id_ = sessid_attr -> value();
 
+            xml_attribute<> *pipeline_attr = node -> first_attribute("pipeline");
+
+            if (pipeline_attr != nullptr)
+            {
+                try
+                {
+                    hft_pipeline_depth_ = std::stoi(std::string(pipeline_attr -> value()));
+                }
+                catch (const std::exception &e)
+                {
+                    hft_pipeline_depth_ = 0;
+                }
+
+                if (hft_pipeline_depth_ < 1)
+                {
+                    std::ostringstream error;
+
+                    error << "Illegal value of ‘pipeline’ attribute in ‘market’ node in xml config: ‘"
+                          << xml_file_name << "’";
+
+                    throw std::runtime_error(error.str());
+                }
+            }
+
+            xml_attribute<> *framing_attr = node -> first_attribute("framing");
+
+            if (framing_attr != nullptr)
+            {
+                if (strcasecmp(framing_attr -> value(), "BINARY") == 0)
+                {
+                    hft_binary_framing_ = true;
+                }
+                else if (strcasecmp(framing_attr -> value(), "JSON") != 0)
+                {
+                    std::ostringstream error;
+
+                    error << "Illegal value of ‘framing’ attribute in ‘market’ node in xml config: ‘"
+                          << xml_file_name << "’";
+
+                    throw std::runtime_error(error.str());
+                }
+            }
+
+            xml_attribute<> *lanes_attr = node -> first_attribute("lanes");
+
+            if (lanes_attr != nullptr)
+            {
+                if (strcasecmp(lanes_attr -> value(), "TRUE") == 0 ||
+                        strcasecmp(lanes_attr -> value(), "YES") == 0 ||
+                            strcasecmp(lanes_attr -> value(), "1") == 0)
+                {
+                    hft_instrument_lanes_ = true;
+                }
+                else if (strcasecmp(lanes_attr -> value(), "FALSE") != 0 &&
+                             strcasecmp(lanes_attr -> value(), "NO") != 0 &&
+                                 strcasecmp(lanes_attr -> value(), "0") != 0)
+                {
+                    std::ostringstream error;
+
+                    error << "Illegal value of ‘lanes’ attribute in ‘market’ node in xml config: ‘"
+                          << xml_file_name << "’";
+
+                    throw std::runtime_error(error.str());
+                }
+            }
+
             bool found_auth = false;
 
             for (xml_node<> *market_node = node -> first_node(); market_node; market_node = market_node -> next_sibling())
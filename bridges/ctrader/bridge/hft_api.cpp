@@ -19,10 +19,140 @@
 #include <hft_api.hpp>
 #include <aux_functions.hpp>
 
+#include <boost/endian/conversion.hpp>
+
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 
-void hft_api::hft_init_session(const std::string &sessid, const instruments_container &instruments)
+//
+// Binary framing of HFT protocol. Layout must match
+// hft/server/include/hft_binary_protocol.hpp.
+//
+
+namespace {
+
+enum : std::uint16_t
+{
+    FRAME_MAGIC = 0x4846,
+    FRAME_NO_INSTRUMENT = 0xFFFF
+};
+
+enum
+{
+    FRAME_FLAG_CID = 0x01,
+    FRAME_HEADER_SIZE = 16,
+    FRAME_ID_SIZE = 32,
+    FRAME_OPERATION_SIZE = 48,
+
+    OPCODE_SYNC = 1,
+    OPCODE_TICK = 2,
+    OPCODE_OPEN_NOTIFY = 3,
+    OPCODE_CLOSE_NOTIFY = 4,
+
+    STATUS_ACK = 0,
+    STATUS_ERROR = 1,
+    STATUS_ADVICE = 2,
+
+    OPERATION_CLOSE = 0,
+    OPERATION_LONG = 1,
+    OPERATION_SHORT = 2
+};
+
+template <typename T>
+void frame_put(std::string &out, T value)
+{
+    boost::endian::native_to_little_inplace(value);
+
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void frame_put_double(std::string &out, double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    frame_put<std::uint64_t>(out, bits);
+}
+
+void frame_put_id(std::string &out, const std::string &id)
+{
+    if (id.length() > FRAME_ID_SIZE)
+    {
+        throw std::invalid_argument("hft_api: Position identifier too long for binary frame");
+    }
+
+    out.append(id);
+    out.append(FRAME_ID_SIZE - id.length(), '\0');
+}
+
+void frame_put_header(std::string &out, std::uint8_t opcode, std::uint16_t instrument_index,
+                          std::uint16_t body_length, long cid)
+{
+    frame_put<std::uint16_t>(out, FRAME_MAGIC);
+    frame_put<std::uint8_t>(out, opcode);
+    frame_put<std::uint8_t>(out, cid >= 0 ? FRAME_FLAG_CID : 0);
+    frame_put<std::uint16_t>(out, instrument_index);
+    frame_put<std::uint16_t>(out, body_length);
+    frame_put<std::int64_t>(out, cid >= 0 ? cid : 0);
+}
+
+template <typename T>
+T frame_get(const char *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+
+    return boost::endian::little_to_native(value);
+}
+
+double frame_get_double(const char *data)
+{
+    std::uint64_t bits = frame_get<std::uint64_t>(data);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+} /* namespace */
+
+long hft_api::binary_cid(void)
+{
+    if (pipeline_depth_ <= 1)
+    {
+        return -1;
+    }
+
+    return next_cid_++;
+}
+
+std::uint16_t hft_api::instrument_index(const std::string &instrument) const
+{
+    for (std::size_t i = 0; i < hft_instruments_.size(); i++)
+    {
+        if (hft_instruments_[i] == instrument)
+        {
+            return i;
+        }
+    }
+
+    throw std::invalid_argument("hft_api: Instrument not declared in session init");
+}
+
+std::string hft_api::cid_attribute(void)
+{
+    if (pipeline_depth_ <= 1)
+    {
+        return std::string();
+    }
+
+    return ",\"cid\":" + std::to_string(next_cid_++);
+}
+
+void hft_api::hft_init_session(const std::string &sessid, const instruments_container &instruments,
+                                   int pipeline_depth, bool binary_framing,
+                                   bool instrument_lanes)
 {
     if (instruments.empty())
     {
@@ -34,6 +164,11 @@ void hft_api::hft_init_session(const std::string &sessid, const instruments_cont
         throw std::invalid_argument("hft_api: hft_init_session: Empty session id");
     }
 
+    if (pipeline_depth < 1)
+    {
+        throw std::invalid_argument("hft_api: hft_init_session: Illegal pipeline depth");
+    }
+
     std::string instruments_str;
 
     for (int i = 0; i < instruments.size() - 1; i++)
@@ -51,7 +186,28 @@ void hft_api::hft_init_session(const std::string &sessid, const instruments_cont
 
     payload << "{\"method\":\"init\",\"sessid\":\""
             << sessid << "\",\"instruments\":["
-            << instruments_str << "]}\n";
+            << instruments_str << "]";
+
+    if (pipeline_depth > 1)
+    {
+        payload << ",\"pipeline\":" << pipeline_depth;
+    }
+
+    if (binary_framing)
+    {
+        payload << ",\"framing\":\"binary\"";
+    }
+
+    if (instrument_lanes)
+    {
+        payload << ",\"lanes\":true";
+    }
+
+    payload << "}\n";
+
+    pipeline_depth_ = pipeline_depth;
+    binary_framing_ = binary_framing;
+    hft_instruments_ = instruments;
 
     connection_.send_data(payload.str());
 }
@@ -82,14 +238,32 @@ void hft_api::hft_sync(const std::string &instrument, unsigned long timestamp, c
             throw std::invalid_argument("hft_api: hft_sync: Illegal trade side");
     }
 
+    if (binary_framing_)
+    {
+        std::string frame;
+
+        frame_put_header(frame, OPCODE_SYNC, instrument_index(instrument), 56, binary_cid());
+        frame_put<std::int64_t>(frame, timestamp);
+        frame_put_double(frame, price);
+        frame_put<std::int32_t>(frame, volume);
+        frame_put<std::uint8_t>(frame, direction == position_type::LONG_POSITION ? 1 : 0);
+        frame.append(3, '\0');
+        frame_put_id(frame, identifier);
+
+        connection_.send_data(frame);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     payload << "{\"method\":\"sync\",\"instrument\":\""
-            << instrument << "\",\"timestamp\":\""
-            << aux::timestamp2string(timestamp) << "\",\"id\":\""
+            << instrument << "\",\"timestamp\":"
+            << timestamp << ",\"id\":\""
             << identifier << "\",\"direction\":\""
             << direction_str << "\",\"price\":"
-            << price << ",\"qty\":" << volume << "}\n";
+            << price << ",\"qty\":" << volume
+            << cid_attribute() << "}\n";
 
     connection_.send_data(payload.str());
 }
@@ -101,15 +275,31 @@ void hft_api::hft_send_tick(const std::string &instrument, unsigned long timesta
         throw std::invalid_argument("hft_api: hft_send_tick: Empty instrument");
     }
 
+    if (binary_framing_)
+    {
+        std::string frame;
+
+        frame_put_header(frame, OPCODE_TICK, instrument_index(instrument), 40, binary_cid());
+        frame_put<std::int64_t>(frame, timestamp);
+        frame_put_double(frame, ask);
+        frame_put_double(frame, bid);
+        frame_put_double(frame, equity);
+        frame_put_double(frame, free_margin);
+
+        connection_.send_data(frame);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     payload << "{\"method\":\"tick\",\"instrument\":\""
-            << instrument << "\",\"timestamp\":\""
-            << aux::timestamp2string(timestamp) << "\",\"ask\":"
+            << instrument << "\",\"timestamp\":"
+            << timestamp << ",\"ask\":"
             << ask << ",\"bid\":"
             << bid << ",\"equity\":"
             << equity  << ",\"free_margin\":"
-            << free_margin << "}\n";
+            << free_margin << cid_attribute() << "}\n";
 
     connection_.send_data(payload.str());
 }
@@ -126,6 +316,21 @@ void hft_api::hft_send_open_notify(const std::string &instrument, const std::str
         throw std::invalid_argument("hft_api: hft_send_open_notify: Empty position identifier");
     }
 
+    if (binary_framing_)
+    {
+        std::string frame;
+
+        frame_put_header(frame, OPCODE_OPEN_NOTIFY, instrument_index(instrument), 48, binary_cid());
+        frame_put_double(frame, price);
+        frame_put<std::uint8_t>(frame, status ? 1 : 0);
+        frame.append(7, '\0');
+        frame_put_id(frame, identifier);
+
+        connection_.send_data(frame);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     std::string s = (status ? "true" : "false");
@@ -133,7 +338,7 @@ void hft_api::hft_send_open_notify(const std::string &instrument, const std::str
     payload << "{\"method\":\"open_notify\",\"instrument\":\""
             << instrument << "\",\"id\":\"" << identifier
             << "\",\"status\":" << s << ",\"price\":"
-            << price << "}\n";
+            << price << cid_attribute() << "}\n";
 
     connection_.send_data(payload.str());
 }
@@ -150,6 +355,21 @@ void hft_api::hft_send_close_notify(const std::string &instrument, const std::st
         throw std::invalid_argument("hft_api: hft_send_close_notify: Empty position identifier");
     }
 
+    if (binary_framing_)
+    {
+        std::string frame;
+
+        frame_put_header(frame, OPCODE_CLOSE_NOTIFY, instrument_index(instrument), 48, binary_cid());
+        frame_put_double(frame, price);
+        frame_put<std::uint8_t>(frame, status ? 1 : 0);
+        frame.append(7, '\0');
+        frame_put_id(frame, identifier);
+
+        connection_.send_data(frame);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     std::string s = (status ? "true" : "false");
@@ -157,11 +377,109 @@ void hft_api::hft_send_close_notify(const std::string &instrument, const std::st
     payload << "{\"method\":\"close_notify\",\"instrument\":\""
             << instrument << "\",\"id\":\"" << identifier
             << "\",\"status\":" << s << ",\"price\":"
-            << price << "}\n";
+            << price << cid_attribute() << "}\n";
 
     connection_.send_data(payload.str());
 }
 
+hft_api::hft_response::hft_response(const std::string &payload, const instruments_container &instruments)
+{
+    if (! payload.empty() && payload[0] != '{')
+    {
+        unserialize_binary(payload, instruments);
+    }
+    else
+    {
+        unserialize(payload);
+    }
+}
+
+void hft_api::hft_response::unserialize_binary(const std::string &payload, const instruments_container &instruments)
+{
+    error_message_.clear();
+    instrument_.clear();
+    new_positions_info_.clear();
+    close_positions_info_.clear();
+    cid_ = -1;
+
+    if (payload.length() < FRAME_HEADER_SIZE || frame_get<std::uint16_t>(payload.c_str()) != FRAME_MAGIC)
+    {
+        throw std::invalid_argument("Bad binary response frame");
+    }
+
+    const char *frame = payload.c_str();
+    std::uint8_t status = frame_get<std::uint8_t>(frame + 2);
+    std::uint8_t flags = frame_get<std::uint8_t>(frame + 3);
+    std::uint16_t instrument_index = frame_get<std::uint16_t>(frame + 4);
+    std::uint16_t body_length = frame_get<std::uint16_t>(frame + 6);
+
+    if (payload.length() != FRAME_HEADER_SIZE + body_length)
+    {
+        throw std::invalid_argument("Invalid length of binary response frame");
+    }
+
+    if (flags & FRAME_FLAG_CID)
+    {
+        cid_ = frame_get<std::int64_t>(frame + 8);
+    }
+
+    if (instrument_index != FRAME_NO_INSTRUMENT)
+    {
+        if (instrument_index >= instruments.size())
+        {
+            throw std::invalid_argument("Illegal instrument index in binary response frame");
+        }
+
+        instrument_ = instruments[instrument_index];
+    }
+
+    const char *body = frame + FRAME_HEADER_SIZE;
+
+    if (status == STATUS_ACK)
+    {
+        return;
+    }
+    else if (status == STATUS_ERROR)
+    {
+        error_message_ = std::string(body, body_length);
+
+        return;
+    }
+    else if (status != STATUS_ADVICE)
+    {
+        throw std::invalid_argument("Illegal status in binary response frame");
+    }
+
+    if (body_length == 0 || body_length % FRAME_OPERATION_SIZE != 0)
+    {
+        throw std::invalid_argument("Invalid length of binary advice frame");
+    }
+
+    for (const char *p = body; p < body + body_length; p += FRAME_OPERATION_SIZE)
+    {
+        std::uint8_t op = frame_get<std::uint8_t>(p);
+        double qty = frame_get_double(p + 8);
+        std::string id(p + 16, strnlen(p + 16, FRAME_ID_SIZE));
+
+        if (op == OPERATION_CLOSE)
+        {
+            close_positions_info_.emplace_back(id);
+        }
+        else if (op == OPERATION_LONG)
+        {
+            new_positions_info_.emplace_back(position_type::LONG_POSITION, id, qty);
+        }
+        else if (op == OPERATION_SHORT)
+        {
+            new_positions_info_.emplace_back(position_type::SHORT_POSITION, id, qty);
+        }
+        else
+        {
+            throw std::invalid_argument("Illegal operation in binary advice frame");
+        }
+    }
+}
+
 void hft_api::hft_response::unserialize(const std::string &payload)
 {
     using namespace boost::json;
@@ -170,6 +488,7 @@ void hft_api::hft_response::unserialize(const std::string &payload)
     instrument_.clear();
     new_positions_info_.clear();
     close_positions_info_.clear();
+    cid_ = -1;
 
     value jv;
 
@@ -208,6 +527,18 @@ void hft_api::hft_response::unserialize(const std::string &payload)
 
     std::string status = status_v.get_string().c_str();
 
+    if (obj.contains("cid"))
+    {
+        value const &cid_v = obj.at("cid");
+
+        if (cid_v.kind() != kind::int64)
+        {
+            throw std::invalid_argument("Invalid cid type");
+        }
+
+        cid_ = cid_v.get_int64();
+    }
+
     if (status == "ack")
     {
         return;
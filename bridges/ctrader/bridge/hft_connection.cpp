@@ -24,7 +24,7 @@
 hft_connection::hft_connection(boost::asio::io_context &io_context, const hft2ctrader_config &cfg)
     : socket_ {io_context}, reconnect_timer_ {io_context}, input_buffer_ {}, send_buffers_ {},
       hft_host_ { cfg.get_hft_host() }, hft_port_ { std::to_string(cfg.get_hft_port())},
-      connected_ { false }, connection_attempts_{0}, ioctx_ {io_context}
+      shm_closing_ { false }, connected_ { false }, connection_attempts_{0}, ioctx_ {io_context}
 {
     el::Loggers::getLogger("hft_connection", true);
 }
@@ -44,29 +44,48 @@ void hft_connection::connect(void)
         throw std::logic_error("Undefined ‘on_data’ callback");
     }
 
-    boost::asio::ip::tcp::resolver resolver(ioctx_);
+    if (hft_host_.compare(0, 4, "shm:") == 0)
+    {
+        connect_shm();
+
+        return;
+    }
 
-    auto resolve_result = resolver.resolve({hft_host_, hft_port_});
-    auto x = resolve_result.begin();
+    boost::asio::generic::stream_protocol::endpoint endpoint;
 
-    if (x == resolve_result.end())
+    if (hft_host_.compare(0, 5, "unix:") == 0)
     {
-        hft2ctrader_log(ERROR) << "No available HFT endpoint";
+        endpoint = boost::asio::local::stream_protocol::endpoint(hft_host_.substr(5));
 
-        throw std::logic_error("No available HFT endpoint");
+        hft2ctrader_log(INFO) << "Starting async connection to the HFT server "
+                              << "on local socket ‘" << hft_host_.substr(5) << "’";
     }
+    else
+    {
+        boost::asio::ip::tcp::resolver resolver(ioctx_);
+
+        auto resolve_result = resolver.resolve({hft_host_, hft_port_});
+        auto x = resolve_result.begin();
 
-    auto endpoint = x -> endpoint();
+        if (x == resolve_result.end())
+        {
+            hft2ctrader_log(ERROR) << "No available HFT endpoint";
+
+            throw std::logic_error("No available HFT endpoint");
+        }
+
+        endpoint = x -> endpoint();
+
+        hft2ctrader_log(INFO) << "Starting async connection to the HFT server "
+                              << (*resolve_result.begin()).host_name() << " ("
+                              << (*resolve_result.begin()).endpoint().address().to_string()
+                              << ")";
+    }
 
     //
     // Start connection.
     //
 
-    hft2ctrader_log(INFO) << "Starting async connection to the HFT server "
-                          << (*resolve_result.begin()).host_name() << " ("
-                          << (*resolve_result.begin()).endpoint().address().to_string()
-                          << ")";
-
     socket_.async_connect(endpoint,
         [this](const boost::system::error_code& error)
         {
@@ -99,10 +118,40 @@ void hft_connection::close(void)
 {
     reconnect_timer_.cancel();
     socket_.close();
+
+    shm_closing_ = true;
+
+    if (shm_reader_.joinable())
+    {
+        shm_reader_.join();
+    }
+
+    shm_.reset();
 }
 
 void hft_connection::send_data(const std::string &data)
 {
+    if (shm_)
+    {
+        //
+        // Ring write completes in place, unless
+        // server lags behind by the whole ring.
+        //
+
+        try
+        {
+            shm_ -> write(data);
+        }
+        catch (const std::runtime_error &e)
+        {
+            hft2ctrader_log(ERROR) << "HFT Write data error: " << e.what();
+
+            throw std::runtime_error("HFT Write data error");
+        }
+
+        return;
+    }
+
     bool can_transmit = connected_ && (send_buffers_.size() == 0);
 
     send_buffers_.push_back(data);
@@ -116,31 +165,18 @@ void hft_connection::send_data(const std::string &data)
 void hft_connection::async_read_raw_message(void)
 {
     //
-    // Start an asynchronous operation
-    // to read a newline-delimited
-    // message.
+    // Start an asynchronous operation to read
+    // any portion of data. Messages are either
+    // newline-delimited JSON or binary frames,
+    // when binary framing has been negotiated.
     //
 
-    boost::asio::async_read_until(socket_, boost::asio::dynamic_buffer(input_buffer_), '\n',
+    boost::asio::async_read(socket_, boost::asio::dynamic_buffer(input_buffer_), boost::asio::transfer_at_least(1),
         [this](const boost::system::error_code& ec, std::size_t n)
         {
             if (! ec)
             {
-                //
-                // Extract the newline-delimited message from the buffer.
-                //
-
-                std::string line(input_buffer_.substr(0, n - 1));
-                input_buffer_.erase(0, n);
-
-                //
-                // Empty messages are ignored.
-                //
-
-                if (! line.empty())
-                {
-                    on_data(line);
-                }
+                dispatch_input();
 
                 async_read_raw_message();
             }
@@ -156,6 +192,63 @@ void hft_connection::async_read_raw_message(void)
     );
 }
 
+void hft_connection::dispatch_input(void)
+{
+    while (! input_buffer_.empty())
+    {
+        if (input_buffer_.length() >= 2 && input_buffer_[0] == 'F' && input_buffer_[1] == 'H')
+        {
+            //
+            // Binary frame: 16-byte header, body
+            // length at offset 6 (little-endian).
+            //
+
+            if (input_buffer_.length() < 16)
+            {
+                return;
+            }
+
+            std::size_t n = 16 + (static_cast<unsigned char>(input_buffer_[6])
+                                  | (static_cast<unsigned char>(input_buffer_[7]) << 8));
+
+            if (input_buffer_.length() < n)
+            {
+                return;
+            }
+
+            std::string frame(input_buffer_.substr(0, n));
+            input_buffer_.erase(0, n);
+
+            on_data(frame);
+        }
+        else
+        {
+            //
+            // Extract the newline-delimited message from the buffer.
+            //
+
+            std::size_t n = input_buffer_.find('\n');
+
+            if (n == std::string::npos)
+            {
+                return;
+            }
+
+            std::string line(input_buffer_.substr(0, n));
+            input_buffer_.erase(0, n + 1);
+
+            //
+            // Empty messages are ignored.
+            //
+
+            if (! line.empty())
+            {
+                on_data(line);
+            }
+        }
+    }
+}
+
 void hft_connection::async_write_raw_message(void)
 {
     if (send_buffers_.size() == 0)
@@ -185,6 +278,86 @@ void hft_connection::async_write_raw_message(void)
         });
 }
 
+void hft_connection::connect_shm(void)
+{
+    hft2ctrader_log(INFO) << "Starting connection to the HFT server "
+                          << "on shared memory ‘" << hft_host_.substr(4) << "’";
+
+    try
+    {
+        shm_.reset(new hft::ipc::shm_client(hft_host_.substr(4)));
+    }
+    catch (const std::runtime_error &e)
+    {
+        connected_ = false;
+
+        hft2ctrader_log(ERROR) << "Connection to the HFT server failed: "
+                               << e.what() << ".";
+
+        try_reconnect_after_a_while();
+
+        return;
+    }
+
+    hft2ctrader_log(INFO) << "HFT connection ESTABLISHED.";
+
+    connection_attempts_ = 0;
+    connected_ = true;
+    shm_closing_ = false;
+
+    shm_reader_ = std::thread(&hft_connection::shm_reader, this);
+
+    //
+    // Flush whatever was queued before connection.
+    //
+
+    while (send_buffers_.size() > 0)
+    {
+        std::string data = send_buffers_.front();
+        send_buffers_.pop_front();
+
+        send_data(data);
+    }
+}
+
+void hft_connection::shm_reader(void)
+{
+    try
+    {
+        while (! shm_closing_)
+        {
+            std::string data;
+
+            if (shm_ -> read_some(data, hft::ipc::WAIT_TIMEOUT_MS) == 0)
+            {
+                continue;
+            }
+
+            boost::asio::post(ioctx_, [this, data](void)
+            {
+                input_buffer_ += data;
+                dispatch_input();
+            });
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        if (shm_closing_)
+        {
+            return;
+        }
+
+        std::string reason = e.what();
+
+        boost::asio::post(ioctx_, [reason](void)
+        {
+            hft2ctrader_log(ERROR) << "HFT Read data error: " << reason << ".";
+
+            throw std::runtime_error("HFT Read data error");
+        });
+    }
+}
+
 void hft_connection::try_reconnect_after_a_while(void)
 {
     if (connection_attempts_ >= 10)
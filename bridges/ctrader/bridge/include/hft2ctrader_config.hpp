@@ -37,7 +37,8 @@ public:
 
     hft2ctrader_config(const std::string &config_file_name, const std::string &broker)
         : broker_ {broker}, auth_account_id_ {0}, account_ {account_type::UNDEFINED},
-          hft_host_ {"127.0.0.1"}, hft_port_ {8137},
+          hft_host_ {"127.0.0.1"}, hft_port_ {8137}, hft_pipeline_depth_ {1},
+          hft_binary_framing_ {false}, hft_instrument_lanes_ {false},
           instrument_ {}, week_number_ {0}, crypto_mode_ {false}
     { xml_parse(config_file_name); }
 
@@ -70,6 +71,9 @@ public:
     std::string get_session_id(void) const { return session_id_; }
     std::string get_hft_host(void) const { return hft_host_; }
     int get_hft_port(void) const { return hft_port_; }
+    int get_hft_pipeline_depth(void) const { return hft_pipeline_depth_; }
+    bool is_hft_binary_framing(void) const { return hft_binary_framing_; }
+    bool is_hft_instrument_lanes(void) const { return hft_instrument_lanes_; }
     std::vector<std::string> get_instruments(void) const { return instruments_; }
     std::string get_instrument(void) const { return instrument_; }
     int get_week_number(void) const { return week_number_; }
@@ -105,6 +109,9 @@ private:
 
     std::string hft_host_;
     int hft_port_;
+    int hft_pipeline_depth_;
+    bool hft_binary_framing_;
+    bool hft_instrument_lanes_;
 
     std::string instrument_;
     int week_number_;
@@ -19,6 +19,7 @@
 
 #include <market_types.hpp>
 #include <hft_connection.hpp>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -31,7 +32,8 @@ public:
     hft_api(hft_api &&) = delete;
 
     hft_api(hft_connection &connection)
-        : connection_ {connection}
+        : connection_ {connection}, pipeline_depth_ {1}, next_cid_ {0},
+          binary_framing_ {false}
     {}
 
     virtual ~hft_api(void) = default;
@@ -40,7 +42,9 @@ public:
     // Request methods.
     //
 
-    void hft_init_session(const std::string &sessid, const instruments_container &instruments);
+    void hft_init_session(const std::string &sessid, const instruments_container &instruments,
+                              int pipeline_depth = 1, bool binary_framing = false,
+                              bool instrument_lanes = false);
     void hft_sync(const std::string &instrument, unsigned long timestamp, const std::string &identifier, position_type direction, double price, int volume);
     void hft_send_tick(const std::string &instrument, unsigned long timestamp, double ask, double bid, double equity, double free_margin);
     void hft_send_open_notify(const std::string &instrument, const std::string &identifier, bool status, double price);
@@ -55,6 +59,14 @@ public:
         hft_response(void) = delete;
         hft_response(const std::string &payload) { unserialize(payload); }
 
+        //
+        // Accepts both JSON and binary frame payload. Binary
+        // frames refer instruments by position in the list
+        // passed to hft_init_session.
+        //
+
+        hft_response(const std::string &payload, const instruments_container &instruments);
+
         struct pos_open_advice_info
         {
             pos_open_advice_info(position_type d, const std::string &i, double v)
@@ -70,6 +82,8 @@ public:
         typedef std::list<std::string> pos_close_advice_info_container;
 
         bool is_error(void) const { return !error_message_.empty(); }
+        bool has_cid(void) const { return cid_ >= 0; }
+        long get_cid(void) const { return cid_; }
         bool has_instrument(void) const { return !instrument_.empty(); }
         std::string get_error_message(void) const { return error_message_; }
         std::string get_instrument(void) const { return instrument_; }
@@ -81,16 +95,44 @@ public:
     private:
 
         void unserialize(const std::string &payload);
+        void unserialize_binary(const std::string &payload, const instruments_container &instruments);
 
         std::string error_message_;
         std::string instrument_;
+        long cid_;
         pos_open_advice_info_container new_positions_info_;
         pos_close_advice_info_container close_positions_info_;
     };
 
+protected:
+
+    const instruments_container &get_hft_instruments(void) const { return hft_instruments_; }
+
 private:
 
+    //
+    // When pipelining is negotiated, every request carries
+    // correlation id, so responses can be matched even if
+    // server does not answer them in order of sending.
+    //
+
+    std::string cid_attribute(void);
+
+    long binary_cid(void);
+
+    std::uint16_t instrument_index(const std::string &instrument) const;
+
     hft_connection &connection_;
+    int pipeline_depth_;
+    unsigned long next_cid_;
+
+    //
+    // Binary framing, when negotiated, replaces JSON
+    // for every request sent after init.
+    //
+
+    bool binary_framing_;
+    instruments_container hft_instruments_;
 };
 
 #endif /* __HFT_API_HPP__ */
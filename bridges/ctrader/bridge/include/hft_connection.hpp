@@ -19,10 +19,14 @@
 
 #include <boost/asio.hpp>
 //#include <boost/asio/steady_timer.hpp>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
 #include <list>
+#include <thread>
 
+#include <hft_shm_ring.hpp>
 #include <hft2ctrader_config.hpp>
 
 class hft_connection
@@ -54,10 +58,29 @@ private:
     std::function<void(const std::string &)> on_data;
 
     void async_read_raw_message(void);
+    void dispatch_input(void);
     void async_write_raw_message(void);
     void try_reconnect_after_a_while(void);
+    void connect_shm(void);
+    void shm_reader(void);
+
+    //
+    // HFT host ‘unix:/path’ selects AF_UNIX socket,
+    // ‘shm:/name’ shared memory rings, anything else
+    // is resolved as TCP host.
+    //
+
+    boost::asio::generic::stream_protocol::socket socket_;
+
+    //
+    // Shared memory has no asio integration, incoming
+    // data is read by a thread and posted to io_context.
+    //
+
+    std::unique_ptr<hft::ipc::shm_client> shm_;
+    std::thread shm_reader_;
+    std::atomic<bool> shm_closing_;
 
-    boost::asio::ip::tcp::socket socket_;
     boost::asio::steady_timer reconnect_timer_;
 
     std::string input_buffer_;
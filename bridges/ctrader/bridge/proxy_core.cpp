@@ -526,7 +526,7 @@ void proxy_core::dispatch_hft_data_event(hft_data_event const &event)
 {
     try
     {
-        hft_api::hft_response rsp {event.data_};
+        hft_api::hft_response rsp {event.data_, get_hft_instruments()};
 
         on_hft_advice(rsp, true);
     }
@@ -540,7 +540,7 @@ void proxy_core::hft_data_event_broker_disconnected(hft_data_event const &event)
 {
     try
     {
-        hft_api::hft_response rsp {event.data_};
+        hft_api::hft_response rsp {event.data_, get_hft_instruments()};
 
         on_hft_advice(rsp, false);
     }
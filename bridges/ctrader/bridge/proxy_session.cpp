@@ -51,7 +51,9 @@ void proxy_session::on_init(void)
         hft2ctrader_log(INFO)  << "Initialize HFT session, id ‘"
                                << config_.get_session_id() << "’";
 
-        hft_init_session(config_.get_session_id(), config_.get_instruments());
+        hft_init_session(config_.get_session_id(), config_.get_instruments(),
+                         config_.get_hft_pipeline_depth(), config_.is_hft_binary_framing(),
+                         config_.is_hft_instrument_lanes());
 
         hft_session_initialized_ = true;
     }
@@ -0,0 +1,216 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <hft_request.hpp>
+
+#include "hft_reference_request.hpp"
+
+namespace prog_opts = boost::program_options;
+
+static struct benchmark_options_type
+{
+    std::string input_file_name;
+    int iterations;
+
+} benchmark_options;
+
+#define hftOption(__X__) \
+    benchmark_options.__X__
+
+//
+// Used when no recorded traffic is given. Timestamps are
+// strings, as reference parser does not know integer ones.
+//
+
+static const char *sample_traffic[] = {
+    "{\"method\":\"init\",\"sessid\":\"icmarkets-session\",\"instruments\":[\"EUR/USD\",\"GBP/USD\"],\"pipeline\":32}",
+    "{\"method\":\"tick\",\"instrument\":\"EUR/USD\",\"timestamp\":\"2019-10-26 20:45:31.000\",\"ask\":1.3145,\"bid\":1.2456,\"equity\":56432,\"free_margin\":45678.12,\"cid\":1}",
+    "{\"method\":\"tick\",\"instrument\":\"GBP/USD\",\"timestamp\":\"2019-10-26 20:45:31.125\",\"ask\":1.28452,\"bid\":1.28447,\"equity\":56432,\"free_margin\":45678.12,\"cid\":2}",
+    "{\"method\":\"tick\",\"instrument\":\"EUR/USD\",\"timestamp\":\"2019-10-26 20:45:31.250\",\"ask\":1.31452,\"bid\":1.24561,\"equity\":56432.5,\"free_margin\":45678.12,\"cid\":3}",
+    "{\"method\":\"open_notify\",\"instrument\":\"EUR/USD\",\"id\":\"ahd76s\",\"status\":true,\"price\":1.31452,\"cid\":4}",
+    "{\"method\":\"tick\",\"instrument\":\"GBP/USD\",\"timestamp\":\"2019-10-26 20:45:31.375\",\"ask\":1.28455,\"bid\":1.28449,\"equity\":56420,\"free_margin\":45600.5,\"cid\":5}",
+    "{\"method\":\"close_notify\",\"instrument\":\"EUR/USD\",\"id\":\"ahd76s\",\"status\":true,\"price\":1.31501,\"cid\":6}",
+    "{\"method\":\"sync\",\"instrument\":\"GBP/USD\",\"id\":\"a87f6d\",\"timestamp\":\"2019-10-26 20:45:31.500\",\"direction\":\"LONG\",\"price\":1.28452,\"qty\":1000,\"cid\":7}"
+};
+
+static std::vector<std::string> load_traffic(const std::string &file_name)
+{
+    std::vector<std::string> result;
+
+    if (file_name.empty())
+    {
+        for (auto &x : sample_traffic)
+        {
+            result.push_back(x);
+        }
+
+        return result;
+    }
+
+    std::ifstream input(file_name);
+
+    if (! input)
+    {
+        std::string err_msg = "Unable to open file ‘" + file_name + "’";
+
+        throw std::runtime_error(err_msg.c_str());
+    }
+
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+        if (line.length() > 0)
+        {
+            result.push_back(line);
+        }
+    }
+
+    if (result.size() == 0)
+    {
+        std::string err_msg = "No requests in file ‘" + file_name + "’";
+
+        throw std::runtime_error(err_msg.c_str());
+    }
+
+    return result;
+}
+
+template <typename F>
+static double measure(const std::vector<std::string> &traffic, int iterations, F parse)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        for (auto &line : traffic)
+        {
+            parse(line);
+        }
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+
+    double total_ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+    return total_ns / (static_cast<double>(iterations) * traffic.size());
+}
+
+int hft_benchmark_main(int argc, char *argv[])
+{
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("benchmark", "")
+    ;
+
+    prog_opts::options_description desc("Options for benchmark");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("input,f", prog_opts::value<std::string>(&hftOption(input_file_name)) -> default_value(""), "File with recorded bridge traffic, one JSON request per line. Built-in sample if not given")
+        ("iterations,n", prog_opts::value<int>(&hftOption(iterations)) -> default_value(100000), "Number of passes over the traffic")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    if (hftOption(iterations) <= 0)
+    {
+        std::cerr << "Number of iterations must be positive\n";
+
+        return 1;
+    }
+
+    try
+    {
+        std::vector<std::string> traffic = load_traffic(hftOption(input_file_name));
+
+        //
+        // Both parsers see the same traffic, malformed
+        // requests are part of it and count as well.
+        //
+
+        hft::protocol::request_parser parser;
+        hft::protocol::request::holder req;
+
+        //
+        // Declare instruments the same way session
+        // does after successful init.
+        //
+
+        for (auto &line : traffic)
+        {
+            if (parser.parse(line.data(), line.length(), req) && req.opcode == hft::protocol::request::init::OPCODE)
+            {
+                parser.set_instruments(req.init_msg.instruments);
+            }
+        }
+
+        std::size_t dom_errors = 0;
+
+        double dom_ns = measure(traffic, hftOption(iterations), [&](const std::string &line)
+        {
+            try
+            {
+                hft::reference::parse_request_payload(line);
+            }
+            catch (const hft::reference::request::violation_error &e)
+            {
+                dom_errors++;
+            }
+        });
+
+        std::size_t sax_errors = 0;
+
+        double sax_ns = measure(traffic, hftOption(iterations), [&](const std::string &line)
+        {
+            if (! parser.parse(line.data(), line.length(), req))
+            {
+                sax_errors++;
+            }
+        });
+
+        std::cout << "Requests per pass: " << traffic.size() << ", passes: " << hftOption(iterations) << "\n";
+        std::cout << "  DOM parser: " << dom_ns << " ns/request, errors: " << dom_errors << "\n";
+        std::cout << "  SAX parser: " << sax_ns << " ns/request, errors: " << sax_errors << "\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/tokenizer.hpp>
+#include <boost/xpressive/xpressive.hpp>
+
+#include <csv_loader.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct csv_benchmark_options_type
+{
+    std::string input_file_name;
+    std::string sample_file_name;
+    int sample_size_mb;
+    bool skip_reference;
+
+} csv_benchmark_options;
+
+#define hftOption(__X__) \
+    csv_benchmark_options.__X__
+
+//
+// Reference line parser, as csv_loader had it before
+// the hand-written one. Kept for benchmarking purpose.
+//
+
+typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+
+static const boost::xpressive::sregex header_regex1 = boost::xpressive::sregex::compile("^\\s*Local\\stime\\s*,Ask\\s*,Bid\\s*,AskVolume\\s*,BidVolume\\s*$");
+static const boost::xpressive::sregex header_regex2 = boost::xpressive::sregex::compile("^\\s*Gmt\\stime\\s*,Ask\\s*,Bid\\s*,AskVolume\\s*,BidVolume\\s*$");
+
+static bool parse_line_reference(const std::string &line, csv_loader::csv_record &rec, std::string &request_time)
+{
+    boost::xpressive::smatch results;
+
+    if (line.length() == 0 || boost::xpressive::regex_match(line, results, header_regex1)
+                           || boost::xpressive::regex_match(line, results, header_regex2))
+    {
+        return false;
+    }
+
+    boost::char_separator<char> sep(",\r", "", boost::drop_empty_tokens);
+    tokenizer tokens(line, sep);
+    std::vector<std::string> columns(tokens.begin(), tokens.end());
+
+    if (columns.size() != 5)
+    {
+        throw std::runtime_error("Column number missmatch in line ‘" + line + "’");
+    }
+
+    rec.ask = boost::lexical_cast<double>(columns[1]);
+    rec.bid = boost::lexical_cast<double>(columns[2]);
+    rec.ask_volume = boost::lexical_cast<double>(columns[3]);
+    rec.bid_volume = boost::lexical_cast<double>(columns[4]);
+
+    boost::char_separator<char> datetime_sep(" .:", "", boost::drop_empty_tokens);
+    tokenizer datetime_tokens(columns[0], datetime_sep);
+    std::vector<std::string> items(datetime_tokens.begin(), datetime_tokens.end());
+
+    if (items.size() != 7 && items.size() != 8)
+    {
+        throw std::runtime_error("Datetime items missmatch in line ‘" + line + "’");
+    }
+
+    int day    = boost::lexical_cast<int>(items[0]);
+    int month  = boost::lexical_cast<int>(items[1]);
+    int year   = boost::lexical_cast<int>(items[2]);
+    int hour   = boost::lexical_cast<int>(items[3]);
+    int minute = boost::lexical_cast<int>(items[4]);
+    int second = boost::lexical_cast<int>(items[5]);
+
+    std::ostringstream req_time;
+
+    req_time << year << '-' << (month < 10 ? "0" : "") << month << '-' << (day < 10 ? "0" : "") << day << ' '
+             << (hour < 10 ? "0" : "") << hour << ':' << (minute < 10 ? "0" : "") << minute << ':'
+             << (second < 10 ? "0" : "") << second << ".000";
+
+    request_time = req_time.str();
+
+    return true;
+}
+
+//
+// Dukascopy like ticks, random walk of EUR/USD
+// a few ticks per second.
+//
+
+static void generate_sample(const std::string &file_name, int size_mb)
+{
+    std::FILE *out = std::fopen(file_name.c_str(), "w");
+
+    if (out == nullptr)
+    {
+        std::string err_msg = "Unable to create file ‘" + file_name + "’";
+
+        throw std::runtime_error(err_msg.c_str());
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> step(-3, 3);
+    std::uniform_int_distribution<int> gap(0, 2000);
+
+    long long target = static_cast<long long>(size_mb) * 1024 * 1024;
+    long long written = std::fprintf(out, "Gmt time,Ask,Bid,AskVolume,BidVolume\n");
+    long long millis = 0;
+    int price = 112345;
+
+    while (written < target)
+    {
+        millis += gap(rng);
+        price += step(rng);
+
+        long long s = millis / 1000;
+        int day = 1 + (s / 86400) % 28;
+        int month = 1 + (s / (86400 * 28)) % 12;
+
+        written += std::fprintf(out, "%02d.%02d.2017 %02lld:%02lld:%02lld.%03lld,%d.%05d,%d.%05d,%.2f,%.2f\n",
+                                day, month, (s / 3600) % 24, (s / 60) % 60, s % 60, millis % 1000,
+                                (price + 12) / 100000, (price + 12) % 100000, price / 100000, price % 100000,
+                                0.75 + (millis % 7) * 0.25, 1.0 + (millis % 5) * 0.5);
+    }
+
+    if (std::fclose(out) != 0)
+    {
+        std::string err_msg = "Failed to write file ‘" + file_name + "’";
+
+        throw std::runtime_error(err_msg.c_str());
+    }
+}
+
+static void report(const char *name, std::size_t records, double seconds, double megabytes)
+{
+    std::cout << "  " << name << ": " << records << " records in " << seconds << " s, "
+              << static_cast<long long>(records / seconds) << " lines/s, "
+              << megabytes / seconds << " MiB/s\n";
+}
+
+int hft_csv_benchmark_main(int argc, char *argv[])
+{
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("csv-benchmark", "")
+    ;
+
+    prog_opts::options_description desc("Options for csv-benchmark");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("input,f", prog_opts::value<std::string>(&hftOption(input_file_name)) -> default_value(""), "Dukascopy CSV file. Generated sample if not given")
+        ("sample,o", prog_opts::value<std::string>(&hftOption(sample_file_name)) -> default_value("/tmp/hft-csv-benchmark.csv"), "Where to generate sample, reused if present")
+        ("size,s", prog_opts::value<int>(&hftOption(sample_size_mb)) -> default_value(1024), "Size of generated sample in MiB")
+        ("no-reference,r", prog_opts::bool_switch(&hftOption(skip_reference)), "Measure current parser only")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    if (hftOption(sample_size_mb) <= 0)
+    {
+        std::cerr << "Sample size must be positive\n";
+
+        return 1;
+    }
+
+    try
+    {
+        std::string file_name = hftOption(input_file_name);
+
+        if (file_name.empty())
+        {
+            file_name = hftOption(sample_file_name);
+
+            if (! boost::filesystem::exists(file_name))
+            {
+                std::cout << "Generating " << hftOption(sample_size_mb) << " MiB sample ‘" << file_name << "’\n";
+
+                generate_sample(file_name, hftOption(sample_size_mb));
+            }
+        }
+
+        double megabytes = boost::filesystem::file_size(file_name) / (1024.0 * 1024.0);
+
+        std::cout << "File ‘" << file_name << "’, " << megabytes << " MiB\n";
+
+        //
+        // Both parsers read the file from the start, it is
+        // likely in page cache for the second one. Current
+        // parser goes first, so it is not favoured.
+        //
+
+        csv_loader::csv_record rec;
+        std::size_t records = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        csv_loader loader(file_name);
+
+        while (loader.get_record(rec))
+        {
+            records++;
+        }
+
+        report("Current parser  ", records, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), megabytes);
+
+        if (! hftOption(skip_reference))
+        {
+            std::string line;
+            std::string request_time;
+
+            records = 0;
+            start = std::chrono::steady_clock::now();
+
+            std::ifstream input(file_name);
+
+            while (std::getline(input, line))
+            {
+                if (parse_line_reference(line, rec, request_time))
+                {
+                    records++;
+                }
+            }
+
+            report("Reference parser", records, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), megabytes);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+#include <hft_shm_ring.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct ipc_benchmark_options_type
+{
+    int round_trips;
+    int message_size;
+    std::string unix_socket_path;
+    std::string shm_name;
+
+} ipc_benchmark_options;
+
+#define hftOption(__X__) \
+    ipc_benchmark_options.__X__
+
+//
+// Single round trip: client writes a message of given
+// size, echo server sends it back. Both ends live in
+// this process, each on its own thread, so figures
+// show transport cost without any request processing.
+//
+
+typedef std::function<void(const std::string &, std::string &)> round_trip;
+
+static void report(const std::string &transport, std::vector<double> &rtt)
+{
+    std::sort(rtt.begin(), rtt.end());
+
+    auto percentile = [&rtt](double p) { return rtt[static_cast<std::size_t>(p * (rtt.size() - 1))]; };
+
+    std::printf("  %-6s RTT min %8.2f us, p50 %8.2f us, p99 %8.2f us, max %8.2f us\n",
+                transport.c_str(), rtt.front(), percentile(0.5), percentile(0.99), rtt.back());
+}
+
+static void measure(const std::string &transport, round_trip rt)
+{
+    std::string message(hftOption(message_size) - 1, 'x');
+    message += '\n';
+
+    std::string reply;
+    std::vector<double> rtt;
+
+    rtt.reserve(hftOption(round_trips));
+
+    //
+    // Warm up caches and let both
+    // threads settle down first.
+    //
+
+    for (int i = 0; i < 1000; i++)
+    {
+        rt(message, reply);
+    }
+
+    for (int i = 0; i < hftOption(round_trips); i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        rt(message, reply);
+
+        auto stop = std::chrono::steady_clock::now();
+
+        if (reply != message)
+        {
+            throw std::runtime_error("Echo mismatch over " + transport);
+        }
+
+        rtt.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+
+    report(transport, rtt);
+}
+
+//
+// Echo over stream sockets, TCP loopback and AF_UNIX.
+//
+
+template <typename Protocol>
+static void measure_socket(const std::string &transport, const typename Protocol::endpoint &endpoint)
+{
+    boost::asio::io_context ioctx;
+    typename Protocol::acceptor acceptor(ioctx, endpoint);
+    typename Protocol::socket client(ioctx);
+
+    std::thread server([&acceptor](void)
+    {
+        typename Protocol::socket peer(acceptor.get_executor());
+        acceptor.accept(peer);
+
+        char buffer[4096];
+        boost::system::error_code ec;
+
+        while (! ec)
+        {
+            std::size_t n = peer.read_some(boost::asio::buffer(buffer, sizeof(buffer)), ec);
+
+            if (! ec)
+            {
+                boost::asio::write(peer, boost::asio::buffer(buffer, n), ec);
+            }
+        }
+    });
+
+    client.connect(acceptor.local_endpoint());
+
+    measure(transport, [&client](const std::string &message, std::string &reply)
+    {
+        boost::asio::write(client, boost::asio::buffer(message));
+
+        reply.resize(message.length());
+        boost::asio::read(client, boost::asio::buffer(&reply[0], reply.length()));
+    });
+
+    client.close();
+    server.join();
+}
+
+//
+// Echo over shared memory rings, server
+// end driven directly by ring primitives.
+//
+
+static void measure_shm(const std::string &name)
+{
+    hft::ipc::segment_ptr segment = hft::ipc::map_segment(name, true, 1);
+    hft::ipc::slot &s = hft::ipc::get_slot(segment.get(), 0);
+
+    std::thread server([&segment, &s](void)
+    {
+        using namespace hft::ipc;
+
+        wait(segment -> doorbell, segment -> doorbell_waiters,
+             [&s](void) { return s.state.load() == SLOT_CONNECTED; }, 5000);
+
+        std::uint32_t expected = SLOT_CONNECTED;
+
+        if (! s.state.compare_exchange_strong(expected, SLOT_SERVED))
+        {
+            return;
+        }
+
+        notify(s.response.seq, s.response.waiters);
+
+        std::string buffer;
+
+        while (s.state.load() == SLOT_SERVED)
+        {
+            buffer.clear();
+
+            if (ring_read(s.request, buffer) == 0)
+            {
+                wait(s.request.seq, s.request.waiters,
+                     [&s](void) { return readable(s.request) != 0 || s.state.load() != SLOT_SERVED; },
+                     WAIT_TIMEOUT_MS);
+
+                continue;
+            }
+
+            std::size_t done = 0;
+
+            while (s.state.load() == SLOT_SERVED)
+            {
+                done += ring_write(s.response, buffer.data() + done, buffer.length() - done);
+
+                if (done == buffer.length())
+                {
+                    break;
+                }
+
+                wait(s.response.seq, s.response.waiters,
+                     [&s](void) { return writable(s.response) != 0 || s.state.load() != SLOT_SERVED; },
+                     WAIT_TIMEOUT_MS);
+            }
+        }
+
+        close_slot(segment.get(), s, true);
+    });
+
+    {
+        hft::ipc::shm_client client(name);
+
+        measure("shm", [&client](const std::string &message, std::string &reply)
+        {
+            client.write(message);
+
+            reply.clear();
+
+            while (reply.length() < message.length())
+            {
+                client.read_some(reply);
+            }
+        });
+    }
+
+    server.join();
+}
+
+int hft_ipc_benchmark_main(int argc, char *argv[])
+{
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("ipc-benchmark", "")
+    ;
+
+    prog_opts::options_description desc("Options for ipc-benchmark");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("round-trips,n", prog_opts::value<int>(&hftOption(round_trips)) -> default_value(100000), "Number of measured round trips per transport")
+        ("message-size,s", prog_opts::value<int>(&hftOption(message_size)) -> default_value(160), "Size of echoed message in bytes, typical tick request by default")
+        ("unix-socket", prog_opts::value<std::string>(&hftOption(unix_socket_path)) -> default_value("/tmp/hft-ipc-benchmark-" + std::to_string(getpid()) + ".sock"), "Path of AF_UNIX socket used during benchmark")
+        ("shm-name", prog_opts::value<std::string>(&hftOption(shm_name)) -> default_value("/hft-ipc-benchmark-" + std::to_string(getpid())), "Name of shared memory used during benchmark")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    if (hftOption(round_trips) <= 0 || hftOption(message_size) <= 0)
+    {
+        std::cerr << "Number of round trips and message size must be positive\n";
+
+        return 1;
+    }
+
+    try
+    {
+        std::cout << "Round trips per transport: " << hftOption(round_trips)
+                  << ", message size: " << hftOption(message_size) << " bytes\n";
+
+        measure_socket<boost::asio::ip::tcp>("tcp", boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+        unlink(hftOption(unix_socket_path).c_str());
+        measure_socket<boost::asio::local::stream_protocol>("unix", boost::asio::local::stream_protocol::endpoint(hftOption(unix_socket_path)));
+        unlink(hftOption(unix_socket_path).c_str());
+
+        measure_shm(hftOption(shm_name));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_REFERENCE_REQUEST_HPP__
+#define __HFT_REFERENCE_REQUEST_HPP__
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <boost/variant2/variant.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <custom_except.hpp>
+
+namespace hft {
+namespace reference {
+namespace request {
+
+DEFINE_CUSTOM_EXCEPTION_CLASS(violation_error, std::runtime_error)
+
+//
+// Every request may carry optional ‘cid’ attribute (correlation
+// id), which is echoed back in the response. Absent cid is
+// represented by NO_CID value.
+//
+
+constexpr std::int64_t NO_CID = -1;
+
+//
+// Maximum number of outstanding requests client
+// may declare in ‘pipeline’ attribute of init.
+//
+
+enum { MAX_PIPELINE_DEPTH = 1024 };
+
+// {"method":"init","sessid":"icmarkets-session","instruments":["EUR/USD","GBP/USD"],"pipeline":32,"framing":"binary"}
+struct init
+{
+    enum { OPCODE = 0 };
+
+    std::int64_t cid;
+    std::string sessid;
+    std::vector<std::string> instruments;
+    int pipeline_depth;
+    bool binary_framing;
+};
+
+// {"method":"sync","instrument":"EUR/USD","id":"a87f6d","direction":"LONG","price":1.23459,"qty":1000}
+struct sync
+{
+    enum { OPCODE = 1 };
+
+    std::int64_t cid;
+    std::string instrument;
+    std::string id;
+    boost::posix_time::ptime created_on;
+    bool is_long;
+    double price;
+    int qty;
+};
+
+// {"method":"tick","instrument":"EUR/USD","timestamp":"2019-10-26 20:45:31.000","ask":1.3145,"bid":1.2456,"equity":56432}
+struct tick
+{
+    enum { OPCODE = 2 };
+
+    std::int64_t cid;
+    std::string instrument;
+    boost::posix_time::ptime request_time;
+    double ask;
+    double bid;
+    double equity;
+    double free_margin;
+};
+
+// {"method":"open_notify","instrument":"EUR/USD","id":"ahd76s","status":false,"price":1.23}
+struct open_notify
+{
+    enum { OPCODE = 3 };
+
+    std::int64_t cid;
+    std::string instrument;
+    std::string id;
+    double price;
+    bool status;
+};
+
+// {"method":"close_notify","instrument":"EUR/USD","id":"ahd76s","status":false}
+struct close_notify
+{
+    enum { OPCODE = 4 };
+
+    std::int64_t cid;
+    std::string instrument;
+    std::string id;
+    double price;
+    bool status;
+};
+
+typedef boost::variant2::variant<init,
+                                 sync,
+                                 tick,
+                                 open_notify,
+                                 close_notify> generic; 
+
+} /* namespace request */
+
+//
+// DOM-based request parser as it was before request_parser
+// replaced it. Kept unchanged for benchmark only, do not use
+// in server code.
+//
+
+request::generic parse_request_payload(const std::string &json_data);
+
+} /* namespace reference */
+} /* namespace hft */
+
+#endif /* __HFT_REFERENCE_REQUEST_HPP__ */
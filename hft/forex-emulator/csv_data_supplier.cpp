@@ -20,9 +20,12 @@
 
 #include <sstream>
 
-csv_data_supplier::csv_data_supplier(const std::string &file_name)
+csv_data_supplier::csv_data_supplier(const std::string &file_name, std::size_t read_ahead)
+    : from_store_ {false}, ring_(read_ahead), head_ {0}, tail_ {0}, terminate_ {false},
+      current_ {nullptr}, pos_ {0}, finished_ {false}, progress_ {0},
+      stall_time_ {std::chrono::steady_clock::duration::zero()}
 {
-    if (boost::iends_with(file_name, ".csv"))
+    if (boost::iends_with(file_name, ".csv") || tick_store::is_tick_store(file_name))
     {
         csv_file_names_.push_back(file_name);
     }
@@ -54,14 +57,58 @@ csv_data_supplier::csv_data_supplier(const std::string &file_name)
     }
 
     current_name_it_ = csv_file_names_.begin();
-    csv_loader_.load(*current_name_it_);
+    load(*current_name_it_);
+
+    if (! ring_.empty())
+    {
+        thread_ = std::thread(&csv_data_supplier::read_ahead, this);
+    }
+}
+
+csv_data_supplier::~csv_data_supplier(void)
+{
+    if (thread_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+            terminate_ = true;
+            cv_.notify_one();
+        }
+
+        thread_.join();
+    }
 }
 
 bool csv_data_supplier::get_record(csv_record &out_rec)
+{
+    if (ring_.empty())
+    {
+        return load_record(out_rec);
+    }
+
+    while (current_ == nullptr || pos_ == current_ -> records.size())
+    {
+        if (! next_batch())
+        {
+            return false;
+        }
+    }
+
+    out_rec = current_ -> records[pos_++];
+
+    return true;
+}
+
+int csv_data_supplier::get_progress(void) const
+{
+    return ring_.empty() ? load_progress() : progress_;
+}
+
+bool csv_data_supplier::load_record(csv_record &out_rec)
 {
     while (true)
     {
-        if (csv_loader_.get_record(out_rec))
+        if (from_store_ ? tick_store_.get_record(out_rec) : csv_loader_.get_record(out_rec))
         {
             return true;
         }
@@ -73,11 +120,135 @@ bool csv_data_supplier::get_record(csv_record &out_rec)
             return false;
         }
 
-        csv_loader_.load(*current_name_it_);
+        load(*current_name_it_);
     }
 }
 
-int csv_data_supplier::get_progress(void) const
+int csv_data_supplier::load_progress(void) const
+{
+    return from_store_ ? tick_store_.get_progress() : csv_loader_.get_progress();
+}
+
+void csv_data_supplier::read_ahead(void)
+{
+    bool last = false;
+
+    while (! last)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_.load(std::memory_order_acquire) == ring_.size())
+        {
+            std::unique_lock<std::mutex> lck(mtx_);
+
+            cv_.wait(lck, [this, tail](void) { return terminate_ || tail - head_.load() < ring_.size(); });
+
+            if (terminate_)
+            {
+                return;
+            }
+        }
+
+        //
+        // Batch keeps capacity of its records, steady
+        // state reading does not allocate.
+        //
+
+        batch &b = ring_[tail % ring_.size()];
+
+        b.records.resize(BATCH_RECORDS);
+        b.error = nullptr;
+
+        std::size_t n = 0;
+
+        try
+        {
+            while (n < BATCH_RECORDS && load_record(b.records[n]))
+            {
+                n++;
+            }
+
+            last = (n < BATCH_RECORDS);
+        }
+        catch (...)
+        {
+            b.error = std::current_exception();
+            last = true;
+        }
+
+        b.records.resize(n);
+        b.progress = load_progress();
+        b.last = last;
+
+        tail_.store(tail + 1, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lck(mtx_);
+        cv_.notify_one();
+    }
+}
+
+bool csv_data_supplier::next_batch(void)
 {
-    return csv_loader_.get_progress();
+    if (current_ != nullptr)
+    {
+        bool last = current_ -> last;
+        std::exception_ptr error = current_ -> error;
+
+        current_ = nullptr;
+
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+            cv_.notify_one();
+        }
+
+        if (last)
+        {
+            finished_ = true;
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    if (finished_)
+    {
+        return false;
+    }
+
+    std::size_t head = head_.load(std::memory_order_relaxed);
+
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lck(mtx_);
+
+        cv_.wait(lck, [this, head](void) { return tail_.load() != head; });
+
+        stall_time_ += std::chrono::steady_clock::now() - start;
+    }
+
+    current_ = &ring_[head % ring_.size()];
+    pos_ = 0;
+    progress_ = current_ -> progress;
+
+    return true;
+}
+
+void csv_data_supplier::load(const std::string &file_name)
+{
+    from_store_ = tick_store::is_tick_store(file_name);
+
+    if (from_store_)
+    {
+        tick_store_.load(file_name);
+    }
+    else
+    {
+        csv_loader_.load(file_name);
+    }
 }
@@ -16,28 +16,78 @@
  
 #include <csv_loader.hpp>
 
-#include <boost/xpressive/xpressive.hpp>
-#include <boost/tokenizer.hpp>
-#include <boost/lexical_cast.hpp>
-
-#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <sstream>
 
-typedef boost::tokenizer<boost::char_separator<char> >  tokenizer;
-
-static const boost::xpressive::sregex header_regex1 = boost::xpressive::sregex::compile("^\\s*Local\\stime\\s*,Ask\\s*,Bid\\s*,AskVolume\\s*,BidVolume\\s*$");
-static const boost::xpressive::sregex header_regex2 = boost::xpressive::sregex::compile("^\\s*Gmt\\stime\\s*,Ask\\s*,Bid\\s*,AskVolume\\s*,BidVolume\\s*$"); //Gmt time,Ask,Bid,AskVolume,BidVolume
+namespace {
 
 //
-// Dukascopy datetime format, examples:
+// Dukascopy datetime format, fixed positions, examples:
 //     01.05.2017 23:00:00.095
 //     01.12.2017 00:00:00.192 GMT+0100
+// Zone suffix, if any, is ignored.
+//
+
+constexpr char DATETIME_PATTERN[] = "dd.mm.yyyy hh:mm:ss.fff";
+constexpr std::size_t DATETIME_LENGTH = sizeof(DATETIME_PATTERN) - 1;
+
+bool digits(const char *p, int n, int &value)
+{
+    value = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (p[i] < '0' || p[i] > '9')
+        {
+            return false;
+        }
+
+        value = 10 * value + (p[i] - '0');
+    }
+
+    return true;
+}
+
+bool is_leap(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int days_in_month(int year, int month)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    return (month == 2 && is_leap(year)) ? 29 : days[month - 1];
+}
+
+//
+// Days since Unix epoch of civil date, after
+// H. Hinnant's chrono-compatible algorithms.
 //
 
-// static const boost::xpressive::sregex datetime_regex = boost::xpressive::sregex::compile("^\\d{2}\\.\\d{2}\\.\\d{4} \\d{2}:\\d{2}:\\d{2}\\.\\d{3}(\\sGMT\\+\\d{4})?$");
-static const boost::xpressive::sregex datetime_regex = boost::xpressive::sregex::compile("^\\d{2}\\.\\d{2}\\.\\d{4} \\d{2}:\\d{2}:\\d{2}\\.\\d$");
+std::int64_t days_from_civil(int year, int month, int day)
+{
+    year -= (month <= 2);
+
+    std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(year - era * 400);
+    unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+std::string line_text(const char *begin, const char *end)
+{
+    return std::string(begin, end - begin);
+}
+
+} /* namespace */
 
 csv_loader::csv_loader(const std::string &file_name)
+    : csv_loader()
 {
     load(file_name);
 }
@@ -57,7 +107,8 @@ void csv_loader::load(const std::string &file_name)
         infile_.close();
     }
 
-    infile_.open(file_name.c_str(), std::ifstream::in);
+    infile_.clear();
+    infile_.open(file_name.c_str(), std::ifstream::in | std::ifstream::binary);
 
     if (! infile_.is_open())
     {
@@ -69,148 +120,213 @@ void csv_loader::load(const std::string &file_name)
     }
 
     filesize_ = get_filesize();
+
+    buffer_.resize(BUFFER_SIZE);
+    begin_ = end_ = 0;
+    buffer_offset_ = 0;
+    eof_ = false;
 }
 
 bool csv_loader::get_record(csv_loader::csv_record &out_rec)
 {
-    std::string line;
-    boost::xpressive::smatch results;
-
-start_readline:
+    const char *begin;
+    const char *end;
 
     do
     {
-        if (! std::getline(infile_, line))
+        if (! next_line(begin, end))
         {
             return false;
         }
-    } while (boost::xpressive::regex_match(line, results, header_regex1) || boost::xpressive::regex_match(line, results, header_regex2));
 
-    if (line.length() == 0)
-    {
-        goto start_readline;
-    }
+        if (end > begin && end[-1] == '\r')
+        {
+            end--;
+        }
+    } while (begin == end || is_header(begin, end));
 
-    boost::char_separator<char> sep(",\r", "", boost::drop_empty_tokens);
-    tokenizer tokens(line, sep);
+    parse_line(begin, end, out_rec);
 
-    std::vector<std::string> columns;
+    return true;
+}
 
-    for (auto tok_iter = tokens.begin(); tok_iter != tokens.end(); ++tok_iter)
+bool csv_loader::next_line(const char *&begin, const char *&end)
+{
+    while (true)
     {
-        columns.push_back(*tok_iter);
-    }
+        const char *data = buffer_.data();
+        const char *nl = static_cast<const char *>(memchr(data + begin_, '\n', end_ - begin_));
 
-    if (columns.size() != CSV_TOTAL_COLUMNS)
-    {
-        std::ostringstream error_msg;
+        if (nl != nullptr)
+        {
+            begin = data + begin_;
+            end = nl;
+            begin_ = nl - data + 1;
 
-        error_msg << "Column number missmatch. Detected "
-                  << columns.size() << " columns, should be "
-                  << CSV_TOTAL_COLUMNS << " in line ‘"
-                  << line << "’.";
+            return true;
+        }
 
-        throw csv_exception(error_msg.str());
+        if (eof_)
+        {
+            if (begin_ == end_)
+            {
+                return false;
+            }
+
+            //
+            // Last line with no terminator.
+            //
+
+            begin = data + begin_;
+            end = data + end_;
+            begin_ = end_;
+
+            return true;
+        }
+
+        //
+        // Keep the incomplete line, read the rest after it.
+        // Line longer than the buffer makes it grow.
+        //
+
+        memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        buffer_offset_ += begin_;
+        end_ -= begin_;
+        begin_ = 0;
+
+        if (end_ == buffer_.size())
+        {
+            buffer_.resize(2 * buffer_.size());
+        }
+
+        infile_.read(buffer_.data() + end_, buffer_.size() - end_);
+
+        std::size_t n = infile_.gcount();
+
+        end_ += n;
+        eof_ = (n == 0);
     }
+}
 
-    out_rec.ask = boost::lexical_cast<double>(columns[CSV_ASK]);
-    out_rec.bid = boost::lexical_cast<double>(columns[CSV_BID]);
-    out_rec.ask_volume = boost::lexical_cast<double>(columns[CSV_ASK_VOLUME]);
-    out_rec.bid_volume = boost::lexical_cast<double>(columns[CSV_BID_VOLUME]);
-/*
- * FIXME: Do zastanowienia się.
+//
+// Header of Dukascopy export, ‘Gmt time,Ask,Bid,AskVolume,BidVolume’
+// or ‘Local time,...’. Nothing else starts with a letter.
+//
 
-    if (! boost::xpressive::regex_match(columns[CSV_DATE], results, datetime_regex))
+bool csv_loader::is_header(const char *begin, const char *end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
     {
-        std::ostringstream error_msg;
+        begin++;
+    }
 
-        error_msg << "Date and time in first colum mismatch with pattern "
-                  << "in line ‘" << line << "’: \"" << columns[CSV_DATE]
-                  << "\".";
+    std::size_t length = end - begin;
 
-        throw csv_exception(error_msg.str());
-    }
-*/
-    boost::char_separator<char> datetime_sep(" .:", "", boost::drop_empty_tokens);
-    tokenizer datetime_tokens(columns[CSV_DATE], datetime_sep);
-    std::vector<std::string> datetime_items;
+    return (length >= 8 && memcmp(begin, "Gmt time", 8) == 0)
+           || (length >= 10 && memcmp(begin, "Local time", 10) == 0);
+}
 
-    for (auto tok_iter = datetime_tokens.begin(); tok_iter != datetime_tokens.end(); ++tok_iter)
+void csv_loader::parse_line(const char *begin, const char *end, csv_record &out_rec) const
+{
+    const char *columns[CSV_TOTAL_COLUMNS + 1];
+    int count = 0;
+
+    columns[count++] = begin;
+
+    for (const char *p = begin; p < end; p++)
     {
-        datetime_items.push_back(*tok_iter);
+        if (*p == ',')
+        {
+            if (count == CSV_TOTAL_COLUMNS)
+            {
+                count++;
+                break;
+            }
+
+            columns[count++] = p + 1;
+        }
     }
 
-    if (datetime_items.size() != CSV_DATETIME_TOTAL_ITEMS &&
-            datetime_items.size() != CSV_DATETIME_TOTAL_ITEMS+1)
+    if (count != CSV_TOTAL_COLUMNS)
     {
         std::ostringstream error_msg;
 
-        error_msg << "Datetime items missmatch. Detected "
-                  << datetime_items.size() << ", should be "
-                  << CSV_DATETIME_TOTAL_ITEMS  << " or "
-                  << CSV_DATETIME_TOTAL_ITEMS + 1 << " in line ‘"
-                  << line << "’.";
+        error_msg << "Column number missmatch. Detected "
+                  << (count > CSV_TOTAL_COLUMNS ? "more than " : "")
+                  << std::min(count, static_cast<int>(CSV_TOTAL_COLUMNS))
+                  << " columns, should be " << CSV_TOTAL_COLUMNS
+                  << " in line ‘" << line_text(begin, end) << "’.";
 
         throw csv_exception(error_msg.str());
     }
 
-    int day    = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_DAY]);
-    int month  = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_MONTH]);
-    int year   = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_YEAR]);
-    int hour   = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_HOUR]);
-    int minute = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_MINUTE]);
-    int second = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_SECOND]);
-    int millis = boost::lexical_cast<int>(datetime_items[CSV_DATETIME_MILLIS]);
+    //
+    // Numbers, each must take up its whole column.
+    //
 
-    csv_loader::validate_range("year", year, 2000, 2100); // At least try to eliminate „exotic” years.
-    csv_loader::validate_range("month", month, 1, 12);    // months since January - [1,12]
-    csv_loader::validate_range("day", day, 1, 31);        // day of the month - [1,31] 
-    csv_loader::validate_range("hour", hour, 0, 23);      // hours since midnight - [0,23]
-    csv_loader::validate_range("minute", minute, 0, 59);  // minutes after the hour - [0,59]
-    csv_loader::validate_range("second", second, 0, 59);  // seconds after the minute - [0,59]
+    double *values[CSV_TOTAL_COLUMNS - 1] = {&out_rec.ask, &out_rec.bid, &out_rec.ask_volume, &out_rec.bid_volume};
 
-    std::ostringstream req_time;
+    for (int i = 1; i < CSV_TOTAL_COLUMNS; i++)
+    {
+        const char *first = columns[i];
+        const char *last = (i + 1 < CSV_TOTAL_COLUMNS) ? columns[i + 1] - 1 : end;
 
-    req_time << year << '-';
+        auto result = std::from_chars(first, last, *values[i - 1]);
 
-    if (month < 10)
-    {
-        req_time << '0';
-    }
+        if (result.ec != std::errc() || result.ptr != last || first == last)
+        {
+            std::ostringstream error_msg;
 
-    req_time << month << '-';
+            error_msg << "Invalid number ‘" << line_text(first, last)
+                      << "’ in line ‘" << line_text(begin, end) << "’.";
 
-    if (day < 10)
-    {
-        req_time << '0';
+            throw csv_exception(error_msg.str());
+        }
     }
 
-    req_time << day << ' ';
+    //
+    // Date and time.
+    //
 
-    if (hour < 10)
-    {
-        req_time << '0';
-    }
+    const char *dt = columns[0];
+    std::size_t dt_length = columns[1] - 1 - dt;
+
+    int day, month, year, hour, minute, second, millis;
 
-    req_time << hour << ':';
+    bool valid = dt_length >= DATETIME_LENGTH
+                 && (dt_length == DATETIME_LENGTH || dt[DATETIME_LENGTH] == ' ')
+                 && digits(dt, 2, day) && dt[2] == '.'
+                 && digits(dt + 3, 2, month) && dt[5] == '.'
+                 && digits(dt + 6, 4, year) && dt[10] == ' '
+                 && digits(dt + 11, 2, hour) && dt[13] == ':'
+                 && digits(dt + 14, 2, minute) && dt[16] == ':'
+                 && digits(dt + 17, 2, second) && dt[19] == '.'
+                 && digits(dt + 20, 3, millis);
 
-    if (minute < 10)
+    if (! valid)
     {
-        req_time << '0';
-    }
+        std::ostringstream error_msg;
 
-    req_time << minute << ':';
+        error_msg << "Date and time in first column mismatch with pattern ‘"
+                  << DATETIME_PATTERN << "’ in line ‘" << line_text(begin, end) << "’.";
 
-    if (second < 10)
-    {
-        req_time << '0';
+        throw csv_exception(error_msg.str());
     }
 
-    req_time << second << ".000";
+    csv_loader::validate_range("year", year, 2000, 2100); // At least try to eliminate „exotic” years.
+    csv_loader::validate_range("month", month, 1, 12);    // months since January - [1,12]
+    csv_loader::validate_range("day", day, 1, days_in_month(year, month)); // day of the month - [1,28..31]
+    csv_loader::validate_range("hour", hour, 0, 23);      // hours since midnight - [0,23]
+    csv_loader::validate_range("minute", minute, 0, 59);  // minutes after the hour - [0,59]
+    csv_loader::validate_range("second", second, 0, 59);  // seconds after the minute - [0,59]
 
-    out_rec.request_time = req_time.str();
+    //
+    // Milliseconds are dropped, emulation
+    // has always run on whole seconds.
+    //
 
-    return true;
+    out_rec.request_time = days_from_civil(year, month, day) * 86400000
+                           + hour * 3600000 + minute * 60000 + second * 1000;
 }
 
 int csv_loader::get_progress(void) const
@@ -228,13 +344,17 @@ int csv_loader::get_progress(void) const
 
 long csv_loader::get_record_position(void) const
 {
-    return infile_.tellg();
+    return buffer_offset_ + begin_;
 }
 
 void csv_loader::set_record_position(long position)
 {
     infile_.clear();
     infile_.seekg(position);
+
+    begin_ = end_ = 0;
+    buffer_offset_ = position;
+    eof_ = false;
 }
 
 long csv_loader::get_filesize(void) const
@@ -15,31 +15,45 @@
 \**********************************************************************/
 
 #include <unistd.h>
+#include <algorithm>
 #include <limits>
 
 #include <hft_forex_emulator.hpp>
+#include <hft_server_connector.hpp>
+#include <hft_inprocess_connector.hpp>
 
 hft_forex_emulator::hft_forex_emulator(const std::string &host, const std::string &port, const std::string &sessid,
                                            const std::map<std::string, std::string> &instrument_data, double deposit,
                                                const std::string &config_file_name, bool check_bankruptcy,
-                                                   bool invert_hft_decision, bool immediate_profit_withdrawal)
-    : hft_connection_(host, port),
-      balance_(deposit),
+                                                   bool invert_hft_decision, bool immediate_profit_withdrawal,
+                                                       bool binary_framing, bool in_process, std::size_t read_ahead)
+    : balance_(deposit),
       check_bankruptcy_(check_bankruptcy),
       invert_hft_decision_(invert_hft_decision),
       immediate_profit_withdrawal_(immediate_profit_withdrawal),
       forbid_new_positions_(false),
-      total_withdrawn_(0.0)
+      total_withdrawn_(0.0),
+      drained_(nullptr)
 {
+    if (in_process)
+    {
+        hft_connection_.reset(new hft_inprocess_connector());
+    }
+    else
+    {
+        hft_connection_.reset(new hft_server_connector(host, port));
+    }
+
     std::vector<std::string> instruments;
 
     for (auto &instr : instrument_data)
     {
+        instruments_[instr.first] = std::make_shared<instrument_data_info>(instr.first, instr.second, config_file_name,
+                                                                           read_ahead, instruments.size());
         instruments.push_back(instr.first);
-        instruments_[instr.first] = std::make_shared<instrument_data_info>(instr.first, instr.second, config_file_name);
     }
 
-    hft_connection_.init(sessid, instruments);
+    hft_connection_ -> init(sessid, instruments, binary_framing);
 
     proceed();
 }
@@ -103,7 +117,7 @@ void hft_forex_emulator::proceed(void)
             break;
         }
 
-        hft_connection_.send_tick(tick_info.instrument, balance_, current_free_margin, tick_info, reply);
+        hft_connection_ -> send_tick(tick_info.instrument, balance_, current_free_margin, tick_info, reply);
         handle_response(tick_info, reply);
     }
 
@@ -131,6 +145,18 @@ void hft_forex_emulator::proceed(void)
     }
 }
 
+std::map<std::string, double> hft_forex_emulator::get_data_stall_times(void) const
+{
+    std::map<std::string, double> result;
+
+    for (auto &item : instruments_)
+    {
+        result[item.first] = item.second -> csv_faucet.get_stall_time();
+    }
+
+    return result;
+}
+
 std::string hft_forex_emulator::get_progress_str(void) const
 {
     std::string result;
@@ -171,52 +197,61 @@ void hft_forex_emulator::close_worst_losing_position(void)
 
 bool hft_forex_emulator::get_record(tick_record &tick)
 {
-    for (auto &item : instruments_)
+    if (drained_ != nullptr)
     {
-        if (item.second -> state == instrument_data_info::data_state::DS_EMPTY)
-        {
-            bool load_result = item.second -> csv_faucet.get_record(item.second -> loaded);
-
-            if (load_result)
-            {
-                item.second -> state = instrument_data_info::data_state::DS_LOADED;
-            }
-            else
-            {
-                item.second -> state = instrument_data_info::data_state::DS_EOF;
-            }
-        }
+        load_next_record(drained_);
+        drained_ = nullptr;
     }
-
-    std::string   earliest_instrument;
-    unsigned long earliest_time = std::numeric_limits<unsigned long>::max();
-
-    for (auto &item : instruments_)
+    else if (loaded_heap_.empty())
     {
-        if (item.second -> state == instrument_data_info::data_state::DS_LOADED)
-        {
-            auto t = hft::utils::ptime2timestamp(boost::posix_time::ptime(boost::posix_time::time_from_string(item.second -> loaded.request_time)));
+        //
+        // First call, instruments have nothing loaded yet.
+        //
 
-            if (t < earliest_time)
+        for (auto &item : instruments_)
+        {
+            if (item.second -> state == instrument_data_info::data_state::DS_EMPTY)
             {
-                earliest_time = t;
-                earliest_instrument = item.first;
+                load_next_record(item.second.get());
             }
         }
     }
 
-    if (earliest_instrument.length() > 0)
+    if (loaded_heap_.empty())
     {
-        instruments_[earliest_instrument] -> official = instruments_[earliest_instrument] -> loaded;
-        instruments_[earliest_instrument] -> state = instrument_data_info::data_state::DS_EMPTY;
+        return false;
+    }
 
-        tick = instruments_[earliest_instrument] -> official;
-        tick.instrument = earliest_instrument;
+    std::pop_heap(loaded_heap_.begin(), loaded_heap_.end(), later_tick);
 
-        return true;
-    }
+    instrument_data_info *earliest = loaded_heap_.back();
+
+    loaded_heap_.pop_back();
+
+    earliest -> official = earliest -> loaded;
+    earliest -> state = instrument_data_info::data_state::DS_EMPTY;
 
-    return false;
+    tick = earliest -> official;
+    tick.instrument = earliest -> instrument;
+
+    drained_ = earliest;
+
+    return true;
+}
+
+void hft_forex_emulator::load_next_record(instrument_data_info *info)
+{
+    if (info -> csv_faucet.get_record(info -> loaded))
+    {
+        info -> state = instrument_data_info::data_state::DS_LOADED;
+
+        loaded_heap_.push_back(info);
+        std::push_heap(loaded_heap_.begin(), loaded_heap_.end(), later_tick);
+    }
+    else
+    {
+        info -> state = instrument_data_info::data_state::DS_EOF;
+    }
 }
 
 void hft_forex_emulator::handle_response(const tick_record &tick_info, const hft::protocol::response &reply)
@@ -241,7 +276,7 @@ hft_forex_emulator::position_status hft_forex_emulator::get_position_status_at_m
 {
     position_status ps;
 
-    ps.moment = boost::posix_time::ptime(boost::posix_time::time_from_string(tick_info.request_time));
+    ps.moment = hft::utils::timestamp2ptime(tick_info.request_time);
 
     int days = days_elapsed(pos.open_time, ps.moment);
 
@@ -328,7 +363,7 @@ void hft_forex_emulator::handle_close_position(const std::string &id, const tick
 
     hft::protocol::response reply;
 
-    hft_connection_.send_close_notify(pos.instrument, id, true, price, reply);
+    hft_connection_ -> send_close_notify(pos.instrument, id, true, price, reply);
     handle_response(tick_info, reply);
 }
 
@@ -349,7 +384,7 @@ void hft_forex_emulator::handle_open_position(const hft::protocol::response::ope
     {
         hft::protocol::response reply;
 
-        hft_connection_.send_open_notify(tick_info.instrument, opi.id_, false, 0.0, reply);
+        hft_connection_ -> send_open_notify(tick_info.instrument, opi.id_, false, 0.0, reply);
 
         //
         // Ignore reply.
@@ -364,7 +399,7 @@ void hft_forex_emulator::handle_open_position(const hft::protocol::response::ope
     {
         hft::protocol::response reply;
 
-        hft_connection_.send_open_notify(tick_info.instrument, opi.id_, false, 0.0, reply);
+        hft_connection_ -> send_open_notify(tick_info.instrument, opi.id_, false, 0.0, reply);
         handle_response(tick_info, reply);
 
         return;
@@ -376,7 +411,7 @@ void hft_forex_emulator::handle_open_position(const hft::protocol::response::ope
     op.instrument = tick_info.instrument;
     op.id         = opi.id_;
     op.qty        = opi.qty_;
-    op.open_time  = boost::posix_time::ptime(boost::posix_time::time_from_string(tick_info.request_time));
+    op.open_time  = hft::utils::timestamp2ptime(tick_info.request_time);
 
     if (invert_hft_decision_)
     {
@@ -414,7 +449,7 @@ void hft_forex_emulator::handle_open_position(const hft::protocol::response::ope
 
     hft::protocol::response reply;
 
-    hft_connection_.send_open_notify(op.instrument, op.id, true, price, reply);
+    hft_connection_ -> send_open_notify(op.instrument, op.id, true, price, reply);
     handle_response(tick_info, reply);
 }
 
@@ -425,7 +460,7 @@ double hft_forex_emulator::get_equity_at_moment(void) const
     for (auto &pos : positions_)
     {
         auto open_time = pos.second.open_time;
-        auto now_time  = boost::posix_time::ptime(boost::posix_time::time_from_string(instruments_.at(pos.second.instrument) -> official.request_time));
+        auto now_time  = hft::utils::timestamp2ptime(instruments_.at(pos.second.instrument) -> official.request_time);
 
         int days = days_elapsed(open_time, now_time);
 
@@ -38,6 +38,9 @@ static struct dukas_emulator_options_type
     bool check_bankruptcy;
     bool invert_hft_decision;
     bool immediate_profit_withdrawal;
+    bool binary_framing;
+    bool in_process;
+    int read_ahead;
 
 } dukas_emulator_options;
 
@@ -138,6 +141,9 @@ int hft_dukasemu_main(int argc, char *argv[])
         ("check-bankruptcy,B", prog_opts::value<bool>(&hftOption(check_bankruptcy)) -> default_value(false), "Stop simulation when equity drops to zero")
         ("invert-hft-decision,I", prog_opts::value<bool>(&hftOption(invert_hft_decision)) -> default_value(false), "Play the opposite of the HFT decision")
         ("immediate-withdrawal,w", prog_opts::value<bool>(&hftOption(immediate_profit_withdrawal)) -> default_value(false), "Simulate instant payout of every profit")
+        ("binary-framing,x", prog_opts::value<bool>(&hftOption(binary_framing)) -> default_value(false), "Use binary framing of HFT protocol instead of JSON")
+        ("in-process,n", prog_opts::bool_switch(&hftOption(in_process)), "Run instrument handlers of session within emulator, no HFT server needed")
+        ("read-ahead,R", prog_opts::value<int>(&hftOption(read_ahead)) -> default_value(8), "Batches of ticks per instrument decoded ahead by background thread, 0 reads on emulation thread")
         ("config,c", prog_opts::value<std::string>(&hftOption(config_file_name)) -> default_value("/etc/hft/hft-config.xml"), "HFT configuration file name")
     ;
 
@@ -173,6 +179,13 @@ int hft_dukasemu_main(int argc, char *argv[])
         return 1;
     }
 
+    if (hftOption(read_ahead) < 0)
+    {
+        hft_log(ERROR) << "Read-ahead depth must not be negative.";
+
+        return 1;
+    }
+
     try
     {
 
@@ -184,7 +197,18 @@ int hft_dukasemu_main(int argc, char *argv[])
                                       hftOption(config_file_name),
                                       hftOption(check_bankruptcy),
                                       hftOption(invert_hft_decision),
-                                      hftOption(immediate_profit_withdrawal));
+                                      hftOption(immediate_profit_withdrawal),
+                                      hftOption(binary_framing),
+                                      hftOption(in_process),
+                                      hftOption(read_ahead));
+
+        if (hftOption(read_ahead) > 0)
+        {
+            for (auto &x : simulation.get_data_stall_times())
+            {
+                hft_log(INFO) << "Emulation waited " << x.second << " s for data of ‘" << x.first << "’";
+            }
+        }
 
         hft_display_filter hdf;
         hdf.display(simulation.get_result());
@@ -0,0 +1,178 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+
+#include <hft_inprocess_connector.hpp>
+#include <hft_session.hpp>
+#include <utilities.hpp>
+
+#include <easylogging++.h>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "forex_emulator")
+
+hft_inprocess_connector::hft_inprocess_connector(void)
+    : binary_framing_(false)
+{
+    //
+    // Handler factory logs to session logger.
+    //
+
+    el::Loggers::getLogger("session", true);
+}
+
+hft_inprocess_connector::~hft_inprocess_connector(void)
+{
+    //
+    // Handlers refer to session state,
+    // they must go away first.
+    //
+
+    instrument_handlers_.clear();
+}
+
+void hft_inprocess_connector::init(const std::string &sessid, const std::vector<std::string> &instruments, bool binary_framing)
+{
+    if (instruments.empty())
+    {
+        throw std::runtime_error("hft_inprocess_connector: init: Empty instrument set");
+    }
+
+    std::string sessdir = hft_session::get_session_dir(sessid);
+
+    if (! boost::filesystem::is_directory(sessdir))
+    {
+        throw std::runtime_error("Not found directory ‘" + sessdir + "’ – session cannot be established");
+    }
+
+    //
+    // Emulation starts from saved state of the session,
+    // but never writes back, session directory stays as
+    // server left it. Handlers run on single lane.
+    //
+
+    pss_.reset(new session_state(sessid, false, true));
+
+    for (auto &instrument : instruments)
+    {
+        instrument_handlers_.emplace_back(create_instrument_handler(pss_, instrument));
+    }
+
+    pss_ -> release_warm_state();
+
+    instruments_ = instruments;
+    binary_framing_ = binary_framing;
+}
+
+void hft_inprocess_connector::send_tick(const std::string &instrument, double balance, double free_margin,
+                                            const csv_data_supplier::csv_record &tick_info, hft::protocol::response &rsp)
+{
+    tick_msg_.cid = hft::protocol::request::NO_CID;
+    tick_msg_.instrument_id = instrument_index(instrument);
+    tick_msg_.instrument = instruments_[tick_msg_.instrument_id];
+    tick_msg_.request_time.set(tick_info.request_time);
+    tick_msg_.ask = wire_value(tick_info.ask);
+    tick_msg_.bid = wire_value(tick_info.bid);
+    tick_msg_.equity = wire_value(balance);
+    tick_msg_.free_margin = wire_value(free_margin);
+
+    invoke_handler(tick_msg_, rsp, &instrument_handler::on_tick);
+}
+
+void hft_inprocess_connector::send_open_notify(const std::string &instrument, const std::string &position_id,
+                                                   bool status, double price, hft::protocol::response &rsp)
+{
+    open_notify_msg_.cid = hft::protocol::request::NO_CID;
+    open_notify_msg_.instrument_id = instrument_index(instrument);
+    open_notify_msg_.instrument = instruments_[open_notify_msg_.instrument_id];
+    open_notify_msg_.id = position_id;
+    open_notify_msg_.price = wire_value(price);
+    open_notify_msg_.status = status;
+
+    invoke_handler(open_notify_msg_, rsp, &instrument_handler::on_position_open);
+}
+
+void hft_inprocess_connector::send_close_notify(const std::string &instrument, const std::string &position_id,
+                                                    bool status, double price, hft::protocol::response &rsp)
+{
+    close_notify_msg_.cid = hft::protocol::request::NO_CID;
+    close_notify_msg_.instrument_id = instrument_index(instrument);
+    close_notify_msg_.instrument = instruments_[close_notify_msg_.instrument_id];
+    close_notify_msg_.id = position_id;
+    close_notify_msg_.price = wire_value(price);
+    close_notify_msg_.status = status;
+
+    invoke_handler(close_notify_msg_, rsp, &instrument_handler::on_position_close);
+}
+
+template <typename T>
+void hft_inprocess_connector::invoke_handler(const T &msg, hft::protocol::response &rsp,
+                                             void (instrument_handler::*on_request)(const T &, hft::protocol::response &))
+{
+    //
+    // Response is reused by emulator, start over
+    // as unserialize() does on the wire.
+    //
+
+    rsp = hft::protocol::response();
+    rsp.set_instrument(msg.instrument);
+
+    //
+    // Session state is saved when autosaver
+    // goes out of scope, as on server.
+    //
+
+    auto as = pss_ -> create_autosaver();
+
+    (instrument_handlers_[msg.instrument_id].get() ->* on_request)(msg, rsp);
+}
+
+int hft_inprocess_connector::instrument_index(const std::string &instrument) const
+{
+    for (std::size_t i = 0; i < instruments_.size(); i++)
+    {
+        if (instruments_[i] == instrument)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("hft_inprocess_connector: Unknown instrument ‘" + instrument + "’");
+}
+
+//
+// Binary framing carries doubles as they are. JSON
+// request is written by ostream of default precision,
+// handler gets value rounded to 6 significant digits.
+//
+
+double hft_inprocess_connector::wire_value(double value) const
+{
+    if (binary_framing_)
+    {
+        return value;
+    }
+
+    char buffer[32];
+
+    std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+
+    return std::strtod(buffer, nullptr);
+}
@@ -17,19 +17,51 @@
 #include <sstream>
 
 #include <hft_server_connector.hpp>
+#include <hft_binary_protocol.hpp>
+#include <utilities.hpp>
 
 hft_server_connector::hft_server_connector(const std::string &host, const std::string &port)
-    : ioctx_(), socket_(ioctx_)
+    : ioctx_(), socket_(ioctx_), binary_framing_(false)
 {
+    if (host.compare(0, 4, "shm:") == 0)
+    {
+        shm_.reset(new hft::ipc::shm_client(host.substr(4)));
+
+        return;
+    }
+
+    if (host.compare(0, 5, "unix:") == 0)
+    {
+        socket_.connect(boost::asio::local::stream_protocol::endpoint(host.substr(5)));
+
+        return;
+    }
+
     boost::asio::ip::tcp::resolver resolver(ioctx_);
-    boost::asio::connect(socket_, resolver.resolve({host, port}));
+    boost::system::error_code ec = boost::asio::error::host_not_found;
+
+    for (auto &entry : resolver.resolve(host, port))
+    {
+        socket_.close();
+        socket_.connect(entry.endpoint(), ec);
+
+        if (! ec)
+        {
+            break;
+        }
+    }
+
+    if (ec)
+    {
+        throw boost::system::system_error(ec);
+    }
 }
 
 hft_server_connector::~hft_server_connector(void)
 {
 }
 
-void hft_server_connector::init(const std::string &sessid, const std::vector<std::string> &instruments)
+void hft_server_connector::init(const std::string &sessid, const std::vector<std::string> &instruments, bool binary_framing)
 {
     if (instruments.empty())
     {
@@ -53,7 +85,8 @@ void hft_server_connector::init(const std::string &sessid, const std::vector<std
 
     payload << "{\"method\":\"init\",\"sessid\":\""
             << sessid << "\",\"instruments\":["
-            << instruments_str << "]}\n";
+            << instruments_str << "]"
+            << (binary_framing ? ",\"framing\":\"binary\"}\n" : "}\n");
 
     hft::protocol::response rsp;
     rsp.unserialize(send_recv_server(payload.str()));
@@ -62,16 +95,31 @@ void hft_server_connector::init(const std::string &sessid, const std::vector<std
     {
         throw std::runtime_error(rsp.get_error_message());
     }
+
+    instruments_ = instruments;
+    binary_framing_ = binary_framing;
 }
 
 void hft_server_connector::send_tick(const std::string &instrument, double balance, double free_margin,
                                          const csv_data_supplier::csv_record &tick_info, hft::protocol::response &rsp)
 {
+    auto timestamp = tick_info.request_time;
+
+    if (binary_framing_)
+    {
+        frame_.clear();
+        hft::protocol::binary::encode_tick(instrument_index(instrument), timestamp, tick_info.ask, tick_info.bid,
+                                           balance, free_margin, hft::protocol::request::NO_CID, frame_);
+        send_recv_server_binary(frame_, rsp);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     payload << "{\"method\":\"tick\",\"instrument\":\""
-            << instrument << "\",\"timestamp\":\""
-            << tick_info.request_time << "\",\"ask\":"
+            << instrument << "\",\"timestamp\":"
+            << timestamp << ",\"ask\":"
             << tick_info.ask << ",\"bid\":"
             << tick_info.bid << ",\"equity\":"
             << balance  << ",\"free_margin\":"
@@ -83,6 +131,16 @@ void hft_server_connector::send_tick(const std::string &instrument, double balan
 void hft_server_connector::send_open_notify(const std::string &instrument, const std::string &position_id,
                                                 bool status, double price, hft::protocol::response &rsp)
 {
+    if (binary_framing_)
+    {
+        frame_.clear();
+        hft::protocol::binary::encode_open_notify(instrument_index(instrument), position_id, status, price,
+                                                   hft::protocol::request::NO_CID, frame_);
+        send_recv_server_binary(frame_, rsp);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     std::string s = (status ? "true" : "false");
@@ -98,6 +156,16 @@ void hft_server_connector::send_open_notify(const std::string &instrument, const
 void hft_server_connector::send_close_notify(const std::string &instrument, const std::string &position_id,
                                                  bool status, double price, hft::protocol::response &rsp)
 {
+    if (binary_framing_)
+    {
+        frame_.clear();
+        hft::protocol::binary::encode_close_notify(instrument_index(instrument), position_id, status, price,
+                                                   hft::protocol::request::NO_CID, frame_);
+        send_recv_server_binary(frame_, rsp);
+
+        return;
+    }
+
     std::ostringstream payload;
 
     std::string s = (status ? "true" : "false");
@@ -112,14 +180,85 @@ void hft_server_connector::send_close_notify(const std::string &instrument, cons
 
 std::string hft_server_connector::send_recv_server(const std::string &payload)
 {
-    std::string reply;
+    write_server(payload.c_str(), payload.length());
+
+    std::size_t pos;
 
-    boost::asio::write(socket_, boost::asio::buffer(payload.c_str(), payload.length()));
+    while ((pos = input_.find('\n')) == std::string::npos)
+    {
+        fill_input(input_.length() + 1);
+    }
 
-    boost::asio::streambuf data_from_server;
-    size_t reply_length = boost::asio::read_until(socket_, data_from_server, '\n');
-    std::istream str(&data_from_server);
-    std::getline(str, reply);
+    std::string reply = input_.substr(0, pos);
+    input_.erase(0, pos + 1);
 
     return reply;
 }
+
+void hft_server_connector::send_recv_server_binary(const std::string &frame, hft::protocol::response &rsp)
+{
+    write_server(frame.c_str(), frame.length());
+
+    //
+    // Read fixed-size header first, it tells
+    // how long the rest of the frame is.
+    //
+
+    fill_input(hft::protocol::binary::HEADER_SIZE);
+
+    std::size_t n = hft::protocol::binary::frame_size(input_.c_str(), input_.length());
+
+    fill_input(n);
+
+    hft::protocol::binary::decode_response(input_.c_str(), n, instruments_, rsp);
+
+    input_.erase(0, n);
+}
+
+void hft_server_connector::write_server(const char *data, std::size_t length)
+{
+    if (shm_)
+    {
+        shm_ -> write(data, length);
+    }
+    else
+    {
+        boost::asio::write(socket_, boost::asio::buffer(data, length));
+    }
+}
+
+//
+// Reads from server until at least ‘length’
+// bytes are buffered in input.
+//
+
+void hft_server_connector::fill_input(std::size_t length)
+{
+    char chunk[4096];
+
+    while (input_.length() < length)
+    {
+        if (shm_)
+        {
+            shm_ -> read_some(input_);
+        }
+        else
+        {
+            std::size_t n = socket_.read_some(boost::asio::buffer(chunk, sizeof(chunk)));
+            input_.append(chunk, n);
+        }
+    }
+}
+
+std::uint16_t hft_server_connector::instrument_index(const std::string &instrument) const
+{
+    for (std::size_t i = 0; i < instruments_.size(); i++)
+    {
+        if (instruments_[i] == instrument)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("hft_server_connector: Unknown instrument ‘" + instrument + "’");
+}
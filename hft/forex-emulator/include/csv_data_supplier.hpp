@@ -18,29 +18,114 @@
 #define __CSV_DATA_SUPPLIER_HPP__
 
 #include <csv_loader.hpp>
+#include <tick_store.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <boost/noncopyable.hpp>
 
+//
+// Supplies ticks from CSV file, tick store or file with list
+// of them. Kind of every data file is told by its content.
+//
+
 class csv_data_supplier : private boost::noncopyable
 {
 public:
 
     typedef csv_loader::csv_record csv_record;
 
-    csv_data_supplier(const std::string &file_name);
+    //
+    // With non-zero ‘read_ahead’ files are read and decoded by
+    // background thread, up to ‘read_ahead’ batches of ticks
+    // ahead. Next file of the list is opened and parsed while
+    // the tail of the current one is still being consumed.
+    //
+
+    csv_data_supplier(const std::string &file_name, std::size_t read_ahead = 0);
+
+    ~csv_data_supplier(void);
 
     bool get_record(csv_record &out_rec);
 
     int get_progress(void) const;
 
+    //
+    // How long get_record() waited for background
+    // thread so far, in seconds.
+    //
+
+    double get_stall_time(void) const { return std::chrono::duration<double>(stall_time_).count(); }
+
 private:
 
+    enum { BATCH_RECORDS = 4096 };
+
+    struct batch
+    {
+        std::vector<csv_record> records;
+
+        //
+        // Progress of file when batch was filled. The last
+        // batch ends the data, it may carry an error.
+        //
+
+        int progress;
+        bool last;
+        std::exception_ptr error;
+    };
+
+    void load(const std::string &file_name);
+
+    bool load_record(csv_record &out_rec);
+
+    int load_progress(void) const;
+
+    //
+    // Producer and consumer side of ring.
+    //
+
+    void read_ahead(void);
+
+    bool next_batch(void);
+
     csv_loader csv_loader_;
+    tick_store tick_store_;
+    bool from_store_;
 
     std::vector<std::string> csv_file_names_;
     std::vector<std::string>::iterator current_name_it_;
+
+    //
+    // Batches between ‘head_’ and ‘tail_’ are filled, the
+    // rest are free. Indices only grow. Thread is absent
+    // when there is no read-ahead.
+    //
+
+    std::vector<batch> ring_;
+    std::atomic<std::size_t> head_;
+    std::atomic<std::size_t> tail_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool terminate_;
+    std::thread thread_;
+
+    //
+    // Consumer state.
+    //
+
+    const batch *current_;
+    std::size_t pos_;
+    bool finished_;
+    int progress_;
+    std::chrono::steady_clock::duration stall_time_;
 };
 
 #endif /* __CSV_DATA_SUPPLIER_HPP__ */
@@ -17,8 +17,10 @@
 #ifndef __CSV_LOADER_HPP__
 #define __CSV_LOADER_HPP__
 
+#include <cstdint>
 #include <fstream>
 #include <stdexcept>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
@@ -33,17 +35,22 @@ public:
     struct csv_record
     {
         csv_record(void)
-            : ask(0.0), bid(0.0),
+            : request_time(0), ask(0.0), bid(0.0),
               ask_volume(0.0), bid_volume(0.0) {}
 
-        std::string request_time;
+        //
+        // Milliseconds since Unix epoch, whole seconds.
+        //
+
+        std::int64_t request_time;
         double ask;
         double bid;
         double ask_volume;
         double bid_volume;
     };
 
-    csv_loader(void) : filesize_ {0} {}
+    csv_loader(void)
+        : filesize_ {0}, begin_ {0}, end_ {0}, buffer_offset_ {0}, eof_ {true} {}
     csv_loader(const std::string &file_name);
     ~csv_loader(void);
 
@@ -64,32 +71,37 @@ private:
 
     long get_filesize(void) const;
 
+    //
+    // Next line of file, without line terminator. Valid
+    // until the next call, it points into read buffer.
+    //
+
+    bool next_line(const char *&begin, const char *&end);
+
+    void parse_line(const char *begin, const char *end, csv_record &out_rec) const;
+
+    static bool is_header(const char *begin, const char *end);
+
     static int validate_range(const char *topic, int value, int min, int max);
 
-    enum
-    {
-        CSV_DATE = 0,
-        CSV_ASK,
-        CSV_BID,
-        CSV_ASK_VOLUME,
-        CSV_BID_VOLUME,
-        CSV_TOTAL_COLUMNS
-    };
+    enum { BUFFER_SIZE = 1024 * 1024 };
 
-    enum /* 01.09.2015 00:00:00.016 */
-    {
-        CSV_DATETIME_DAY = 0,
-        CSV_DATETIME_MONTH,
-        CSV_DATETIME_YEAR,
-        CSV_DATETIME_HOUR,
-        CSV_DATETIME_MINUTE,
-        CSV_DATETIME_SECOND,
-        CSV_DATETIME_MILLIS,
-        CSV_DATETIME_TOTAL_ITEMS
-    };
+    enum { CSV_TOTAL_COLUMNS = 5 };
 
     mutable std::ifstream infile_;
     long filesize_;
+
+    //
+    // Data of file not parsed yet is in buffer between
+    // ‘begin_’ and ‘end_’. Buffer starts at file offset
+    // ‘buffer_offset_’.
+    //
+
+    std::vector<char> buffer_;
+    std::size_t begin_;
+    std::size_t end_;
+    long buffer_offset_;
+    bool eof_;
 };
 
 #endif /* __CSV_LOADER_HPP__ */
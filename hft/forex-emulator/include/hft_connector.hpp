@@ -0,0 +1,49 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_CONNECTOR_HPP__
+#define __HFT_CONNECTOR_HPP__
+
+#include <string>
+#include <vector>
+
+#include <hft_response.hpp>
+#include <csv_data_supplier.hpp>
+
+//
+// What emulator talks to. Either HFT server over
+// the wire, or instrument handlers loaded in process.
+//
+
+class hft_connector
+{
+public:
+
+    virtual ~hft_connector(void) = default;
+
+    virtual void init(const std::string &sessid, const std::vector<std::string> &instruments, bool binary_framing = false) = 0;
+
+    virtual void send_tick(const std::string &instrument, double balance, double free_margin,
+                               const csv_data_supplier::csv_record &tick_info, hft::protocol::response &rsp) = 0;
+
+    virtual void send_open_notify(const std::string &instrument, const std::string &position_id,
+                                      bool status, double price, hft::protocol::response &rsp) = 0;
+
+    virtual void send_close_notify(const std::string &instrument, const std::string &position_id,
+                                       bool status, double price, hft::protocol::response &rsp) = 0;
+};
+
+#endif /* __HFT_CONNECTOR_HPP__ */
@@ -20,8 +20,9 @@
 #include <map>
 #include <limits>
 #include <memory>
+#include <vector>
 
-#include <hft_server_connector.hpp>
+#include <hft_connector.hpp>
 #include <csv_data_supplier.hpp>
 #include <hft_instrument_property.hpp>
 #include <hft_response.hpp>
@@ -74,10 +75,18 @@ public:
     hft_forex_emulator(const std::string &host, const std::string &port, const std::string &sessid,
                            const std::map<std::string, std::string> &instrument_data, double deposit,
                                const std::string &config_file_name, bool check_bankruptcy,
-                                   bool invert_hft_decision, bool immediate_profit_withdrawal);
+                                   bool invert_hft_decision, bool immediate_profit_withdrawal,
+                                       bool binary_framing, bool in_process, std::size_t read_ahead);
 
     const emulation_result &get_result(void) const { return emulation_result_; }
 
+    //
+    // Time emulation waited for data of every
+    // instrument, in seconds. See csv_data_supplier.
+    //
+
+    std::map<std::string, double> get_data_stall_times(void) const;
+
 private:
 
     struct opened_position
@@ -123,8 +132,10 @@ private:
         };
 
         instrument_data_info(void) = delete;
-        instrument_data_info(const std::string &instr, const std::string &csv_file, const std::string &config_file_name)
-            : instrument(instr), csv_faucet(csv_file), property(instr, config_file_name), state(data_state::DS_EMPTY)
+        instrument_data_info(const std::string &instr, const std::string &csv_file, const std::string &config_file_name,
+                             std::size_t read_ahead, std::size_t order)
+            : instrument(instr), csv_faucet(csv_file, read_ahead), property(instr, config_file_name), state(data_state::DS_EMPTY),
+              rank(order)
         {}
 
         std::string instrument;
@@ -134,10 +145,28 @@ private:
         data_state state;
         csv_data_supplier::csv_record loaded;
         csv_data_supplier::csv_record official;
+
+        //
+        // Ticks of the same time are taken
+        // in order of instrument name.
+        //
+
+        std::size_t rank;
     };
 
     typedef std::map<std::string, std::shared_ptr<instrument_data_info>> instruments_info;
 
+    //
+    // Order of min-heap of instruments with
+    // loaded tick, the earliest on top.
+    //
+
+    static bool later_tick(const instrument_data_info *a, const instrument_data_info *b)
+    {
+        return a -> loaded.request_time > b -> loaded.request_time
+               || (a -> loaded.request_time == b -> loaded.request_time && a -> rank > b -> rank);
+    }
+
     void proceed(void);
 
     std::string get_progress_str(void) const;
@@ -146,6 +175,8 @@ private:
 
     bool get_record(tick_record &tick);
 
+    void load_next_record(instrument_data_info *info);
+
     void handle_response(const tick_record &tick_info, const hft::protocol::response &reply);
 
     void handle_close_position(const std::string &id, const tick_record &tick_info, bool is_forcibly = false);
@@ -175,7 +206,7 @@ private:
 
     emulation_result emulation_result_;
     opened_positions positions_;
-    hft_server_connector hft_connection_;
+    std::unique_ptr<hft_connector> hft_connection_;
 
     double balance_;
     bool check_bankruptcy_;
@@ -185,6 +216,15 @@ private:
     double total_withdrawn_;
 
     instruments_info instruments_;
+
+    //
+    // Instruments in DS_LOADED state. Instrument of the
+    // last tick taken is DS_EMPTY, it is refilled when
+    // the next tick is requested.
+    //
+
+    std::vector<instrument_data_info *> loaded_heap_;
+    instrument_data_info *drained_;
 };
 
 #endif /* __HFT_FOREX_EMULATOR_HPP__ */
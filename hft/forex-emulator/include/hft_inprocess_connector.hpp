@@ -0,0 +1,81 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_INPROCESS_CONNECTOR_HPP__
+#define __HFT_INPROCESS_CONNECTOR_HPP__
+
+#include <memory>
+#include <boost/noncopyable.hpp>
+
+#include <hft_connector.hpp>
+#include <hft_request.hpp>
+#include <instrument_handler.hpp>
+
+//
+// Runs instrument handlers of session inside emulator
+// process, requests become plain function calls. Handlers
+// get the same values they would get from the wire, so
+// results do not differ from emulation through server.
+// Session state is loaded as on server and then kept
+// in memory, the session directory is not changed by
+// emulation.
+//
+
+class hft_inprocess_connector : public hft_connector, private boost::noncopyable
+{
+public:
+
+    hft_inprocess_connector(void);
+
+    ~hft_inprocess_connector(void);
+
+    virtual void init(const std::string &sessid, const std::vector<std::string> &instruments, bool binary_framing = false);
+
+    virtual void send_tick(const std::string &instrument, double balance, double free_margin,
+                               const csv_data_supplier::csv_record &tick_info, hft::protocol::response &rsp);
+
+    virtual void send_open_notify(const std::string &instrument, const std::string &position_id,
+                                      bool status, double price, hft::protocol::response &rsp);
+
+    virtual void send_close_notify(const std::string &instrument, const std::string &position_id,
+                                       bool status, double price, hft::protocol::response &rsp);
+
+private:
+
+    template <typename T>
+    void invoke_handler(const T &msg, hft::protocol::response &rsp,
+                        void (instrument_handler::*on_request)(const T &, hft::protocol::response &));
+
+    int instrument_index(const std::string &instrument) const;
+
+    double wire_value(double value) const;
+
+    std::shared_ptr<session_state> pss_;
+    std::vector<std::unique_ptr<instrument_handler>> instrument_handlers_;
+
+    std::vector<std::string> instruments_;
+    bool binary_framing_;
+
+    //
+    // Requests are reused, as server does.
+    //
+
+    hft::protocol::request::tick tick_msg_;
+    hft::protocol::request::open_notify open_notify_msg_;
+    hft::protocol::request::close_notify close_notify_msg_;
+};
+
+#endif /* __HFT_INPROCESS_CONNECTOR_HPP__ */
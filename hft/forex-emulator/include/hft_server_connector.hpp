@@ -17,38 +17,58 @@
 #ifndef __HFT_SERVER_CONNECTION_HPP__
 #define __HFT_SERVER_CONNECTION_HPP__
 
+#include <memory>
 #include <boost/asio.hpp>
 
-#include <hft_response.hpp>
-#include <csv_data_supplier.hpp>
+#include <hft_shm_ring.hpp>
+#include <hft_connector.hpp>
 
-class hft_server_connector : private boost::noncopyable
+class hft_server_connector : public hft_connector, private boost::noncopyable
 {
 public:
 
     hft_server_connector(void) = delete;
 
+    //
+    // Host may also be given as ‘unix:/path/to/socket’
+    // or ‘shm:/name’, then port is ignored.
+    //
+
     hft_server_connector(const std::string &host, const std::string &port);
 
     ~hft_server_connector(void);
 
-    void init(const std::string &sessid, const std::vector<std::string> &instruments);
+    virtual void init(const std::string &sessid, const std::vector<std::string> &instruments, bool binary_framing = false);
 
-    void send_tick(const std::string &instrument, double balance, double free_margin,
-                       const csv_data_supplier::csv_record &tick_info, hft::protocol::response &rsp);
+    virtual void send_tick(const std::string &instrument, double balance, double free_margin,
+                               const csv_data_supplier::csv_record &tick_info, hft::protocol::response &rsp);
 
-    void send_open_notify(const std::string &instrument, const std::string &position_id,
-                              bool status, double price, hft::protocol::response &rsp);
+    virtual void send_open_notify(const std::string &instrument, const std::string &position_id,
+                                      bool status, double price, hft::protocol::response &rsp);
 
-    void send_close_notify(const std::string &instrument, const std::string &position_id,
-                               bool status, double price, hft::protocol::response &rsp);
+    virtual void send_close_notify(const std::string &instrument, const std::string &position_id,
+                                       bool status, double price, hft::protocol::response &rsp);
 
 private:
 
     std::string send_recv_server(const std::string &payload);
 
+    void send_recv_server_binary(const std::string &frame, hft::protocol::response &rsp);
+
+    std::uint16_t instrument_index(const std::string &instrument) const;
+
+    void write_server(const char *data, std::size_t length);
+
+    void fill_input(std::size_t length);
+
     boost::asio::io_context ioctx_;
-    boost::asio::ip::tcp::socket socket_;
+    boost::asio::generic::stream_protocol::socket socket_;
+    std::unique_ptr<hft::ipc::shm_client> shm_;
+    std::string input_;
+
+    std::vector<std::string> instruments_;
+    bool binary_framing_;
+    std::string frame_;
 
 };
 
@@ -0,0 +1,160 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __TICK_STORE_HPP__
+#define __TICK_STORE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <csv_loader.hpp>
+
+//
+// Columnar binary store of ticks, made from Dukascopy CSV
+// by ‘hft tick-convert’. Loaded by mapping, records come
+// as csv_loader gives them, bit for bit, with no parsing.
+//
+// Ticks are kept in blocks of up to BLOCK_RECORDS, every
+// column of block is contiguous. Prices are integers in
+// units of the last decimal place used in the block, so
+// the same double comes back. Blocks are indexed by time.
+//
+// Layout, native endian:
+//
+//   header, 64 bytes: magic ‘HFTTICK1’, u32 version,
+//                     u32 block count, u64 record count,
+//                     u64 index offset, i64 first and last
+//                     tick time in ms since epoch, 16 bytes
+//                     reserved
+//   blocks, 8 byte aligned: n × i64 time, n × f64 ask
+//                     volume, n × f64 bid volume, n × i32
+//                     ask, n × i32 bid, padding
+//   index, per block: i64 first and last tick time, u64
+//                     block offset, u32 record count,
+//                     u32 price decimals
+//
+
+class tick_store : private boost::noncopyable
+{
+public:
+
+    typedef csv_loader::csv_record csv_record;
+
+    enum { BLOCK_RECORDS = 4096 };
+
+    class writer : private boost::noncopyable
+    {
+    public:
+
+        explicit writer(const std::string &file_name);
+
+        ~writer(void);
+
+        void append(const csv_record &rec);
+
+        //
+        // Writes index and header. Store is not
+        // recognized until it is closed.
+        //
+
+        void close(void);
+
+        std::uint64_t get_record_count(void) const { return record_count_; }
+
+    private:
+
+        void flush_block(void);
+
+        std::string file_name_;
+        std::ofstream outfile_;
+
+        std::vector<std::int64_t> time_;
+        std::vector<double> ask_;
+        std::vector<double> bid_;
+        std::vector<double> ask_volume_;
+        std::vector<double> bid_volume_;
+
+        std::string index_;
+        std::uint32_t block_count_;
+        std::uint64_t record_count_;
+        std::uint64_t offset_;
+        std::int64_t first_time_;
+        std::int64_t last_time_;
+        bool closed_;
+    };
+
+    tick_store(void);
+    explicit tick_store(const std::string &file_name);
+    ~tick_store(void);
+
+    //
+    // Maps the store, throws if it is damaged.
+    //
+
+    void load(const std::string &file_name);
+
+    bool get_record(csv_record &out_rec);
+
+    int get_progress(void) const;
+
+    std::uint64_t get_record_count(void) const { return record_count_; }
+
+    static bool is_tick_store(const std::string &file_name);
+
+private:
+
+    struct block_entry
+    {
+        std::int64_t first_time;
+        std::int64_t last_time;
+        std::uint64_t offset;
+        std::uint32_t count;
+        std::uint32_t decimals;
+    };
+
+    void unload(void);
+
+    void enter_block(std::uint32_t block);
+
+    const char *base_;
+    std::size_t size_;
+
+    const block_entry *index_;
+    std::uint32_t block_count_;
+    std::uint64_t record_count_;
+
+    //
+    // Read position.
+    //
+
+    std::uint32_t block_;
+    std::uint32_t pos_;
+    std::uint64_t consumed_;
+
+    const std::int64_t *time_;
+    const double *ask_volume_;
+    const double *bid_volume_;
+    const std::int32_t *ask_;
+    const std::int32_t *bid_;
+    double scale_;
+};
+
+#endif /* __TICK_STORE_HPP__ */
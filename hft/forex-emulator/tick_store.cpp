@@ -0,0 +1,412 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <tick_store.hpp>
+#include <utilities.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace {
+
+constexpr char MAGIC[8] = {'H', 'F', 'T', 'T', 'I', 'C', 'K', '1'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t MAX_DECIMALS = 9;
+
+struct store_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t block_count;
+    std::uint64_t record_count;
+    std::uint64_t index_offset;
+    std::int64_t first_time;
+    std::int64_t last_time;
+    char reserved[16];
+};
+
+static_assert(sizeof(store_header) == 64, "Header size mismatch");
+
+//
+// Bytes taken by a record in block.
+//
+
+constexpr std::size_t RECORD_SIZE = 3 * sizeof(std::int64_t) + 2 * sizeof(std::int32_t);
+
+constexpr double POW10[MAX_DECIMALS + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+//
+// Fewest decimal places price can be written with. Integer
+// and power of ten are both exact, their quotient is rounded
+// once, as the decimal text was when parsed.
+//
+
+std::uint32_t price_decimals(double price)
+{
+    for (std::uint32_t d = 0; d <= MAX_DECIMALS; d++)
+    {
+        if (static_cast<double>(std::llround(price * POW10[d])) / POW10[d] == price)
+        {
+            return d;
+        }
+    }
+
+    throw std::runtime_error("Price ‘" + std::to_string(price) + "’ cannot be stored in tick store");
+}
+
+std::int32_t scaled_price(double price, std::uint32_t decimals)
+{
+    long long value = std::llround(price * POW10[decimals]);
+
+    if (value < std::numeric_limits<std::int32_t>::min() || value > std::numeric_limits<std::int32_t>::max())
+    {
+        throw std::runtime_error("Price ‘" + std::to_string(price) + "’ out of range of tick store");
+    }
+
+    return value;
+}
+
+} /* namespace */
+
+tick_store::writer::writer(const std::string &file_name)
+    : file_name_ {file_name}, block_count_ {0}, record_count_ {0}, offset_ {sizeof(store_header)},
+      first_time_ {0}, last_time_ {0}, closed_ {false}
+{
+    outfile_.open(file_name.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+
+    if (! outfile_.is_open())
+    {
+        throw std::runtime_error("Unable to create file ‘" + file_name + "’");
+    }
+
+    //
+    // Placeholder, real header goes at close.
+    //
+
+    store_header header {};
+
+    outfile_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+tick_store::writer::~writer(void)
+{
+    if (! closed_)
+    {
+        outfile_.close();
+    }
+}
+
+void tick_store::writer::append(const csv_record &rec)
+{
+    std::int64_t t = rec.request_time;
+
+    if (record_count_ > 0 && t < last_time_)
+    {
+        throw std::runtime_error("Ticks out of time order at ‘"
+                                 + boost::posix_time::to_simple_string(hft::utils::timestamp2ptime(t)) + "’");
+    }
+
+    if (record_count_ == 0)
+    {
+        first_time_ = t;
+    }
+
+    last_time_ = t;
+    record_count_++;
+
+    time_.push_back(t);
+    ask_.push_back(rec.ask);
+    bid_.push_back(rec.bid);
+    ask_volume_.push_back(rec.ask_volume);
+    bid_volume_.push_back(rec.bid_volume);
+
+    if (time_.size() == BLOCK_RECORDS)
+    {
+        flush_block();
+    }
+}
+
+void tick_store::writer::flush_block(void)
+{
+    std::uint32_t n = time_.size();
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    std::uint32_t decimals = 0;
+
+    for (std::uint32_t i = 0; i < n; i++)
+    {
+        decimals = std::max(decimals, price_decimals(ask_[i]));
+        decimals = std::max(decimals, price_decimals(bid_[i]));
+    }
+
+    std::vector<std::int32_t> ask(n);
+    std::vector<std::int32_t> bid(n);
+
+    for (std::uint32_t i = 0; i < n; i++)
+    {
+        ask[i] = scaled_price(ask_[i], decimals);
+        bid[i] = scaled_price(bid_[i], decimals);
+    }
+
+    outfile_.write(reinterpret_cast<const char *>(time_.data()), n * sizeof(std::int64_t));
+    outfile_.write(reinterpret_cast<const char *>(ask_volume_.data()), n * sizeof(double));
+    outfile_.write(reinterpret_cast<const char *>(bid_volume_.data()), n * sizeof(double));
+    outfile_.write(reinterpret_cast<const char *>(ask.data()), n * sizeof(std::int32_t));
+    outfile_.write(reinterpret_cast<const char *>(bid.data()), n * sizeof(std::int32_t));
+
+    if (! outfile_)
+    {
+        throw std::runtime_error("Failed to write file ‘" + file_name_ + "’");
+    }
+
+    block_entry entry {time_.front(), time_.back(), offset_, n, decimals};
+
+    index_.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+
+    block_count_++;
+    offset_ += n * RECORD_SIZE;
+
+    time_.clear();
+    ask_.clear();
+    bid_.clear();
+    ask_volume_.clear();
+    bid_volume_.clear();
+}
+
+void tick_store::writer::close(void)
+{
+    if (closed_)
+    {
+        return;
+    }
+
+    flush_block();
+
+    outfile_.write(index_.data(), index_.size());
+
+    store_header header {};
+
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.block_count = block_count_;
+    header.record_count = record_count_;
+    header.index_offset = offset_;
+    header.first_time = first_time_;
+    header.last_time = last_time_;
+
+    outfile_.seekp(0);
+    outfile_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    outfile_.close();
+
+    closed_ = true;
+
+    if (outfile_.fail())
+    {
+        throw std::runtime_error("Failed to write file ‘" + file_name_ + "’");
+    }
+}
+
+tick_store::tick_store(void)
+    : base_ {nullptr}, size_ {0}, index_ {nullptr}, block_count_ {0}, record_count_ {0},
+      block_ {0}, pos_ {0}, consumed_ {0}, time_ {nullptr}, ask_volume_ {nullptr},
+      bid_volume_ {nullptr}, ask_ {nullptr}, bid_ {nullptr}, scale_ {1.0}
+{
+}
+
+tick_store::tick_store(const std::string &file_name)
+    : tick_store()
+{
+    load(file_name);
+}
+
+tick_store::~tick_store(void)
+{
+    unload();
+}
+
+void tick_store::load(const std::string &file_name)
+{
+    unload();
+
+    int fd = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        throw std::runtime_error("Unable to open tick store ‘" + file_name + "’: " + strerror(errno));
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(store_header))
+    {
+        close(fd);
+
+        throw std::runtime_error("Bad tick store ‘" + file_name + "’");
+    }
+
+    void *base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map tick store ‘" + file_name + "’: " + strerror(error));
+    }
+
+    base_ = static_cast<const char *>(base);
+    size_ = st.st_size;
+
+    //
+    // Read sequentially, once.
+    //
+
+    madvise(base, size_, MADV_SEQUENTIAL);
+
+    store_header header;
+
+    memcpy(&header, base_, sizeof(header));
+
+    bool valid = (memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION
+                  && header.index_offset <= size_ && header.index_offset % 8 == 0
+                  && header.block_count <= (size_ - header.index_offset) / sizeof(block_entry));
+
+    if (valid)
+    {
+        index_ = reinterpret_cast<const block_entry *>(base_ + header.index_offset);
+        block_count_ = header.block_count;
+        record_count_ = header.record_count;
+
+        std::uint64_t total = 0;
+
+        for (std::uint32_t i = 0; valid && i < block_count_; i++)
+        {
+            valid = (index_[i].count > 0 && index_[i].count <= BLOCK_RECORDS
+                     && index_[i].decimals <= MAX_DECIMALS
+                     && index_[i].offset >= sizeof(store_header) && index_[i].offset % 8 == 0
+                     && index_[i].offset + index_[i].count * RECORD_SIZE <= header.index_offset);
+
+            total += index_[i].count;
+        }
+
+        valid = valid && (total == record_count_);
+    }
+
+    if (! valid)
+    {
+        unload();
+
+        throw std::runtime_error("Bad tick store ‘" + file_name + "’");
+    }
+
+    enter_block(0);
+}
+
+void tick_store::unload(void)
+{
+    if (base_ != nullptr)
+    {
+        munmap(const_cast<char *>(base_), size_);
+    }
+
+    base_ = nullptr;
+    size_ = 0;
+    index_ = nullptr;
+    block_count_ = 0;
+    record_count_ = 0;
+    block_ = 0;
+    pos_ = 0;
+    consumed_ = 0;
+}
+
+void tick_store::enter_block(std::uint32_t block)
+{
+    block_ = block;
+    pos_ = 0;
+
+    if (block_ >= block_count_)
+    {
+        return;
+    }
+
+    const block_entry &entry = index_[block_];
+    const char *p = base_ + entry.offset;
+
+    time_ = reinterpret_cast<const std::int64_t *>(p);
+    ask_volume_ = reinterpret_cast<const double *>(p + entry.count * sizeof(std::int64_t));
+    bid_volume_ = ask_volume_ + entry.count;
+    ask_ = reinterpret_cast<const std::int32_t *>(bid_volume_ + entry.count);
+    bid_ = ask_ + entry.count;
+    scale_ = POW10[entry.decimals];
+}
+
+bool tick_store::get_record(csv_record &out_rec)
+{
+    while (block_ < block_count_ && pos_ == index_[block_].count)
+    {
+        enter_block(block_ + 1);
+    }
+
+    if (block_ >= block_count_)
+    {
+        return false;
+    }
+
+    out_rec.request_time = time_[pos_];
+    out_rec.ask = ask_[pos_] / scale_;
+    out_rec.bid = bid_[pos_] / scale_;
+    out_rec.ask_volume = ask_volume_[pos_];
+    out_rec.bid_volume = bid_volume_[pos_];
+
+    pos_++;
+    consumed_++;
+
+    return true;
+}
+
+int tick_store::get_progress(void) const
+{
+    if (record_count_ == 0)
+    {
+        return 100;
+    }
+
+    return (100 * consumed_) / record_count_;
+}
+
+bool tick_store::is_tick_store(const std::string &file_name)
+{
+    char magic[sizeof(MAGIC)];
+
+    std::ifstream infile(file_name.c_str(), std::ifstream::in | std::ifstream::binary);
+
+    return infile.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
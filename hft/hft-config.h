@@ -0,0 +1,2 @@
+#define HFT_VERSION_MAJOR "4"
+#define HFT_VERSION_MINOR "19"
@@ -21,7 +21,7 @@
 
 #include <boost/program_options.hpp>
 
-#include <csv_loader.hpp>
+#include <csv_data_supplier.hpp>
 #include <hft_instrument_property.hpp>
 #include <utilities.hpp>
 
@@ -185,7 +185,7 @@ int hft_instrument_stats(int argc, char *argv[])
         hftOption(csv_file_name) = p.second;
     }
 
-    csv_loader csv{hftOption(csv_file_name)};
+    csv_data_supplier csv{hftOption(csv_file_name)};
     hft_instrument_property instrument_property{hftOption(instrument), hftOption(config_file_name)};
 
     std::map<int, counter> spreads;
@@ -198,7 +198,7 @@ int hft_instrument_stats(int argc, char *argv[])
     int bid_pips = 0;
     int spread = 0;
     int avg_course_pips = 0;
-    csv_loader::csv_record rec;
+    csv_data_supplier::csv_record rec;
 
     while (csv.get_record(rec))
     {
@@ -39,6 +39,12 @@ int draft_main(int argc, char *argv[]);
 int hft_server_main(int argc, char *argv[]);
 int hft_dukasemu_main(int argc, char *argv[]);
 int hft_instrument_stats(int argc, char *argv[]);
+int hft_benchmark_main(int argc, char *argv[]);
+int hft_ipc_benchmark_main(int argc, char *argv[]);
+int hft_csv_benchmark_main(int argc, char *argv[]);
+int hft_trace_convert_main(int argc, char *argv[]);
+int hft_tick_convert_main(int argc, char *argv[]);
+int hft_self_test_main(int argc, char *argv[]);
 
 static struct
 {
@@ -49,7 +55,13 @@ static struct
     { .tool_name = "draft",            .start_program = &draft_main },
     { .tool_name = "server",           .start_program = &hft_server_main },
     { .tool_name = "forex-emulator",   .start_program = &hft_dukasemu_main },
-    { .tool_name = "instrument-stats", .start_program = &hft_instrument_stats }
+    { .tool_name = "instrument-stats", .start_program = &hft_instrument_stats },
+    { .tool_name = "benchmark",        .start_program = &hft_benchmark_main },
+    { .tool_name = "ipc-benchmark",    .start_program = &hft_ipc_benchmark_main },
+    { .tool_name = "csv-benchmark",    .start_program = &hft_csv_benchmark_main },
+    { .tool_name = "trace-convert",    .start_program = &hft_trace_convert_main },
+    { .tool_name = "tick-convert",     .start_program = &hft_tick_convert_main },
+    { .tool_name = "self-test",        .start_program = &hft_self_test_main }
 };
 
 int main(int argc, char *argv[])
@@ -64,12 +76,24 @@ int main(int argc, char *argv[])
             std::cout << "Usage:\n"
                       << "  hft <tool> [tool options]\n\n"
                       << "Available tools:\n"
+                      << "  benchmark                 Measures request parsing cost on recorded\n"
+                      << "                            bridge traffic\n\n"
+                      << "  ipc-benchmark             Measures round trip latency of TCP, AF_UNIX\n"
+                      << "                            and shared memory transports\n\n"
+                      << "  csv-benchmark             Measures loading speed of historical CSV\n"
+                      << "                            data on a large sample\n\n"
                       << "  forex-emulator            HFT TCP Client emulates forex broker and trading\n"
                       << "                            account using historical CSV data\n\n"
                       << "  instrument-stats          Calculates various instrument statistics using\n"
                       << "                            historical CSV data\n\n"
+                      << "  self-test                 Checks wire and storage formats and metrics\n"
+                      << "                            registry, run by ctest\n\n"
                       << "  server                    HFT Trading TCP Server. Expert Advisor for\n"
-                      << "                            production and testing purposes\n\n";
+                      << "                            production and testing purposes\n\n"
+                      << "  tick-convert              Converts historical CSV data to columnar\n"
+                      << "                            tick store, loaded much faster\n\n"
+                      << "  trace-convert             Converts server trace dump to Chrome trace\n"
+                      << "                            JSON for Perfetto\n\n";
 
             return 0;
         }
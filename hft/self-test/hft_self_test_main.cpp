@@ -0,0 +1,693 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+
+#include <handler_state_store.hpp>
+#include <hft_binary_protocol.hpp>
+#include <hft_handler_resource.hpp>
+#include <metrics.hpp>
+#include <session_journal.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct self_test_options_type
+{
+    bool keep_work_dir;
+
+} self_test_options;
+
+#define hftOption(__X__) \
+    self_test_options.__X__
+
+//
+// Behavior checks of formats and registries the server
+// depends on. Every failed check is reported with its
+// line, the tool returns non-zero if any failed.
+//
+
+static int failed_checks = 0;
+
+#define hft_check(__X__) \
+    do { if (! (__X__)) { failed_checks++; std::cerr << "  FAILED " << __FILE__ << ":" << __LINE__ << ": " << #__X__ << "\n"; } } while (0)
+
+template <typename F>
+static bool throws(F f)
+{
+    try
+    {
+        f();
+    }
+    catch (const std::exception &)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+static void check_binary_framing(const std::string &)
+{
+    namespace binary = hft::protocol::binary;
+    namespace request = hft::protocol::request;
+
+    std::vector<std::string> instruments = {"EUR/USD", "GBP/USD"};
+    request::holder req;
+    std::string out;
+
+    //
+    // Requests.
+    //
+
+    binary::encode_tick(1, 1572122731000, 1.3145, 1.2456, 56432.5, 1000.25, 42, out);
+
+    hft_check(out.size() == binary::HEADER_SIZE + binary::TICK_BODY_SIZE);
+    hft_check(binary::frame_size(out.data(), binary::HEADER_SIZE - 1) == 0);
+    hft_check(binary::frame_size(out.data(), out.size()) == out.size());
+    hft_check(binary::tick_instrument(out.data()) == 1);
+
+    binary::decode_request(out.data(), instruments, req);
+
+    hft_check(req.opcode == request::tick::OPCODE);
+    hft_check(req.tick_msg.cid == 42);
+    hft_check(req.tick_msg.instrument == "GBP/USD");
+    hft_check(req.tick_msg.instrument_id == 1);
+    hft_check(req.tick_msg.request_time.millis() == 1572122731000);
+    hft_check(req.tick_msg.ask == 1.3145 && req.tick_msg.bid == 1.2456);
+    hft_check(req.tick_msg.equity == 56432.5 && req.tick_msg.free_margin == 1000.25);
+
+    out.clear();
+    binary::encode_sync(0, 1572122731000, "a87f6d", true, 1.23459, 1000, request::NO_CID, out);
+    binary::decode_request(out.data(), instruments, req);
+
+    hft_check(binary::tick_instrument(out.data()) == -1);
+    hft_check(req.opcode == request::sync::OPCODE);
+    hft_check(req.sync_msg.cid == request::NO_CID);
+    hft_check(req.sync_msg.instrument == "EUR/USD");
+    hft_check(req.sync_msg.created_on.millis() == 1572122731000);
+    hft_check(req.sync_msg.id == "a87f6d" && req.sync_msg.is_long);
+    hft_check(req.sync_msg.price == 1.23459 && req.sync_msg.qty == 1000);
+
+    out.clear();
+    binary::encode_open_notify(1, "ahd76s", true, 1.23, 7, out);
+    binary::decode_request(out.data(), instruments, req);
+
+    hft_check(req.opcode == request::open_notify::OPCODE);
+    hft_check(req.open_notify_msg.cid == 7 && req.open_notify_msg.id == "ahd76s");
+    hft_check(req.open_notify_msg.status && req.open_notify_msg.price == 1.23);
+
+    out.clear();
+    binary::encode_close_notify(1, std::string(binary::ID_SIZE, 'x'), false, 1.25, 8, out);
+    binary::decode_request(out.data(), instruments, req);
+
+    hft_check(req.opcode == request::close_notify::OPCODE);
+    hft_check(req.close_notify_msg.id == std::string(binary::ID_SIZE, 'x'));
+    hft_check(! req.close_notify_msg.status && req.close_notify_msg.price == 1.25);
+
+    //
+    // Rejected input leaves nothing behind.
+    //
+
+    out.clear();
+
+    hft_check(throws([&]() { binary::encode_sync(0, 0, std::string(binary::ID_SIZE + 1, 'x'), true, 1.0, 1, 1, out); }));
+    hft_check(out.empty());
+
+    binary::encode_tick(2, 0, 1.0, 1.0, 1.0, 1.0, 1, out);
+
+    hft_check(throws([&]() { binary::decode_request(out.data(), instruments, req); }));
+
+    out[0] = 0;
+
+    hft_check(throws([&]() { binary::frame_size(out.data(), out.size()); }));
+
+    //
+    // Responses.
+    //
+
+    hft::protocol::response resp, decoded;
+
+    resp.set_cid(5);
+    out.clear();
+    binary::encode_response(resp, 0, out);
+    binary::decode_response(out.data(), out.size(), instruments, decoded);
+
+    hft_check(out.size() == binary::HEADER_SIZE);
+    hft_check(decoded.get_cid() == 5 && ! decoded.is_error());
+    hft_check(decoded.get_instrument() == "EUR/USD");
+    hft_check(decoded.get_new_positions().empty() && decoded.get_close_positions().empty());
+
+    resp.error("Illegal request");
+    out.clear();
+    binary::encode_response(resp, binary::NO_INSTRUMENT, out);
+    binary::decode_response(out.data(), out.size(), instruments, decoded);
+
+    hft_check(decoded.is_error() && decoded.get_error_message() == "Illegal request");
+    hft_check(decoded.get_instrument().empty());
+
+    resp = hft::protocol::response();
+    resp.close_position("p1");
+    resp.open_long("p2", 0.5);
+    resp.open_short("p3", 1.5);
+    out.clear();
+    binary::encode_response(resp, 1, out);
+    binary::decode_response(out.data(), out.size(), instruments, decoded);
+
+    hft_check(out.size() == binary::HEADER_SIZE + 3 * binary::OPERATION_SIZE);
+    hft_check(! decoded.has_cid());
+    hft_check(decoded.get_close_positions().size() == 1 && decoded.get_close_positions().front() == "p1");
+    hft_check(decoded.get_new_positions().size() == 2);
+
+    if (decoded.get_new_positions().size() == 2)
+    {
+        auto &p2 = decoded.get_new_positions().front();
+        auto &p3 = decoded.get_new_positions().back();
+
+        hft_check(p2.id_ == "p2" && p2.qty_ == 0.5 && p2.pd_ == hft::protocol::response::position_direction::POSITION_LONG);
+        hft_check(p3.id_ == "p3" && p3.qty_ == 1.5 && p3.pd_ == hft::protocol::response::position_direction::POSITION_SHORT);
+    }
+
+    resp.close_position(std::string(binary::ID_SIZE + 1, 'x'));
+    out.clear();
+
+    hft_check(throws([&]() { binary::encode_response(resp, 1, out); }));
+    hft_check(out.empty());
+
+    hft_check(throws([&]() { binary::decode_response(out.data(), 0, instruments, decoded); }));
+}
+
+static void check_session_journal(const std::string &work_dir)
+{
+    el::Loggers::getLogger("session_state", true);
+
+    typedef std::tuple<std::string, std::string, std::string> record;
+
+    std::string file_name = work_dir + "/session_state.journal";
+    std::vector<record> records;
+
+    auto collect = [&](const std::string &scope, const std::string &name, const std::string &value)
+                   {
+                       records.emplace_back(scope, name, value);
+                   };
+
+    std::vector<record> expected = {
+        record {"EUR/USD", "trend", "up"},
+        record {"EUR/USD", "level", std::string(100000, 'x')},
+        record {"", "balance", ""}
+    };
+
+    {
+        session_journal journal(file_name);
+
+        hft_check(journal.generation() == 0 && journal.size() == 0);
+        hft_check(! session_journal::has_records(file_name));
+
+        std::string batch;
+
+        for (auto &r : expected)
+        {
+            session_journal::encode(batch, std::get<0>(r), std::get<1>(r), std::get<2>(r));
+        }
+
+        journal.append(batch);
+        journal.sync();
+
+        hft_check(journal.size() == batch.size());
+    }
+
+    hft_check(session_journal::has_records(file_name));
+
+    //
+    // Tail torn by crash is cut off on replay.
+    //
+
+    std::uint64_t intact_size = boost::filesystem::file_size(file_name);
+
+    {
+        std::string torn;
+
+        session_journal::encode(torn, "EUR/USD", "trend", "down");
+
+        std::ofstream out(file_name, std::ios::binary | std::ios::app);
+        out.write(torn.data(), torn.size() - 1);
+    }
+
+    //
+    // Read-only journal is replayed as it is,
+    // torn tail is not cut off.
+    //
+
+    std::uint64_t torn_size = boost::filesystem::file_size(file_name);
+
+    {
+        session_journal journal(file_name, true);
+
+        hft_check(journal.replay(collect) == expected.size());
+        hft_check(records == expected);
+        hft_check(throws([&]() { journal.reset(1); }));
+    }
+
+    hft_check(boost::filesystem::file_size(file_name) == torn_size);
+
+    {
+        session_journal journal(work_dir + "/missing.journal", true);
+
+        hft_check(journal.generation() == 0 && journal.replay(collect) == 0);
+    }
+
+    hft_check(! boost::filesystem::exists(work_dir + "/missing.journal"));
+
+    records.clear();
+
+    {
+        session_journal journal(file_name);
+
+        hft_check(journal.replay(collect) == expected.size());
+        hft_check(records == expected);
+        hft_check(boost::filesystem::file_size(file_name) == intact_size);
+
+        //
+        // Compaction starts next generation,
+        // old records are gone.
+        //
+
+        journal.reset(7);
+
+        hft_check(journal.generation() == 7 && journal.size() == 0);
+    }
+
+    hft_check(! session_journal::has_records(file_name));
+
+    {
+        session_journal journal(file_name);
+
+        hft_check(journal.generation() == 7 && journal.size() == 0);
+
+        std::string batch;
+
+        session_journal::encode(batch, "GBP/USD", "trend", "down");
+        journal.append(batch);
+    }
+
+    records.clear();
+
+    {
+        session_journal journal(file_name);
+
+        hft_check(journal.generation() == 7);
+        hft_check(journal.replay(collect) == 1);
+        hft_check(records.size() == 1 && records[0] == (record {"GBP/USD", "trend", "down"}));
+    }
+
+    //
+    // Decoding stops at the first damaged record.
+    //
+
+    std::string batch;
+
+    session_journal::encode(batch, "a", "b", "c");
+    session_journal::encode(batch, "d", "e", "f");
+
+    std::size_t first_size = batch.size() / 2;
+    std::size_t consumed;
+
+    batch[batch.size() - 1] ^= 1;
+    records.clear();
+
+    hft_check(session_journal::decode(batch.data(), batch.size(), collect, consumed) == 1);
+    hft_check(consumed == first_size && records.size() == 1);
+
+    //
+    // Scope or name too long for its u16
+    // length is not written at all.
+    //
+
+    batch.clear();
+
+    hft_check(throws([&]() { session_journal::encode(batch, std::string(0x10000, 's'), "name", "value"); }));
+    hft_check(throws([&]() { session_journal::encode(batch, "scope", std::string(0x10000, 'n'), "value"); }));
+    hft_check(batch.empty());
+
+    session_journal::encode(batch, std::string(0xffff, 's'), std::string(0xffff, 'n'), "value");
+    records.clear();
+
+    hft_check(session_journal::decode(batch.data(), batch.size(), collect, consumed) == 1);
+    hft_check(consumed == batch.size() && records.size() == 1 && std::get<1>(records[0]).size() == 0xffff);
+}
+
+static void check_handler_state_store(const std::string &work_dir)
+{
+    std::string file_name = work_dir + "/handler.state";
+
+    auto load = [&](void)
+                {
+                    std::map<std::string, std::string> values;
+                    handler_state_store store(file_name);
+
+                    store.for_each([&](char type, const std::string &name, const char *value, std::size_t length)
+                                   {
+                                       values[std::string(1, type) + name] = std::string(value, length);
+                                   });
+
+                    return values;
+                };
+
+    std::string long_name(1000, 'n');
+    std::string long_value(100000, 'v');
+
+    {
+        handler_state_store store(file_name);
+
+        int counter = 5;
+
+        store.put('i', "counter", &counter, sizeof(counter));
+        store.put('s', "counter", "five", 4);
+        store.put('s', long_name, long_value.data(), long_value.size());
+
+        //
+        // Growing value moves to larger run.
+        //
+
+        for (int i = 1; i <= 10; i++)
+        {
+            std::string grown(i * 100, 'a' + i);
+
+            store.put('s', "grown", grown.data(), grown.size());
+        }
+
+        counter = 7;
+
+        store.put('i', "counter", &counter, sizeof(counter));
+        store.sync(true);
+
+        hft_check(throws([&]() { store.put('s', std::string(handler_state_store::MAX_NAME_LENGTH + 1, 'n'), "", 0); }));
+    }
+
+    auto values = load();
+    int counter = 0;
+
+    hft_check(values.size() == 4);
+    hft_check(values["icounter"].size() == sizeof(counter));
+
+    memcpy(&counter, values["icounter"].data(), sizeof(counter));
+
+    hft_check(counter == 7);
+    hft_check(values["scounter"] == "five");
+    hft_check(values["s" + long_name] == long_value);
+    hft_check(values["sgrown"] == std::string(1000, 'a' + 10));
+
+    {
+        handler_state_store store(file_name);
+
+        counter = 9;
+
+        store.put('i', "counter", &counter, sizeof(counter));
+        store.sync(true);
+    }
+
+    //
+    // Copy torn by crash is detected,
+    // previous value is used instead.
+    //
+
+    std::string data;
+
+    {
+        std::ifstream in(file_name, std::ios::binary);
+
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::string image = std::string("counter") + std::string(reinterpret_cast<const char *>(&counter), sizeof(counter));
+    std::size_t pos = data.find(image);
+
+    hft_check(pos != std::string::npos);
+
+    if (pos != std::string::npos)
+    {
+        data[pos + image.size() - 1] ^= 1;
+
+        std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    }
+
+    values = load();
+
+    memcpy(&counter, values["icounter"].data(), sizeof(counter));
+
+    hft_check(counter == 7);
+    hft_check(values.size() == 4 && values["s" + long_name] == long_value);
+
+    //
+    // Store of no slots would never grow.
+    //
+
+    {
+        std::string header(64, '\0');
+        std::uint32_t fields[3] = {2, handler_state_store::SLOT_SIZE, 0};
+
+        memcpy(&header[0], "HFTHSTA1", 8);
+        memcpy(&header[8], fields, sizeof(fields));
+
+        std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+        out.write(header.data(), header.size());
+    }
+
+    hft_check(throws([&]() { handler_state_store store(file_name); }));
+}
+
+static void check_metrics_registry(const std::string &)
+{
+    //
+    // Handles are live once service is enabled. Listener
+    // takes any free port, it is never run here.
+    //
+
+    boost::asio::io_context ioctx;
+
+    metrics::create_server(ioctx, "127.0.0.1", 0);
+
+    metrics::counter c1 = metrics::make_counter("hft_self_test_requests_total", "Requests",
+                                                {{"session", "s1"}, {"instrument", "EUR/USD"}});
+    metrics::counter c2 = metrics::make_counter("hft_self_test_requests_total", "Requests",
+                                                {{"instrument", "EUR/USD"}, {"session", "s1"}});
+    metrics::counter c3 = metrics::make_counter("hft_self_test_requests_total", "Requests",
+                                                {{"session", "s\"2\""}, {"instrument", "EUR/USD"}});
+
+    c1.increment(3);
+    c2.increment(2);
+    c3.increment();
+
+    metrics::make_gauge("hft_self_test_level", "Level", {}).set(1.5);
+
+    metrics::histogram h = metrics::make_histogram("hft_self_test_seconds", "Seconds", {1, 5}, {{"session", "s1"}});
+
+    h.observe(0.5);
+    h.observe(3);
+    h.observe(10);
+
+    std::string text = metrics::produce_text_format();
+
+    auto contains = [&](const std::string &line) { return text.find(line + "\n") != std::string::npos; };
+
+    hft_check(contains("# TYPE hft_self_test_requests_total counter"));
+    hft_check(contains("hft_self_test_requests_total{instrument=\"EUR/USD\",session=\"s1\"} 5"));
+    hft_check(contains("hft_self_test_requests_total{instrument=\"EUR/USD\",session=\"s\\\"2\\\"\"} 1"));
+    hft_check(contains("hft_self_test_level 1.5"));
+    hft_check(contains("hft_self_test_seconds_bucket{session=\"s1\",le=\"1\"} 1"));
+    hft_check(contains("hft_self_test_seconds_bucket{session=\"s1\",le=\"5\"} 2"));
+    hft_check(contains("hft_self_test_seconds_bucket{session=\"s1\",le=\"+Inf\"} 3"));
+    hft_check(contains("hft_self_test_seconds_sum{session=\"s1\"} 13.5"));
+    hft_check(contains("hft_self_test_seconds_count{session=\"s1\"} 3"));
+
+    //
+    // Series keeps its type and buckets,
+    // existing one is no exception.
+    //
+
+    hft_check(throws([]() { metrics::make_gauge("hft_self_test_requests_total", "Requests", {{"session", "s1"}, {"instrument", "EUR/USD"}}); }));
+    hft_check(throws([]() { metrics::make_gauge("hft_self_test_requests_total", "Requests", {}); }));
+    hft_check(throws([]() { metrics::make_histogram("hft_self_test_seconds", "Seconds", {1, 10}, {{"session", "s1"}}); }));
+    hft_check(throws([]() { metrics::make_histogram("hft_self_test_unsorted", "Unsorted", {5, 1}, {}); }));
+    hft_check(throws([]() { metrics::make_counter("1_self_test", "Invalid", {}); }));
+    hft_check(throws([]() { metrics::make_counter("hft_self_test_labels", "Invalid", {{"bad-label", "x"}}); }));
+}
+
+//
+// Every file under ‘dir’, by path, with its content.
+//
+
+static std::map<std::string, std::string> directory_contents(const std::string &dir)
+{
+    std::map<std::string, std::string> contents;
+
+    for (auto &entry : boost::filesystem::recursive_directory_iterator(dir))
+    {
+        if (boost::filesystem::is_regular_file(entry.path()))
+        {
+            std::ifstream in(entry.path().string(), std::ios::binary);
+
+            contents[entry.path().string()].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+    }
+
+    return contents;
+}
+
+static void check_in_memory_handler_resource(const std::string &work_dir)
+{
+    std::string dir = work_dir + "/in-memory";
+    std::string store_name = dir + "/handler.state";
+    std::string legacy_name = dir + "/legacy/handler.state";
+
+    boost::filesystem::create_directories(dir + "/legacy");
+
+    {
+        hft_handler_resource hs(store_name, "handler_self_test");
+
+        hs.set_int_var("counter", 5);
+        hs.set_string_var("trend", "up");
+        hs.persistent();
+    }
+
+    {
+        std::ofstream out(legacy_name, std::ios::binary);
+        out << "i;counter;3\n";
+    }
+
+    auto before = directory_contents(dir);
+
+    //
+    // Emulation reads what handler saved on server,
+    // changes it in memory, writes nothing back.
+    //
+
+    {
+        hft_handler_resource hs(store_name, "handler_self_test", false, true);
+
+        hs.persistent();
+
+        hft_check(hs.get_int_var("counter") == 5 && hs.get_string_var("trend") == "up");
+
+        hs.set_int_var("counter", 6);
+        hs.set_string_var("trend", std::string(1000, 'd'));
+        hs.set_double_var("level", 1.5);
+        hs.save();
+
+        hft_check(hs.get_int_var("counter") == 6 && hs.get_double_var("level") == 1.5);
+    }
+
+    {
+        hft_handler_resource hs(legacy_name, "handler_self_test", false, true);
+
+        hs.persistent();
+
+        hft_check(hs.get_int_var("counter") == 3);
+
+        hs.set_int_var("counter", 4);
+        hs.save();
+    }
+
+    hft_check(directory_contents(dir) == before);
+}
+
+typedef void (*check)(const std::string &work_dir);
+
+static struct
+{
+    const char *check_name;
+    check run_check;
+
+} hft_checks[] = {
+    { .check_name = "binary-framing",           .run_check = &check_binary_framing },
+    { .check_name = "session-journal",          .run_check = &check_session_journal },
+    { .check_name = "handler-state",            .run_check = &check_handler_state_store },
+    { .check_name = "in-memory-handler-state",  .run_check = &check_in_memory_handler_resource },
+    { .check_name = "metrics-registry",         .run_check = &check_metrics_registry }
+};
+
+int hft_self_test_main(int argc, char *argv[])
+{
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("self-test", "")
+    ;
+
+    prog_opts::options_description desc("Options for self-test");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("keep,k", prog_opts::bool_switch(&hftOption(keep_work_dir)) -> default_value(false), "Keep files written by checks")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    boost::filesystem::path work_dir = boost::filesystem::temp_directory_path()
+                                       / boost::filesystem::unique_path("hft-self-test-%%%%-%%%%");
+
+    boost::filesystem::create_directories(work_dir);
+
+    for (auto &c : hft_checks)
+    {
+        int failed_before = failed_checks;
+
+        try
+        {
+            c.run_check(work_dir.string());
+        }
+        catch (const std::exception &e)
+        {
+            failed_checks++;
+            std::cerr << "  FAILED " << c.check_name << ": " << e.what() << "\n";
+        }
+
+        std::cout << (failed_checks == failed_before ? "ok      " : "FAILED  ") << c.check_name << "\n";
+    }
+
+    if (hftOption(keep_work_dir))
+    {
+        std::cout << "Files kept in ‘" << work_dir.string() << "’\n";
+    }
+    else
+    {
+        boost::filesystem::remove_all(work_dir);
+    }
+
+    return failed_checks == 0 ? 0 : 1;
+}
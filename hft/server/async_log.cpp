@@ -0,0 +1,770 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <async_log.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <easylogging++.h>
+
+namespace {
+
+constexpr int MAX_TARGETS = 64;
+constexpr int NO_TARGET = -1;
+
+//
+// Log file. Opened by the first producer logging into it,
+// written only by the writer thread. Targets are never
+// removed, producers refer to them by index.
+//
+
+struct target
+{
+    std::string filename;
+    std::size_t max_size;
+    int fd;
+
+    //
+    // Writer side.
+    //
+
+    std::uint64_t size;
+    std::string batch;
+    std::uint64_t dropped_reported;
+
+    std::atomic<std::uint64_t> dropped;
+};
+
+//
+// Bounded multi-producer single-consumer queue, cell
+// sequence numbers tell producers and consumer whose
+// turn it is (D. Vyukov's bounded queue).
+//
+
+struct cell
+{
+    std::atomic<std::size_t> sequence;
+    std::string line;
+    int target;
+};
+
+class dispatcher
+{
+public:
+
+    dispatcher(std::size_t capacity, async_log::overflow_policy policy)
+        : cells_(capacity), mask_ {capacity - 1}, enqueue_pos_ {0}, dequeue_pos_ {0},
+          written_ {0}, policy_ {policy}, sleeping_ {false}, terminate_ {false}, targets_count_ {0}
+    {
+        for (std::size_t i = 0; i < capacity; i++)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        thread_ = std::thread(&dispatcher::run, this);
+    }
+
+    ~dispatcher(void)
+    {
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+            terminate_ = true;
+            cv_.notify_one();
+        }
+
+        thread_.join();
+
+        for (int i = 0; i < targets_count_.load(); i++)
+        {
+            close(targets_[i].fd);
+        }
+    }
+
+    int get_target(const std::string &filename, std::size_t max_size);
+
+    //
+    // With ‘wait_written’ returns only when the line
+    // is in the file, used for fatal messages.
+    //
+
+    void push(int target, std::string &line, bool wait_written);
+
+    std::uint64_t dropped(void) const
+    {
+        std::uint64_t total = 0;
+
+        for (int i = 0; i < targets_count_.load(); i++)
+        {
+            total += targets_[i].dropped.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+private:
+
+    bool try_push(int target, std::string &line, std::size_t &ticket);
+
+    void wake_writer(void);
+
+    bool queue_empty(void) const
+    {
+        return cells_[dequeue_pos_ & mask_].sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+
+    void run(void);
+
+    std::size_t drain(void);
+
+    void write_out(target &t);
+
+    std::vector<cell> cells_;
+    const std::size_t mask_;
+    std::atomic<std::size_t> enqueue_pos_;
+    std::size_t dequeue_pos_;
+
+    //
+    // Lines already in files, in queue order.
+    //
+
+    std::atomic<std::size_t> written_;
+
+    const async_log::overflow_policy policy_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::atomic<bool> sleeping_;
+    bool terminate_;
+
+    std::mutex targets_mtx_;
+    target targets_[MAX_TARGETS];
+    std::atomic<int> targets_count_;
+
+    std::thread thread_;
+};
+
+int dispatcher::get_target(const std::string &filename, std::size_t max_size)
+{
+    std::lock_guard<std::mutex> lck(targets_mtx_);
+
+    int count = targets_count_.load();
+
+    for (int i = 0; i < count; i++)
+    {
+        if (targets_[i].filename == filename)
+        {
+            return i;
+        }
+    }
+
+    if (count == MAX_TARGETS)
+    {
+        std::cerr << "Too many log files, ‘" << filename << "’ is not logged\n";
+
+        return NO_TARGET;
+    }
+
+    int fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd == -1)
+    {
+        std::cerr << "Unable to open log file ‘" << filename << "’: " << strerror(errno) << "\n";
+
+        return NO_TARGET;
+    }
+
+    struct stat st;
+
+    target &t = targets_[count];
+    t.filename = filename;
+    t.max_size = max_size;
+    t.fd = fd;
+    t.size = (fstat(fd, &st) == 0 ? st.st_size : 0);
+    t.dropped_reported = 0;
+    t.dropped.store(0);
+
+    //
+    // Published after filling, writer reads
+    // target only after line referring to it.
+    //
+
+    targets_count_.store(count + 1);
+
+    return count;
+}
+
+bool dispatcher::try_push(int target, std::string &line, std::size_t &ticket)
+{
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    cell *c;
+
+    for (;;)
+    {
+        c = &cells_[pos & mask_];
+
+        std::size_t sequence = c -> sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    c -> line.swap(line);
+    c -> target = target;
+    c -> sequence.store(pos + 1, std::memory_order_release);
+
+    ticket = pos;
+
+    return true;
+}
+
+void dispatcher::wake_writer(void)
+{
+    //
+    // Pairs with the fence of writer going to sleep:
+    // either writer sees the line, or we see it asleep.
+    //
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (sleeping_.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        cv_.notify_one();
+    }
+}
+
+void dispatcher::push(int target, std::string &line, bool wait_written)
+{
+    std::size_t ticket;
+
+    while (! try_push(target, line, ticket))
+    {
+        if (policy_ == async_log::overflow_policy::DROP && ! wait_written)
+        {
+            targets_[target].dropped.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+        }
+
+        wake_writer();
+        std::this_thread::yield();
+    }
+
+    wake_writer();
+
+    while (wait_written && written_.load(std::memory_order_acquire) <= ticket)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void dispatcher::run(void)
+{
+    for (;;)
+    {
+        if (drain() > 0)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lck(mtx_);
+
+        if (terminate_)
+        {
+            break;
+        }
+
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        cv_.wait(lck, [this](void) { return terminate_ || ! queue_empty(); });
+
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+
+    //
+    // Producers are gone, but lines queued before
+    // termination still have to reach files.
+    //
+
+    drain();
+}
+
+std::size_t dispatcher::drain(void)
+{
+    std::size_t count = 0;
+
+    //
+    // Batch is bounded by queue capacity, so busy
+    // producers cannot keep lines in memory forever.
+    //
+
+    while (count <= mask_ && ! queue_empty())
+    {
+        cell &c = cells_[dequeue_pos_ & mask_];
+
+        if (c.target != NO_TARGET)
+        {
+            targets_[c.target].batch += c.line;
+        }
+
+        c.line.clear();
+        c.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+
+        dequeue_pos_++;
+        count++;
+    }
+
+    int targets_count = targets_count_.load();
+
+    for (int i = 0; i < targets_count; i++)
+    {
+        target &t = targets_[i];
+
+        std::uint64_t dropped = t.dropped.load(std::memory_order_relaxed);
+
+        if (dropped != t.dropped_reported)
+        {
+            t.batch += "*** " + std::to_string(dropped - t.dropped_reported) + " log lines dropped, log queue full\n";
+            t.dropped_reported = dropped;
+        }
+
+        if (! t.batch.empty())
+        {
+            write_out(t);
+        }
+    }
+
+    written_.store(dequeue_pos_, std::memory_order_release);
+
+    return count;
+}
+
+void dispatcher::write_out(target &t)
+{
+    const char *data = t.batch.data();
+    std::size_t left = t.batch.size();
+
+    while (left > 0)
+    {
+        ssize_t n = write(t.fd, data, left);
+
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            std::cerr << "Unable to write log to file ‘" << t.filename << "’: " << strerror(errno) << "\n";
+
+            break;
+        }
+
+        data += n;
+        left -= n;
+    }
+
+    t.size += t.batch.size() - left;
+    t.batch.clear();
+
+    //
+    // The same as easylogging++ does: file
+    // is truncated when it gets too big.
+    //
+
+    if (t.max_size > 0 && t.size >= t.max_size)
+    {
+        if (ftruncate(t.fd, 0) == 0)
+        {
+            t.size = 0;
+        }
+    }
+}
+
+//
+// Formatting of log line into caller's buffer. Does what
+// easylogging++ log builder does for specifiers left in
+// format after configuration, without building temporary
+// strings for every line. Formats it does not cover go
+// through log builder.
+//
+
+void append_number(std::string &out, unsigned long n, int width)
+{
+    char digits[24];
+    int len = 0;
+
+    do
+    {
+        digits[len++] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    }
+    while (n > 0 && len < static_cast<int>(sizeof(digits)));
+
+    for (int i = len; i < width; i++)
+    {
+        out += '0';
+    }
+
+    while (len > 0)
+    {
+        out += digits[--len];
+    }
+}
+
+void append_datetime(std::string &out, const std::string &format, const el::base::SubsecondPrecision &ssp)
+{
+    struct timeval tv;
+    el::base::utils::DateTime::gettimeofday(&tv);
+
+    //
+    // Broken-down time changes once a second,
+    // conversion is redone only then.
+    //
+
+    thread_local time_t last_sec = -1;
+    thread_local struct tm tm_cache;
+
+    if (tv.tv_sec != last_sec)
+    {
+        localtime_r(&tv.tv_sec, &tm_cache);
+        last_sec = tv.tv_sec;
+    }
+
+    const struct tm &t = tm_cache;
+
+    for (std::size_t i = 0; i < format.length(); i++)
+    {
+        if (format[i] != '%' || i + 1 == format.length())
+        {
+            out += format[i];
+
+            continue;
+        }
+
+        switch (format[++i])
+        {
+            case '%': out += '%'; break;
+            case 'd': append_number(out, t.tm_mday, 2); break;
+            case 'a': out += el::base::consts::kDaysAbbrev[t.tm_wday]; break;
+            case 'A': out += el::base::consts::kDays[t.tm_wday]; break;
+            case 'M': append_number(out, t.tm_mon + 1, 2); break;
+            case 'b': out += el::base::consts::kMonthsAbbrev[t.tm_mon]; break;
+            case 'B': out += el::base::consts::kMonths[t.tm_mon]; break;
+            case 'y': append_number(out, (t.tm_year + el::base::consts::kYearBase) % 100, 2); break;
+            case 'Y': append_number(out, t.tm_year + el::base::consts::kYearBase, 4); break;
+            case 'h': append_number(out, t.tm_hour % 12, 2); break;
+            case 'H': append_number(out, t.tm_hour, 2); break;
+            case 'm': append_number(out, t.tm_min, 2); break;
+            case 's': append_number(out, t.tm_sec, 2); break;
+            case 'z':
+            case 'g': append_number(out, tv.tv_usec / ssp.m_offset, ssp.m_width); break;
+            case 'F': out += (t.tm_hour >= 12 ? el::base::consts::kPm : el::base::consts::kAm); break;
+        }
+    }
+}
+
+void append_base_filename(std::string &out, const std::string &path)
+{
+    std::size_t slash = path.find_last_of('/');
+
+    out.append(path, (slash == std::string::npos ? 0 : slash + 1), std::string::npos);
+}
+
+enum specifier
+{
+    SPEC_DATETIME = 1,
+    SPEC_MESSAGE  = 2,
+    SPEC_APP      = 4,
+    SPEC_FUNC     = 8,
+    SPEC_FBASE    = 16,
+    SPEC_LINE     = 32,
+    SPEC_VLEVEL   = 64
+};
+
+struct specifier_name
+{
+    const char *name;
+    std::size_t length;
+    specifier id;
+};
+
+const specifier_name specifier_names[] = {
+    {"%datetime", 9, SPEC_DATETIME},
+    {"%msg",      4, SPEC_MESSAGE},
+    {"%app",      4, SPEC_APP},
+    {"%func",     5, SPEC_FUNC},
+    {"%fbase",    6, SPEC_FBASE},
+    {"%line",     5, SPEC_LINE},
+    {"%vlevel",   7, SPEC_VLEVEL}
+};
+
+//
+// False when format holds specifier not covered here,
+// line is left untouched then.
+//
+
+bool format_line(const el::LogMessage *msg, std::string &line)
+{
+    el::base::TypedConfigurations *tc = msg -> logger() -> typedConfigurations();
+    const el::base::LogFormat &lf = tc -> logFormat(msg -> level());
+
+    if (lf.hasFlag(el::base::FormatFlags::ThreadId) || lf.hasFlag(el::base::FormatFlags::File)
+            || lf.hasFlag(el::base::FormatFlags::Location) || ! ELPP -> customFormatSpecifiers() -> empty())
+    {
+        return false;
+    }
+
+    const std::string &format = lf.format();
+    int done = 0;
+
+    for (std::size_t i = 0; i < format.length(); i++)
+    {
+        if (format[i] != '%')
+        {
+            line += format[i];
+
+            continue;
+        }
+
+        //
+        // Escaped specifier, ‘%%msg’, stays in line
+        // as ‘%msg’, like with log builder.
+        //
+
+        bool escaped = (i + 1 < format.length() && format[i + 1] == '%');
+        const specifier_name *spec = nullptr;
+
+        for (auto &sn : specifier_names)
+        {
+            if (format.compare(i + escaped, sn.length, sn.name) == 0)
+            {
+                spec = &sn;
+
+                break;
+            }
+        }
+
+        if (spec == nullptr || (done & spec -> id))
+        {
+            line += format[i];
+
+            continue;
+        }
+
+        if (escaped)
+        {
+            line.append(spec -> name, spec -> length);
+            i += spec -> length;
+
+            continue;
+        }
+
+        switch (spec -> id)
+        {
+            case SPEC_DATETIME:
+                 append_datetime(line, lf.dateTimeFormat(), tc -> subsecondPrecision(msg -> level()));
+                 break;
+            case SPEC_MESSAGE:
+                 line += msg -> message();
+                 break;
+            case SPEC_APP:
+                 line += msg -> logger() -> parentApplicationName();
+                 break;
+            case SPEC_FUNC:
+                 line += msg -> func();
+                 break;
+            case SPEC_FBASE:
+                 append_base_filename(line, msg -> file());
+                 break;
+            case SPEC_LINE:
+                 append_number(line, msg -> line(), 0);
+                 break;
+            case SPEC_VLEVEL:
+                 if (msg -> level() == el::Level::Verbose)
+                 {
+                     append_number(line, msg -> verboseLevel(), 0);
+                 }
+                 else
+                 {
+                     line.append(spec -> name, spec -> length);
+                 }
+                 break;
+        }
+
+        done |= spec -> id;
+        i += spec -> length - 1;
+    }
+
+    line += '\n';
+
+    return true;
+}
+
+std::unique_ptr<dispatcher> log_dispatcher;
+
+class async_dispatch_callback : public el::LogDispatchCallback
+{
+protected:
+
+    void handle(const el::LogDispatchData *data) override
+    {
+        if (data -> dispatchAction() != el::base::DispatchAction::NormalLog)
+        {
+            return;
+        }
+
+        const el::LogMessage *msg = data -> logMessage();
+        el::base::TypedConfigurations *tc = msg -> logger() -> typedConfigurations();
+
+        bool to_file = tc -> toFile(msg -> level());
+        bool to_stdout = tc -> toStandardOutput(msg -> level());
+
+        if (! to_file && ! to_stdout)
+        {
+            return;
+        }
+
+        //
+        // Formatted here, on the calling thread, into buffer
+        // of the thread, then swapped into queue cell without
+        // copying. Thread gets back buffer of the cell, which
+        // writer has emptied, so buffers circulate between
+        // threads and queue and the hot path does not
+        // allocate once they have grown.
+        //
+
+        thread_local std::string line;
+
+        line.clear();
+
+        if (! format_line(msg, line))
+        {
+            line = msg -> logger() -> logBuilder() -> build(msg, true);
+        }
+
+        if (to_stdout)
+        {
+            std::string out = line;
+
+            if (el::Loggers::hasFlag(el::LoggingFlag::ColoredTerminalOutput))
+            {
+                msg -> logger() -> logBuilder() -> convertToColoredOutput(&out, msg -> level());
+            }
+
+            std::cout << out << std::flush;
+        }
+
+        if (to_file)
+        {
+            //
+            // Loggers of one process mostly share single
+            // file, last one is remembered per thread.
+            //
+
+            thread_local std::string last_filename;
+            thread_local int last_target = NO_TARGET;
+
+            const std::string &filename = tc -> filename(msg -> level());
+
+            if (last_target == NO_TARGET || filename != last_filename)
+            {
+                last_target = log_dispatcher -> get_target(filename, tc -> maxLogFileSize(msg -> level()));
+                last_filename = filename;
+            }
+
+            if (last_target != NO_TARGET)
+            {
+                log_dispatcher -> push(last_target, line, msg -> level() == el::Level::Fatal);
+            }
+        }
+    }
+};
+
+const char *ASYNC_CALLBACK_ID = "async_log";
+const char *DEFAULT_CALLBACK_ID = "DefaultLogDispatchCallback";
+
+} /* namespace */
+
+namespace async_log {
+
+void start(std::size_t queue_capacity, overflow_policy policy)
+{
+    if (log_dispatcher)
+    {
+        return;
+    }
+
+    std::size_t capacity = 2;
+
+    while (capacity < queue_capacity)
+    {
+        capacity <<= 1;
+    }
+
+    log_dispatcher.reset(new dispatcher(capacity, policy));
+
+    el::Helpers::installLogDispatchCallback<async_dispatch_callback>(ASYNC_CALLBACK_ID);
+    el::Helpers::uninstallLogDispatchCallback<el::base::DefaultLogDispatchCallback>(DEFAULT_CALLBACK_ID);
+}
+
+void stop(void)
+{
+    if (! log_dispatcher)
+    {
+        return;
+    }
+
+    el::Helpers::installLogDispatchCallback<el::base::DefaultLogDispatchCallback>(DEFAULT_CALLBACK_ID);
+    el::Helpers::uninstallLogDispatchCallback<async_dispatch_callback>(ASYNC_CALLBACK_ID);
+
+    log_dispatcher.reset();
+}
+
+std::uint64_t dropped(void)
+{
+    return (log_dispatcher ? log_dispatcher -> dropped() : 0);
+}
+
+} /* namespace async_log */
@@ -58,18 +58,29 @@ deallocator::resource::~resource(void)
 
 void deallocator::resource::cleanup(void)
 {
-    std::set<void *>::iterator it;
+    void *obj;
 
     while (true)
     {
-        it = registered_.begin();
+        //
+        // Lock is released before delete, since
+        // operator delete unregisters the object.
+        //
 
-        if (it == registered_.end())
         {
-            break;
+            std::lock_guard<std::mutex> lck(mtx_);
+
+            auto it = registered_.begin();
+
+            if (it == registered_.end())
+            {
+                break;
+            }
+
+            obj = *it;
         }
 
-        delete reinterpret_cast<deallocator *>(*it);
+        delete reinterpret_cast<deallocator *>(obj);
     }
 }
 
@@ -80,6 +91,8 @@ void deallocator::resource::register_object(void *obj)
               << obj << "]\n";
     #endif
 
+    std::lock_guard<std::mutex> lck(mtx_);
+
     registered_.insert(obj);
 }
 
@@ -90,5 +103,7 @@ void deallocator::resource::unregister_object(void *obj)
               << obj << "]\n";
     #endif
 
+    std::lock_guard<std::mutex> lck(mtx_);
+
     registered_.erase(obj);
 }
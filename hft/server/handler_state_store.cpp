@@ -0,0 +1,440 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <handler_state_store.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/crc.hpp>
+
+namespace {
+
+constexpr char MAGIC[8] = {'H', 'F', 'T', 'H', 'S', 'T', 'A', '1'};
+constexpr std::uint32_t VERSION = 2;
+
+struct store_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slot_size;
+    std::uint32_t slot_count;
+    char reserved[44];
+};
+
+static_assert(sizeof(store_header) == 64, "Header size mismatch");
+
+struct copy_header
+{
+    std::uint8_t type;
+    std::uint8_t copy;
+    std::uint16_t name_length;
+    std::uint32_t run;
+    std::uint32_t value_length;
+    std::uint32_t sequence;
+    std::uint32_t crc;
+    std::uint32_t reserved2;
+};
+
+static_assert(sizeof(copy_header) == 24, "Copy header size mismatch");
+
+std::uint32_t copy_crc(const copy_header &h, const char *name, const void *value)
+{
+    copy_header zeroed = h;
+    zeroed.crc = 0;
+
+    boost::crc_32_type crc;
+
+    crc.process_bytes(&zeroed, sizeof(zeroed));
+    crc.process_bytes(name, h.name_length);
+    crc.process_bytes(value, h.value_length);
+
+    return crc.checksum();
+}
+
+std::size_t slots_needed(std::size_t name_length, std::size_t value_length)
+{
+    return (sizeof(copy_header) + name_length + value_length + handler_state_store::SLOT_SIZE - 1) / handler_state_store::SLOT_SIZE;
+}
+
+//
+// Sequence numbers wrap around.
+//
+
+bool newer(std::uint32_t a, std::uint32_t b)
+{
+    return static_cast<std::int32_t>(a - b) > 0;
+}
+
+//
+// Copy is intact when it is not free, fits in its
+// run and in ‘available’ bytes and its CRC matches.
+//
+
+bool valid_copy(const char *s, std::size_t available, copy_header &h)
+{
+    memcpy(&h, s, sizeof(h));
+
+    std::size_t length = sizeof(copy_header) + h.name_length + static_cast<std::size_t>(h.value_length);
+
+    return h.type != 0 && h.copy < 2 && h.run != 0
+           && length <= static_cast<std::size_t>(h.run) * handler_state_store::SLOT_SIZE && length <= available
+           && copy_crc(h, s + sizeof(h), s + sizeof(h) + h.name_length) == h.crc;
+}
+
+} /* namespace */
+
+handler_state_store::handler_state_store(const std::string &file_name, bool read_only)
+    : file_name_ {file_name}, read_only_ {read_only}, fd_ {-1}, base_ {nullptr}, size_ {0},
+      slot_count_ {0}, used_ {0}, dirty_begin_ {0}, dirty_end_ {0}
+{
+    fd_ = (read_only_ ? open(file_name_.c_str(), O_RDONLY | O_CLOEXEC)
+                      : open(file_name_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+
+    if (fd_ == -1)
+    {
+        throw std::runtime_error("Unable to open handler state ‘" + file_name_ + "’: " + strerror(errno));
+    }
+
+    struct stat st;
+
+    if (fstat(fd_, &st) == -1)
+    {
+        int error = errno;
+        close(fd_);
+
+        throw std::runtime_error("Unable to stat handler state ‘" + file_name_ + "’: " + strerror(error));
+    }
+
+    try
+    {
+        if (st.st_size == 0 && ! read_only_)
+        {
+            //
+            // New store.
+            //
+
+            if (ftruncate(fd_, HEADER_SIZE + INITIAL_SLOT_COUNT * SLOT_SIZE) == -1)
+            {
+                throw std::runtime_error("Unable to size handler state ‘" + file_name_ + "’: " + strerror(errno));
+            }
+
+            map(INITIAL_SLOT_COUNT);
+
+            store_header header {};
+
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.slot_size = SLOT_SIZE;
+            header.slot_count = slot_count_;
+
+            memcpy(base_, &header, sizeof(header));
+
+            dirty_begin_ = 0;
+            dirty_end_ = size_;
+
+            return;
+        }
+
+        store_header header;
+
+        if (static_cast<std::size_t>(st.st_size) < sizeof(header)
+                || pread(fd_, &header, sizeof(header), 0) != sizeof(header)
+                || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+                || header.version != VERSION
+                || header.slot_size != SLOT_SIZE
+                || header.slot_count == 0
+                || static_cast<std::size_t>(st.st_size) < HEADER_SIZE + static_cast<std::size_t>(header.slot_count) * SLOT_SIZE)
+        {
+            throw std::runtime_error("Bad handler state ‘" + file_name_ + "’");
+        }
+
+        map(header.slot_count);
+    }
+    catch (...)
+    {
+        unmap();
+        close(fd_);
+
+        throw;
+    }
+
+    //
+    // Index of variables. Slot is taken for start of
+    // copy only if the copy is intact, otherwise scan
+    // goes on with the next slot. Of two runs of the
+    // same variable, left by crash in the middle of
+    // move, the newer one is current.
+    //
+
+    std::uint32_t i = 0;
+
+    while (i < slot_count_)
+    {
+        copy_header h;
+
+        if (! valid_copy(slot(i), static_cast<std::size_t>(slot_count_ - i) * SLOT_SIZE, h) || h.copy * h.run > i - used_
+                || i - h.copy * h.run + 2 * static_cast<std::uint64_t>(h.run) > slot_count_)
+        {
+            i++;
+
+            continue;
+        }
+
+        entry e {i - h.copy * h.run, h.run, h.sequence, h.copy};
+        copy_header other;
+
+        if (valid_copy(copy(e, 1 - h.copy), static_cast<std::size_t>(e.run) * SLOT_SIZE, other) && other.type == h.type && other.run == h.run
+                && other.copy == 1 - h.copy && newer(other.sequence, h.sequence))
+        {
+            e.current = 1 - h.copy;
+            e.sequence = other.sequence;
+        }
+
+        std::string key = std::string(1, static_cast<char>(h.type))
+                          + std::string(copy(e, e.current) + sizeof(copy_header), h.name_length);
+
+        auto it = index_.find(key);
+
+        if (it == index_.end() || newer(e.sequence, it -> second.sequence))
+        {
+            index_[key] = e;
+        }
+
+        i = e.first + 2 * e.run;
+        used_ = i;
+    }
+}
+
+handler_state_store::~handler_state_store(void)
+{
+    unmap();
+    close(fd_);
+}
+
+void handler_state_store::for_each(const visitor &v) const
+{
+    for (auto &item : index_)
+    {
+        const char *s = copy(item.second, item.second.current);
+
+        copy_header h;
+        memcpy(&h, s, sizeof(h));
+
+        v(item.first[0], item.first.substr(1), s + sizeof(h) + h.name_length, h.value_length);
+    }
+}
+
+void handler_state_store::put(char type, const std::string &name, const void *value, std::size_t length)
+{
+    if (read_only_)
+    {
+        throw std::runtime_error("Handler state ‘" + file_name_ + "’ is read only");
+    }
+
+    if (type == 0 || name.size() > MAX_NAME_LENGTH || length > MAX_VALUE_LENGTH)
+    {
+        throw std::runtime_error("Variable ‘" + name + "’ does not fit handler state");
+    }
+
+    std::string key = std::string(1, type) + name;
+    std::uint32_t need = slots_needed(name.size(), length);
+
+    auto it = index_.find(key);
+
+    if (it != index_.end() && need <= it -> second.run)
+    {
+        //
+        // Current copy stays intact until
+        // the other one is complete.
+        //
+
+        entry &e = it -> second;
+        int other = 1 - e.current;
+
+        write_copy(e, other, e.sequence + 1, type, name, value, length);
+        touch(copy(e, other), static_cast<std::size_t>(e.run) * SLOT_SIZE);
+
+        e.current = other;
+        e.sequence++;
+
+        return;
+    }
+
+    //
+    // New variable, or one outgrowing its run. Run is at
+    // least doubled, so growing value moves only a few
+    // times. Old run is freed once the new one is on disk,
+    // pages are not written back in order otherwise.
+    //
+
+    std::uint32_t run = (it != index_.end() ? std::max(need, 2 * it -> second.run) : need);
+
+    reserve(used_ + 2 * run);
+
+    entry e {used_, run, (it != index_.end() ? it -> second.sequence + 1 : 1), 0};
+
+    memset(copy(e, 1), 0, sizeof(copy_header));
+    write_copy(e, 0, e.sequence, type, name, value, length);
+    touch(copy(e, 0), 2 * static_cast<std::size_t>(run) * SLOT_SIZE);
+
+    used_ += 2 * run;
+
+    if (it != index_.end())
+    {
+        sync(true);
+
+        for (int which = 0; which < 2; which++)
+        {
+            char *s = copy(it -> second, which);
+
+            s[0] = 0;
+            touch(s, 1);
+        }
+
+        it -> second = e;
+    }
+    else
+    {
+        index_.emplace(key, e);
+    }
+}
+
+void handler_state_store::write_copy(const entry &e, int which, std::uint32_t sequence, char type,
+                                     const std::string &name, const void *value, std::size_t length)
+{
+    char *s = copy(e, which);
+    copy_header h {};
+
+    h.type = static_cast<std::uint8_t>(type);
+    h.copy = which;
+    h.name_length = name.size();
+    h.run = e.run;
+    h.value_length = length;
+    h.sequence = sequence;
+    h.crc = copy_crc(h, name.data(), value);
+
+    memcpy(s + sizeof(h), name.data(), name.size());
+    memcpy(s + sizeof(h) + name.size(), value, length);
+
+    //
+    // Type goes last, run being allocated
+    // is free until it is complete.
+    //
+
+    memcpy(s + 1, reinterpret_cast<const char *>(&h) + 1, sizeof(h) - 1);
+    s[0] = h.type;
+}
+
+void handler_state_store::touch(const char *begin, std::size_t length)
+{
+    std::size_t offset = begin - base_;
+
+    if (dirty_begin_ >= dirty_end_)
+    {
+        dirty_begin_ = offset;
+        dirty_end_ = offset + length;
+    }
+    else
+    {
+        dirty_begin_ = std::min(dirty_begin_, offset);
+        dirty_end_ = std::max(dirty_end_, offset + length);
+    }
+}
+
+void handler_state_store::reserve(std::uint32_t slot_count)
+{
+    if (slot_count <= slot_count_)
+    {
+        return;
+    }
+
+    std::uint32_t new_count = slot_count_;
+
+    while (new_count < slot_count)
+    {
+        if (new_count > UINT32_MAX / 2)
+        {
+            throw std::runtime_error("Handler state ‘" + file_name_ + "’ too big");
+        }
+
+        new_count *= 2;
+    }
+
+    if (ftruncate(fd_, HEADER_SIZE + static_cast<std::size_t>(new_count) * SLOT_SIZE) == -1)
+    {
+        throw std::runtime_error("Unable to grow handler state ‘" + file_name_ + "’: " + strerror(errno));
+    }
+
+    unmap();
+    map(new_count);
+
+    memcpy(base_ + offsetof(store_header, slot_count), &slot_count_, sizeof(slot_count_));
+
+    touch(base_, HEADER_SIZE);
+}
+
+void handler_state_store::sync(bool durable)
+{
+    if (dirty_begin_ >= dirty_end_)
+    {
+        return;
+    }
+
+    static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+
+    std::size_t begin = dirty_begin_ - dirty_begin_ % page_size;
+
+    if (msync(base_ + begin, dirty_end_ - begin, durable ? MS_SYNC : MS_ASYNC) == -1)
+    {
+        throw std::runtime_error("Unable to sync handler state ‘" + file_name_ + "’: " + strerror(errno));
+    }
+
+    dirty_begin_ = dirty_end_ = 0;
+}
+
+void handler_state_store::map(std::uint32_t slot_count)
+{
+    std::size_t size = HEADER_SIZE + static_cast<std::size_t>(slot_count) * SLOT_SIZE;
+
+    void *base = mmap(nullptr, size, (read_only_ ? PROT_READ : PROT_READ | PROT_WRITE), MAP_SHARED, fd_, 0);
+
+    if (base == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map handler state ‘" + file_name_ + "’: " + strerror(errno));
+    }
+
+    base_ = static_cast<char *>(base);
+    size_ = size;
+    slot_count_ = slot_count;
+}
+
+void handler_state_store::unmap(void)
+{
+    if (base_ != nullptr)
+    {
+        munmap(base_, size_);
+        base_ = nullptr;
+    }
+}
@@ -0,0 +1,434 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/endian/conversion.hpp>
+
+#include <hft_binary_protocol.hpp>
+
+namespace hft {
+namespace protocol {
+namespace binary {
+
+namespace {
+
+//
+// Little-endian primitives.
+//
+
+template <typename T>
+void put(std::string &out, T value)
+{
+    boost::endian::native_to_little_inplace(value);
+
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void put_double(std::string &out, double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    put<std::uint64_t>(out, bits);
+}
+
+//
+// Ids are validated before the header goes out, so that a rejected id
+// never leaves a partial frame behind in the caller's buffer.
+//
+
+void check_id(const std::string &id)
+{
+    if (id.length() > ID_SIZE)
+    {
+        throw std::invalid_argument("Position id ‘" + id + "’ exceeds binary frame limit");
+    }
+}
+
+void put_id(std::string &out, const std::string &id)
+{
+    out.append(id);
+    out.append(ID_SIZE - id.length(), '\0');
+}
+
+void put_padding(std::string &out, std::size_t n)
+{
+    out.append(n, '\0');
+}
+
+void put_header(std::string &out, std::uint8_t code, std::uint16_t instrument_index,
+                    std::uint16_t body_length, std::int64_t cid)
+{
+    put<std::uint16_t>(out, MAGIC);
+    put<std::uint8_t>(out, code);
+    put<std::uint8_t>(out, cid >= 0 ? FLAG_CID : 0);
+    put<std::uint16_t>(out, instrument_index);
+    put<std::uint16_t>(out, body_length);
+    put<std::int64_t>(out, cid >= 0 ? cid : 0);
+}
+
+template <typename T>
+T get(const char *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+
+    return boost::endian::little_to_native(value);
+}
+
+double get_double(const char *data)
+{
+    std::uint64_t bits = get<std::uint64_t>(data);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+void get_id(const char *data, std::string &id)
+{
+    id.assign(data, strnlen(data, ID_SIZE));
+}
+
+struct header
+{
+    std::uint8_t code;
+    std::uint8_t flags;
+    std::uint16_t instrument_index;
+    std::uint16_t body_length;
+    std::int64_t cid;
+};
+
+header get_header(const char *data)
+{
+    header h;
+
+    h.code             = get<std::uint8_t>(data + 2);
+    h.flags            = get<std::uint8_t>(data + 3);
+    h.instrument_index = get<std::uint16_t>(data + 4);
+    h.body_length      = get<std::uint16_t>(data + 6);
+    h.cid              = (h.flags & FLAG_CID) ? get<std::int64_t>(data + 8) : request::NO_CID;
+
+    return h;
+}
+
+const std::string &get_instrument(const header &h, const std::vector<std::string> &instruments)
+{
+    if (h.instrument_index >= instruments.size())
+    {
+        throw request::violation_error("Illegal instrument index in binary frame");
+    }
+
+    return instruments[h.instrument_index];
+}
+
+} /* namespace */
+
+std::size_t frame_size(const char *data, std::size_t length)
+{
+    if (length < HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    if (get<std::uint16_t>(data) != MAGIC)
+    {
+        throw std::runtime_error("Bad binary frame magic");
+    }
+
+    return HEADER_SIZE + get<std::uint16_t>(data + 6);
+}
+
+void decode_request(const char *frame, const std::vector<std::string> &instruments, request::holder &req)
+{
+    header h = get_header(frame);
+    const char *body = frame + HEADER_SIZE;
+
+    switch (h.code)
+    {
+        case request::tick::OPCODE:
+             {
+                 if (h.body_length != TICK_BODY_SIZE)
+                 {
+                     throw request::violation_error("Invalid length of binary tick frame");
+                 }
+
+                 auto &ret = req.tick_msg;
+
+                 ret.cid = h.cid;
+                 ret.instrument = get_instrument(h, instruments);
+                 ret.instrument_id = h.instrument_index;
+                 ret.request_time.set(get<std::int64_t>(body));
+                 ret.ask = get_double(body + 8);
+                 ret.bid = get_double(body + 16);
+                 ret.equity = get_double(body + 24);
+                 ret.free_margin = get_double(body + 32);
+
+                 req.opcode = h.code;
+
+                 return;
+             }
+        case request::open_notify::OPCODE:
+             {
+                 if (h.body_length != NOTIFY_BODY_SIZE)
+                 {
+                     throw request::violation_error("Invalid length of binary open_notify frame");
+                 }
+
+                 auto &ret = req.open_notify_msg;
+
+                 ret.cid = h.cid;
+                 ret.instrument = get_instrument(h, instruments);
+                 ret.instrument_id = h.instrument_index;
+                 ret.price = get_double(body);
+                 ret.status = (get<std::uint8_t>(body + 8) != 0);
+                 get_id(body + 16, ret.id);
+
+                 req.opcode = h.code;
+
+                 return;
+             }
+        case request::close_notify::OPCODE:
+             {
+                 if (h.body_length != NOTIFY_BODY_SIZE)
+                 {
+                     throw request::violation_error("Invalid length of binary close_notify frame");
+                 }
+
+                 auto &ret = req.close_notify_msg;
+
+                 ret.cid = h.cid;
+                 ret.instrument = get_instrument(h, instruments);
+                 ret.instrument_id = h.instrument_index;
+                 ret.price = get_double(body);
+                 ret.status = (get<std::uint8_t>(body + 8) != 0);
+                 get_id(body + 16, ret.id);
+
+                 req.opcode = h.code;
+
+                 return;
+             }
+        case request::sync::OPCODE:
+             {
+                 if (h.body_length != SYNC_BODY_SIZE)
+                 {
+                     throw request::violation_error("Invalid length of binary sync frame");
+                 }
+
+                 auto &ret = req.sync_msg;
+
+                 ret.cid = h.cid;
+                 ret.instrument = get_instrument(h, instruments);
+                 ret.instrument_id = h.instrument_index;
+                 ret.created_on.set(get<std::int64_t>(body));
+                 ret.price = get_double(body + 8);
+                 ret.qty = get<std::int32_t>(body + 16);
+                 ret.is_long = (get<std::uint8_t>(body + 20) != 0);
+                 get_id(body + 24, ret.id);
+
+                 req.opcode = h.code;
+
+                 return;
+             }
+    }
+
+    throw request::violation_error("Illegal opcode in binary frame");
+}
+
+int tick_instrument(const char *frame)
+{
+    header h = get_header(frame);
+
+    return h.code == request::tick::OPCODE ? h.instrument_index : -1;
+}
+
+void encode_response(const response &resp, std::uint16_t instrument_index, std::string &out)
+{
+    if (resp.is_error())
+    {
+        std::string message = resp.get_error_message().substr(0, UINT16_MAX);
+
+        put_header(out, static_cast<std::uint8_t>(status::ERROR), instrument_index, message.length(), resp.get_cid());
+        out.append(message);
+
+        return;
+    }
+
+    std::size_t n = resp.get_close_positions().size() + resp.get_new_positions().size();
+
+    if (n == 0)
+    {
+        put_header(out, static_cast<std::uint8_t>(status::ACK), instrument_index, 0, resp.get_cid());
+
+        return;
+    }
+
+    if (n * OPERATION_SIZE > UINT16_MAX)
+    {
+        throw std::runtime_error("Too many operations for binary advice frame");
+    }
+
+    for (auto &id : resp.get_close_positions())
+    {
+        check_id(id);
+    }
+
+    for (auto &item : resp.get_new_positions())
+    {
+        check_id(item.id_);
+    }
+
+    put_header(out, static_cast<std::uint8_t>(status::ADVICE), instrument_index, n * OPERATION_SIZE, resp.get_cid());
+
+    for (auto &id : resp.get_close_positions())
+    {
+        put<std::uint8_t>(out, static_cast<std::uint8_t>(operation::CLOSE));
+        put_padding(out, 7);
+        put_double(out, 0.0);
+        put_id(out, id);
+    }
+
+    for (auto &item : resp.get_new_positions())
+    {
+        operation op = (item.pd_ == response::position_direction::POSITION_LONG ? operation::LONG : operation::SHORT);
+
+        put<std::uint8_t>(out, static_cast<std::uint8_t>(op));
+        put_padding(out, 7);
+        put_double(out, item.qty_);
+        put_id(out, item.id_);
+    }
+}
+
+void encode_tick(std::uint16_t instrument_index, std::int64_t timestamp, double ask, double bid,
+                     double equity, double free_margin, std::int64_t cid, std::string &out)
+{
+    put_header(out, request::tick::OPCODE, instrument_index, TICK_BODY_SIZE, cid);
+    put<std::int64_t>(out, timestamp);
+    put_double(out, ask);
+    put_double(out, bid);
+    put_double(out, equity);
+    put_double(out, free_margin);
+}
+
+void encode_sync(std::uint16_t instrument_index, std::int64_t created_on, const std::string &id,
+                     bool is_long, double price, int qty, std::int64_t cid, std::string &out)
+{
+    check_id(id);
+
+    put_header(out, request::sync::OPCODE, instrument_index, SYNC_BODY_SIZE, cid);
+    put<std::int64_t>(out, created_on);
+    put_double(out, price);
+    put<std::int32_t>(out, qty);
+    put<std::uint8_t>(out, is_long ? 1 : 0);
+    put_padding(out, 3);
+    put_id(out, id);
+}
+
+void encode_open_notify(std::uint16_t instrument_index, const std::string &id, bool status,
+                            double price, std::int64_t cid, std::string &out)
+{
+    check_id(id);
+
+    put_header(out, request::open_notify::OPCODE, instrument_index, NOTIFY_BODY_SIZE, cid);
+    put_double(out, price);
+    put<std::uint8_t>(out, status ? 1 : 0);
+    put_padding(out, 7);
+    put_id(out, id);
+}
+
+void encode_close_notify(std::uint16_t instrument_index, const std::string &id, bool status,
+                             double price, std::int64_t cid, std::string &out)
+{
+    check_id(id);
+
+    put_header(out, request::close_notify::OPCODE, instrument_index, NOTIFY_BODY_SIZE, cid);
+    put_double(out, price);
+    put<std::uint8_t>(out, status ? 1 : 0);
+    put_padding(out, 7);
+    put_id(out, id);
+}
+
+void decode_response(const char *frame, std::size_t length,
+                         const std::vector<std::string> &instruments, response &resp)
+{
+    if (length < HEADER_SIZE || frame_size(frame, length) != length)
+    {
+        throw response::violation_error("Damaged binary response frame");
+    }
+
+    header h = get_header(frame);
+    const char *body = frame + HEADER_SIZE;
+
+    resp = response();
+    resp.set_cid(h.cid);
+
+    if (h.instrument_index != NO_INSTRUMENT)
+    {
+        if (h.instrument_index >= instruments.size())
+        {
+            throw response::violation_error("Illegal instrument index in binary response");
+        }
+
+        resp.set_instrument(instruments[h.instrument_index]);
+    }
+
+    switch (static_cast<status>(h.code))
+    {
+        case status::ACK:
+             return;
+        case status::ERROR:
+             resp.error(std::string(body, h.body_length));
+             return;
+        case status::ADVICE:
+             break;
+        default:
+             throw response::violation_error("Illegal status in binary response");
+    }
+
+    if (h.body_length == 0 || h.body_length % OPERATION_SIZE != 0)
+    {
+        throw response::violation_error("Invalid length of binary advice frame");
+    }
+
+    for (const char *p = body; p < body + h.body_length; p += OPERATION_SIZE)
+    {
+        double qty = get_double(p + 8);
+        std::string id;
+
+        get_id(p + 16, id);
+
+        switch (static_cast<operation>(get<std::uint8_t>(p)))
+        {
+            case operation::CLOSE:
+                 resp.close_position(id);
+                 break;
+            case operation::LONG:
+                 resp.open_long(id, qty);
+                 break;
+            case operation::SHORT:
+                 resp.open_short(id, qty);
+                 break;
+            default:
+                 throw response::violation_error("Illegal operation in binary advice frame");
+        }
+    }
+}
+
+} /* namespace binary */
+} /* namespace protocol */
+} /* namespace hft */
@@ -18,10 +18,11 @@
 #include <utilities.hpp>
 
 #include <sstream>
-#include <iomanip>
 #include <string>
 #include <cstdint>
+#include <cstring>
 
+#include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/tokenizer.hpp>
 
@@ -46,9 +47,9 @@ hft_handler_resource::autosaver::~autosaver(void)
     }
 }
 
-hft_handler_resource::hft_handler_resource(const std::string &file_name, const std::string &logger_id)
+hft_handler_resource::hft_handler_resource(const std::string &file_name, const std::string &logger_id, bool sync, bool in_memory)
     : initialized_(false), changed_(false),
-      file_name_(file_name), logger_id_(logger_id)
+      file_name_(file_name), logger_id_(logger_id), sync_(sync), in_memory_(in_memory)
 {
     el::Loggers::getLogger(logger_id_.c_str(), true);
 }
@@ -68,18 +69,131 @@ hft_handler_resource::~hft_handler_resource(void)
 
 void hft_handler_resource::persistent(void)
 {
-    std::string data;
+    std::string store_file_name = file_name_ + ".bin";
+    bool legacy = (! boost::filesystem::exists(store_file_name) && boost::filesystem::exists(file_name_));
 
     initialized_ = true;
 
+    if (legacy)
+    {
+        migrate(file_name_);
+    }
+
+    if (in_memory_)
+    {
+        //
+        // Neither text file nor store is changed,
+        // nor is the text file migrated.
+        //
+
+        if (boost::filesystem::exists(store_file_name))
+        {
+            try
+            {
+                restore(handler_state_store(store_file_name, true));
+            }
+            catch (const std::runtime_error &e)
+            {
+                hft_log(ERROR) << "handler_resource: " << e.what() << ", starting with default values.";
+            }
+        }
+
+        return;
+    }
+
+    try
+    {
+        store_.reset(new handler_state_store(store_file_name));
+    }
+    catch (const std::runtime_error &e)
+    {
+        //
+        // Damaged store is put aside, handler
+        // starts with its default values.
+        //
+
+        std::string backup = hft::utils::find_free_name(store_file_name);
+
+        hft_log(ERROR) << "handler_resource: " << e.what() << ", moved to ‘" << backup << "’.";
+
+        boost::filesystem::rename(store_file_name, backup);
+
+        store_.reset(new handler_state_store(store_file_name));
+    }
+
+    restore(*store_);
+
+    //
+    // Variables set before, not found
+    // in the store, get their slots.
+    //
+
+    for (auto &it : ints_) store_int(it.first, it.second);
+    for (auto &it : bools_) store_bool(it.first, it.second);
+    for (auto &it : doubles_) store_double(it.first, it.second);
+    for (auto &it : strings_) store_string(it.first, it.second);
+
+    store_ -> sync(true);
+
+    if (legacy)
+    {
+        boost::filesystem::rename(file_name_, file_name_ + ".migrated");
+
+        hft_log(INFO) << "handler_resource: Migrated ‘" << file_name_
+                      << "’ to ‘" << store_file_name << "’.";
+    }
+}
+
+void hft_handler_resource::restore(const handler_state_store &store)
+{
+    store.for_each([this](char type, const std::string &var_name, const char *value, std::size_t length)
+    {
+        std::int64_t int_value;
+        double double_value;
+
+        switch (type)
+        {
+            case 'i':
+                if (length != sizeof(int_value)) break;
+                memcpy(&int_value, value, sizeof(int_value));
+                ints_[var_name] = int_value;
+                hft_log(INFO) << "handler_resource: Restored integer "
+                              << var_name << " → " << ints_[var_name] << ".";
+                break;
+            case 'b':
+                if (length != 1) break;
+                bools_[var_name] = (value[0] != 0);
+                hft_log(INFO) << "handler_resource: Restored boolean "
+                              << var_name << " → " << bools_[var_name] << ".";
+                break;
+            case 'd':
+                if (length != sizeof(double_value)) break;
+                memcpy(&double_value, value, sizeof(double_value));
+                doubles_[var_name] = double_value;
+                hft_log(INFO) << "handler_resource: Restored floating point "
+                              << var_name << " → " << doubles_[var_name] << ".";
+                break;
+            case 's':
+                strings_[var_name].assign(value, length);
+                hft_log(INFO) << "handler_resource: Restored string "
+                              << var_name << " → " << strings_[var_name] << ".";
+                break;
+        }
+    });
+}
+
+void hft_handler_resource::migrate(const std::string &text_file_name)
+{
+    std::string data;
+
     try
     {
-        data = hft::utils::file_get_contents(file_name_);
+        data = hft::utils::file_get_contents(text_file_name);
     }
     catch (const std::runtime_error &e)
     {
         hft_log(WARNING) << "handler_resource: Unalbe to load file ‘"
-                         << file_name_ << "’.";
+                         << text_file_name << "’.";
 
         return;
     }
@@ -102,48 +216,44 @@ void hft_handler_resource::save(void)
     hft_log(DEBUG) << "hft_handler_resource::save: Got called, initialized_: ‘"
                    << initialized_ << "’, changed_ ‘" << changed_ << "’.";
 
-    if (initialized_ && changed_)
+    if (initialized_ && changed_ && store_)
     {
-        std::stringstream ss;
+        //
+        // Values are already in the store,
+        // touched pages are written back.
+        //
 
-        for (auto &it : ints_)
-        {
-            ss << "i;" << it.first << ';' << it.second << "\n";
-        }
+        store_ -> sync(sync_);
 
-        for (auto &it : bools_)
-        {
-            ss << "b;" << it.first << ';' << it.second << "\n";
-        }
+        hft_log(TRACE) << "Saved handler state to ‘"
+                       << file_name_ << ".bin’.";
 
-        for (auto &it : doubles_)
-        {
-            ss << "d;" << it.first << ';' << it.second << "\n";
-        }
+        changed_ = false;
+    }
+}
 
-        for (auto &it : strings_)
-        {
-            ss << "s;" << it.first << ';';
+void hft_handler_resource::store_int(const std::string &var_name, int value)
+{
+    std::int64_t v = value;
 
-            if (it.second.length() == 0)
-            {
-                ss << "(empty)\n";
-            }
-            else
-            {
-                ss << hft_handler_resource::string_to_hex(it.second) << "\n";
-            }
-        }
+    store_ -> put('i', var_name, &v, sizeof(v));
+}
 
-        std::string payload = ss.str();
+void hft_handler_resource::store_bool(const std::string &var_name, bool value)
+{
+    char v = value ? 1 : 0;
 
-        hft::utils::file_put_contents(file_name_, payload);
+    store_ -> put('b', var_name, &v, sizeof(v));
+}
 
-        hft_log(TRACE) << "Saved handler state to ‘"
-                       << file_name_ << "’.";
+void hft_handler_resource::store_double(const std::string &var_name, double value)
+{
+    store_ -> put('d', var_name, &value, sizeof(value));
+}
 
-        changed_ = false;
-    }
+void hft_handler_resource::store_string(const std::string &var_name, const std::string &value)
+{
+    store_ -> put('s', var_name, value.data(), value.size());
 }
 
 void hft_handler_resource::set_int_var(const std::string &var_name, int value)
@@ -153,6 +263,11 @@ void hft_handler_resource::set_int_var(const std::string &var_name, int value)
         ints_[var_name] = value;
         changed_ = true;
 
+        if (store_)
+        {
+            store_int(var_name, value);
+        }
+
         hft_log(DEBUG) << "Updated integer: ‘" << var_name
                        << "=" << value << "’.";
     }
@@ -165,6 +280,11 @@ void hft_handler_resource::set_bool_var(const std::string &var_name, bool value)
         bools_[var_name] = value;
         changed_ = true;
 
+        if (store_)
+        {
+            store_bool(var_name, value);
+        }
+
         hft_log(DEBUG) << "Updated boolean: ‘" << var_name
                        << "=" << value << "’.";
     }
@@ -177,6 +297,11 @@ void hft_handler_resource::set_double_var(const std::string &var_name, double va
         doubles_[var_name] = value;
         changed_ = true;
 
+        if (store_)
+        {
+            store_double(var_name, value);
+        }
+
         hft_log(DEBUG) << "Updated floating point: ‘" << var_name
                        << "=" << value << "’.";
     }
@@ -189,6 +314,11 @@ void hft_handler_resource::set_string_var(const std::string &var_name, const std
         strings_[var_name] = value;
         changed_ = true;
 
+        if (store_)
+        {
+            store_string(var_name, value);
+        }
+
         hft_log(DEBUG) << "Updated string: ‘" << var_name
                        << "=" << value << "’.";
     }
@@ -332,20 +462,6 @@ void hft_handler_resource::process_line(const std::string &line)
     }
 }
 
-std::string hft_handler_resource::string_to_hex(const std::string &in)
-{
-    std::stringstream ss;
-
-    ss << std::hex << std::setfill('0');
-
-    for (size_t i = 0; in.length() > i; ++i)
-    {
-        ss << std::setw(2) << static_cast<unsigned int>(static_cast<unsigned char>(in[i]));
-    }
-
-    return ss.str(); 
-}
-
 std::string hft_handler_resource::hex_to_string(const std::string &in)
 {
     std::string output;
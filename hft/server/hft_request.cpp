@@ -14,7 +14,10 @@
 **                                                                    **
 \**********************************************************************/
 
+#include <cstring>
+
 #include <boost/json.hpp>
+#include <boost/json/basic_parser_impl.hpp>
 
 #include <hft_request.hpp>
 
@@ -22,627 +25,1021 @@ namespace hft {
 namespace protocol {
 namespace request {
 
-static init make_init(boost::json::object const &obj)
+std::string_view instrument_table::intern(std::string_view name, int &instrument_id)
 {
-    using namespace boost::json;
-
-    init ret;
-
-    if (! obj.contains("sessid"))
+    for (std::size_t i = 0; i < names_.size(); i++)
     {
-        ret.sessid = "";
+        if (names_[i] == name)
+        {
+            instrument_id = i;
+
+            return names_[i];
+        }
     }
-    else
-    {
-        value const &v = obj.at("sessid");
 
-        if (v.kind() != kind::string)
+    instrument_id = NO_INSTRUMENT;
+    unknown_.assign(name.data(), name.size());
+
+    return unknown_;
+}
+
+static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, boost::gregorian::Jan, 1));
+
+} /* namespace request */
+
+namespace {
+
+//
+// Fixed-format fast path for ‘YYYY-MM-DD hh:mm:ss[.ffffff]’
+// timestamps, converted straight to epoch milliseconds
+// without building ptime. Anything else goes through
+// time_from_string.
+//
+
+bool parse_digits(const char *p, int n, int &out)
+{
+    out = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (p[i] < '0' || p[i] > '9')
         {
-            throw violation_error("Invalid sessid attribute type for method init");
+            return false;
         }
 
-        ret.sessid = v.get_string().c_str();
+        out = out * 10 + (p[i] - '0');
     }
 
-    if (! obj.contains("instruments"))
-    {
-        throw violation_error("Missing instruments for method init");
-    }
+    return true;
+}
 
-    value const &v = obj.at("instruments");
+//
+// Number of days since 1970-01-01 for proleptic
+// Gregorian calendar date.
+//
 
-    if (v.kind() != kind::array)
+std::int64_t days_from_civil(int year, int month, int day)
+{
+    year -= (month <= 2);
+
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return static_cast<std::int64_t>(era) * 146097 + doe - 719468;
+}
+
+bool parse_timestamp(const std::string &s, std::int64_t &millis)
+{
+    int year, month, day, hour, minute, second;
+    int fraction = 0, fraction_digits = 0;
+
+    bool fixed = (s.length() >= 19 && s[4] == '-' && s[7] == '-' && s[10] == ' ' && s[13] == ':' && s[16] == ':'
+                  && parse_digits(&s[0], 4, year) && parse_digits(&s[5], 2, month) && parse_digits(&s[8], 2, day)
+                  && parse_digits(&s[11], 2, hour) && parse_digits(&s[14], 2, minute) && parse_digits(&s[17], 2, second));
+
+    if (fixed && s.length() > 19)
     {
-        throw violation_error("Invalid instruments attribute type for method init");
-    }
+        fraction_digits = s.length() - 20;
 
-    array const &arr = v.get_array();
+        fixed = (s[19] == '.' && fraction_digits >= 1 && fraction_digits <= 6
+                 && parse_digits(&s[20], fraction_digits, fraction));
+    }
 
-    if (arr.empty())
+    if (fixed)
     {
-        throw violation_error("Method init requires at least one instrument");
+        if (year < 1400 || month < 1 || month > 12 || day < 1
+                || day > boost::gregorian::gregorian_calendar::end_of_month_day(year, month)
+                || hour > 23 || minute > 59 || second > 59)
+        {
+            return false;
+        }
+
+        for (int i = fraction_digits; i < 3; i++)
+        {
+            fraction *= 10;
+        }
+
+        for (int i = 3; i < fraction_digits; i++)
+        {
+            fraction /= 10;
+        }
+
+        millis = ((days_from_civil(year, month, day) * 24 + hour) * 60 + minute) * 60 + second;
+        millis = millis * 1000 + fraction;
+
+        return true;
     }
 
-    for (auto it = arr.begin(); it != arr.end(); it++)
+    try
     {
-        value const &array_val = *it;
+        boost::posix_time::ptime t = boost::posix_time::time_from_string(s);
 
-        if (array_val.kind() != kind::string)
+        if (t.is_not_a_date_time())
         {
-            throw violation_error("Instrument ticker must be a string type for method init");
+            return false;
         }
 
-        ret.instruments.push_back(std::string(array_val.get_string().c_str())); // XXX mozeby emplace zrobic?
+        millis = (t - request::epoch).total_milliseconds();
+    }
+    catch (const std::exception &e)
+    {
+        return false;
     }
 
-    return ret;
+    return true;
 }
 
-static sync make_sync(boost::json::object const &obj)
+enum field_id
 {
-    using namespace boost::json;
+    FIELD_METHOD,
+    FIELD_CID,
+    FIELD_SESSID,
+    FIELD_INSTRUMENTS,
+    FIELD_PIPELINE,
+    FIELD_FRAMING,
+    FIELD_LANES,
+    FIELD_INSTRUMENT,
+    FIELD_ID,
+    FIELD_TIMESTAMP,
+    FIELD_DIRECTION,
+    FIELD_PRICE,
+    FIELD_QTY,
+    FIELD_ASK,
+    FIELD_BID,
+    FIELD_EQUITY,
+    FIELD_FREE_MARGIN,
+    FIELD_STATUS,
+
+    FIELD_UNKNOWN,
+    FIELD_COUNT
+};
+
+const struct
+{
+    const char *name;
+    std::size_t length;
+    field_id id;
+
+} fields[] = {
+    { "method",      6,  FIELD_METHOD },
+    { "instrument",  10, FIELD_INSTRUMENT },
+    { "timestamp",   9,  FIELD_TIMESTAMP },
+    { "ask",         3,  FIELD_ASK },
+    { "bid",         3,  FIELD_BID },
+    { "equity",      6,  FIELD_EQUITY },
+    { "free_margin", 11, FIELD_FREE_MARGIN },
+    { "cid",         3,  FIELD_CID },
+    { "id",          2,  FIELD_ID },
+    { "price",       5,  FIELD_PRICE },
+    { "status",      6,  FIELD_STATUS },
+    { "direction",   9,  FIELD_DIRECTION },
+    { "qty",         3,  FIELD_QTY },
+    { "sessid",      6,  FIELD_SESSID },
+    { "instruments", 11, FIELD_INSTRUMENTS },
+    { "pipeline",    8,  FIELD_PIPELINE },
+    { "framing",     7,  FIELD_FRAMING },
+    { "lanes",       5,  FIELD_LANES }
+};
+
+field_id lookup_field(const char *key, std::size_t length)
+{
+    for (auto &f : fields)
+    {
+        if (f.length == length && std::memcmp(f.name, key, length) == 0)
+        {
+            return f.id;
+        }
+    }
 
-    sync ret;
+    return FIELD_UNKNOWN;
+}
 
-    //
-    // Obtain instrument.
-    //
+enum class value_kind
+{
+    NONE,
+    STRING,
+    INT64,
+    UINT64,
+    DOUBLE,
+    BOOL,
+    ARRAY,
+    OTHER
+};
+
+//
+// Handler for boost::json::basic_parser. Collects top-level
+// attributes of the request object into fixed slots indexed
+// by field_id; values of unknown attributes are skipped.
+// Strings are copied into buffers which are reused between
+// requests.
+//
+
+class sax_handler
+{
+public:
+
+    static constexpr std::size_t max_object_size = std::size_t(-1);
+    static constexpr std::size_t max_array_size  = std::size_t(-1);
+    static constexpr std::size_t max_key_size    = std::size_t(-1);
+    static constexpr std::size_t max_string_size = std::size_t(-1);
+
+    typedef boost::json::string_view string_view;
+    typedef boost::json::error_code error_code;
 
-    if (! obj.contains("instrument"))
+    sax_handler(void)
     {
-        throw violation_error("Missing instrument attribute for method sync");
+        clear();
     }
 
-    value const &v_instrument = obj.at("instrument");
-
-    if (v_instrument.kind() != kind::string)
+    void clear(void)
     {
-        throw violation_error("Invalid instrument attribute type for method sync");
+        depth_ = 0;
+        root_is_object_ = false;
+        root_size_ = 0;
+        key_ = FIELD_UNKNOWN;
+        in_instruments_ = false;
+        instruments_valid_ = true;
+        instruments_size_ = 0;
+        instruments_count_ = 0;
+        text_.clear();
+        key_text_.clear();
+
+        for (auto &k : kinds_)
+        {
+            k = value_kind::NONE;
+        }
     }
 
-    ret.instrument = v_instrument.get_string().c_str();
+    bool on_document_begin(error_code &ec) { return true; }
+    bool on_document_end(error_code &ec) { return true; }
 
-    //
-    // Obtain position ID.
-    //
+    bool on_object_begin(error_code &ec) { enter_container(false); return true; }
+    bool on_object_end(std::size_t n, error_code &ec) { leave_container(n); return true; }
+    bool on_array_begin(error_code &ec) { enter_container(true); return true; }
+    bool on_array_end(std::size_t n, error_code &ec) { leave_container(n); return true; }
 
-    if (! obj.contains("id"))
+    bool on_key_part(string_view s, std::size_t n, error_code &ec)
     {
-        throw violation_error("Missing id attribute for method sync");
-    }
+        if (depth_ == 1)
+        {
+            key_text_.append(s.data(), s.size());
+        }
 
-    value const &v_id = obj.at("id");
+        return true;
+    }
 
-    if (v_id.kind() != kind::string)
+    bool on_key(string_view s, std::size_t n, error_code &ec)
     {
-        throw violation_error("Invalid id attribute type for method sync");
+        if (depth_ == 1)
+        {
+            if (key_text_.empty())
+            {
+                key_ = lookup_field(s.data(), s.size());
+            }
+            else
+            {
+                key_text_.append(s.data(), s.size());
+                key_ = lookup_field(key_text_.data(), key_text_.size());
+                key_text_.clear();
+            }
+        }
+
+        return true;
     }
 
-    ret.id = v_id.get_string().c_str();
+    bool on_string_part(string_view s, std::size_t n, error_code &ec)
+    {
+        text_.append(s.data(), s.size());
 
-    //
-    // Obtain created on.
-    //
+        return true;
+    }
 
-    if (! obj.contains("timestamp"))
+    bool on_string(string_view s, std::size_t n, error_code &ec)
     {
-        throw violation_error("Missing timestamp attribute for method sync");
+        const char *data = s.data();
+        std::size_t length = s.size();
+
+        if (! text_.empty())
+        {
+            text_.append(s.data(), s.size());
+            data = text_.data();
+            length = text_.size();
+        }
+
+        if (depth_ == 1)
+        {
+            kinds_[key_] = value_kind::STRING;
+            strings_[key_].assign(data, length);
+        }
+        else if (depth_ == 2 && in_instruments_)
+        {
+            if (instruments_count_ == instruments_.size())
+            {
+                instruments_.emplace_back();
+            }
+
+            instruments_[instruments_count_++].assign(data, length);
+        }
+
+        text_.clear();
+
+        return true;
     }
 
-    value const &v_timestamp = obj.at("timestamp");
+    bool on_number_part(string_view s, error_code &ec) { return true; }
 
-    if (v_timestamp.kind() != kind::string)
+    bool on_int64(std::int64_t i, string_view s, error_code &ec)
     {
-        throw violation_error("Invalid timestamp attribute type for method sync");
+        if (scalar(value_kind::INT64))
+        {
+            int64_[key_] = i;
+        }
+
+        return true;
     }
 
-    try
+    bool on_uint64(std::uint64_t u, string_view s, error_code &ec)
     {
-        ret.created_on = boost::posix_time::ptime(boost::posix_time::time_from_string(v_timestamp.get_string().c_str()));
+        if (scalar(value_kind::UINT64))
+        {
+            uint64_[key_] = u;
+        }
+
+        return true;
     }
-    catch (const std::exception &e)
+
+    bool on_double(double d, string_view s, error_code &ec)
     {
-        throw violation_error("Invalid format of timestamp attribute for method sync");
+        if (scalar(value_kind::DOUBLE))
+        {
+            double_[key_] = d;
+        }
+
+        return true;
     }
 
-    if (ret.created_on.is_not_a_date_time())
+    bool on_bool(bool b, error_code &ec)
     {
-        throw violation_error("Invalid format of timestamp attribute for method sync");
+        if (scalar(value_kind::BOOL))
+        {
+            bool_[key_] = b;
+        }
+
+        return true;
     }
 
+    bool on_null(error_code &ec) { scalar(value_kind::OTHER); return true; }
+
+    bool on_comment_part(string_view s, error_code &ec) { return true; }
+    bool on_comment(string_view s, error_code &ec) { return true; }
+
     //
-    // Obtain position direction.
+    // Validates collected attributes
+    // and fills the request.
     //
 
-    if (! obj.contains("direction"))
+    bool build(request::holder &req, request::instrument_table &instruments, std::string &error);
+
+private:
+
+    void enter_container(bool is_array)
     {
-        throw violation_error("Missing direction attribute for method sync");
-    }
+        if (depth_ == 0)
+        {
+            root_is_object_ = ! is_array;
+        }
+        else if (depth_ == 1)
+        {
+            kinds_[key_] = (is_array ? value_kind::ARRAY : value_kind::OTHER);
+
+            if (is_array && key_ == FIELD_INSTRUMENTS)
+            {
+                in_instruments_ = true;
+                instruments_valid_ = true;
+                instruments_count_ = 0;
+            }
+        }
+        else if (depth_ == 2 && in_instruments_)
+        {
+            instruments_valid_ = false;
+        }
 
-    value const &v_direction = obj.at("direction");
+        depth_++;
+    }
 
-    if (v_direction.kind() != kind::string)
+    void leave_container(std::size_t n)
     {
-        throw violation_error("Invalid direction attribute type for method sync");
+        depth_--;
+
+        if (depth_ == 0)
+        {
+            root_size_ = n;
+        }
+        else if (depth_ == 1 && in_instruments_)
+        {
+            instruments_size_ = n;
+            in_instruments_ = false;
+        }
     }
 
-    std::string direction = v_direction.get_string().c_str();
+    bool scalar(value_kind kind)
+    {
+        if (depth_ == 1)
+        {
+            kinds_[key_] = kind;
+
+            return true;
+        }
+
+        if (depth_ == 2 && in_instruments_)
+        {
+            instruments_valid_ = false;
+        }
+
+        return false;
+    }
 
-    if (direction == "LONG")
+    bool fail(std::string &error, const char *message)
     {
-        ret.is_long = true;
+        error = message;
+
+        return false;
     }
-    else if (direction == "SHORT")
+
+    bool has(field_id f) const
     {
-        ret.is_long = false;
+        return kinds_[f] != value_kind::NONE;
     }
-    else
+
+    bool is(field_id f, value_kind kind) const
     {
-        throw violation_error("Illegal value of direction attribute for method sync");
+        return kinds_[f] == kind;
     }
 
     //
-    // Obtain price.
+    // Obtains numeric attribute as double. Floating point
+    // is always accepted, integers only when allowed.
     //
 
-    if (! obj.contains("price"))
+    bool number(field_id f, bool accept_int64, bool accept_uint64, double &out) const
     {
-        throw violation_error("Missing price attribute for method sync");
+        switch (kinds_[f])
+        {
+            case value_kind::DOUBLE:
+                 out = double_[f];
+                 return true;
+            case value_kind::INT64:
+                 out = int64_[f];
+                 return accept_int64;
+            case value_kind::UINT64:
+                 out = uint64_[f];
+                 return accept_uint64;
+            default:
+                 return false;
+        }
     }
 
-    value const &v_price = obj.at("price");
+    bool build_init(request::init &ret, std::string &error);
+    bool build_sync(request::sync &ret, request::instrument_table &instruments, std::string &error);
+    bool build_tick(request::tick &ret, request::instrument_table &instruments, std::string &error);
+    bool build_notify(double &price, bool &status, std::string &id, const char *method, std::string &error);
+    bool build_cid(std::int64_t &cid, std::string &error);
 
-    if (v_price.kind() != kind::double_)
-    {
-        throw violation_error("Invalid price attribute type for method sync");
-    }
+    int depth_;
+    bool root_is_object_;
+    std::size_t root_size_;
+    field_id key_;
 
-    ret.price = v_price.get_double();
+    value_kind kinds_[FIELD_COUNT];
+    std::int64_t int64_[FIELD_COUNT];
+    std::uint64_t uint64_[FIELD_COUNT];
+    double double_[FIELD_COUNT];
+    bool bool_[FIELD_COUNT];
+    std::string strings_[FIELD_COUNT];
 
-    //
-    // Obtain contract quantity.
-    //
+    bool in_instruments_;
+    bool instruments_valid_;
+    std::size_t instruments_size_;
+    std::size_t instruments_count_;
+    std::vector<std::string> instruments_;
+
+    std::string text_;
+    std::string key_text_;
+};
 
-    if (! obj.contains("qty"))
+bool sax_handler::build(request::holder &req, request::instrument_table &instruments, std::string &error)
+{
+    if (! root_is_object_)
     {
-        throw violation_error("Missing qty attribute for method sync");
+        return fail(error, "Bad request");
     }
 
-    value const &v_qty = obj.at("qty");
-
-    if (v_qty.kind() == kind::uint64)
+    if (root_size_ == 0)
     {
-        ret.qty = v_qty.get_uint64();
+        return fail(error, "Empty request");
     }
-    else if (v_qty.kind() == kind::int64)
+
+    if (! has(FIELD_METHOD))
     {
-        ret.qty = v_qty.get_int64();
+        return fail(error, "Missing method");
     }
-    else
+
+    if (! is(FIELD_METHOD, value_kind::STRING))
     {
-        throw violation_error("Invalid qty attribute type for method sync");
+        return fail(error, "Invalid method type");
     }
 
-    return ret;
-}
-
-static tick make_tick(boost::json::object const &obj)
-{
-    using namespace boost::json;
-
-    tick ret;
+    const std::string &method = strings_[FIELD_METHOD];
 
     //
-    // Obtain instrument.
+    // The order of checking should depend on
+    // the frequency of the request type.
     //
 
-    if (! obj.contains("instrument"))
+    if (method == "tick")
     {
-        throw violation_error("Missing instrument attribute for method tick");
+        req.opcode = request::tick::OPCODE;
+
+        return build_tick(req.tick_msg, instruments, error) && build_cid(req.tick_msg.cid, error);
     }
+    else if (method == "open_notify")
+    {
+        req.opcode = request::open_notify::OPCODE;
 
-    value const &v_instrument = obj.at("instrument");
+        auto &ret = req.open_notify_msg;
 
-    if (v_instrument.kind() != kind::string)
-    {
-        throw violation_error("Invalid instrument attribute type for method tick");
+        if (! has(FIELD_INSTRUMENT))
+        {
+            return fail(error, "Missing instrument attribute for method open_notify");
+        }
+
+        if (! is(FIELD_INSTRUMENT, value_kind::STRING))
+        {
+            return fail(error, "Invalid instrument attribute type for method open_notify");
+        }
+
+        ret.instrument = instruments.intern(strings_[FIELD_INSTRUMENT], ret.instrument_id);
+
+        return build_notify(ret.price, ret.status, ret.id, "open_notify", error) && build_cid(ret.cid, error);
     }
+    else if (method == "close_notify")
+    {
+        req.opcode = request::close_notify::OPCODE;
 
-    ret.instrument = v_instrument.get_string().c_str();
+        auto &ret = req.close_notify_msg;
 
-    //
-    // Obtain request time.
-    //
+        if (! has(FIELD_INSTRUMENT))
+        {
+            return fail(error, "Missing instrument attribute for method close_notify");
+        }
+
+        if (! is(FIELD_INSTRUMENT, value_kind::STRING))
+        {
+            return fail(error, "Invalid instrument attribute type for method close_notify");
+        }
+
+        ret.instrument = instruments.intern(strings_[FIELD_INSTRUMENT], ret.instrument_id);
 
-    if (! obj.contains("timestamp"))
+        return build_notify(ret.price, ret.status, ret.id, "close_notify", error) && build_cid(ret.cid, error);
+    }
+    else if (method == "sync")
+    {
+        req.opcode = request::sync::OPCODE;
+
+        return build_sync(req.sync_msg, instruments, error) && build_cid(req.sync_msg.cid, error);
+    }
+    else if (method == "init")
     {
-        throw violation_error("Missing timestamp attribute for method tick");
+        req.opcode = request::init::OPCODE;
+
+        return build_init(req.init_msg, error) && build_cid(req.init_msg.cid, error);
     }
 
-    value const &v_timestamp = obj.at("timestamp");
+    error = "Illegal method: ";
+    error += method;
+
+    return false;
+}
+
+bool sax_handler::build_init(request::init &ret, std::string &error)
+{
+    if (! has(FIELD_SESSID))
+    {
+        ret.sessid.clear();
+    }
+    else if (! is(FIELD_SESSID, value_kind::STRING))
+    {
+        return fail(error, "Invalid sessid attribute type for method init");
+    }
+    else
+    {
+        ret.sessid = strings_[FIELD_SESSID];
+    }
 
-    if (v_timestamp.kind() != kind::string)
+    if (! has(FIELD_INSTRUMENTS))
     {
-        throw violation_error("Invalid timestamp attribute type for method tick");
+        return fail(error, "Missing instruments for method init");
     }
 
-    try
+    if (! is(FIELD_INSTRUMENTS, value_kind::ARRAY))
     {
-        ret.request_time = boost::posix_time::ptime(boost::posix_time::time_from_string(v_timestamp.get_string().c_str()));
+        return fail(error, "Invalid instruments attribute type for method init");
     }
-    catch (const std::exception &e)
+
+    if (instruments_size_ == 0)
     {
-        throw violation_error("Invalid format of timestamp attribute for method tick");
+        return fail(error, "Method init requires at least one instrument");
     }
 
-    if (ret.request_time.is_not_a_date_time())
+    if (! instruments_valid_)
     {
-        throw violation_error("Invalid format of timestamp attribute for method tick");
+        return fail(error, "Instrument ticker must be a string type for method init");
     }
 
-    //
-    // Obtain ask.
-    //
+    ret.instruments.assign(instruments_.begin(), instruments_.begin() + instruments_count_);
+
+    ret.pipeline_depth = 1;
 
-    if (! obj.contains("ask"))
+    if (has(FIELD_PIPELINE))
     {
-        throw violation_error("Missing ask attribute for method tick");
+        if (! is(FIELD_PIPELINE, value_kind::INT64) && ! is(FIELD_PIPELINE, value_kind::UINT64))
+        {
+            return fail(error, "Invalid pipeline attribute type for method init");
+        }
+
+        if (is(FIELD_PIPELINE, value_kind::UINT64) || int64_[FIELD_PIPELINE] < 1
+                || int64_[FIELD_PIPELINE] > request::MAX_PIPELINE_DEPTH)
+        {
+            return fail(error, "Illegal value of pipeline attribute for method init");
+        }
+
+        ret.pipeline_depth = int64_[FIELD_PIPELINE];
     }
 
-    value const &v_ask = obj.at("ask");
+    ret.binary_framing = false;
 
-    if (v_ask.kind() == kind::double_)
+    if (has(FIELD_FRAMING))
     {
-        ret.ask = v_ask.get_double();
+        if (! is(FIELD_FRAMING, value_kind::STRING))
+        {
+            return fail(error, "Invalid framing attribute type for method init");
+        }
+
+        if (strings_[FIELD_FRAMING] == "binary")
+        {
+            ret.binary_framing = true;
+        }
+        else if (strings_[FIELD_FRAMING] != "json")
+        {
+            return fail(error, "Illegal value of framing attribute for method init");
+        }
     }
-    else if (v_ask.kind() == kind::int64)
+
+    ret.instrument_lanes = false;
+
+    if (has(FIELD_LANES))
     {
-        ret.ask = v_ask.get_int64();
+        if (! is(FIELD_LANES, value_kind::BOOL))
+        {
+            return fail(error, "Invalid lanes attribute type for method init");
+        }
+
+        ret.instrument_lanes = bool_[FIELD_LANES];
     }
-    else if (v_ask.kind() == kind::uint64)
+
+    return true;
+}
+
+bool sax_handler::build_sync(request::sync &ret, request::instrument_table &instruments, std::string &error)
+{
+    if (! has(FIELD_INSTRUMENT))
     {
-        ret.ask = v_ask.get_uint64();
+        return fail(error, "Missing instrument attribute for method sync");
     }
-    else
+
+    if (! is(FIELD_INSTRUMENT, value_kind::STRING))
     {
-        throw violation_error("Invalid ask attribute type for method tick");
+        return fail(error, "Invalid instrument attribute type for method sync");
     }
 
-    //
-    // Obtain bid.
-    //
+    ret.instrument = instruments.intern(strings_[FIELD_INSTRUMENT], ret.instrument_id);
 
-    if (! obj.contains("bid"))
+    if (! has(FIELD_ID))
     {
-        throw violation_error("Missing bid attribute for method tick");
+        return fail(error, "Missing id attribute for method sync");
     }
 
-    value const &v_bid = obj.at("bid");
+    if (! is(FIELD_ID, value_kind::STRING))
+    {
+        return fail(error, "Invalid id attribute type for method sync");
+    }
+
+    ret.id = strings_[FIELD_ID];
 
-    if (v_bid.kind() == kind::double_)
+    if (! has(FIELD_TIMESTAMP))
     {
-        ret.bid = v_bid.get_double();
+        return fail(error, "Missing timestamp attribute for method sync");
     }
-    else if (v_bid.kind() == kind::int64)
+
+    if (is(FIELD_TIMESTAMP, value_kind::INT64))
     {
-        ret.bid = v_bid.get_int64();
+        ret.created_on.set(int64_[FIELD_TIMESTAMP]);
     }
-    else if (v_bid.kind() == kind::uint64)
+    else if (is(FIELD_TIMESTAMP, value_kind::STRING))
     {
-        ret.bid = v_bid.get_uint64();
+        std::int64_t millis;
+
+        if (! parse_timestamp(strings_[FIELD_TIMESTAMP], millis))
+        {
+            return fail(error, "Invalid format of timestamp attribute for method sync");
+        }
+
+        ret.created_on.set(millis);
     }
     else
     {
-        throw violation_error("Invalid bid attribute type for method tick");
+        return fail(error, "Invalid timestamp attribute type for method sync");
     }
 
-    //
-    // Obtain equity.
-    //
-
-    if (! obj.contains("equity"))
+    if (! has(FIELD_DIRECTION))
     {
-        throw violation_error("Missing equity attribute for method tick");
+        return fail(error, "Missing direction attribute for method sync");
     }
 
-    value const &v_equity = obj.at("equity");
+    if (! is(FIELD_DIRECTION, value_kind::STRING))
+    {
+        return fail(error, "Invalid direction attribute type for method sync");
+    }
 
-    if (v_equity.kind() == kind::double_)
+    if (strings_[FIELD_DIRECTION] == "LONG")
     {
-        ret.equity = v_equity.get_double();
+        ret.is_long = true;
     }
-    else if (v_equity.kind() == kind::int64)
+    else if (strings_[FIELD_DIRECTION] == "SHORT")
     {
-        ret.equity = v_equity.get_int64();
+        ret.is_long = false;
     }
     else
     {
-        throw violation_error("Invalid equity attribute type for method tick");
+        return fail(error, "Illegal value of direction attribute for method sync");
     }
 
-    //
-    // Obtain free_margin.
-    //
+    if (! has(FIELD_PRICE))
+    {
+        return fail(error, "Missing price attribute for method sync");
+    }
 
-    if (! obj.contains("free_margin"))
+    if (! number(FIELD_PRICE, false, false, ret.price))
     {
-        throw violation_error("Missing free_margin attribute for method tick");
+        return fail(error, "Invalid price attribute type for method sync");
     }
 
-    value const &v_free_margin = obj.at("free_margin");
+    if (! has(FIELD_QTY))
+    {
+        return fail(error, "Missing qty attribute for method sync");
+    }
 
-    if (v_free_margin.kind() == kind::double_)
+    if (is(FIELD_QTY, value_kind::UINT64))
     {
-        ret.free_margin = v_free_margin.get_double();
+        ret.qty = uint64_[FIELD_QTY];
     }
-    else if (v_free_margin.kind() == kind::int64)
+    else if (is(FIELD_QTY, value_kind::INT64))
     {
-        ret.free_margin = v_free_margin.get_int64();
+        ret.qty = int64_[FIELD_QTY];
     }
     else
     {
-        throw violation_error("Invalid free_margin attribute type for method tick");
+        return fail(error, "Invalid qty attribute type for method sync");
     }
 
-    return ret;
+    return true;
 }
 
-static open_notify make_open_notify(boost::json::object const &obj)
+bool sax_handler::build_tick(request::tick &ret, request::instrument_table &instruments, std::string &error)
 {
-    using namespace boost::json;
-
-    open_notify ret;
-
-    //
-    // Obtain instrument.
-    //
-
-    if (! obj.contains("instrument"))
+    if (! has(FIELD_INSTRUMENT))
     {
-        throw violation_error("Missing instrument attribute for method open_notify");
+        return fail(error, "Missing instrument attribute for method tick");
     }
 
-    value const &v_instrument = obj.at("instrument");
-
-    if (v_instrument.kind() != kind::string)
+    if (! is(FIELD_INSTRUMENT, value_kind::STRING))
     {
-        throw violation_error("Invalid instrument attribute type for method open_notify");
+        return fail(error, "Invalid instrument attribute type for method tick");
     }
 
-    ret.instrument = v_instrument.get_string().c_str();
+    ret.instrument = instruments.intern(strings_[FIELD_INSTRUMENT], ret.instrument_id);
 
-    //
-    // Obtain position ID.
-    //
-
-    if (! obj.contains("id"))
+    if (! has(FIELD_TIMESTAMP))
     {
-        throw violation_error("Missing id attribute for method open_notify");
+        return fail(error, "Missing timestamp attribute for method tick");
     }
 
-    value const &v_id = obj.at("id");
-
-    if (v_id.kind() != kind::string)
+    if (is(FIELD_TIMESTAMP, value_kind::INT64))
     {
-        throw violation_error("Invalid id attribute type for method open_notify");
+        ret.request_time.set(int64_[FIELD_TIMESTAMP]);
     }
+    else if (is(FIELD_TIMESTAMP, value_kind::STRING))
+    {
+        std::int64_t millis;
 
-    ret.id = v_id.get_string().c_str();
-
-    //
-    // Obtain status.
-    //
+        if (! parse_timestamp(strings_[FIELD_TIMESTAMP], millis))
+        {
+            return fail(error, "Invalid format of timestamp attribute for method tick");
+        }
 
-    if (! obj.contains("status"))
+        ret.request_time.set(millis);
+    }
+    else
     {
-        throw violation_error("Missing status attribute for method open_notify");
+        return fail(error, "Invalid timestamp attribute type for method tick");
     }
 
-    value const &v_status = obj.at("status");
-
-    if (v_status.kind() != kind::bool_)
+    if (! has(FIELD_ASK))
     {
-        throw violation_error("Invalid status attribute type for method open_notify");
+        return fail(error, "Missing ask attribute for method tick");
     }
 
-    ret.status = v_status.get_bool();
-
-    //
-    // Obtain final transaction price.
-    //
+    if (! number(FIELD_ASK, true, true, ret.ask))
+    {
+        return fail(error, "Invalid ask attribute type for method tick");
+    }
 
-    if (! obj.contains("price"))
+    if (! has(FIELD_BID))
     {
-        throw violation_error("Missing price attribute for method open_notify");
+        return fail(error, "Missing bid attribute for method tick");
     }
 
-    value const &v_price = obj.at("price");
+    if (! number(FIELD_BID, true, true, ret.bid))
+    {
+        return fail(error, "Invalid bid attribute type for method tick");
+    }
 
-    if (v_price.kind() == kind::double_)
+    if (! has(FIELD_EQUITY))
     {
-        ret.price = v_price.get_double();
+        return fail(error, "Missing equity attribute for method tick");
     }
-    else if (v_price.kind() == kind::int64)
+
+    if (! number(FIELD_EQUITY, true, false, ret.equity))
     {
-        ret.price = v_price.get_int64();
+        return fail(error, "Invalid equity attribute type for method tick");
     }
-    else if (v_price.kind() == kind::uint64)
+
+    if (! has(FIELD_FREE_MARGIN))
     {
-        ret.price = v_price.get_uint64();
+        return fail(error, "Missing free_margin attribute for method tick");
     }
-    else
+
+    if (! number(FIELD_FREE_MARGIN, true, false, ret.free_margin))
     {
-        throw violation_error("Invalid price attribute type for method open_notify");
+        return fail(error, "Invalid free_margin attribute type for method tick");
     }
 
-    return ret;
+    return true;
 }
 
-static close_notify make_close_notify(boost::json::object const &obj)
+bool sax_handler::build_notify(double &price, bool &status, std::string &id, const char *method, std::string &error)
 {
-    using namespace boost::json;
-
-    close_notify ret;
-
-    //
-    // Obtain instrument.
-    //
-
-    if (! obj.contains("instrument"))
+    if (! has(FIELD_ID))
     {
-        throw violation_error("Missing instrument attribute for method close_notify");
-    }
-
-    value const &v_instrument = obj.at("instrument");
+        error = std::string("Missing id attribute for method ") + method;
 
-    if (v_instrument.kind() != kind::string)
-    {
-        throw violation_error("Invalid instrument attribute type for method close_notify");
+        return false;
     }
 
-    ret.instrument = v_instrument.get_string().c_str();
-
-    //
-    // Obtain position ID.
-    //
-
-    if (! obj.contains("id"))
+    if (! is(FIELD_ID, value_kind::STRING))
     {
-        throw violation_error("Missing id attribute for method close_notify");
+        error = std::string("Invalid id attribute type for method ") + method;
+
+        return false;
     }
 
-    value const &v_id = obj.at("id");
+    id = strings_[FIELD_ID];
 
-    if (v_id.kind() != kind::string)
+    if (! has(FIELD_STATUS))
     {
-        throw violation_error("Invalid id attribute type for method close_notify");
-    }
-
-    ret.id = v_id.get_string().c_str();
+        error = std::string("Missing status attribute for method ") + method;
 
-    //
-    // Obtain status.
-    //
+        return false;
+    }
 
-    if (! obj.contains("status"))
+    if (! is(FIELD_STATUS, value_kind::BOOL))
     {
-        throw violation_error("Missing status attribute for method close_notify");
+        error = std::string("Invalid status attribute type for method ") + method;
+
+        return false;
     }
 
-    value const &v_status = obj.at("status");
+    status = bool_[FIELD_STATUS];
 
-    if (v_status.kind() != kind::bool_)
+    if (! has(FIELD_PRICE))
     {
-        throw violation_error("Invalid status attribute type for method close_notify");
-    }
-
-    ret.status = v_status.get_bool();
+        error = std::string("Missing price attribute for method ") + method;
 
-    //
-    // Obtain final transaction price.
-    //
+        return false;
+    }
 
-    if (! obj.contains("price"))
+    if (! number(FIELD_PRICE, true, true, price))
     {
-        throw violation_error("Missing price attribute for method close_notify");
+        error = std::string("Invalid price attribute type for method ") + method;
+
+        return false;
     }
 
-    value const &v_price = obj.at("price");
+    return true;
+}
 
-    if (v_price.kind() == kind::double_)
-    {
-        ret.price = v_price.get_double();
-    }
-    else if (v_price.kind() == kind::int64)
+bool sax_handler::build_cid(std::int64_t &cid, std::string &error)
+{
+    if (! has(FIELD_CID))
     {
-        ret.price = v_price.get_int64();
+        cid = request::NO_CID;
+
+        return true;
     }
-    else if (v_price.kind() == kind::uint64)
+
+    if (is(FIELD_CID, value_kind::INT64) && int64_[FIELD_CID] >= 0)
     {
-        ret.price = v_price.get_uint64();
+        cid = int64_[FIELD_CID];
+
+        return true;
     }
-    else
+    else if (is(FIELD_CID, value_kind::UINT64) && uint64_[FIELD_CID] <= INT64_MAX)
     {
-        throw violation_error("Invalid price attribute type for method close_notify");
+        cid = uint64_[FIELD_CID];
+
+        return true;
     }
 
-    return ret;
+    return fail(error, "Invalid cid attribute");
 }
 
-} /* namespace request */
+} /* namespace */
 
-request::generic parse_request_payload(const std::string &json_data)
+class request_parser::impl
 {
-    using namespace boost::json;
+public:
 
-    value jv;
+    impl(void)
+        : parser_(boost::json::parse_options())
+    {}
 
-    try
+    bool parse(const char *json_data, std::size_t length, request::holder &req)
     {
-        jv = parse(json_data);
-    }
-    catch (const system_error &e)
-    {
-        throw request::violation_error("JSON parse error");
-    }
+        auto &handler = parser_.handler();
 
-    if (jv.kind() == kind::object)
-    {
-        object const &obj = jv.get_object();
+        handler.clear();
+        parser_.reset();
+
+        boost::json::error_code ec;
+        std::size_t n = parser_.write_some(false, json_data, length, ec);
 
-        if (obj.empty())
+        if (! ec && n < length)
         {
-            throw request::violation_error("Empty request");
+            ec = boost::json::error::extra_data;
         }
 
-        if (! obj.contains("method"))
+        if (ec)
         {
-            throw request::violation_error("Missing method");
+            error_ = "JSON parse error";
+
+            return false;
         }
 
-        value const &v = obj.at("method");
+        return handler.build(req, instruments_, error_);
+    }
 
-        if (v.kind() != kind::string)
-        {
-            throw request::violation_error("Invalid method type");
-        }
+    std::string error_;
+    request::instrument_table instruments_;
 
-        std::string method = v.get_string().c_str();
+private:
 
-        //
-        // The order of checking should depend on
-        // the frequency of the request type.
-        //
+    boost::json::basic_parser<sax_handler> parser_;
+};
 
-        if (method == "tick")
-        {
-            return request::make_tick(obj);
-        }
-        else if (method == "open_notify")
-        {
-            return request::make_open_notify(obj);
-        }
-        else if (method == "close_notify")
-        {
-            return request::make_close_notify(obj);
-        }
-        else if (method == "sync")
-        {
-            return request::make_sync(obj);
-        }
-        else if (method == "init")
-        {
-            return request::make_init(obj);
-        }
+request_parser::request_parser(void)
+    : impl_(new impl)
+{
+}
 
-        std::string error_message = std::string("Illegal method: ") + method;
+request_parser::~request_parser(void)
+{
+}
 
-        throw request::violation_error(error_message);
-    }
-    else
-    {
-        throw request::violation_error("Bad request");
-    }
+bool request_parser::parse(const char *json_data, std::size_t length, request::holder &req)
+{
+    return impl_ -> parse(json_data, length, req);
+}
+
+const std::string &request_parser::get_error_message(void) const
+{
+    return impl_ -> error_;
+}
+
+void request_parser::set_instruments(const std::vector<std::string> &instruments)
+{
+    impl_ -> instruments_.assign(instruments);
 }
 
 } /* namespace protocol */
@@ -14,6 +14,8 @@
 **                                                                    **
 \**********************************************************************/
 
+#include <charconv>
+
 #include <boost/json.hpp>
 
 #include <hft_response.hpp>
@@ -21,73 +23,185 @@
 namespace hft {
 namespace protocol {
 
-std::string response::serialize(void) const
+response &response::operator=(const response &other)
 {
-    using namespace boost::json;
+    error_message_ = other.error_message_;
+    instrument_storage_ = other.instrument_storage_;
+    instrument_id_ = other.instrument_id_;
+    new_positions_ = other.new_positions_;
+    close_positions_ = other.close_positions_;
+    cid_ = other.cid_;
+
+    //
+    // Name owned by the other response must
+    // be rebound to our own copy.
+    //
+
+    if (other.instrument_.data() == other.instrument_storage_.data())
+    {
+        instrument_ = instrument_storage_;
+    }
+    else
+    {
+        instrument_ = other.instrument_;
+    }
+
+    return *this;
+}
+
+namespace {
+
+//
+// Response payloads are written directly into caller's
+// buffer, no intermediate JSON objects or strings.
+//
+
+const char ack_payload[] = "{\"status\":\"ack\"}\n";
+
+void append_literal(std::string &out, const char *literal)
+{
+    out.append(literal);
+}
+
+void append_string(std::string &out, std::string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    out.push_back('"');
+
+    for (char c : s)
+    {
+        switch (c)
+        {
+            case '"':  out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b");  break;
+            case '\f': out.append("\\f");  break;
+            case '\n': out.append("\\n");  break;
+            case '\r': out.append("\\r");  break;
+            case '\t': out.append("\\t");  break;
+            default:
+                 if (static_cast<unsigned char>(c) < 0x20)
+                 {
+                     out.append("\\u00");
+                     out.push_back(hex[(c >> 4) & 0x0F]);
+                     out.push_back(hex[c & 0x0F]);
+                 }
+                 else
+                 {
+                     out.push_back(c);
+                 }
+        }
+    }
+
+    out.push_back('"');
+}
+
+template <typename T>
+void append_number(std::string &out, T value)
+{
+    char buffer[32];
+
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    out.append(buffer, result.ptr - buffer);
+}
 
+} /* namespace */
+
+std::string response::serialize(void) const
+{
     std::string ret;
 
+    serialize(ret);
+
+    return ret;
+}
+
+void response::serialize(std::string &out) const
+{
     if (error_message_.empty() && new_positions_.empty() && close_positions_.empty())
     {
-        ret = "{\"status\":\"ack\"}\n";
+        if (cid_ < 0)
+        {
+            out.append(ack_payload, sizeof(ack_payload) - 1);
+        }
+        else
+        {
+            append_literal(out, "{\"status\":\"ack\",\"cid\":");
+            append_number(out, cid_);
+            append_literal(out, "}\n");
+        }
 
-        return ret;
+        return;
     }
 
     if (! error_message_.empty())
     {
-        object obj;
-        obj["status"] = "error";
-        obj["message"] = error_message_;
+        append_literal(out, "{\"status\":\"error\",\"message\":");
+        append_string(out, error_message_);
+
+        if (cid_ >= 0)
+        {
+            append_literal(out, ",\"cid\":");
+            append_number(out, cid_);
+        }
 
-        ret = boost::json::serialize(obj);
-        ret += std::string("\n");
+        append_literal(out, "}\n");
 
-        return ret;
+        return;
     }
 
-    object obj, cp_obj, op_obj;
-    obj["status"] = "advice";
-    obj["instrument"] = instrument_;
-
-    array arr;
+    append_literal(out, "{\"status\":\"advice\",\"instrument\":");
+    append_string(out, instrument_);
+    append_literal(out, ",\"operations\":[");
 
-    cp_obj["op"] = "close";
+    bool first = true;
 
     for (auto &item : close_positions_)
     {
-        cp_obj["id"] = item;
+        append_literal(out, first ? "{\"op\":\"close\",\"id\":" : ",{\"op\":\"close\",\"id\":");
+        append_string(out, item);
+        out.push_back('}');
 
-        arr.emplace_back(cp_obj);
+        first = false;
     }
 
     for (auto &item : new_positions_)
     {
+        append_literal(out, first ? "{\"op\":" : ",{\"op\":");
+
         if (item.pd_ == position_direction::POSITION_LONG)
         {
-            op_obj["op"] = "LONG";
+            append_literal(out, "\"LONG\"");
         }
         else if (item.pd_ == position_direction::POSITION_SHORT)
         {
-            op_obj["op"] = "SHORT";
+            append_literal(out, "\"SHORT\"");
         }
         else
         {
-            op_obj["op"] = "?";
+            append_literal(out, "\"?\"");
         }
 
-        op_obj["id"]  = item.id_;
-        op_obj["qty"] = item.qty_;
+        append_literal(out, ",\"id\":");
+        append_string(out, item.id_);
+        append_literal(out, ",\"qty\":");
+        append_number(out, item.qty_);
+        out.push_back('}');
 
-        arr.emplace_back(op_obj);
+        first = false;
     }
 
-    obj["operations"] = arr;
+    out.push_back(']');
 
-    ret = boost::json::serialize(obj);
-    ret += std::string("\n");
+    if (cid_ >= 0)
+    {
+        append_literal(out, ",\"cid\":");
+        append_number(out, cid_);
+    }
 
-    return ret;
+    append_literal(out, "}\n");
 }
 
 void response::unserialize(const std::string &payload)
@@ -95,9 +209,12 @@ void response::unserialize(const std::string &payload)
     using namespace boost::json;
 
     error_message_.clear();
-    instrument_.clear();
+    instrument_ = std::string_view();
+    instrument_storage_.clear();
+    instrument_id_ = -1;
     new_positions_.clear();
     close_positions_.clear();
+    cid_ = -1;
 
     value jv;
 
@@ -136,6 +253,18 @@ void response::unserialize(const std::string &payload)
 
     std::string status = status_v.get_string().c_str();
 
+    if (obj.contains("cid"))
+    {
+        value const &cid_v = obj.at("cid");
+
+        if (cid_v.kind() != kind::int64)
+        {
+            throw response::violation_error("Invalid cid type");
+        }
+
+        cid_ = cid_v.get_int64();
+    }
+
     if (status == "ack")
     {
         return;
@@ -172,7 +301,7 @@ void response::unserialize(const std::string &payload)
             throw response::violation_error("Invalid instrument type");
         }
 
-        instrument_ = instrument_v.get_string().c_str();
+        set_instrument(instrument_v.get_string().c_str());
 
         if (! obj.contains("operations"))
         {
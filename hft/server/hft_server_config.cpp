@@ -25,11 +25,20 @@
 
 hft_server_config::hft_server_config(const std::string &xml_file_name)
     : log_severity_ {logging_severity::HFT_SEVERITY_INFO},
+      async_logging_ {false},
+      log_queue_size_ {8192},
+      log_overflow_ {async_log::overflow_policy::BLOCK},
       ipc_address_ {"127.0.0.1"},
       ipc_port_ {8137},
       metrics_active_ {false},
       metrics_address_ {"127.0.0.1"},
-      metrics_port_ {8138}
+      metrics_port_ {8138},
+      gateway_transport_ {gateway_transport::TCP},
+      unix_socket_path_ {"/var/run/hft/hft.sock"},
+      shm_name_ {"/hft-ipc"},
+      shm_slots_ {8},
+      workers_count_ {0},
+      workers_mode_ {workers_mode::IO_CONTEXTS}
 {
     using namespace rapidxml;
 
@@ -57,6 +66,71 @@ hft_server_config::hft_server_config(const std::string &xml_file_name)
         throw std::runtime_error("Bad xml config: no ‘hft’ node in file");
     }
 
+    //
+    // Stuff to parse:
+    //
+    //    <market-gateway-processes transport="unix" unix-socket="/var/run/hft/hft.sock">
+    //    <market-gateway-processes transport="shm" shm-name="/hft-ipc" shm-slots="8">
+    //
+
+    xml_node<> *gateways_node = root_node -> first_node("market-gateway-processes");
+
+    if (gateways_node != nullptr)
+    {
+        xml_attribute<> *transport_attr = gateways_node -> first_attribute("transport");
+
+        if (transport_attr != nullptr)
+        {
+            if (strcasecmp(transport_attr -> value(), "tcp") == 0)
+            {
+                gateway_transport_ = gateway_transport::TCP;
+            }
+            else if (strcasecmp(transport_attr -> value(), "unix") == 0)
+            {
+                gateway_transport_ = gateway_transport::UNIX;
+            }
+            else if (strcasecmp(transport_attr -> value(), "shm") == 0)
+            {
+                gateway_transport_ = gateway_transport::SHM;
+            }
+            else
+            {
+                throw std::runtime_error("Illegal ‘transport’ attribute value in ‘market-gateway-processes’ node in xml config");
+            }
+        }
+
+        xml_attribute<> *unix_socket_attr = gateways_node -> first_attribute("unix-socket");
+
+        if (unix_socket_attr != nullptr)
+        {
+            unix_socket_path_ = unix_socket_attr -> value();
+        }
+
+        xml_attribute<> *shm_name_attr = gateways_node -> first_attribute("shm-name");
+
+        if (shm_name_attr != nullptr)
+        {
+            shm_name_ = shm_name_attr -> value();
+
+            if (shm_name_.empty() || shm_name_[0] != '/')
+            {
+                throw std::runtime_error("Value of ‘shm-name’ attribute in ‘market-gateway-processes’ node must start with ‘/’");
+            }
+        }
+
+        xml_attribute<> *shm_slots_attr = gateways_node -> first_attribute("shm-slots");
+
+        if (shm_slots_attr != nullptr)
+        {
+            shm_slots_ = atoi(shm_slots_attr -> value());
+
+            if (shm_slots_ < 1)
+            {
+                throw std::runtime_error("Illegal ‘shm-slots’ attribute value in ‘market-gateway-processes’ node in xml config");
+            }
+        }
+    }
+
     xml_node<> *server_node = root_node -> first_node("server");
 
     if (server_node == nullptr)
@@ -143,6 +217,74 @@ hft_server_config::hft_server_config(const std::string &xml_file_name)
                 metrics_port_ = atoi(port_node -> value());
             }
         }
+        else if (node_name == "workers")
+        {
+            //
+            // Stuff to parse:
+            //
+            //    <workers count="4" mode="io-contexts">
+            //        <worker cpu="2"/>
+            //        <worker cpu="3"/>
+            //    </workers>
+            //
+
+            xml_attribute<> *count_attr = node -> first_attribute("count");
+
+            if (count_attr == nullptr)
+            {
+                throw std::runtime_error("Missing ‘count’ attribute in ‘workers’ node in xml config");
+            }
+
+            workers_count_ = atoi(count_attr -> value());
+
+            if (workers_count_ < 0)
+            {
+                throw std::runtime_error("Illegal ‘count’ attribute value in ‘workers’ node in xml config");
+            }
+
+            //
+            // Obtain ‘mode’ attribute, if present.
+            //
+
+            xml_attribute<> *mode_attr = node -> first_attribute("mode");
+
+            if (mode_attr != nullptr)
+            {
+                if (strcasecmp(mode_attr -> value(), "io-contexts") == 0)
+                {
+                    workers_mode_ = workers_mode::IO_CONTEXTS;
+                }
+                else if (strcasecmp(mode_attr -> value(), "strands") == 0)
+                {
+                    workers_mode_ = workers_mode::STRANDS;
+                }
+                else
+                {
+                    throw std::runtime_error("Illegal ‘mode’ attribute value in ‘workers’ node in xml config");
+                }
+            }
+
+            //
+            // Obtain CPU affinity of subsequent workers.
+            //
+
+            for (xml_node<> *worker_node = node -> first_node("worker"); worker_node; worker_node = worker_node -> next_sibling("worker"))
+            {
+                xml_attribute<> *cpu_attr = worker_node -> first_attribute("cpu");
+
+                if (cpu_attr == nullptr)
+                {
+                    throw std::runtime_error("Missing ‘cpu’ attribute in ‘worker’ node in xml config");
+                }
+
+                workers_cpus_.push_back(atoi(cpu_attr -> value()));
+            }
+
+            if (workers_cpus_.size() > static_cast<std::size_t>(workers_count_))
+            {
+                throw std::runtime_error("More ‘worker’ nodes than declared workers count in xml config");
+            }
+        }
         else if (node_name == "sms-alerts")
         {
             //
@@ -307,6 +449,60 @@ hft_server_config::hft_server_config(const std::string &xml_file_name)
 
                  throw std::runtime_error(error.str());
              }
+
+            //
+            // Optional asynchronous dispatch:
+            //
+            //    <logging severity="INFO" mode="async" queue-size="8192" overflow="block"/>
+            //
+
+            xml_attribute<> *mode_attr = node -> first_attribute("mode");
+
+            if (mode_attr != nullptr)
+            {
+                if (strcasecmp(mode_attr -> value(), "sync") == 0)
+                {
+                    async_logging_ = false;
+                }
+                else if (strcasecmp(mode_attr -> value(), "async") == 0)
+                {
+                    async_logging_ = true;
+                }
+                else
+                {
+                    throw std::runtime_error("Illegal ‘mode’ attribute value in ‘logging’ node in xml config");
+                }
+            }
+
+            xml_attribute<> *queue_size_attr = node -> first_attribute("queue-size");
+
+            if (queue_size_attr != nullptr)
+            {
+                log_queue_size_ = atoi(queue_size_attr -> value());
+
+                if (log_queue_size_ < 2)
+                {
+                    throw std::runtime_error("Illegal ‘queue-size’ attribute value in ‘logging’ node in xml config");
+                }
+            }
+
+            xml_attribute<> *overflow_attr = node -> first_attribute("overflow");
+
+            if (overflow_attr != nullptr)
+            {
+                if (strcasecmp(overflow_attr -> value(), "block") == 0)
+                {
+                    log_overflow_ = async_log::overflow_policy::BLOCK;
+                }
+                else if (strcasecmp(overflow_attr -> value(), "drop") == 0)
+                {
+                    log_overflow_ = async_log::overflow_policy::DROP;
+                }
+                else
+                {
+                    throw std::runtime_error("Illegal ‘overflow’ attribute value in ‘logging’ node in xml config");
+                }
+            }
         }
     }
 }
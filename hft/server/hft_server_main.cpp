@@ -21,9 +21,15 @@
 #include <marketplace_gateway_process.hpp>
 #include <hft_session.hpp>
 #include <basic_tcp_server.hpp>
+#include <basic_unix_server.hpp>
+#include <basic_shm_server.hpp>
 #include <hft_server_config.hpp>
 #include <deallocator.hpp>
+#include <io_context_pool.hpp>
 #include <metrics.hpp>
+#include <hft_trace.hpp>
+#include <async_log.hpp>
+#include <utilities.hpp>
 
 #include <boost/asio.hpp>
 #include <boost/asio/signal_set.hpp>
@@ -37,16 +43,69 @@ class hft_server : public basic_tcp_server<hft_session>
 {
 public:
 
-    using basic_tcp_server<hft_session>::basic_tcp_server;
+    hft_server(boost::asio::io_context &ioctx, const std::string &endpoint, short port, io_context_pool *workers)
+        : basic_tcp_server<hft_session>(ioctx, endpoint, port, select_context(ioctx, workers)),
+          workers_(workers)
+    {}
 
     ~hft_server(void)
     {
+        //
+        // Sessions cannot be destroyed
+        // while workers still serve them.
+        //
+
+        if (workers_)
+        {
+            workers_ -> stop();
+        }
+
         //
         // Destroy pending sessions, if any.
         //
 
         deallocator::cleanup();
     }
+
+    static context_selector select_context(boost::asio::io_context &ioctx, io_context_pool *workers)
+    {
+        if (workers)
+        {
+            return [workers](void) -> boost::asio::io_context & { return workers -> get_io_context(); };
+        }
+
+        return [&ioctx](void) -> boost::asio::io_context & { return ioctx; };
+    }
+
+private:
+
+    io_context_pool *workers_;
+};
+
+//
+// Local listener next to TCP one, for gateways
+// running on the same host.
+//
+
+class hft_local_server
+{
+public:
+
+    virtual ~hft_local_server(void) = default;
+};
+
+template <typename ServerType>
+class hft_local_server_adapter : public hft_local_server
+{
+public:
+
+    template <typename... Args>
+    hft_local_server_adapter(Args&&... args)
+        : server_(std::forward<Args>(args)...) {}
+
+private:
+
+    ServerType server_;
 };
 
 static struct hft_server_options_type
@@ -68,6 +127,46 @@ static struct hft_server_options_type
 
 static std::unique_ptr<daemon_process> server_daemon;
 
+//
+// SIGUSR2 dumps trace rings, see ‘hft trace-convert’.
+//
+
+static void dump_trace(void)
+{
+    if (! hft::trace::enabled)
+    {
+        hft_log(WARNING) << "Trace dump requested, but server is built without HFT_TRACE";
+
+        return;
+    }
+
+    std::string file_name = "/var/log/hft/hft-trace-" + std::to_string(getpid()) + "-"
+                            + std::to_string(hft::utils::get_current_timestamp()) + ".bin";
+
+    try
+    {
+        std::size_t n = hft::trace::dump(file_name);
+
+        hft_log(INFO) << "Trace dump ‘" << file_name << "’ written, " << n << " events";
+    }
+    catch (const std::exception &e)
+    {
+        hft_log(ERROR) << e.what();
+    }
+}
+
+static void wait_for_trace_dump(boost::asio::signal_set &trace_signal)
+{
+    trace_signal.async_wait([&trace_signal](const boost::system::error_code &error, int)
+                            {
+                                if (! error)
+                                {
+                                    dump_trace();
+                                    wait_for_trace_dump(trace_signal);
+                                }
+                            });
+}
+
 int hft_server_main(int argc, char *argv[])
 {
     //
@@ -183,7 +282,18 @@ int hft_server_main(int argc, char *argv[])
     // possible use by child processes.
     //
 
-    setenv("HFT_ENDPOINT", hft_srv_cfg.get_ipc_address().c_str(), 1);
+    switch (hft_srv_cfg.get_gateway_transport())
+    {
+        case hft_server_config::gateway_transport::UNIX:
+            setenv("HFT_ENDPOINT", ("unix:" + hft_srv_cfg.get_unix_socket_path()).c_str(), 1);
+            break;
+        case hft_server_config::gateway_transport::SHM:
+            setenv("HFT_ENDPOINT", ("shm:" + hft_srv_cfg.get_shm_name()).c_str(), 1);
+            break;
+        default:
+            setenv("HFT_ENDPOINT", hft_srv_cfg.get_ipc_address().c_str(), 1);
+    }
+
     setenv("HFT_PORT", std::to_string(hft_srv_cfg.get_ipc_port()).c_str(), 1);
 
     if (hftOption(start_as_daemon))
@@ -203,6 +313,16 @@ int hft_server_main(int argc, char *argv[])
         }
     }
 
+    //
+    // Writer thread is started after fork
+    // of daemon, threads do not survive it.
+    //
+
+    if (hft_srv_cfg.is_async_logging())
+    {
+        async_log::start(hft_srv_cfg.get_log_queue_size(), hft_srv_cfg.get_log_overflow());
+    }
+
     boost::asio::io_context ioctx;
 
     //
@@ -212,17 +332,72 @@ int hft_server_main(int argc, char *argv[])
     boost::asio::signal_set signals(ioctx, SIGINT, SIGTERM);
     signals.async_wait(boost::bind(&boost::asio::io_context::stop, &ioctx));
 
+    boost::asio::signal_set trace_signal(ioctx, SIGUSR2);
+    wait_for_trace_dump(trace_signal);
+
     try
     {
+        //
+        // Optional worker threads serving sessions. Main
+        // thread keeps acceptor, gateway processes, metrics
+        // server and signals anyway.
+        //
+
+        std::unique_ptr<io_context_pool> workers;
+
+        if (hft_srv_cfg.get_workers_count() > 0)
+        {
+            auto mode = (hft_srv_cfg.get_workers_mode() == hft_server_config::workers_mode::STRANDS
+                         ? io_context_pool::mode::STRANDS
+                         : io_context_pool::mode::CONTEXTS);
+
+            workers.reset(new io_context_pool(hft_srv_cfg.get_workers_count(), mode, hft_srv_cfg.get_workers_cpus()));
+        }
+
         marketplace_gateway_process gateway_process(ioctx, hftOption(config_file_name));
 
-        hft_server server(ioctx, hft_srv_cfg.get_ipc_address(), hft_srv_cfg.get_ipc_port());
+        hft_server server(ioctx, hft_srv_cfg.get_ipc_address(), hft_srv_cfg.get_ipc_port(), workers.get());
+
+        //
+        // Declared after TCP server, so it is gone
+        // before sessions are cleaned up.
+        //
+
+        std::unique_ptr<hft_local_server> local_server;
+
+        switch (hft_srv_cfg.get_gateway_transport())
+        {
+            case hft_server_config::gateway_transport::UNIX:
+                local_server.reset(new hft_local_server_adapter<basic_unix_server<hft_session>>(ioctx, hft_srv_cfg.get_unix_socket_path(),
+                                                                                               hft_server::select_context(ioctx, workers.get())));
+                break;
+            case hft_server_config::gateway_transport::SHM:
+                local_server.reset(new hft_local_server_adapter<basic_shm_server<hft_session>>(ioctx, hft_srv_cfg.get_shm_name(), hft_srv_cfg.get_shm_slots(),
+                                                                                              hft_server::select_context(ioctx, workers.get())));
+                break;
+            default:
+                break;
+        }
 
         if (hft_srv_cfg.is_metrics_active())
         {
             metrics::create_server(ioctx, hft_srv_cfg.get_metrics_address(), hft_srv_cfg.get_metrics_port());
         }
 
+        //
+        // Plugins and manifests are ready before the first
+        // session comes, nothing is served until workers and
+        // ioctx run. Preloaded after metrics are enabled, so
+        // that plugin load times get exported.
+        //
+
+        preload_instrument_handlers();
+
+        if (workers)
+        {
+            workers -> run();
+        }
+
         if (hftOption(start_as_daemon))
         {
             //
@@ -245,10 +420,19 @@ int hft_server_main(int argc, char *argv[])
 
         sms::alert(std::string("terminated server: ") + e.what());
 
+        async_log::stop();
+
         return 1;
     }
 
     hft_log(WARNING) << "*** Server terminated.";
 
+    //
+    // Workers and sessions are gone,
+    // nobody else logs anymore.
+    //
+
+    async_log::stop();
+
     return 0;
 }
@@ -14,13 +14,49 @@
 **                                                                    **
 \**********************************************************************/
 
+#include <algorithm>
+
 #include <boost/filesystem.hpp>
 
 #include <hft_session.hpp>
+#include <hft_trace.hpp>
 
 #define hft_log(__X__) \
     CLOG(__X__, "session")
 
+namespace {
+
+//
+// Copies request into lane slot, strings
+// of the slot keep their capacity.
+//
+
+void store_request(hft::protocol::request::holder &job, const hft::protocol::request::sync &msg)
+{
+    job.opcode = hft::protocol::request::sync::OPCODE;
+    job.sync_msg = msg;
+}
+
+void store_request(hft::protocol::request::holder &job, const hft::protocol::request::tick &msg)
+{
+    job.opcode = hft::protocol::request::tick::OPCODE;
+    job.tick_msg = msg;
+}
+
+void store_request(hft::protocol::request::holder &job, const hft::protocol::request::open_notify &msg)
+{
+    job.opcode = hft::protocol::request::open_notify::OPCODE;
+    job.open_notify_msg = msg;
+}
+
+void store_request(hft::protocol::request::holder &job, const hft::protocol::request::close_notify &msg)
+{
+    job.opcode = hft::protocol::request::close_notify::OPCODE;
+    job.close_notify_msg = msg;
+}
+
+} /* namespace */
+
 //
 // On production, should be undefined.
 //
@@ -31,6 +67,7 @@
 // Static member init.
 //
 
+std::mutex hft_session::pending_sessions_mtx_;
 std::set<std::string> hft_session::pending_sessions_;
 
 hft_session::hft_session(boost::asio::io_service &io_service)
@@ -45,8 +82,47 @@ hft_session::~hft_session(void)
     hft_log(INFO) << "Destructor got called";
     #endif
 
+    //
+    // Lane workers must be stopped before
+    // handlers they call are destroyed.
+    //
+
+    instrument_lanes_.clear();
+
+    //
+    // State of handlers for warm restart, session
+    // state writes it out when it goes away.
+    //
+
+    std::set<instrument_handler *> checkpointed;
+
+    for (auto &handler : instrument_handlers_)
+    {
+        if (! checkpointed.insert(handler.get()).second)
+        {
+            continue;
+        }
+
+        try
+        {
+            std::string state;
+
+            if (handler -> checkpoint(state))
+            {
+                pss_ -> set_warm_state(handler -> get_ticker_fmt2(), handler -> get_manifest_checksum(), state);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            hft_log(ERROR) << "Checkpoint of handler ‘" << handler -> get_ticker_fmt2()
+                           << "’ failed: " << e.what();
+        }
+    }
+
     if (! sessid_.empty())
     {
+        std::lock_guard<std::mutex> lck(pending_sessions_mtx_);
+
         auto it = pending_sessions_.find(sessid_);
 
         if (it != pending_sessions_.end())
@@ -97,7 +173,7 @@ bool hft_session::check_session_directory(const std::string &sessid)
 }
 
 
-void hft_session::handle_init_request(const hft::protocol::request::init &msg, std::string &response_payload)
+void hft_session::handle_init_request(const hft::protocol::request::init &msg, hft::protocol::response &resp)
 {
     #ifdef HFT_DEBUG
     hft_log(INFO) << "hft_session::handle_init_request: got called; sessid [" << msg.sessid << "], instruments:";
@@ -107,8 +183,6 @@ void hft_session::handle_init_request(const hft::protocol::request::init &msg, s
     }
     #endif
 
-    hft::protocol::response resp;
-
     if (! sessid_.empty())
     {
         hft_log(ERROR) << "Attempt to re-initialize session ‘"
@@ -117,31 +191,32 @@ void hft_session::handle_init_request(const hft::protocol::request::init &msg, s
 
         resp.error("Forbidden reinitialize session");
 
-        response_payload = resp.serialize();
-
         return;
     }
 
-    auto it = pending_sessions_.find(msg.sessid);
-
-    if (it != pending_sessions_.end())
+    if (! check_session_directory(msg.sessid))
     {
-        hft_log(ERROR) << "Cannot create session ‘" << msg.sessid << "’ because it is already pending";
-
-        resp.error("Session already pending");
-
-        response_payload = resp.serialize();
+        resp.error("Internal server error");
 
         return;
     }
 
-    if (! check_session_directory(msg.sessid))
     {
-        resp.error("Internal server error");
+        //
+        // Look up and claim session id atomically, two
+        // workers may initialize the same session at once.
+        //
 
-        response_payload = resp.serialize();
+        std::lock_guard<std::mutex> lck(pending_sessions_mtx_);
 
-        return;
+        if (! pending_sessions_.insert(msg.sessid).second)
+        {
+            hft_log(ERROR) << "Cannot create session ‘" << msg.sessid << "’ because it is already pending";
+
+            resp.error("Session already pending");
+
+            return;
+        }
     }
 
     //
@@ -149,16 +224,18 @@ void hft_session::handle_init_request(const hft::protocol::request::init &msg, s
     //
 
     sessid_ = msg.sessid;
-    pending_sessions_.insert(sessid_);
-    pss_.reset(new session_state(sessid_));
+    pss_.reset(new session_state(sessid_, msg.instrument_lanes));
 
     //
     // Create handlers for requested instruments.
     //
 
-    for (auto &instrument : msg.instruments)
+    for (std::size_t i = 0; i < msg.instruments.size(); i++)
     {
-        if (instrument_handlers_.find(instrument) == instrument_handlers_.end())
+        auto &instrument = msg.instruments[i];
+        std::size_t first = std::find(msg.instruments.begin(), msg.instruments.end(), instrument) - msg.instruments.begin();
+
+        if (first == i)
         {
             hft_log(INFO) << "Creating handler for instrument ‘"
                           << instrument << "’";
@@ -167,7 +244,7 @@ void hft_session::handle_init_request(const hft::protocol::request::init &msg, s
             {
                 std::shared_ptr<instrument_handler> handler;
                 handler.reset(create_instrument_handler(pss_, instrument));
-                instrument_handlers_.insert(std::pair<std::string, std::shared_ptr<instrument_handler> >(instrument, handler));
+                instrument_handlers_.push_back(handler);
             }
             catch (std::exception &e)
             {
@@ -181,223 +258,268 @@ void hft_session::handle_init_request(const hft::protocol::request::init &msg, s
         {
             hft_log(WARNING) << "Instrument handler ‘" << instrument
                              << "’ already created, ignoring";
-        }
-    }
-
-    response_payload = resp.serialize();
-
-    return;
-}
 
-void hft_session::handle_sync_request(const hft::protocol::request::sync &msg, std::string &response_payload)
-{
-    #ifdef HFT_DEBUG
-    hft_log(INFO) << "hft_session::handle_sync_request: got called";
-    hft_log(INFO) << "hft_session::handle_sync_request: instrument [" << msg.instrument << "]";
-    hft_log(INFO) << "hft_session::handle_sync_request: id [" << msg.id << "]";
-    hft_log(INFO) << "hft_session::handle_sync_request: direction [" << (msg.is_long ? "LONG" : "SHORT") << "]";
-    hft_log(INFO) << "hft_session::handle_sync_request: open price [" << msg.price << "]";
-    hft_log(INFO) << "hft_session::handle_sync_request: qty [" << msg.qty << "]";
-    #endif
-
-    hft::protocol::response resp {msg.instrument};
-
-    if (sessid_.empty())
-    {
-        hft_log(ERROR) << "Got SYNC request for uninitialized session.";
+            //
+            // Duplicate keeps its own id, so that
+            // ids match positions declared in init.
+            //
 
-        resp.error("Session uninitialized");
-
-        response_payload = resp.serialize();
+            instrument_handlers_.push_back(instrument_handlers_[first]);
+        }
 
-        return;
+        conflated_ticks_.push_back(instrument_handlers_[i] -> is_conflating()
+                                   ? metrics::make_counter("hft_conflated_ticks_total", "Total number of stale ticks dropped by conflation.",
+                                                           {{"market", sessid_}, {"instrument", instrument_handlers_[i] -> get_ticker_fmt2()}})
+                                   : metrics::counter());
     }
 
     //
-    // Find appropriate instrument handler, then dispatch notify to it.
+    // Handlers took what they needed from warm image.
     //
 
-    auto it = instrument_handlers_.find(msg.instrument);
+    pss_ -> release_warm_state();
 
-    if (it == instrument_handlers_.end())
+    if (msg.instrument_lanes)
     {
-        hft_log(ERROR) << "Unsubscribend instrument ‘"
-                       << msg.instrument << "’";
+        if (msg.pipeline_depth <= 1)
+        {
+            hft_log(WARNING) << "Session ‘" << sessid_ << "’ requested instrument lanes "
+                             << "in lockstep mode, handlers will not run in parallel";
+        }
 
-        std::string error_message = std::string("Unsubscribend instrument ‘")
-                                  + msg.instrument + std::string("’");
+        //
+        // Lane never holds more requests than
+        // client may have outstanding.
+        //
 
-        resp.error(error_message);
+        for (std::size_t i = 0; i < msg.instruments.size(); i++)
+        {
+            std::size_t first = std::find(msg.instruments.begin(), msg.instruments.end(), msg.instruments[i]) - msg.instruments.begin();
 
-        response_payload = resp.serialize();
+            if (first == i)
+            {
+                instrument_lane::job_handler on_conflate;
+
+                if (instrument_handlers_[i] -> is_conflating())
+                {
+                    on_conflate = [this](const hft::protocol::request::holder &job, hft::protocol::response &resp)
+                                  {
+                                      resp.set_cid(job.tick_msg.cid);
+                                      resp.set_instrument(job.tick_msg.instrument_id, job.tick_msg.instrument);
+                                      on_tick_conflated(job.tick_msg);
+                                  };
+                }
+
+                instrument_lanes_.push_back(std::make_shared<instrument_lane>(msg.pipeline_depth,
+                    [this](const hft::protocol::request::holder &job, hft::protocol::response &resp) { run_lane_job(job, resp); },
+                    [this](hft::protocol::response &resp, std::exception_ptr error) { complete_deferred(resp, error); },
+                    on_conflate));
+            }
+            else
+            {
+                instrument_lanes_.push_back(instrument_lanes_[first]);
+            }
+        }
 
-        return;
+        hft_log(INFO) << "Session ‘" << sessid_ << "’ runs instrument handlers on "
+                      << instrument_lanes_.size() << " lane(s)";
     }
 
-    auto as = pss_ -> create_autosaver();
-
-    it -> second -> on_sync(msg, resp);
-
-    response_payload = resp.serialize();
-
     return;
 }
 
-void hft_session::handle_tick_request(const hft::protocol::request::tick &msg, std::string &response_payload)
+template <typename T>
+void hft_session::dispatch_to_handler(const T &msg, hft::protocol::response &resp, const char *request_name,
+                                      void (instrument_handler::*on_request)(const T &, hft::protocol::response &))
 {
-    #ifdef HFT_DEBUG
-    hft_log(INFO) << "hft_session::handle_tick_request got called";
-    hft_log(INFO) << "hft_session::handle_tick_request: instrument [" << msg.instrument << "]";
-    hft_log(INFO) << "hft_session::handle_tick_request: ask [" << msg.ask << "]";
-    hft_log(INFO) << "hft_session::handle_tick_request: bid [" << msg.bid << "]";
-    hft_log(INFO) << "hft_session::handle_tick_request:  equity [" << msg.equity << "]";
-    #endif
-
-    hft::protocol::response resp {msg.instrument};
+    resp.set_instrument(msg.instrument_id, msg.instrument);
 
     if (sessid_.empty())
     {
-        hft_log(ERROR) << "Got TICK request for uninitialized session.";
+        hft_log(ERROR) << "Got " << request_name << " request for uninitialized session.";
 
         resp.error("Session uninitialized");
 
-        response_payload = resp.serialize();
-
         return;
     }
 
     //
-    // Find appropriate instrument handler, then dispatch notify to it.
+    // Find appropriate instrument handler, then dispatch request to it.
     //
 
-    auto it = instrument_handlers_.find(msg.instrument);
-
-    if (it == instrument_handlers_.end())
+    if (msg.instrument_id < 0 || msg.instrument_id >= static_cast<int>(instrument_handlers_.size()))
     {
         hft_log(ERROR) << "Unsubscribend instrument ‘"
                        << msg.instrument << "’";
 
         std::string error_message = std::string("Unsubscribend instrument ‘")
-                                  + msg.instrument + std::string("’");
+                                  + std::string(msg.instrument) + std::string("’");
 
         resp.error(error_message);
 
-        response_payload = resp.serialize();
-
         return;
     }
 
-    auto as = pss_ -> create_autosaver();
+    if (! instrument_lanes_.empty())
+    {
+        auto &lane = *instrument_lanes_[msg.instrument_id];
 
-    it -> second -> on_tick(msg, resp);
+        store_request(lane.prepare(), msg);
+        lane.commit();
 
-    response_payload = resp.serialize();
+        defer_response();
 
-    return;
+        return;
+    }
+
+    invoke_handler(msg, resp, on_request);
 }
 
-void hft_session::handle_open_notify_request(const hft::protocol::request::open_notify &msg, std::string &response_payload)
+template <typename T>
+void hft_session::invoke_handler(const T &msg, hft::protocol::response &resp,
+                                 void (instrument_handler::*on_request)(const T &, hft::protocol::response &))
 {
-    #ifdef HFT_DEBUG
-    hft_log(INFO) << "hft_session::handle_open_notify_request got called";
-    hft_log(INFO) << "hft_session::handle_open_notify_request: instrument [" << msg.instrument << "]";
-    hft_log(INFO) << "hft_session::handle_open_notify_request: id [" << msg.id << "]";
-    hft_log(INFO) << "hft_session::handle_open_notify_request: status [" << msg.status << "]";
-    hft_log(INFO) << "hft_session::handle_open_notify_request: price [" << msg.price << "]";
-    #endif
+    int family = latency_family(T::OPCODE, msg.instrument_id);
 
-    hft::protocol::response resp {msg.instrument};
-
-    if (sessid_.empty())
+    if (family == metrics::latency::NO_FAMILY)
     {
-        hft_log(ERROR) << "Got OPEN_NOTIFY request for uninitialized session.";
+        auto as = pss_ -> create_autosaver();
 
-        resp.error("Session uninitialized");
+        HFT_TRACE_BEGIN(trace_start);
 
-        response_payload = resp.serialize();
+        (instrument_handlers_[msg.instrument_id].get() ->* on_request)(msg, resp);
+
+        HFT_TRACE_END(trace_start, HANDLER, msg.instrument_id, T::OPCODE);
 
         return;
     }
 
     //
-    // Find appropriate instrument handler, then dispatch notify to it.
+    // Session state is saved when autosaver
+    // goes out of scope, that is persistence.
     //
 
-    auto it = instrument_handlers_.find(msg.instrument);
+    std::uint64_t handler_start = metrics::latency::now();
+    std::uint64_t handler_end;
 
-    if (it == instrument_handlers_.end())
     {
-        hft_log(ERROR) << "Unsubscribend instrument ‘"
-                       << msg.instrument << "’";
+        auto as = pss_ -> create_autosaver();
 
-        std::string error_message = std::string("Unsubscribend instrument ‘")
-                                  + msg.instrument + std::string("’");
+        HFT_TRACE_BEGIN(trace_start);
 
-        resp.error(error_message);
+        (instrument_handlers_[msg.instrument_id].get() ->* on_request)(msg, resp);
 
-        response_payload = resp.serialize();
+        handler_end = metrics::latency::now();
 
-        return;
+        HFT_TRACE_END(trace_start, HANDLER, msg.instrument_id, T::OPCODE);
     }
 
-    auto as = pss_ -> create_autosaver();
-
-    it -> second -> on_position_open(msg, resp);
-
-    response_payload = resp.serialize();
-
-    return;
+    metrics::latency::record(family, metrics::latency::HANDLER, handler_end - handler_start);
+    metrics::latency::record(family, metrics::latency::PERSIST, metrics::latency::now() - handler_end);
 }
 
-void hft_session::handle_close_notify_request(const hft::protocol::request::close_notify &msg, std::string &response_payload)
+void hft_session::run_lane_job(const hft::protocol::request::holder &job, hft::protocol::response &resp)
 {
-    #ifdef HFT_DEBUG
-    hft_log(INFO) << "hft_session::handle_close_notify_request got called";
-    hft_log(INFO) << "hft_session::handle_close_notify_request: instrument [" << msg.instrument << "]";
-    hft_log(INFO) << "hft_session::handle_close_notify_request: id [" << msg.id << "]";
-    hft_log(INFO) << "hft_session::handle_close_notify_request: status [" << msg.status << "]";
-    hft_log(INFO) << "hft_session::handle_close_notify_request: price [" << msg.price << "]";
-    #endif
-
-    hft::protocol::response resp {msg.instrument};
+    //
+    // Runs on lane thread. Response is fresh,
+    // so cid and instrument are set again.
+    //
 
-    if (sessid_.empty())
+    switch (job.opcode)
     {
-        hft_log(ERROR) << "Got CLOSE_NOTIFY request for uninitialized session.";
-
-        resp.error("Session uninitialized");
-
-        response_payload = resp.serialize();
-
-        return;
+        case hft::protocol::request::sync::OPCODE:
+             resp.set_cid(job.sync_msg.cid);
+             resp.set_instrument(job.sync_msg.instrument_id, job.sync_msg.instrument);
+             invoke_handler(job.sync_msg, resp, &instrument_handler::on_sync);
+             break;
+        case hft::protocol::request::tick::OPCODE:
+             resp.set_cid(job.tick_msg.cid);
+             resp.set_instrument(job.tick_msg.instrument_id, job.tick_msg.instrument);
+             invoke_handler(job.tick_msg, resp, &instrument_handler::on_tick);
+             break;
+        case hft::protocol::request::open_notify::OPCODE:
+             resp.set_cid(job.open_notify_msg.cid);
+             resp.set_instrument(job.open_notify_msg.instrument_id, job.open_notify_msg.instrument);
+             invoke_handler(job.open_notify_msg, resp, &instrument_handler::on_position_open);
+             break;
+        case hft::protocol::request::close_notify::OPCODE:
+             resp.set_cid(job.close_notify_msg.cid);
+             resp.set_instrument(job.close_notify_msg.instrument_id, job.close_notify_msg.instrument);
+             invoke_handler(job.close_notify_msg, resp, &instrument_handler::on_position_close);
+             break;
+        default:
+            throw std::runtime_error("Illegal request in instrument lane");
     }
+}
 
+bool hft_session::is_conflating(int instrument_id) const
+{
     //
-    // Find appropriate instrument handler, then dispatch notify to it.
+    // On lanes ticks wait in lane rings,
+    // lanes conflate on their own.
     //
 
-    auto it = instrument_handlers_.find(msg.instrument);
+    return instrument_lanes_.empty()
+           && instrument_id >= 0 && instrument_id < static_cast<int>(instrument_handlers_.size())
+           && instrument_handlers_[instrument_id] -> is_conflating();
+}
 
-    if (it == instrument_handlers_.end())
-    {
-        hft_log(ERROR) << "Unsubscribend instrument ‘"
-                       << msg.instrument << "’";
+void hft_session::on_tick_conflated(const hft::protocol::request::tick &msg)
+{
+    HFT_TRACE_INSTANT(CONFLATE, msg.instrument_id, 0);
 
-        std::string error_message = std::string("Unsubscribend instrument ‘")
-                                  + msg.instrument + std::string("’");
+    conflated_ticks_[msg.instrument_id].increment();
+}
 
-        resp.error(error_message);
+void hft_session::handle_sync_request(const hft::protocol::request::sync &msg, hft::protocol::response &resp)
+{
+    #ifdef HFT_DEBUG
+    hft_log(INFO) << "hft_session::handle_sync_request: got called";
+    hft_log(INFO) << "hft_session::handle_sync_request: instrument [" << msg.instrument << "]";
+    hft_log(INFO) << "hft_session::handle_sync_request: id [" << msg.id << "]";
+    hft_log(INFO) << "hft_session::handle_sync_request: direction [" << (msg.is_long ? "LONG" : "SHORT") << "]";
+    hft_log(INFO) << "hft_session::handle_sync_request: open price [" << msg.price << "]";
+    hft_log(INFO) << "hft_session::handle_sync_request: qty [" << msg.qty << "]";
+    #endif
 
-        response_payload = resp.serialize();
+    dispatch_to_handler(msg, resp, "SYNC", &instrument_handler::on_sync);
+}
 
-        return;
-    }
+void hft_session::handle_tick_request(const hft::protocol::request::tick &msg, hft::protocol::response &resp)
+{
+    #ifdef HFT_DEBUG
+    hft_log(INFO) << "hft_session::handle_tick_request got called";
+    hft_log(INFO) << "hft_session::handle_tick_request: instrument [" << msg.instrument << "]";
+    hft_log(INFO) << "hft_session::handle_tick_request: ask [" << msg.ask << "]";
+    hft_log(INFO) << "hft_session::handle_tick_request: bid [" << msg.bid << "]";
+    hft_log(INFO) << "hft_session::handle_tick_request:  equity [" << msg.equity << "]";
+    #endif
+
+    dispatch_to_handler(msg, resp, "TICK", &instrument_handler::on_tick);
+}
 
-    auto as = pss_ -> create_autosaver();
+void hft_session::handle_open_notify_request(const hft::protocol::request::open_notify &msg, hft::protocol::response &resp)
+{
+    #ifdef HFT_DEBUG
+    hft_log(INFO) << "hft_session::handle_open_notify_request got called";
+    hft_log(INFO) << "hft_session::handle_open_notify_request: instrument [" << msg.instrument << "]";
+    hft_log(INFO) << "hft_session::handle_open_notify_request: id [" << msg.id << "]";
+    hft_log(INFO) << "hft_session::handle_open_notify_request: status [" << msg.status << "]";
+    hft_log(INFO) << "hft_session::handle_open_notify_request: price [" << msg.price << "]";
+    #endif
 
-    it -> second -> on_position_close(msg, resp);
+    dispatch_to_handler(msg, resp, "OPEN_NOTIFY", &instrument_handler::on_position_open);
+}
 
-    response_payload = resp.serialize();
+void hft_session::handle_close_notify_request(const hft::protocol::request::close_notify &msg, hft::protocol::response &resp)
+{
+    #ifdef HFT_DEBUG
+    hft_log(INFO) << "hft_session::handle_close_notify_request got called";
+    hft_log(INFO) << "hft_session::handle_close_notify_request: instrument [" << msg.instrument << "]";
+    hft_log(INFO) << "hft_session::handle_close_notify_request: id [" << msg.id << "]";
+    hft_log(INFO) << "hft_session::handle_close_notify_request: status [" << msg.status << "]";
+    hft_log(INFO) << "hft_session::handle_close_notify_request: price [" << msg.price << "]";
+    #endif
 
-    return;
+    dispatch_to_handler(msg, resp, "CLOSE_NOTIFY", &instrument_handler::on_position_close);
 }
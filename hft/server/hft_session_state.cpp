@@ -15,61 +15,517 @@
 \**********************************************************************/
 
 #include <hft_session_state.hpp>
+#include <session_flusher.hpp>
 #include <hft_session.hpp>
 #include <instrument_handler.hpp>
 #include <utilities.hpp>
+#include <hft_trace.hpp>
 #include <boost/json.hpp>
+#include <boost/filesystem.hpp>
 #include <easylogging++.h>
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+
+#include <sys/stat.h>
+
 #define hft_log(__X__) \
     CLOG(__X__, "session_state")
 
-session_state::session_state(const std::string &sessid)
+namespace {
+
+//
+// Journal bigger than that is compacted
+// into snapshot on the next save.
+//
+
+constexpr std::uint64_t JOURNAL_COMPACTION_SIZE = 1024 * 1024;
+
+//
+// Optional ‘durability’ object of session_state.json,
+// missing one means commit on every request, no fsync.
+//
+
+durability_policy parse_durability(const boost::json::object &obj, const std::string &file_name)
+{
+    using namespace boost::json;
+
+    durability_policy policy {commit_policy::IMMEDIATE, std::chrono::milliseconds(0), 0, false};
+
+    if (! obj.contains("durability"))
+    {
+        return policy;
+    }
+
+    value const &durability_v = obj.at("durability");
+
+    if (durability_v.kind() != kind::object)
+    {
+        hft_log(ERROR) << "Bad JSON – attribute ‘durability’ not a object : "
+                       << file_name;
+
+        throw std::runtime_error("Session error");
+    }
+
+    object const &durability_obj = durability_v.get_object();
+
+    if (durability_obj.contains("fsync"))
+    {
+        value const &fsync_v = durability_obj.at("fsync");
+
+        if (fsync_v.kind() != kind::bool_)
+        {
+            hft_log(ERROR) << "Bad JSON – attribute ‘fsync’ of ‘durability’ not a boolean : "
+                           << file_name;
+
+            throw std::runtime_error("Session error");
+        }
+
+        policy.fsync = fsync_v.get_bool();
+    }
+
+    if (! durability_obj.contains("commit"))
+    {
+        return policy;
+    }
+
+    value const &commit_v = durability_obj.at("commit");
+
+    if (commit_v.kind() != kind::string)
+    {
+        hft_log(ERROR) << "Bad JSON – attribute ‘commit’ of ‘durability’ not a string : "
+                       << file_name;
+
+        throw std::runtime_error("Session error");
+    }
+
+    std::string commit_str = commit_v.get_string().c_str();
+
+    if (commit_str == "immediate")
+    {
+        return policy;
+    }
+
+    const char *limit_name;
+
+    if (commit_str == "interval")
+    {
+        policy.commit = commit_policy::INTERVAL;
+        limit_name = "interval_ms";
+    }
+    else if (commit_str == "requests")
+    {
+        policy.commit = commit_policy::REQUESTS;
+        limit_name = "requests";
+    }
+    else
+    {
+        hft_log(ERROR) << "Bad JSON – illegal value of ‘commit’ : "
+                       << file_name;
+
+        throw std::runtime_error("Session error");
+    }
+
+    if (! durability_obj.contains(limit_name) || ! durability_obj.at(limit_name).is_int64()
+            || durability_obj.at(limit_name).get_int64() <= 0 || durability_obj.at(limit_name).get_int64() > 86400000)
+    {
+        hft_log(ERROR) << "Bad JSON – attribute ‘" << limit_name << "’ of ‘durability’ missing or not a positive integer : "
+                       << file_name;
+
+        throw std::runtime_error("Session error");
+    }
+
+    int limit = durability_obj.at(limit_name).get_int64();
+
+    if (policy.commit == commit_policy::INTERVAL)
+    {
+        policy.interval = std::chrono::milliseconds(limit);
+    }
+    else
+    {
+        policy.requests = limit;
+    }
+
+    return policy;
+}
+
+} /* namespace */
+
+session_state::session_state(const std::string &sessid, bool concurrent, bool in_memory)
     : state_filename_ { hft_session::get_session_dir(sessid) + "/session_state.json" },
+      journal_filename_ { hft_session::get_session_dir(sessid) + "/session_state.journal" },
+      warm_image_filename_ { hft_session::get_session_dir(sessid) + "/session_state.warm" },
       sessid_ { sessid },
       mode_ { session_mode::PERSISTENT },
-      changed_ { false}
+      concurrent_ { concurrent },
+      in_memory_ { in_memory },
+      snapshot_needed_ { false },
+      snapshot_generation_ { 0 },
+      durability_ { commit_policy::IMMEDIATE, std::chrono::milliseconds(0), 0, false },
+      requests_since_flush_ { 0 },
+      dirty_ { false },
+      warm_image_present_ { false },
+      bytes_written_ { metrics::make_counter("hft_persist_bytes_written_total", "Total number of bytes of session state and files written to disk.", {{"market", sessid}}) },
+      flush_lag_ { metrics::make_histogram("hft_persist_flush_lag_seconds", "Time from the first change to the end of its flush.",
+                                           {0.0001, 0.001, 0.01, 0.1, 1.0, 10.0}, {{"market", sessid}}) }
 {
     el::Loggers::getLogger("session_state", true);
     load();
+
+    if (in_memory_)
+    {
+        //
+        // Nothing to flush in background.
+        //
+
+        durability_.commit = commit_policy::IMMEDIATE;
+    }
+
+    switch (durability_.commit)
+    {
+        case commit_policy::IMMEDIATE:
+            break;
+        case commit_policy::INTERVAL:
+            session_flusher::instance().attach(this, durability_.interval);
+            break;
+        case commit_policy::REQUESTS:
+            session_flusher::instance().attach(this, std::chrono::milliseconds(0));
+            break;
+    }
 }
 
 session_state::~session_state(void)
 {
+    if (durability_.commit != commit_policy::IMMEDIATE)
+    {
+        session_flusher::instance().detach(this);
+    }
+
+    //
+    // Clean shutdown leaves snapshot only,
+    // plus image for warm restart.
+    //
+
     try
     {
-        save();
+        flush(true);
+
+        if (mode_ == session_mode::PERSISTENT && ! in_memory_)
+        {
+            write_warm_image();
+        }
     }
-    catch (...)
+    catch (const std::exception &e)
     {
-        hft_log(ERROR) << "Failed to save " << state_filename_;
+        hft_log(ERROR) << "Failed to save " << state_filename_ << ": " << e.what();
     }
 }
 
 svr session_state::variable(instrument_handler *ph, const std::string &name, varscope scope)
 {
+    //
+    // Refused here rather than by
+    // journal on every flush.
+    //
+
+    if (name.size() > session_journal::MAX_KEY_LENGTH)
+    {
+        throw std::runtime_error("Session variable name too long");
+    }
+
+    //
+    // Map nodes are stable, references held
+    // by svr stay valid after unlocking.
+    //
+
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    //
+    // Changes are read by background flusher, unless
+    // they are committed by the request that made them.
+    //
+
+    bool lock_writes = (concurrent_ || durability_.commit != commit_policy::IMMEDIATE);
+
     if (scope == varscope::GLOBAL)
     {
-        return svr(changed_, variables_["global"][name]);
+        return svr(mtx_, concurrent_, lock_writes, changed_, slot("global", name));
+    }
+
+    return svr(mtx_, concurrent_, lock_writes, changed_, slot(ph -> get_ticker_fmt2(), name));
+}
+
+session_variable &session_state::slot(const std::string &scope, const std::string &name)
+{
+    auto &scope_vars = variables_[scope];
+    auto it = scope_vars.find(name);
+
+    if (it == scope_vars.end())
+    {
+        it = scope_vars.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(scope, name)).first;
     }
 
-    return svr(changed_, variables_[ph -> get_ticker_fmt2()][name]);
+    return it -> second;
+}
+
+void session_state::mark_dirty(void)
+{
+    if (! dirty_)
+    {
+        dirty_ = true;
+        dirty_since_ = std::chrono::steady_clock::now();
+    }
 }
 
 void session_state::save(void)
 {
-    using namespace boost::json;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        if (! changed_.empty())
+        {
+            mark_dirty();
+        }
+
+        if (durability_.commit == commit_policy::INTERVAL)
+        {
+            return;
+        }
+
+        if (durability_.commit == commit_policy::REQUESTS)
+        {
+            if (++requests_since_flush_ >= durability_.requests)
+            {
+                requests_since_flush_ = 0;
+                session_flusher::instance().request(this);
+            }
+
+            return;
+        }
+    }
+
+    flush(false);
+}
+
+void session_state::put_file(const std::string &file_name, const std::string &content)
+{
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        pending_files_[file_name] = content;
+        mark_dirty();
+
+        if (durability_.commit != commit_policy::IMMEDIATE)
+        {
+            return;
+        }
+    }
+
+    flush(false);
+}
+
+std::string session_state::get_file(const std::string &file_name)
+{
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        auto it = pending_files_.find(file_name);
+
+        if (it != pending_files_.end())
+        {
+            return it -> second;
+        }
+    }
+
+    //
+    // File taken out for flush is either being written
+    // or already there, wait for the flush in progress.
+    //
+
+    std::lock_guard<std::mutex> io_lck(io_mtx_);
+
+    return hft::utils::file_get_contents(file_name);
+}
+
+void session_state::flush(bool compact)
+{
+    if (in_memory_)
+    {
+        //
+        // Changes are not journaled, files stay
+        // pending, get_file() finds them there.
+        //
+
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        for (auto *v : changed_)
+        {
+            v -> dirty = false;
+        }
+
+        changed_.clear();
+        dirty_ = false;
+
+        return;
+    }
+
+    std::lock_guard<std::mutex> io_lck(io_mtx_);
+
+    std::map<std::string, std::string> files;
+    std::string snapshot;
+    bool write_snapshot = false;
+    std::uint64_t next_generation = 0;
+    bool was_dirty;
+    std::chrono::steady_clock::time_point dirty_since;
 
-    if (mode_ == session_mode::VOLATILE || ! changed_)
+    //
+    // Changes are taken out under the lock, IO is done
+    // with the lock released, so handlers are not held
+    // up by the disk.
+    //
+
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        files.swap(pending_files_);
+
+        was_dirty = dirty_;
+        dirty_since = dirty_since_;
+        dirty_ = false;
+        requests_since_flush_ = 0;
+
+        journal_batch_.clear();
+
+        if (mode_ == session_mode::PERSISTENT)
+        {
+            //
+            // Only what changed goes to the journal, in order of
+            // first change. Journal records carry final values.
+            //
+
+            for (auto *v : changed_)
+            {
+                session_journal::encode(journal_batch_, v -> scope, v -> name, v -> text());
+                v -> dirty = false;
+            }
+
+            changed_.clear();
+
+            bool journal_dirty = (journal_ -> size() > 0 || ! journal_batch_.empty());
+
+            if (snapshot_needed_ || (compact && journal_dirty)
+                    || journal_ -> size() + journal_batch_.size() > JOURNAL_COMPACTION_SIZE)
+            {
+                //
+                // Snapshot has every value, journal is reset
+                // only after it is in place. Snapshot names the
+                // next journal generation, so the old journal
+                // is not replayed over it, should we crash in
+                // between.
+                //
+
+                snapshot_needed_ = true;
+                write_snapshot = true;
+                next_generation = journal_ -> generation() + 1;
+                snapshot = serialize_snapshot(next_generation);
+            }
+        }
+    }
+
+    if (files.empty() && journal_batch_.empty() && ! write_snapshot)
     {
         return;
     }
 
+    HFT_TRACE_SCOPE(STATE_SAVE, -1);
+
+    if (warm_image_present_)
+    {
+        remove_warm_image();
+    }
+
+    std::uint64_t bytes = 0;
+
+    if (write_snapshot)
+    {
+        hft::utils::file_put_contents_atomic(state_filename_, snapshot, durability_.fsync);
+        bytes += snapshot.size();
+
+        journal_ -> reset(next_generation);
+
+        std::lock_guard<std::mutex> lck(mtx_);
+        snapshot_needed_ = false;
+    }
+    else if (! journal_batch_.empty())
+    {
+        try
+        {
+            journal_ -> append(journal_batch_);
+
+            if (durability_.fsync)
+            {
+                journal_ -> sync();
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+            snapshot_needed_ = true;
+
+            throw;
+        }
+
+        bytes += journal_batch_.size();
+    }
+
+    for (auto it = files.begin(); it != files.end(); it++)
+    {
+        try
+        {
+            hft::utils::file_put_contents_atomic(it -> first, it -> second, durability_.fsync);
+            bytes += it -> second.size();
+        }
+        catch (...)
+        {
+            //
+            // Unwritten files go back to pending,
+            // unless newer content is already there.
+            //
+
+            std::lock_guard<std::mutex> lck(mtx_);
+
+            for (; it != files.end(); it++)
+            {
+                pending_files_.emplace(it -> first, std::move(it -> second));
+            }
+
+            mark_dirty();
+
+            throw;
+        }
+    }
+
+    bytes_written_.increment(bytes);
+
+    if (was_dirty)
+    {
+        flush_lag_.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - dirty_since).count());
+    }
+}
+
+std::string session_state::serialize_snapshot(std::uint64_t journal_generation) const
+{
+    using namespace boost::json;
+
     //
     // Example structure to create:
     //
     // {
     //     "session_type": "simulation",
+    //     "durability": {"commit":"immediate","fsync":false},
+    //     "journal_generation": 3,
     //     "custom_session_variables" : [
     //         {"scope":"global","name":"xgrid.lockedby","value":"USDCHF"},
     //         {"scope":"EURUSD","name":"dupsko","value":"2"}
@@ -89,6 +545,28 @@ void session_state::save(void)
             break;
     }
 
+    object durability_object;
+
+    switch (durability_.commit)
+    {
+        case commit_policy::IMMEDIATE:
+            durability_object["commit"] = "immediate";
+            break;
+        case commit_policy::INTERVAL:
+            durability_object["commit"] = "interval";
+            durability_object["interval_ms"] = durability_.interval.count();
+            break;
+        case commit_policy::REQUESTS:
+            durability_object["commit"] = "requests";
+            durability_object["requests"] = durability_.requests;
+            break;
+    }
+
+    durability_object["fsync"] = durability_.fsync;
+
+    main_object["durability"] = durability_object;
+    main_object["journal_generation"] = journal_generation;
+
     array var_array;
     object var_array_object;
 
@@ -99,7 +577,7 @@ void session_state::save(void)
         for (auto &item2 : item1.second)
         {
             var_array_object["name"] = item2.first;
-            var_array_object["value"] = item2.second;
+            var_array_object["value"] = item2.second.text();
 
             var_array.emplace_back(var_array_object);
         }
@@ -107,14 +585,268 @@ void session_state::save(void)
 
     main_object["custom_session_variables"] = var_array;
 
-    std::string data = boost::json::serialize(main_object);
+    return boost::json::serialize(main_object);
+}
 
-    hft::utils::file_put_contents(state_filename_, data);
+void session_state::set_warm_state(const std::string &handler, std::uint32_t checksum, const std::string &state)
+{
+    std::string &entry = warm_states_[handler];
 
-    changed_ = false;
+    entry.assign(reinterpret_cast<const char *>(&checksum), sizeof(checksum));
+    entry += state;
+}
+
+bool session_state::get_warm_state(const std::string &handler, std::uint32_t checksum, std::string_view &state) const
+{
+    std::string_view payload;
+
+    if (! warm_image_ || ! warm_image_ -> find(session_snapshot::section::HANDLER, handler, payload)
+            || payload.size() < sizeof(checksum))
+    {
+        return false;
+    }
+
+    std::uint32_t stored_checksum;
+
+    memcpy(&stored_checksum, payload.data(), sizeof(stored_checksum));
+
+    if (stored_checksum != checksum)
+    {
+        hft_log(INFO) << "Config of handler ‘" << handler << "’ changed, warm state ignored";
+
+        return false;
+    }
+
+    state = payload.substr(sizeof(checksum));
+
+    return true;
+}
+
+void session_state::write_warm_image(void)
+{
+    std::string variables;
+
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        for (auto &item1 : variables_)
+        {
+            for (auto &item2 : item1.second)
+            {
+                session_journal::encode(variables, item1.first, item2.first, item2.second.text());
+            }
+        }
+    }
+
+    session_snapshot::writer image;
+
+    image.add(session_snapshot::section::VARIABLES, "", variables);
+
+    for (auto &item : warm_states_)
+    {
+        image.add(session_snapshot::section::HANDLER, item.first, item.second);
+    }
+
+    std::lock_guard<std::mutex> io_lck(io_mtx_);
+
+    image.write(warm_image_filename_, durability_.fsync);
+    warm_image_present_ = true;
+}
+
+void session_state::remove_warm_image(void)
+{
+    if (in_memory_)
+    {
+        warm_image_present_ = false;
+
+        return;
+    }
+
+    if (std::remove(warm_image_filename_.c_str()) != 0 && errno != ENOENT)
+    {
+        hft_log(ERROR) << "Unable to remove " << warm_image_filename_ << ": " << strerror(errno);
+    }
+
+    warm_image_present_ = false;
+}
+
+bool session_state::load_warm_image(void)
+{
+    if (! boost::filesystem::exists(warm_image_filename_))
+    {
+        return false;
+    }
+
+    //
+    // Image is written after journal is compacted into
+    // snapshot and removed before journal is appended.
+    // Image along with journal is not to be trusted.
+    //
+
+    if (session_journal::has_records(journal_filename_))
+    {
+        hft_log(WARNING) << "Journal not empty, ignoring " << warm_image_filename_;
+
+        remove_warm_image();
+
+        return false;
+    }
+
+    //
+    // Image is written after snapshot, snapshot newer
+    // than image was edited while server was down.
+    // Edits win over variables held in image.
+    //
+
+    struct stat image_st, snapshot_st;
+
+    if (stat(warm_image_filename_.c_str(), &image_st) == 0 && stat(state_filename_.c_str(), &snapshot_st) == 0
+            && (snapshot_st.st_mtim.tv_sec > image_st.st_mtim.tv_sec
+                || (snapshot_st.st_mtim.tv_sec == image_st.st_mtim.tv_sec && snapshot_st.st_mtim.tv_nsec > image_st.st_mtim.tv_nsec)))
+    {
+        hft_log(WARNING) << state_filename_ << " changed after " << warm_image_filename_
+                         << " was taken, ignoring image";
+
+        remove_warm_image();
+
+        return false;
+    }
+
+    std::string_view variables;
+
+    try
+    {
+        warm_image_.reset(new session_snapshot(warm_image_filename_));
+    }
+    catch (const std::runtime_error &e)
+    {
+        hft_log(WARNING) << e.what() << ", falling back to " << state_filename_;
+
+        remove_warm_image();
+
+        return false;
+    }
+
+    if (! warm_image_ -> find(session_snapshot::section::VARIABLES, "", variables))
+    {
+        hft_log(WARNING) << "Incomplete " << warm_image_filename_ << ", falling back to " << state_filename_;
+
+        warm_image_.reset();
+        remove_warm_image();
+
+        return false;
+    }
+
+    std::size_t consumed;
+    std::size_t records = session_journal::decode(variables.data(), variables.size(),
+                                                  [this](const std::string &scope, const std::string &name, const std::string &value)
+                                                  {
+                                                      slot(scope, name).assign_text(value);
+                                                  }, consumed);
+
+    warm_image_present_ = true;
+
+    hft_log(INFO) << "Warm restart from " << warm_image_filename_ << " taken at "
+                  << hft::utils::timestamp2string(warm_image_ -> get_creation_time())
+                  << ", " << records << " variables";
+
+    return true;
 }
 
 void session_state::load(void)
+{
+    //
+    // Session in memory is loaded the same way, only
+    // image and journal are not changed, not even if
+    // they turn out stale or damaged.
+    //
+
+    if (load_warm_image())
+    {
+        //
+        // Image holds variables only, settings
+        // are always taken from snapshot.
+        //
+
+        load_snapshot(true);
+
+        if (mode_ == session_mode::VOLATILE)
+        {
+            //
+            // Session turned volatile, it will not
+            // write image again, so nor is it kept.
+            //
+
+            remove_warm_image();
+
+            return;
+        }
+
+        if (in_memory_)
+        {
+            return;
+        }
+
+        journal_.reset(new session_journal(journal_filename_));
+
+        if (journal_ -> generation() != snapshot_generation_)
+        {
+            journal_ -> reset(snapshot_generation_);
+        }
+
+        return;
+    }
+
+    load_snapshot(false);
+
+    if (mode_ == session_mode::VOLATILE)
+    {
+        return;
+    }
+
+    //
+    // Changes made after the snapshot.
+    //
+
+    journal_.reset(new session_journal(journal_filename_, in_memory_));
+
+    if (journal_ -> generation() < snapshot_generation_)
+    {
+        //
+        // Crash right after compaction, snapshot
+        // already has everything journal has.
+        //
+
+        hft_log(INFO) << "Journal " << journal_filename_ << " of generation " << journal_ -> generation()
+                      << " is older than snapshot, discarding it";
+
+        if (! in_memory_)
+        {
+            journal_ -> reset(snapshot_generation_);
+        }
+
+        return;
+    }
+
+    if (journal_ -> generation() > snapshot_generation_)
+    {
+        hft_log(WARNING) << "Journal " << journal_filename_ << " of generation " << journal_ -> generation()
+                         << " is newer than snapshot of generation " << snapshot_generation_
+                         << ", replaying it anyway";
+    }
+
+    std::size_t records = journal_ -> replay([this](const std::string &scope, const std::string &name, const std::string &value)
+                                             {
+                                                 slot(scope, name).assign_text(value);
+                                             });
+
+    if (records > 0)
+    {
+        hft_log(INFO) << "Replayed " << records << " changes from " << journal_filename_;
+    }
+}
+
+void session_state::load_snapshot(bool settings_only)
 {
     using namespace boost::json;
 
@@ -128,7 +860,7 @@ void session_state::load(void)
     {
         hft_log(ERROR) << e.what();
 
-        changed_ = true;
+        snapshot_needed_ = true;
 
         return;
     }
@@ -201,6 +933,41 @@ void session_state::load(void)
         throw std::runtime_error("Session error");
     }
 
+    durability_ = parse_durability(obj, state_filename_);
+
+    //
+    // Generation of journal that applies on top of the
+    // snapshot, none in snapshot of older versions.
+    //
+
+    snapshot_generation_ = 0;
+
+    if (obj.contains("journal_generation"))
+    {
+        value const &generation_v = obj.at("journal_generation");
+
+        if (generation_v.kind() == kind::uint64)
+        {
+            snapshot_generation_ = generation_v.get_uint64();
+        }
+        else if (generation_v.kind() == kind::int64 && generation_v.get_int64() >= 0)
+        {
+            snapshot_generation_ = generation_v.get_int64();
+        }
+        else
+        {
+            hft_log(ERROR) << "Bad JSON – attribute ‘journal_generation’ not a non-negative integer : "
+                           << state_filename_;
+
+            throw std::runtime_error("Session error");
+        }
+    }
+
+    if (settings_only)
+    {
+        return;
+    }
+
     //
     // Variables.
     //
@@ -317,6 +1084,6 @@ void session_state::load(void)
         // Put together {scope, name, value} into variable map.
         //
 
-        variables_[var_scope][var_name] = var_value;
+        slot(var_scope, var_name).assign_text(var_value);
     }
 }
@@ -0,0 +1,256 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <hft_trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+
+//
+// Single writer ring. Writer fills the slot, then publishes
+// it by advancing head. Reader copies what is published and
+// drops slots writer might have reused meanwhile.
+//
+
+struct ring
+{
+    ring(void) : tid {static_cast<std::uint32_t>(syscall(SYS_gettid))}, head {0} {}
+
+    std::uint32_t tid;
+    std::atomic<std::uint64_t> head;
+    hft::trace::event events[hft::trace::RING_CAPACITY];
+};
+
+//
+// Rings outlive their threads, so events of finished
+// threads still make it to the dump. Ring of finished
+// thread is retired and handed over to the next thread
+// started, so short-lived threads (instrument lanes are
+// created per session) do not pile up rings.
+//
+
+std::mutex rings_mtx;
+std::vector<std::unique_ptr<ring> > rings;
+std::vector<ring *> retired_rings;
+
+ring *acquire_ring(void)
+{
+    std::lock_guard<std::mutex> lck(rings_mtx);
+
+    if (! retired_rings.empty())
+    {
+        ring *r = retired_rings.back();
+        retired_rings.pop_back();
+
+        //
+        // Writer is gone and dump holds the same lock,
+        // so nobody looks at the ring while it is reset.
+        //
+
+        r -> tid = static_cast<std::uint32_t>(syscall(SYS_gettid));
+        r -> head.store(0, std::memory_order_relaxed);
+
+        return r;
+    }
+
+    rings.push_back(std::unique_ptr<ring>(new ring));
+
+    return rings.back().get();
+}
+
+void retire_ring(ring *r)
+{
+    std::lock_guard<std::mutex> lck(rings_mtx);
+
+    retired_rings.push_back(r);
+}
+
+struct ring_owner
+{
+    ring_owner(void) : r {acquire_ring()} {}
+
+    ~ring_owner(void)
+    {
+        retire_ring(r);
+    }
+
+    ring *const r;
+};
+
+} /* namespace */
+
+namespace hft {
+namespace trace {
+
+const char *event_name(std::uint16_t id)
+{
+    static const char *names[EVENT_COUNT] = {
+        "read", "parse", "handler", "conflate", "state_save", "serialize", "write"
+    };
+
+    return (id < EVENT_COUNT ? names[id] : "unknown");
+}
+
+void record(event_id id, int instrument_id, std::uint64_t start, std::uint64_t duration, std::int64_t payload)
+{
+    thread_local ring_owner owner;
+    ring *r = owner.r;
+
+    std::uint64_t head = r -> head.load(std::memory_order_relaxed);
+    event &e = r -> events[head & (RING_CAPACITY - 1)];
+
+    e.start = start;
+    e.duration = duration;
+    e.payload = payload;
+    e.instrument_id = instrument_id;
+    e.id = id;
+    e.reserved = 0;
+
+    r -> head.store(head + 1, std::memory_order_release);
+}
+
+std::size_t dump(const std::string &file_name)
+{
+    std::vector<thread_events> snapshot;
+
+    {
+        std::lock_guard<std::mutex> lck(rings_mtx);
+
+        for (auto &r : rings)
+        {
+            thread_events te;
+            te.tid = r -> tid;
+
+            std::uint64_t head = r -> head.load(std::memory_order_acquire);
+            std::uint64_t first = (head > RING_CAPACITY ? head - RING_CAPACITY : 0);
+
+            te.events.resize(head - first);
+
+            for (std::uint64_t i = first; i < head; i++)
+            {
+                std::memcpy(&te.events[i - first], &r -> events[i & (RING_CAPACITY - 1)], sizeof(event));
+            }
+
+            //
+            // Writer kept going while we were copying, slots
+            // it has touched since then may be torn.
+            //
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            std::uint64_t last_head = r -> head.load(std::memory_order_relaxed);
+
+            if (last_head + 1 > first + RING_CAPACITY)
+            {
+                std::uint64_t torn = std::min<std::uint64_t>(last_head + 1 - RING_CAPACITY - first, te.events.size());
+
+                te.events.erase(te.events.begin(), te.events.begin() + torn);
+            }
+
+            snapshot.push_back(std::move(te));
+        }
+    }
+
+    std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+
+    if (! out)
+    {
+        throw std::runtime_error("Unable to create trace dump ‘" + file_name + "’");
+    }
+
+    dump_header header;
+    std::memcpy(header.magic, DUMP_MAGIC, sizeof(header.magic));
+    header.version = DUMP_VERSION;
+    header.thread_count = snapshot.size();
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::size_t total = 0;
+
+    for (auto &te : snapshot)
+    {
+        thread_header th {te.tid, static_cast<std::uint32_t>(te.events.size())};
+
+        out.write(reinterpret_cast<const char *>(&th), sizeof(th));
+        out.write(reinterpret_cast<const char *>(te.events.data()), te.events.size() * sizeof(event));
+
+        total += te.events.size();
+    }
+
+    if (! out)
+    {
+        throw std::runtime_error("Failed to write trace dump ‘" + file_name + "’");
+    }
+
+    return total;
+}
+
+std::vector<thread_events> load(const std::string &file_name)
+{
+    std::ifstream in(file_name, std::ios::binary);
+
+    if (! in)
+    {
+        throw std::runtime_error("Unable to open trace dump ‘" + file_name + "’");
+    }
+
+    dump_header header;
+
+    if (! in.read(reinterpret_cast<char *>(&header), sizeof(header))
+            || std::memcmp(header.magic, DUMP_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error("File ‘" + file_name + "’ is not a trace dump");
+    }
+
+    if (header.version != DUMP_VERSION)
+    {
+        throw std::runtime_error("Unsupported trace dump version " + std::to_string(header.version));
+    }
+
+    std::vector<thread_events> result(header.thread_count);
+
+    for (auto &te : result)
+    {
+        thread_header th;
+
+        if (! in.read(reinterpret_cast<char *>(&th), sizeof(th)))
+        {
+            throw std::runtime_error("Trace dump ‘" + file_name + "’ is truncated");
+        }
+
+        te.tid = th.tid;
+        te.events.resize(th.count);
+
+        if (! in.read(reinterpret_cast<char *>(te.events.data()), th.count * sizeof(event)))
+        {
+            throw std::runtime_error("Trace dump ‘" + file_name + "’ is truncated");
+        }
+    }
+
+    return result;
+}
+
+} /* namespace trace */
+} /* namespace hft */
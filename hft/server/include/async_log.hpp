@@ -0,0 +1,66 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __ASYNC_LOG_HPP__
+#define __ASYNC_LOG_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Asynchronous dispatch for easylogging++ loggers. Log line
+// is formatted on the calling thread, then passed through
+// a bounded lock-free queue to a background writer, which
+// appends lines to log files in batches, one write(2) per
+// file per batch. Standard output, when configured, is
+// still written synchronously.
+//
+// Replaces default easylogging++ dispatch for all loggers
+// until stop() is called. Files are rolled over at
+// MAX_LOG_FILE_SIZE by the writer.
+//
+
+namespace async_log {
+
+enum class overflow_policy
+{
+    BLOCK,   // Caller waits for free slot.
+    DROP     // Line is dropped and counted.
+};
+
+//
+// Queue capacity is rounded up to power of two.
+//
+
+void start(std::size_t queue_capacity, overflow_policy policy);
+
+//
+// Writes out everything queued, then restores
+// synchronous dispatch. No other thread may
+// log meanwhile.
+//
+
+void stop(void);
+
+//
+// Number of lines dropped on overflow so far.
+//
+
+std::uint64_t dropped(void);
+
+} /* namespace async_log */
+
+#endif /* __ASYNC_LOG_HPP__ */
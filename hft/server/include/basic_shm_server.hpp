@@ -0,0 +1,142 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __BASIC_SHM_SERVER_HPP__
+#define __BASIC_SHM_SERVER_HPP__
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <boost/asio.hpp>
+
+#include <easylogging++.h>
+
+#include <hft_shm_ring.hpp>
+
+#define hft_shmserver_log(__X__) \
+    CLOG(__X__, "SHM_server")
+
+//
+// Counterpart of basic_tcp_server for shared memory
+// transport. Watcher thread sleeps on segment doorbell
+// and hands every newly connected slot over to io_context
+// of acceptor, where session is created.
+//
+
+template <typename SessionType>
+class basic_shm_server
+{
+public:
+
+    typedef std::function<boost::asio::io_context &(void)> context_selector;
+
+    basic_shm_server(boost::asio::io_context &ioctx, const std::string &name, std::uint32_t slots, context_selector select_context)
+        : ioctx_(ioctx),
+          segment_(hft::ipc::map_segment(name, true, slots)),
+          select_context_(select_context),
+          terminate_(false)
+    {
+        el::Loggers::getLogger("SHM_server", true);
+
+        hft_shmserver_log(INFO) << "Server configured to listen "
+                                << "on shared memory ‘" << name
+                                << "’ with " << slots << " slot(s)";
+
+        watcher_ = std::thread(&basic_shm_server<SessionType>::watch, this);
+    }
+
+    virtual ~basic_shm_server(void)
+    {
+        terminate_ = true;
+        hft::ipc::notify(segment_ -> doorbell, segment_ -> doorbell_waiters);
+
+        if (watcher_.joinable())
+        {
+            watcher_.join();
+        }
+    }
+
+private:
+
+    void watch(void)
+    {
+        hft::ipc::segment *seg = segment_.get();
+
+        while (! terminate_)
+        {
+            std::uint32_t bell = seg -> doorbell.load();
+
+            for (std::uint32_t i = 0; i < seg -> slot_count; i++)
+            {
+                hft::ipc::slot &s = hft::ipc::get_slot(seg, i);
+
+                //
+                // Client which died before being served
+                // leaves the slot behind, reclaim it.
+                //
+
+                std::uint32_t state = s.state.load();
+
+                if ((state == hft::ipc::SLOT_CONNECTED || state == hft::ipc::SLOT_CLAIMED)
+                        && ! hft::ipc::process_alive(s.client_pid.load()) && s.client_pid.load() != 0)
+                {
+                    hft::ipc::free_slot(s);
+
+                    continue;
+                }
+
+                std::uint32_t expected = hft::ipc::SLOT_CONNECTED;
+
+                if (s.state.compare_exchange_strong(expected, hft::ipc::SLOT_SERVED))
+                {
+                    boost::asio::post(ioctx_, [this, &s](void) { handle_accept(s); });
+                }
+            }
+
+            if (seg -> doorbell.load() == bell)
+            {
+                hft::ipc::wait(seg -> doorbell, seg -> doorbell_waiters,
+                               [this, seg, bell](void) { return terminate_ || seg -> doorbell.load() != bell; },
+                               hft::ipc::WAIT_TIMEOUT_MS);
+            }
+        }
+    }
+
+    void handle_accept(hft::ipc::slot &s)
+    {
+        SessionType *new_session = new SessionType(select_context_());
+
+        hft_shmserver_log(INFO) << "Accepted shared memory client, pid "
+                                << s.client_pid.load();
+
+        //
+        // Client waits on response ring for acceptance.
+        //
+
+        hft::ipc::notify(s.response.seq, s.response.waiters);
+
+        new_session -> start(segment_, s);
+    }
+
+    boost::asio::io_context &ioctx_;
+    hft::ipc::segment_ptr segment_;
+    context_selector select_context_;
+    std::atomic<bool> terminate_;
+    std::thread watcher_;
+};
+
+#endif /* __BASIC_SHM_SERVER_HPP__ */
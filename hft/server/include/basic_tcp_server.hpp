@@ -18,6 +18,7 @@
 #define __BASIC_TCP_SERVER_HPP__
 
 #include <iostream>
+#include <functional>
 
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
@@ -34,9 +35,21 @@ class basic_tcp_server
 {
 public:
 
+    //
+    // Function choosing io_context of every
+    // newly accepted session.
+    //
+
+    typedef std::function<boost::asio::io_context &(void)> context_selector;
+
     basic_tcp_server(boost::asio::io_context &ioctx, const std::string &endpoint, short port)
+        : basic_tcp_server(ioctx, endpoint, port, [&ioctx](void) -> boost::asio::io_context & { return ioctx; })
+    {}
+
+    basic_tcp_server(boost::asio::io_context &ioctx, const std::string &endpoint, short port, context_selector select_context)
         : ioctx_(ioctx),
-          acceptor_(ioctx, tcp::endpoint(boost::asio::ip::address::from_string(endpoint), port))
+          acceptor_(ioctx, tcp::endpoint(boost::asio::ip::address::from_string(endpoint), port)),
+          select_context_(select_context)
     {
         //
         // Creates logger with id `TCP_IP_server'.
@@ -56,7 +69,7 @@ private:
 
     void start_accept(void)
     {
-        SessionType *new_session = new SessionType(ioctx_);
+        SessionType *new_session = new SessionType(select_context_());
 
         acceptor_.async_accept(new_session -> socket(), boost::bind(&basic_tcp_server<SessionType>::handle_accept, this, new_session, boost::asio::placeholders::error));
     }
@@ -80,6 +93,7 @@ private:
 
     boost::asio::io_context &ioctx_;
     tcp::acceptor acceptor_;
+    context_selector select_context_;
 };
 
 
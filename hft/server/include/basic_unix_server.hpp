@@ -0,0 +1,115 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __BASIC_UNIX_SERVER_HPP__
+#define __BASIC_UNIX_SERVER_HPP__
+
+#include <cstdio>
+#include <functional>
+
+#include <boost/bind.hpp>
+#include <boost/asio.hpp>
+
+#include <easylogging++.h>
+
+#define hft_unixserver_log(__X__) \
+    CLOG(__X__, "UNIX_server")
+
+//
+// Counterpart of basic_tcp_server listening on AF_UNIX
+// stream socket. Sessions are the same, their socket
+// is protocol agnostic.
+//
+
+template <typename SessionType>
+class basic_unix_server
+{
+public:
+
+    typedef std::function<boost::asio::io_context &(void)> context_selector;
+
+    basic_unix_server(boost::asio::io_context &ioctx, const std::string &path, context_selector select_context)
+        : ioctx_(ioctx),
+          path_(path),
+          acceptor_(ioctx, endpoint_of(path)),
+          select_context_(select_context)
+    {
+        el::Loggers::getLogger("UNIX_server", true);
+
+        hft_unixserver_log(INFO) << "Server configured to listen "
+                                 << "on socket ‘" << path_ << "’";
+
+        start_accept();
+    }
+
+    virtual ~basic_unix_server(void)
+    {
+        boost::system::error_code ec;
+
+        acceptor_.close(ec);
+        std::remove(path_.c_str());
+    }
+
+private:
+
+    static boost::asio::local::stream_protocol::endpoint endpoint_of(const std::string &path)
+    {
+        //
+        // Socket file left by previous
+        // server instance blocks bind.
+        //
+
+        std::remove(path.c_str());
+
+        return boost::asio::local::stream_protocol::endpoint(path);
+    }
+
+    void start_accept(void)
+    {
+        SessionType *new_session = new SessionType(select_context_());
+
+        acceptor_.async_accept(new_session -> socket(), boost::bind(&basic_unix_server<SessionType>::handle_accept, this, new_session, boost::asio::placeholders::error));
+    }
+
+    void handle_accept(SessionType *new_session, const boost::system::error_code &error)
+    {
+        if (! error)
+        {
+            new_session -> start();
+        }
+        else
+        {
+            hft_unixserver_log(ERROR) << "Terminate session because of system error: "
+                                      << error.message();
+
+            delete new_session;
+
+            if (error == boost::asio::error::operation_aborted)
+            {
+                return;
+            }
+        }
+
+        start_accept();
+    }
+
+    boost::asio::io_context &ioctx_;
+    std::string path_;
+    boost::asio::local::stream_protocol::acceptor acceptor_;
+    context_selector select_context_;
+};
+
+#endif /* __BASIC_UNIX_SERVER_HPP__ */
@@ -17,6 +17,7 @@
 #ifndef __DEALLOCATOR_HPP__
 #define __DEALLOCATOR_HPP__
 
+#include <mutex>
 #include <set>
 
 class deallocator
@@ -43,6 +44,7 @@ private:
 
     private:
 
+       std::mutex mtx_;
        std::set<void *> registered_;
     };
 
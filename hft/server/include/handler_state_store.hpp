@@ -0,0 +1,142 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HANDLER_STATE_STORE_HPP__
+#define __HANDLER_STATE_STORE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+//
+// Memory-mapped file of handler resource variables. Every
+// variable takes a run of fixed-size slots, twice: two
+// copies, of which the one last written is current. Change
+// is written to the other copy and published by sequence
+// number and checksum, so copy torn by crash is detected
+// and the previous one is used. Only pages touched since
+// the last sync() are synced.
+//
+// Layout, native endian:
+//
+//   header, 64 bytes: magic ‘HFTHSTA1’, u32 version,
+//                     u32 slot size, u32 slot count
+//   variable: two copies of run of slots, each copy:
+//             u8 type, u8 copy, u16 name length,
+//             u32 run length in slots, u32 value length,
+//             u32 sequence, u32 CRC-32, u32 reserved,
+//             name, value
+//
+// CRC-32 covers the copy from type to the end of value,
+// with CRC field zeroed. Copy is 0 or 1, it tells where
+// the run starts should the other copy be torn. Slot of
+// type 0 is free. Variable outgrowing its run moves to
+// new run at the end of file, sequence tells which one
+// is current should both remain.
+//
+
+class handler_state_store
+{
+public:
+
+    enum
+    {
+        SLOT_SIZE = 64,
+        MAX_NAME_LENGTH = 65535,
+        MAX_VALUE_LENGTH = 64 * 1024 * 1024
+    };
+
+    typedef std::function<void (char type, const std::string &name, const char *value, std::size_t length)> visitor;
+
+    //
+    // Opens the store, creates empty one if file does not exist.
+    // Store opened ‘read_only’ must exist, it cannot be changed.
+    //
+
+    explicit handler_state_store(const std::string &file_name, bool read_only = false);
+
+    ~handler_state_store(void);
+
+    handler_state_store(const handler_state_store &) = delete;
+
+    handler_state_store &operator=(const handler_state_store &) = delete;
+
+    void for_each(const visitor &v) const;
+
+    //
+    // Type is a non-zero tag chosen by caller, same
+    // name with different type is different variable.
+    //
+
+    void put(char type, const std::string &name, const void *value, std::size_t length);
+
+    //
+    // Schedules write back of touched pages, with
+    // ‘durable’ returns once they are on disk.
+    //
+
+    void sync(bool durable);
+
+private:
+
+    struct entry
+    {
+        std::uint32_t first;     // Slot of the first copy.
+        std::uint32_t run;       // Slots per copy.
+        std::uint32_t sequence;  // Of the current copy.
+        int current;             // 0 or 1.
+    };
+
+    void map(std::uint32_t slot_count);
+    void unmap(void);
+    void reserve(std::uint32_t slot_count);
+
+    char *slot(std::size_t index) const { return base_ + HEADER_SIZE + index * SLOT_SIZE; }
+    char *copy(const entry &e, int which) const { return slot(e.first + which * e.run); }
+
+    void write_copy(const entry &e, int which, std::uint32_t sequence, char type,
+                    const std::string &name, const void *value, std::size_t length);
+
+    void touch(const char *begin, std::size_t length);
+
+    enum { HEADER_SIZE = 64, INITIAL_SLOT_COUNT = 256 };
+
+    const std::string file_name_;
+    const bool read_only_;
+    int fd_;
+    char *base_;
+    std::size_t size_;
+    std::uint32_t slot_count_;
+    std::uint32_t used_;
+
+    //
+    // Type tag followed by name, to variable.
+    //
+
+    std::unordered_map<std::string, entry> index_;
+
+    //
+    // Byte range touched since the last
+    // sync, empty when begin >= end.
+    //
+
+    std::size_t dirty_begin_;
+    std::size_t dirty_end_;
+};
+
+#endif /* __HANDLER_STATE_STORE_HPP__ */
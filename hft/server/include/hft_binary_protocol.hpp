@@ -0,0 +1,159 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_BINARY_PROTOCOL_HPP__
+#define __HFT_BINARY_PROTOCOL_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <hft_request.hpp>
+#include <hft_response.hpp>
+
+//
+// Binary framing of the HFT protocol, negotiated by
+// client in init request ("framing":"binary"). Init
+// request and its response are always JSON, every
+// next request and response is binary frame.
+//
+// All integers and floating point numbers are stored
+// in little-endian byte order. Every frame starts with
+// 16-byte header:
+//
+//  offset  size  field
+//  0       2     magic (0x4846)
+//  2       1     opcode (request) or status (response)
+//  3       1     flags (bit 0: cid valid)
+//  4       2     instrument index (position in init
+//                instrument list, 0xFFFF if none)
+//  6       2     body length
+//  8       8     cid (correlation id)
+//
+// Request bodies:
+//
+//  tick (40 bytes):
+//   int64 timestamp (milliseconds since epoch), double ask,
+//   double bid, double equity, double free_margin
+//
+//  sync (56 bytes):
+//   int64 created on (milliseconds since epoch), double price,
+//   int32 qty, uint8 direction (1 - LONG, 0 - SHORT),
+//   3 bytes padding, char id[32]
+//
+//  open_notify, close_notify (48 bytes):
+//   double price, uint8 status, 7 bytes padding, char id[32]
+//
+// Response bodies:
+//
+//  ack: empty
+//  error: message text (not terminated)
+//  advice: sequence of 48-byte operations:
+//   uint8 op (0 - close, 1 - LONG, 2 - SHORT), 7 bytes
+//   padding, double qty, char id[32]
+//
+// Position identifiers shorter than 32 bytes are padded
+// with zeros.
+//
+
+namespace hft {
+namespace protocol {
+namespace binary {
+
+enum : std::uint16_t
+{
+    MAGIC = 0x4846,
+    NO_INSTRUMENT = 0xFFFF
+};
+
+enum : std::uint8_t
+{
+    FLAG_CID = 0x01
+};
+
+enum
+{
+    HEADER_SIZE      = 16,
+    ID_SIZE          = 32,
+    TICK_BODY_SIZE   = 40,
+    SYNC_BODY_SIZE   = 56,
+    NOTIFY_BODY_SIZE = 48,
+    OPERATION_SIZE   = 48
+};
+
+enum class status : std::uint8_t
+{
+    ACK    = 0,
+    ERROR  = 1,
+    ADVICE = 2
+};
+
+enum class operation : std::uint8_t
+{
+    CLOSE = 0,
+    LONG  = 1,
+    SHORT = 2
+};
+
+//
+// Returns size of the whole frame starting at ‘data’
+// or 0 if frame header is not complete yet. Throws
+// std::runtime_error on damaged header, since stream
+// cannot be resynchronized after that.
+//
+
+std::size_t frame_size(const char *data, std::size_t length);
+
+//
+// Methods used by server.
+//
+
+void decode_request(const char *frame, const std::vector<std::string> &instruments, request::holder &req);
+
+//
+// Tells from header of complete frame which instrument
+// it is tick of, -1 when it is not tick at all. Body
+// is not decoded.
+//
+
+int tick_instrument(const char *frame);
+
+void encode_response(const response &resp, std::uint16_t instrument_index, std::string &out);
+
+//
+// Methods used by client.
+//
+
+void encode_tick(std::uint16_t instrument_index, std::int64_t timestamp, double ask, double bid,
+                     double equity, double free_margin, std::int64_t cid, std::string &out);
+
+void encode_sync(std::uint16_t instrument_index, std::int64_t created_on, const std::string &id,
+                     bool is_long, double price, int qty, std::int64_t cid, std::string &out);
+
+void encode_open_notify(std::uint16_t instrument_index, const std::string &id, bool status,
+                            double price, std::int64_t cid, std::string &out);
+
+void encode_close_notify(std::uint16_t instrument_index, const std::string &id, bool status,
+                             double price, std::int64_t cid, std::string &out);
+
+void decode_response(const char *frame, std::size_t length,
+                         const std::vector<std::string> &instruments, response &resp);
+
+} /* namespace binary */
+} /* namespace protocol */
+} /* namespace hft */
+
+#endif /* __HFT_BINARY_PROTOCOL_HPP__ */
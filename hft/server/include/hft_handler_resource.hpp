@@ -18,8 +18,19 @@
 #define __HFT_HANDLER_RESOURCE__
 
 #include <map>
+#include <memory>
 #include <string>
 #include <stdexcept>
+#include <handler_state_store.hpp>
+
+//
+// Variables of instrument handler. Once persistent() is
+// called, they are kept in memory-mapped binary store and
+// written through on every change, save() syncs them.
+// Values found in the store override ones set before.
+// Resource ‘in_memory’ reads the store, but changes are
+// kept in memory only, no file is written.
+//
 
 class hft_handler_resource
 {
@@ -43,7 +54,12 @@ public:
 
     hft_handler_resource(void) = delete;
 
-    hft_handler_resource(const std::string &file_name, const std::string &logger_id);
+    //
+    // With ‘sync’ save() returns once
+    // changes are on disk.
+    //
+
+    hft_handler_resource(const std::string &file_name, const std::string &logger_id, bool sync = false, bool in_memory = false);
 
     ~hft_handler_resource(void);
 
@@ -64,11 +80,22 @@ public:
 
 private:
 
+    //
+    // One-time conversion of text file used before.
+    //
+
+    void migrate(const std::string &text_file_name);
     void process_line(const std::string &line);
 
-    static std::string string_to_hex(const std::string &in);
+    void restore(const handler_state_store &store);
+
     static std::string hex_to_string(const std::string &in);
 
+    void store_int(const std::string &var_name, int value);
+    void store_bool(const std::string &var_name, bool value);
+    void store_double(const std::string &var_name, double value);
+    void store_string(const std::string &var_name, const std::string &value);
+
     std::map<std::string, int> ints_;
     std::map<std::string, bool> bools_;
     std::map<std::string, double> doubles_;
@@ -78,6 +105,10 @@ private:
     bool changed_;
     const std::string file_name_;
     const std::string logger_id_;
+    const bool sync_;
+    const bool in_memory_;
+
+    std::unique_ptr<handler_state_store> store_;
 };
 
 #endif /* __HFT_HANDLER_RESOURCE__ */
@@ -17,7 +17,11 @@
 #ifndef __HFT_REQUEST_HPP__
 #define __HFT_REQUEST_HPP__
 
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <boost/variant2/variant.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -30,34 +34,110 @@ namespace request {
 
 DEFINE_CUSTOM_EXCEPTION_CLASS(violation_error, std::runtime_error)
 
+//
+// Every request may carry optional ‘cid’ attribute (correlation
+// id), which is echoed back in the response. Absent cid is
+// represented by NO_CID value.
+//
+
+constexpr std::int64_t NO_CID = -1;
+
+//
+// Maximum number of outstanding requests client
+// may declare in ‘pipeline’ attribute of init.
+//
+
+enum { MAX_PIPELINE_DEPTH = 1024 };
+
+//
+// Instruments declared in init get dense ids 0..n-1
+// in order of declaration. Any other instrument
+// has NO_INSTRUMENT id.
+//
+
+constexpr int NO_INSTRUMENT = -1;
+
+//
+// Point in time as milliseconds since Unix epoch. This is
+// what travels on the wire; ptime is built only when some
+// handler asks for it, then cached.
+//
+
+class epoch_time
+{
+public:
+
+    epoch_time(void)
+        : millis_ {0}, materialized_ {false} {}
+
+    void set(std::int64_t millis)
+    {
+        millis_ = millis;
+        materialized_ = false;
+    }
+
+    std::int64_t millis(void) const { return millis_; }
+
+    const boost::posix_time::ptime &ptime(void) const
+    {
+        if (! materialized_)
+        {
+            ptime_ = boost::posix_time::ptime(boost::gregorian::date(1970, boost::gregorian::Jan, 1))
+                     + boost::posix_time::milliseconds(millis_);
+            materialized_ = true;
+        }
+
+        return ptime_;
+    }
+
+    operator const boost::posix_time::ptime &(void) const { return ptime(); }
+
+private:
+
+    std::int64_t millis_;
+    mutable boost::posix_time::ptime ptime_;
+    mutable bool materialized_;
+};
+
+// {"method":"init","sessid":"icmarkets-session","instruments":["EUR/USD","GBP/USD"],"pipeline":32,"framing":"binary","lanes":true}
+// With ‘lanes’ every instrument handler runs on its own thread.
 struct init
 {
     enum { OPCODE = 0 };
 
+    std::int64_t cid;
     std::string sessid;
     std::vector<std::string> instruments;
+    int pipeline_depth;
+    bool binary_framing;
+    bool instrument_lanes;
 };
 
-// {"method":"sync","instrument":"EUR/USD","id":"a87f6d","direction":"LONG","price":1.23459,"qty":1000}
+// {"method":"sync","instrument":"EUR/USD","id":"a87f6d","timestamp":1572122731000,"direction":"LONG","price":1.23459,"qty":1000}
 struct sync
 {
     enum { OPCODE = 1 };
 
-    std::string instrument;
+    std::int64_t cid;
+    int instrument_id;
+    std::string_view instrument;
     std::string id;
-    boost::posix_time::ptime created_on;
+    epoch_time created_on;
     bool is_long;
     double price;
     int qty;
 };
 
-// {"method":"tick","instrument":"EUR/USD","timestamp":"2019-10-26 20:45:31.000","ask":1.3145,"bid":1.2456,"equity":56432}
+// {"method":"tick","instrument":"EUR/USD","timestamp":1572122731000,"ask":1.3145,"bid":1.2456,"equity":56432}
+// Timestamp may also be given as string ‘2019-10-26 20:45:31.000’.
 struct tick
 {
     enum { OPCODE = 2 };
 
-    std::string instrument;
-    boost::posix_time::ptime request_time;
+    std::int64_t cid;
+    int instrument_id;
+    std::string_view instrument;
+    epoch_time request_time;
     double ask;
     double bid;
     double equity;
@@ -69,7 +149,9 @@ struct open_notify
 {
     enum { OPCODE = 3 };
 
-    std::string instrument;
+    std::int64_t cid;
+    int instrument_id;
+    std::string_view instrument;
     std::string id;
     double price;
     bool status;
@@ -80,7 +162,9 @@ struct close_notify
 {
     enum { OPCODE = 4 };
 
-    std::string instrument;
+    std::int64_t cid;
+    int instrument_id;
+    std::string_view instrument;
     std::string id;
     double price;
     bool status;
@@ -92,9 +176,82 @@ typedef boost::variant2::variant<init,
                                  open_notify,
                                  close_notify> generic; 
 
+//
+// Reusable storage for incoming requests. Every request
+// type has its own slot filled in place by the parser,
+// so strings keep their capacity between requests and
+// steady state traffic does not allocate.
+//
+
+struct holder
+{
+    int opcode;
+
+    init init_msg;
+    sync sync_msg;
+    tick tick_msg;
+    open_notify open_notify_msg;
+    close_notify close_notify_msg;
+};
+
+//
+// Instrument names declared in init, looked up by name
+// to get dense id and the view of interned name. Names
+// outside of the table are kept in a single reused slot,
+// valid until next intern(). Views of declared names
+// stay valid until next assign().
+//
+
+class instrument_table
+{
+public:
+
+    void assign(const std::vector<std::string> &names) { names_ = names; }
+
+    std::string_view intern(std::string_view name, int &instrument_id);
+
+private:
+
+    std::vector<std::string> names_;
+    std::string unknown_;
+};
+
 } /* namespace request */
 
-request::generic parse_request_payload(const std::string &json_data);
+//
+// Single-pass (SAX) JSON request parser. Fills request
+// holder in place. Returns false on malformed request,
+// reason is available through get_error_message().
+//
+
+class request_parser
+{
+public:
+
+    request_parser(void);
+
+    ~request_parser(void);
+
+    request_parser(const request_parser &) = delete;
+
+    request_parser &operator=(const request_parser &) = delete;
+
+    bool parse(const char *json_data, std::size_t length, request::holder &req);
+
+    const std::string &get_error_message(void) const;
+
+    //
+    // Declares instruments subscribed in init.
+    //
+
+    void set_instruments(const std::vector<std::string> &instruments);
+
+private:
+
+    class impl;
+
+    std::unique_ptr<impl> impl_;
+};
 
 } /* namespace protocol */
 } /* namespace hft */
@@ -18,6 +18,10 @@
 #define __HFT_RESPONSE_HPP__
 
 #include <list>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <stdexcept>
 #include <custom_except.hpp>
 
 namespace hft {
@@ -47,11 +51,21 @@ public:
     };
 
     response(void)
+        : instrument_id_ {-1}, cid_ {-1}
     {};
 
     response(const std::string &instrument)
-        : instrument_ {instrument}
-    {}
+        : instrument_id_ {-1}, cid_ {-1}
+    {
+        set_instrument(instrument);
+    }
+
+    response(const response &other)
+    {
+        *this = other;
+    }
+
+    response &operator=(const response &other);
 
     ~response(void) = default;
 
@@ -61,10 +75,30 @@ public:
 
     std::string serialize(void) const;
 
+    //
+    // Appends serialized response to ‘out’, reusing its
+    // capacity. Nothing else is allocated on the way.
+    //
+
+    void serialize(std::string &out) const;
+
     void error(const std::string &message) { error_message_ = message; }
     void close_position(const std::string &id) { close_positions_.push_back(id); }
     void open_long(const std::string &id, double qty) { new_positions_.emplace_back(position_direction::POSITION_LONG, id, qty); }
     void open_short(const std::string &id, double qty) { new_positions_.emplace_back(position_direction::POSITION_SHORT, id, qty); }
+    void set_cid(std::int64_t cid) { cid_ = cid; }
+
+    //
+    // Server refers to instrument by its dense id and name
+    // owned by session, which outlives the response, so
+    // the name is not copied.
+    //
+
+    void set_instrument(int instrument_id, std::string_view instrument)
+    {
+        instrument_id_ = instrument_id;
+        instrument_ = instrument;
+    }
 
     //
     // Methods used by client.
@@ -72,18 +106,36 @@ public:
 
     void unserialize(const std::string &payload);
 
+    void set_instrument(std::string_view instrument)
+    {
+        instrument_storage_.assign(instrument.data(), instrument.size());
+        instrument_ = instrument_storage_;
+    }
+
     bool is_error(void) const { return !error_message_.empty(); }
     std::string get_error_message(void) const { return error_message_; }
-    std::string get_instrument(void) const { return instrument_; }
+    std::string_view get_instrument(void) const { return instrument_; }
+    int get_instrument_id(void) const { return instrument_id_; }
     const std::list<open_position_info> &get_new_positions(void) const { return new_positions_; }
     const std::list<std::string> &get_close_positions(void) const { return close_positions_; }
+    bool has_cid(void) const { return cid_ >= 0; }
+    std::int64_t get_cid(void) const { return cid_; }
 
 private:
 
     std::string error_message_;
-    std::string instrument_;
+    std::string_view instrument_;
+    std::string instrument_storage_;
+    int instrument_id_;
     std::list<open_position_info> new_positions_;
     std::list<std::string> close_positions_;
+
+    //
+    // Correlation id of the request this response
+    // refers to, negative if request had none.
+    //
+
+    std::int64_t cid_;
 };
 
 } /* namespace protocol */
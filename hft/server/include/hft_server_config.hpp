@@ -18,6 +18,9 @@
 #define __HFT_SERVER_CONFIG__
 
 #include <sms_alert.hpp>
+#include <async_log.hpp>
+
+#include <vector>
 
 class hft_server_config
 {
@@ -28,6 +31,10 @@ public:
 
     std::string get_logging_config(void) const;
 
+    bool is_async_logging(void) const { return async_logging_; }
+    int get_log_queue_size(void) const { return log_queue_size_; }
+    async_log::overflow_policy get_log_overflow(void) const { return log_overflow_; }
+
     std::string get_ipc_address(void) const { return ipc_address_; }
     void override_ipc_address(const std::string &ipc_addr) { ipc_address_ = ipc_addr; }
     int get_ipc_port(void) const { return ipc_port_; }
@@ -42,6 +49,39 @@ public:
 
     const sms::config &get_sms_alert_config(void) const { return sms_config_; }
 
+    //
+    // Session worker threads. Zero workers means sessions
+    // are served by main thread together with gateway
+    // processes and metrics server.
+    //
+
+    enum class workers_mode
+    {
+        IO_CONTEXTS,
+        STRANDS
+    };
+
+    //
+    // Transport offered to gateway processes on top of
+    // TCP listener, which is always active.
+    //
+
+    enum class gateway_transport
+    {
+        TCP,
+        UNIX,
+        SHM
+    };
+
+    gateway_transport get_gateway_transport(void) const { return gateway_transport_; }
+    std::string get_unix_socket_path(void) const { return unix_socket_path_; }
+    std::string get_shm_name(void) const { return shm_name_; }
+    int get_shm_slots(void) const { return shm_slots_; }
+
+    int get_workers_count(void) const { return workers_count_; }
+    workers_mode get_workers_mode(void) const { return workers_mode_; }
+    const std::vector<int> &get_workers_cpus(void) const { return workers_cpus_; }
+
 private:
 
     enum logging_severity
@@ -55,6 +95,9 @@ private:
     };
 
     logging_severity log_severity_;
+    bool async_logging_;
+    int log_queue_size_;
+    async_log::overflow_policy log_overflow_;
 
     std::string ipc_address_;
     int ipc_port_;
@@ -64,6 +107,15 @@ private:
     int metrics_port_;
 
     sms::config sms_config_;
+
+    gateway_transport gateway_transport_;
+    std::string unix_socket_path_;
+    std::string shm_name_;
+    int shm_slots_;
+
+    int workers_count_;
+    workers_mode workers_mode_;
+    std::vector<int> workers_cpus_;
 };
 
 #endif /* __HFT_SERVER_CONFIG__ */
@@ -18,11 +18,14 @@
 #define __HFT_SESSION_HPP__
 
 #include <instrument_handler.hpp>
+#include <instrument_lane.hpp>
 #include <session_transport.hpp>
 #include <hft_session_state.hpp>
 
 #include <memory>
+#include <mutex>
 #include <set>
+#include <vector>
 
 class hft_session : public session_transport
 {
@@ -41,16 +44,52 @@ private:
 
     bool check_session_directory(const std::string &sessid);
 
-    typedef std::map<std::string, std::shared_ptr<instrument_handler> > instrument_handler_container;
+    //
+    // Handlers indexed by dense instrument id.
+    //
 
-    virtual void handle_init_request(const hft::protocol::request::init &msg, std::string &response_payload);
-    virtual void handle_sync_request(const hft::protocol::request::sync &msg, std::string &response_payload);
-    virtual void handle_tick_request(const hft::protocol::request::tick &msg, std::string &response_payload);
-    virtual void handle_open_notify_request(const hft::protocol::request::open_notify &msg, std::string &response_payload);
-    virtual void handle_close_notify_request(const hft::protocol::request::close_notify &msg, std::string &response_payload);
+    typedef std::vector<std::shared_ptr<instrument_handler> > instrument_handler_container;
+
+    virtual void handle_init_request(const hft::protocol::request::init &msg, hft::protocol::response &resp);
+    virtual void handle_sync_request(const hft::protocol::request::sync &msg, hft::protocol::response &resp);
+    virtual void handle_tick_request(const hft::protocol::request::tick &msg, hft::protocol::response &resp);
+    virtual void handle_open_notify_request(const hft::protocol::request::open_notify &msg, hft::protocol::response &resp);
+    virtual void handle_close_notify_request(const hft::protocol::request::close_notify &msg, hft::protocol::response &resp);
+
+    template <typename T>
+    void dispatch_to_handler(const T &msg, hft::protocol::response &resp, const char *request_name,
+                             void (instrument_handler::*on_request)(const T &, hft::protocol::response &));
+
+    template <typename T>
+    void invoke_handler(const T &msg, hft::protocol::response &resp,
+                        void (instrument_handler::*on_request)(const T &, hft::protocol::response &));
+
+    void run_lane_job(const hft::protocol::request::holder &job, hft::protocol::response &resp);
+
+    virtual bool is_conflating(int instrument_id) const;
+    virtual void on_tick_conflated(const hft::protocol::request::tick &msg);
 
     instrument_handler_container instrument_handlers_;
 
+    //
+    // Executor lanes indexed by dense instrument id, empty
+    // unless client asked for lanes in init. Duplicated
+    // instrument shares lane with its first occurrence.
+    //
+
+    std::vector<std::shared_ptr<instrument_lane> > instrument_lanes_;
+
+    //
+    // Conflation counters indexed by dense instrument id.
+    //
+
+    std::vector<metrics::counter> conflated_ticks_;
+
+    //
+    // Sessions may live on different worker threads.
+    //
+
+    static std::mutex pending_sessions_mtx_;
     static std::set<std::string> pending_sessions_;
     std::string sessid_;
     std::shared_ptr<session_state> pss_;
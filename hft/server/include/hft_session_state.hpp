@@ -17,8 +17,16 @@
 #ifndef __HFT_SESSION_STATE_HPP__
 #define __HFT_SESSION_STATE_HPP__
 
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
 #include <svr.hpp>
+#include <session_journal.hpp>
+#include <session_snapshot.hpp>
+#include <metrics.hpp>
 
 enum class session_mode
 {
@@ -32,6 +40,35 @@ enum class varscope
     GLOBAL
 };
 
+//
+// When changes reach the disk. IMMEDIATE writes on every
+// request, INTERVAL and REQUESTS leave it to background
+// flusher, every ‘interval’ or after ‘requests’ requests.
+// Whatever is pending is written on session shutdown.
+// With ‘fsync’ every write is synced, so it survives
+// power loss, not only process crash.
+//
+// Configured in session_state.json:
+//
+//   "durability": {"commit":"interval","interval_ms":50,"fsync":true}
+//   "durability": {"commit":"requests","requests":100,"fsync":false}
+//
+
+enum class commit_policy
+{
+    IMMEDIATE,
+    INTERVAL,
+    REQUESTS
+};
+
+struct durability_policy
+{
+    commit_policy commit;
+    std::chrono::milliseconds interval;
+    int requests;
+    bool fsync;
+};
+
 class instrument_handler;
 
 class session_state
@@ -54,29 +91,161 @@ public:
     session_state(void) = delete;
     session_state(session_state &) = delete;
     session_state(session_state &&) = delete;
-    session_state(const std::string &sessid);
+    //
+    // With ‘concurrent’ handlers of session run on separate
+    // instrument lanes, and reads of variables are locked.
+    // With ‘in_memory’ session is loaded as usual, from warm
+    // image or from snapshot and journal, and keeps its mode,
+    // but nothing of it is written back to session directory.
+    // Used by in-process emulation.
+    //
+
+    session_state(const std::string &sessid, bool concurrent, bool in_memory = false);
     ~session_state(void);
 
     autosaver create_autosaver(void) { return autosaver {this}; }
 
     session_mode get_mode(void) const { return mode_; }
 
+    bool is_in_memory(void) const { return in_memory_; }
+
     std::string get_session_id(void) const { return sessid_; }
 
+    const durability_policy &get_durability(void) const { return durability_; }
+
     svr variable(instrument_handler *ph, const std::string &name, varscope scope);
 
+    //
+    // Called after every request, commits changes
+    // according to durability policy.
+    //
+
     void save(void);
 
+    //
+    // Files of session written by handlers. Content is written
+    // along with session variables, repeated writes of the same
+    // file in between are coalesced. Reads see pending content.
+    //
+
+    void put_file(const std::string &file_name, const std::string &content);
+    std::string get_file(const std::string &file_name);
+
+    //
+    // Appends changes made since last flush to journal and
+    // writes pending files. Journal is compacted into snapshot,
+    // the JSON file, when it grows too big.
+    //
+
+    void flush(void) { flush(false); }
+
+    //
+    // Warm restart. Persistent session leaves binary image of
+    // its state at close, with state of handlers given here.
+    // Variables are loaded from image instead of JSON snapshot
+    // and journal, session settings are still taken from JSON,
+    // handler state is handed back if ‘checksum’ of handler
+    // config matches. Image is removed before anything else
+    // is written, so it never goes stale.
+    //
+
+    void set_warm_state(const std::string &handler, std::uint32_t checksum, const std::string &state);
+    bool get_warm_state(const std::string &handler, std::uint32_t checksum, std::string_view &state) const;
+
+    //
+    // Unmaps image once handlers are initialized.
+    //
+
+    void release_warm_state(void) { warm_image_.reset(); }
+
 private:
 
     void load(void);
+    void load_snapshot(bool settings_only);
+    bool load_warm_image(void);
+    void write_warm_image(void);
+    void remove_warm_image(void);
+
+    void flush(bool compact);
+
+    //
+    // Caller holds the lock.
+    //
+
+    session_variable &slot(const std::string &scope, const std::string &name);
+    void mark_dirty(void);
+    std::string serialize_snapshot(std::uint64_t journal_generation) const;
 
     const std::string state_filename_;
+    const std::string journal_filename_;
+    const std::string warm_image_filename_;
     const std::string sessid_;
     session_mode mode_;
-    bool changed_;
+    const bool concurrent_;
+    const bool in_memory_;
+
+    //
+    // Guards variables and list of changes, instrument
+    // handlers of session may run on separate lanes.
+    //
+
+    std::mutex mtx_;
+    std::vector<session_variable *> changed_;
+    std::map<std::string, std::string> pending_files_;
+
+    //
+    // Snapshot is missing or journal
+    // could not be written.
+    //
+
+    bool snapshot_needed_;
+
+    //
+    // Generation of journal the loaded
+    // snapshot is to be followed by.
+    //
+
+    std::uint64_t snapshot_generation_;
+
+    durability_policy durability_;
+    int requests_since_flush_;
+
+    //
+    // When the oldest change not yet
+    // on disk was made, for flush lag.
+    //
+
+    bool dirty_;
+    std::chrono::steady_clock::time_point dirty_since_;
+
+    //
+    // Serializes flushes, held during IO
+    // with ‘mtx_’ released. Guards journal.
+    //
+
+    std::mutex io_mtx_;
+    std::unique_ptr<session_journal> journal_;
+    std::string journal_batch_;
+
+    //
+    // Loaded image, and whether image
+    // file is still there.
+    //
+
+    std::unique_ptr<session_snapshot> warm_image_;
+    bool warm_image_present_;
+
+    //
+    // Handler name to u32 checksum
+    // followed by handler state.
+    //
+
+    std::map<std::string, std::string> warm_states_;
+
+    metrics::counter bytes_written_;
+    metrics::histogram flush_lag_;
 
-    std::map<std::string, std::map<std::string, std::string>> variables_;
+    std::map<std::string, std::map<std::string, session_variable>> variables_;
 };
 
 
@@ -0,0 +1,607 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_SHM_RING_HPP__
+#define __HFT_SHM_RING_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+//
+// Shared memory transport for co-located clients. Server
+// creates named segment (shm_open) with fixed number of
+// slots, every slot is a pair of byte rings: requests
+// (client to server) and responses (server to client).
+// Bytes travelling the rings are exactly what would
+// travel TCP connection, so framing is unchanged.
+//
+// Rings are single-producer single-consumer, waiting side
+// sleeps on futex placed in the ring itself, so no file
+// descriptors have to be passed between processes.
+//
+// Slot life cycle:
+//
+//    FREE -> CLAIMED -> CONNECTED    client
+//    CONNECTED -> SERVED             server accepts
+//    SERVED -> CLOSED                side closing first
+//    CLOSED -> FREE                  side closing second
+//
+// Side which finds its peer process dead frees the slot
+// on its own.
+//
+// Header only, it is shared by server and bridges.
+//
+
+namespace hft {
+namespace ipc {
+
+enum
+{
+    SHM_MAGIC = 0x52544648, /* ‘HFTR’ */
+    SHM_VERSION = 1,
+    RING_CAPACITY = 256 * 1024,
+    DEFAULT_SLOTS = 8,
+    SPIN_COUNT = 4096,
+    WAIT_TIMEOUT_MS = 100
+};
+
+enum slot_state : std::uint32_t
+{
+    SLOT_FREE = 0,
+    SLOT_CLAIMED,
+    SLOT_CONNECTED,
+    SLOT_SERVED,
+    SLOT_CLOSED
+};
+
+//
+// Byte at position p lives at data[p % RING_CAPACITY].
+// Positions grow monotonically. Futex word ‘seq’ is bumped
+// after every move of either position, so it serves both
+// waiting for data and waiting for room.
+//
+
+struct ring
+{
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> tail;
+    alignas(64) std::atomic<std::uint32_t> seq;
+    std::atomic<std::uint32_t> waiters;
+    alignas(64) char data[RING_CAPACITY];
+};
+
+struct slot
+{
+    alignas(64) std::atomic<std::uint32_t> state;
+    std::atomic<std::int32_t> client_pid;
+    ring request;
+    ring response;
+};
+
+struct segment
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t slot_count;
+    std::int32_t server_pid;
+
+    //
+    // Bumped by client after it connects or
+    // closes, server sleeps on it between.
+    //
+
+    std::atomic<std::uint32_t> doorbell;
+    std::atomic<std::uint32_t> doorbell_waiters;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Futex word must be lock free");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Ring position must be lock free");
+
+constexpr std::size_t segment_header_size(void)
+{
+    return (sizeof(segment) + 63) & ~static_cast<std::size_t>(63);
+}
+
+inline std::size_t segment_size(std::uint32_t slot_count)
+{
+    return segment_header_size() + slot_count * sizeof(slot);
+}
+
+inline slot &get_slot(segment *seg, std::uint32_t index)
+{
+    return reinterpret_cast<slot *>(reinterpret_cast<char *>(seg) + segment_header_size())[index];
+}
+
+//
+// Futex primitives. Not private, words live in memory
+// shared between processes.
+//
+
+inline void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected, int timeout_ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<std::uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+inline void notify(std::atomic<std::uint32_t> &seq, std::atomic<std::uint32_t> &waiters)
+{
+    seq.fetch_add(1);
+
+    if (waiters.load() != 0)
+    {
+        futex_wake(seq);
+    }
+}
+
+//
+// Waits until ready() holds or timeout expires, returns
+// ready(). Spins shortly first, unless there is single
+// CPU, where peer cannot progress while we spin. Any
+// notify() after seq is sampled makes futex_wait return
+// at once, so wakeup cannot be lost.
+//
+
+template <typename Ready>
+bool wait(std::atomic<std::uint32_t> &seq, std::atomic<std::uint32_t> &waiters, Ready ready, int timeout_ms)
+{
+    static const int spin_count = (std::thread::hardware_concurrency() > 1 ? SPIN_COUNT : 0);
+
+    for (int i = 0; i < spin_count; i++)
+    {
+        if (ready())
+        {
+            return true;
+        }
+    }
+
+    std::uint32_t s = seq.load();
+
+    if (ready())
+    {
+        return true;
+    }
+
+    waiters.fetch_add(1);
+    futex_wait(seq, s, timeout_ms);
+    waiters.fetch_sub(1);
+
+    return ready();
+}
+
+inline std::size_t readable(const ring &r)
+{
+    return r.tail.load(std::memory_order_acquire) - r.head.load(std::memory_order_relaxed);
+}
+
+inline std::size_t writable(const ring &r)
+{
+    return RING_CAPACITY - (r.tail.load(std::memory_order_relaxed) - r.head.load(std::memory_order_acquire));
+}
+
+//
+// Producer side. Writes as much as fits, returns
+// number of bytes written.
+//
+
+inline std::size_t ring_write(ring &r, const char *data, std::size_t length)
+{
+    std::uint64_t tail = r.tail.load(std::memory_order_relaxed);
+    std::size_t room = RING_CAPACITY - (tail - r.head.load(std::memory_order_acquire));
+    std::size_t n = (length < room ? length : room);
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    std::size_t offset = tail % RING_CAPACITY;
+    std::size_t first = (n < RING_CAPACITY - offset ? n : RING_CAPACITY - offset);
+
+    std::memcpy(r.data + offset, data, first);
+    std::memcpy(r.data, data + first, n - first);
+
+    r.tail.store(tail + n, std::memory_order_release);
+    notify(r.seq, r.waiters);
+
+    return n;
+}
+
+//
+// Consumer side. Appends all available bytes
+// to ‘out’, returns their number.
+//
+
+inline std::size_t ring_read(ring &r, std::string &out)
+{
+    std::uint64_t head = r.head.load(std::memory_order_relaxed);
+    std::size_t n = r.tail.load(std::memory_order_acquire) - head;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    std::size_t offset = head % RING_CAPACITY;
+    std::size_t first = (n < RING_CAPACITY - offset ? n : RING_CAPACITY - offset);
+
+    out.append(r.data + offset, first);
+    out.append(r.data, n - first);
+
+    r.head.store(head + n, std::memory_order_release);
+    notify(r.seq, r.waiters);
+
+    return n;
+}
+
+inline void reset_ring(ring &r)
+{
+    r.head.store(0);
+    r.tail.store(0);
+    r.waiters.store(0);
+}
+
+inline bool process_alive(std::int32_t pid)
+{
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+//
+// Gives slot back. Called by the side which closes
+// as second one, or finds its peer dead.
+//
+
+inline void free_slot(slot &s)
+{
+    reset_ring(s.request);
+    reset_ring(s.response);
+    s.client_pid.store(0);
+    s.state.store(SLOT_FREE);
+}
+
+//
+// Closing handshake, see slot life cycle above.
+//
+
+inline void close_slot(segment *seg, slot &s, bool peer_alive)
+{
+    std::uint32_t expected = SLOT_SERVED;
+
+    if (peer_alive && s.state.compare_exchange_strong(expected, SLOT_CLOSED))
+    {
+        notify(s.request.seq, s.request.waiters);
+        notify(s.response.seq, s.response.waiters);
+        notify(seg -> doorbell, seg -> doorbell_waiters);
+
+        return;
+    }
+
+    free_slot(s);
+}
+
+//
+// Owning handle of mapped segment. Creator unlinks
+// the name when handle is destroyed.
+//
+
+typedef std::shared_ptr<segment> segment_ptr;
+
+inline segment_ptr map_segment(const std::string &name, bool create, std::uint32_t slot_count)
+{
+    int fd;
+
+    if (create)
+    {
+        //
+        // Stale segment of previous server
+        // instance is never reused.
+        //
+
+        shm_unlink(name.c_str());
+
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    }
+    else
+    {
+        fd = shm_open(name.c_str(), O_RDWR, 0);
+    }
+
+    if (fd == -1)
+    {
+        throw std::runtime_error("Unable to open shared memory ‘" + name + "’: " + strerror(errno));
+    }
+
+    std::size_t size;
+
+    if (create)
+    {
+        size = segment_size(slot_count);
+
+        if (ftruncate(fd, size) == -1)
+        {
+            int err = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+
+            throw std::runtime_error("Unable to size shared memory ‘" + name + "’: " + strerror(err));
+        }
+    }
+    else
+    {
+        struct stat st;
+
+        if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < segment_header_size())
+        {
+            close(fd);
+
+            throw std::runtime_error("Invalid shared memory ‘" + name + "’");
+        }
+
+        size = st.st_size;
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        if (create)
+        {
+            shm_unlink(name.c_str());
+        }
+
+        throw std::runtime_error("Unable to map shared memory ‘" + name + "’: " + strerror(errno));
+    }
+
+    segment *seg = static_cast<segment *>(addr);
+
+    if (create)
+    {
+        //
+        // Fresh pages are zeroed, that is initial
+        // state of rings and FREE state of slots.
+        //
+
+        seg -> magic = SHM_MAGIC;
+        seg -> version = SHM_VERSION;
+        seg -> slot_count = slot_count;
+        seg -> server_pid = getpid();
+    }
+    else if (seg -> magic != SHM_MAGIC || seg -> version != SHM_VERSION
+                 || size < segment_size(seg -> slot_count))
+    {
+        munmap(addr, size);
+
+        throw std::runtime_error("Incompatible shared memory ‘" + name + "’");
+    }
+
+    return segment_ptr(seg, [name, size, create](segment *s)
+    {
+        munmap(s, size);
+
+        if (create)
+        {
+            shm_unlink(name.c_str());
+        }
+    });
+}
+
+//
+// Client end of the slot. Blocking, used by bridges,
+// emulator and benchmark.
+//
+
+class shm_client
+{
+public:
+
+    shm_client(const std::string &name, int connect_timeout_ms = 5000)
+        : segment_ {map_segment(name, false, 0)}, slot_ {nullptr}
+    {
+        segment *seg = segment_.get();
+
+        for (std::uint32_t i = 0; i < seg -> slot_count && slot_ == nullptr; i++)
+        {
+            slot &s = get_slot(seg, i);
+            std::uint32_t expected = SLOT_FREE;
+
+            if (s.state.compare_exchange_strong(expected, SLOT_CLAIMED))
+            {
+                s.client_pid.store(getpid());
+                s.state.store(SLOT_CONNECTED);
+                slot_ = &s;
+            }
+        }
+
+        if (slot_ == nullptr)
+        {
+            throw std::runtime_error("No free slot in shared memory ‘" + name + "’");
+        }
+
+        notify(seg -> doorbell, seg -> doorbell_waiters);
+
+        //
+        // Server announces acceptance on response ring.
+        //
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(connect_timeout_ms);
+
+        while (slot_ -> state.load() == SLOT_CONNECTED)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                std::uint32_t expected = SLOT_CONNECTED;
+
+                if (slot_ -> state.compare_exchange_strong(expected, SLOT_CLAIMED))
+                {
+                    free_slot(*slot_);
+                    slot_ = nullptr;
+
+                    throw std::runtime_error("HFT server did not accept shared memory connection");
+                }
+
+                break;
+            }
+
+            wait(slot_ -> response.seq, slot_ -> response.waiters,
+                 [this](void) { return slot_ -> state.load() != SLOT_CONNECTED; }, WAIT_TIMEOUT_MS);
+        }
+
+        if (slot_ -> state.load() != SLOT_SERVED)
+        {
+            free_slot(*slot_);
+            slot_ = nullptr;
+
+            throw std::runtime_error("HFT server refused shared memory connection");
+        }
+    }
+
+    ~shm_client(void)
+    {
+        close();
+    }
+
+    shm_client(const shm_client &) = delete;
+
+    shm_client &operator=(const shm_client &) = delete;
+
+    void write(const char *data, std::size_t length)
+    {
+        std::size_t done = 0;
+
+        while (slot_ != nullptr)
+        {
+            done += ring_write(slot_ -> request, data + done, length - done);
+
+            if (done == length)
+            {
+                return;
+            }
+
+            check_server();
+
+            wait(slot_ -> request.seq, slot_ -> request.waiters,
+                 [this](void) { return writable(slot_ -> request) != 0 || slot_ -> state.load() != SLOT_SERVED; },
+                 WAIT_TIMEOUT_MS);
+        }
+
+        throw std::runtime_error("Shared memory connection closed");
+    }
+
+    void write(const std::string &data)
+    {
+        write(data.data(), data.length());
+    }
+
+    //
+    // Appends at least one byte to ‘out’, blocks until
+    // there is something to read. With non-negative
+    // timeout returns 0 if nothing came in meantime.
+    // Throws when server closed connection or has gone.
+    //
+
+    std::size_t read_some(std::string &out, int timeout_ms = -1)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+        while (slot_ != nullptr)
+        {
+            std::size_t n = ring_read(slot_ -> response, out);
+
+            if (n != 0)
+            {
+                return n;
+            }
+
+            //
+            // Server may have written its last words
+            // just before closing, read them first.
+            //
+
+            if (slot_ -> state.load() != SLOT_SERVED && (n = ring_read(slot_ -> response, out)) != 0)
+            {
+                return n;
+            }
+
+            check_server();
+
+            if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline)
+            {
+                return 0;
+            }
+
+            wait(slot_ -> response.seq, slot_ -> response.waiters,
+                 [this](void) { return readable(slot_ -> response) != 0 || slot_ -> state.load() != SLOT_SERVED; },
+                 timeout_ms >= 0 ? std::min(timeout_ms, static_cast<int>(WAIT_TIMEOUT_MS)) : WAIT_TIMEOUT_MS);
+        }
+
+        throw std::runtime_error("Shared memory connection closed");
+    }
+
+    void close(void)
+    {
+        if (slot_ != nullptr)
+        {
+            close_slot(segment_.get(), *slot_, process_alive(segment_ -> server_pid));
+            slot_ = nullptr;
+        }
+    }
+
+private:
+
+    void check_server(void)
+    {
+        if (slot_ -> state.load() != SLOT_SERVED || ! process_alive(segment_ -> server_pid))
+        {
+            close();
+
+            throw std::runtime_error("Shared memory connection closed by HFT server");
+        }
+    }
+
+    segment_ptr segment_;
+    slot *slot_;
+};
+
+} /* namespace ipc */
+} /* namespace hft */
+
+#endif /* __HFT_SHM_RING_HPP__ */
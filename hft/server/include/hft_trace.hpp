@@ -0,0 +1,196 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_TRACE_HPP__
+#define __HFT_TRACE_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <time.h>
+
+//
+// Hot path tracing. Every thread records fixed-size events
+// into its own ring, oldest events are overwritten. Rings
+// are written without locks and copied out by dump(), which
+// may run on any thread at any time.
+//
+// Trace points compile to nothing unless the server is
+// built with HFT_TRACE defined (cmake -DHFT_TRACE=ON).
+//
+
+namespace hft {
+namespace trace {
+
+enum event_id : std::uint16_t
+{
+    READ,          // Data arrived from the gateway.
+    PARSE,         // Request decoded, payload is opcode.
+    HANDLER,       // Instrument handler call, payload is opcode.
+    CONFLATE,      // Stale tick dropped.
+    STATE_SAVE,    // Session state written to disk.
+    SERIALIZE,     // Response encoded into output buffer.
+    WRITE,         // Output buffer handed to gateway, payload is bytes.
+    EVENT_COUNT
+};
+
+const char *event_name(std::uint16_t id);
+
+//
+// Event of zero duration is an instant one.
+//
+
+struct event
+{
+    std::uint64_t start;
+    std::uint64_t duration;
+    std::int64_t payload;
+    std::int32_t instrument_id;
+    std::uint16_t id;
+    std::uint16_t reserved;
+};
+
+static_assert(sizeof(event) == 32, "Trace event must stay 32 bytes");
+
+//
+// Dump file layout, all in host byte order:
+//
+//   dump_header
+//   for each thread: thread_header, then ‘count’ events
+//
+
+struct dump_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t thread_count;
+};
+
+struct thread_header
+{
+    std::uint32_t tid;
+    std::uint32_t count;
+};
+
+constexpr char DUMP_MAGIC[8] = {'H', 'F', 'T', 'T', 'R', 'A', 'C', 'E'};
+constexpr std::uint32_t DUMP_VERSION = 1;
+
+//
+// Events per thread, power of two.
+//
+
+constexpr std::size_t RING_CAPACITY = 1 << 15;
+
+#ifdef HFT_TRACE
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+//
+// Monotonic nanoseconds. CLOCK_MONOTONIC is served by vDSO,
+// so no system call, and unlike raw TSC needs no calibration
+// to be shown on a timeline.
+//
+
+inline std::uint64_t now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+void record(event_id id, int instrument_id, std::uint64_t start, std::uint64_t duration, std::int64_t payload);
+
+//
+// Records event lasting until the end of scope.
+//
+
+class span
+{
+public:
+
+    span(event_id id, int instrument_id)
+        : start_ {now()}, instrument_id_ {instrument_id}, id_ {id} {}
+
+    ~span(void) { record(id_, instrument_id_, start_, now() - start_, 0); }
+
+    span(const span &) = delete;
+    span &operator=(const span &) = delete;
+
+private:
+
+    std::uint64_t start_;
+    int instrument_id_;
+    event_id id_;
+};
+
+//
+// Writes events of all threads, including finished ones,
+// to the file. Throws std::runtime_error on failure.
+// Returns number of events written.
+//
+
+std::size_t dump(const std::string &file_name);
+
+//
+// Reads dump file, used by the converter.
+//
+
+struct thread_events
+{
+    std::uint32_t tid;
+    std::vector<event> events;
+};
+
+std::vector<thread_events> load(const std::string &file_name);
+
+} /* namespace trace */
+} /* namespace hft */
+
+#define HFT_TRACE_CONCAT_(a, b) a##b
+#define HFT_TRACE_CONCAT(a, b) HFT_TRACE_CONCAT_(a, b)
+
+#ifdef HFT_TRACE
+
+#define HFT_TRACE_SCOPE(__ID__, __INSTRUMENT__) \
+    hft::trace::span HFT_TRACE_CONCAT(hft_trace_span_, __LINE__)(hft::trace::__ID__, __INSTRUMENT__)
+
+#define HFT_TRACE_INSTANT(__ID__, __INSTRUMENT__, __PAYLOAD__) \
+    hft::trace::record(hft::trace::__ID__, __INSTRUMENT__, hft::trace::now(), 0, __PAYLOAD__)
+
+#define HFT_TRACE_BEGIN(__VAR__) \
+    std::uint64_t __VAR__ = hft::trace::now()
+
+#define HFT_TRACE_STAMP(__VAR__) \
+    __VAR__ = hft::trace::now()
+
+#define HFT_TRACE_END(__VAR__, __ID__, __INSTRUMENT__, __PAYLOAD__) \
+    hft::trace::record(hft::trace::__ID__, __INSTRUMENT__, __VAR__, hft::trace::now() - (__VAR__), __PAYLOAD__)
+
+#else
+
+#define HFT_TRACE_SCOPE(__ID__, __INSTRUMENT__) do {} while (0)
+#define HFT_TRACE_INSTANT(__ID__, __INSTRUMENT__, __PAYLOAD__) do {} while (0)
+#define HFT_TRACE_BEGIN(__VAR__) do {} while (0)
+#define HFT_TRACE_STAMP(__VAR__) do {} while (0)
+#define HFT_TRACE_END(__VAR__, __ID__, __INSTRUMENT__, __PAYLOAD__) do {} while (0)
+
+#endif
+
+#endif /* __HFT_TRACE_HPP__ */
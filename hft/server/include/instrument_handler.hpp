@@ -44,12 +44,29 @@ public:
         std::string session_name;
         int pips_digit;
         trade_time_frame ttf;
+
+        //
+        // Drop stale ticks, when newer one of the
+        // same instrument is already waiting.
+        //
+
+        bool conflate;
+
+        //
+        // CRC-32 of manifest, warm state is handed
+        // back only to handler of the same config.
+        //
+
+        std::uint32_t manifest_checksum;
     };
 
     instrument_handler(const init_info &general_config)
         : handler_informations_(general_config),
           // hs_(get_work_dir() + "/handler.state", get_logger_id()) XXX O dziwo handler insformations_ jest inicjalizowany po hs_, mimo że na liście inicjalizacyjnej figuruje jako pierwszy
-          hs_(general_config.work_dir + "/handler.state", std::string("handler_") + general_config.ticker_fmt2)
+          hs_(general_config.work_dir + "/handler.state", std::string("handler_") + general_config.ticker_fmt2,
+              general_config.pss -> get_durability().fsync, general_config.pss -> is_in_memory()),
+          percentage_use_of_margin_ {metrics::make_gauge("hft_percentage_use_of_margin", "How many in percentage money is used by instrument.", metric_labels(general_config))},
+          opened_positions_ {metrics::make_gauge("hft_opened_positions", "Total number of opened position by instrument.", metric_labels(general_config))}
     {}
 
     instrument_handler(void) = delete;
@@ -69,9 +86,23 @@ public:
     virtual void on_position_open(const hft::protocol::request::open_notify &msg, hft::protocol::response &market) = 0;
     virtual void on_position_close(const hft::protocol::request::close_notify &msg, hft::protocol::response &market) = 0;
 
+    //
+    // Warm restart. Called at session close, handler may put
+    // its in-memory state into ‘state’ and return true. State
+    // is handed back by get_warm_state() during init_handler()
+    // of the next session, unless anything session persists
+    // changed meanwhile. State kept by ‘hs_’ must not be put
+    // there, it is not tracked.
+    //
+
+    virtual bool checkpoint(std::string &/*state*/) { return false; }
+
+    std::uint32_t get_manifest_checksum(void) const { return handler_informations_.manifest_checksum; }
+
     std::string get_ticker(void) const { return handler_informations_.ticker; }
     std::string get_ticker_fmt2(void) const { return handler_informations_.ticker_fmt2; }
     std::string get_instrument_description(void) const { return handler_informations_.description; }
+    bool is_conflating(void) const { return handler_informations_.conflate; }
 
 protected:
 
@@ -105,12 +136,29 @@ protected:
     session_mode get_session_mode(void) const { return handler_informations_.pss -> get_mode(); }
     svr session_variable(const std::string &name, varscope scope = varscope::LOCAL) { return handler_informations_.pss -> variable(this, name, scope); }
 
+    //
+    // State saved by checkpoint(), empty if none. Valid
+    // in init_handler() only, copy what is needed.
+    //
+
+    std::string_view get_warm_state(void) const;
+
     //
     // Methods for metrics purposes.
     //
 
-    void setup_percentage_use_of_margin_metric(double value) { metrics::setup_percentage_use_of_margin(handler_informations_.session_name, handler_informations_.ticker_fmt2, value); }
-    void setup_opened_positions_metric(int value) { metrics::setup_opened_positions(handler_informations_.session_name, handler_informations_.ticker_fmt2, value); }
+    void setup_percentage_use_of_margin_metric(double value) { percentage_use_of_margin_.set(value); }
+    void setup_opened_positions_metric(int value) { opened_positions_.set(value); }
+
+    //
+    // Handler own metrics. Series get ‘market’ and ‘instrument’
+    // labels of this handler. Register once, in init_handler(),
+    // and keep the handle, updates then cost single atomic op.
+    //
+
+    metrics::counter register_counter(const std::string &name, const std::string &help) const;
+    metrics::gauge register_gauge(const std::string &name, const std::string &help) const;
+    metrics::histogram register_histogram(const std::string &name, const std::string &help, const std::vector<double> &upper_bounds) const;
 
     //
     // Extra.
@@ -129,7 +177,15 @@ protected:
 
 private:
 
+    static metrics::labels metric_labels(const init_info &info)
+    {
+        return {{"market", info.session_name}, {"instrument", info.ticker_fmt2}};
+    }
+
     init_info handler_informations_;
+
+    metrics::gauge percentage_use_of_margin_;
+    metrics::gauge opened_positions_;
 };
 
 typedef instrument_handler *instrument_handler_ptr;
@@ -140,4 +196,13 @@ typedef instrument_handler *instrument_handler_ptr;
 
 instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state> pss, const std::string &instrument);
 
+//
+// Parses manifests found in session directories and loads
+// plugins they refer to, so that the first init of session
+// does not pay for it. Failures are logged only, they are
+// reported again by init.
+//
+
+void preload_instrument_handlers(void);
+
 #endif /*  __INSTRUMENT_HANDLER_HPP__ */
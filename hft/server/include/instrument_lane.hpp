@@ -0,0 +1,116 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __INSTRUMENT_LANE_HPP__
+#define __INSTRUMENT_LANE_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <hft_request.hpp>
+#include <hft_response.hpp>
+
+//
+// Executor lane of single instrument handler: a bounded
+// single-producer single-consumer ring of requests plus
+// a worker thread. Producer is the session (its strand),
+// consumer is the worker. Requests are executed and
+// completed in order of submission.
+//
+// Ring slots are request holders filled in place, so
+// steady state traffic does not allocate.
+//
+
+class instrument_lane
+{
+public:
+
+    typedef std::function<void (const hft::protocol::request::holder &req, hft::protocol::response &resp)> job_handler;
+
+    //
+    // Called on worker thread after every job,
+    // error is set if job handler has thrown.
+    //
+
+    typedef std::function<void (hft::protocol::response &resp, std::exception_ptr error)> completion_handler;
+
+    //
+    // With ‘on_conflate’ given, tick followed by another
+    // tick already queued is passed to it instead of
+    // ‘on_job’. Other requests are never conflated.
+    //
+
+    instrument_lane(std::size_t capacity, job_handler on_job, completion_handler on_complete,
+                    job_handler on_conflate = nullptr);
+
+    ~instrument_lane(void);
+
+    instrument_lane(const instrument_lane &) = delete;
+
+    instrument_lane &operator=(const instrument_lane &) = delete;
+
+    //
+    // Producer side. Returns free slot to be filled
+    // in place, then commit() passes it to worker.
+    //
+
+    hft::protocol::request::holder &prepare(void);
+
+    void commit(void);
+
+private:
+
+    enum { SPIN_COUNT = 4096 };
+
+    void run(void);
+
+    std::vector<hft::protocol::request::holder> slots_;
+
+    //
+    // Monotonic positions, slot index is position
+    // modulo capacity. Head is advanced by consumer,
+    // tail by producer.
+    //
+
+    std::atomic<std::size_t> head_;
+    std::atomic<std::size_t> tail_;
+
+    //
+    // Ticks committed and not taken by worker yet,
+    // counted only if lane conflates.
+    //
+
+    std::atomic<std::size_t> queued_ticks_;
+
+    int spin_count_;
+    std::atomic<bool> sleeping_;
+    std::atomic<bool> terminate_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+
+    job_handler on_job_;
+    completion_handler on_complete_;
+    job_handler on_conflate_;
+
+    std::thread thread_;
+};
+
+#endif /* __INSTRUMENT_LANE_HPP__ */
@@ -0,0 +1,76 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __IO_CONTEXT_POOL_HPP__
+#define __IO_CONTEXT_POOL_HPP__
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+//
+// Worker threads serving sessions. In ‘contexts’ mode
+// every worker runs its own io_context and sessions are
+// spread over them round-robin. In ‘strands’ mode all
+// workers run a single io_context. Either way session
+// handlers run on per-session strand, so a session is
+// never served by two threads at once.
+//
+
+class io_context_pool
+{
+public:
+
+    enum class mode
+    {
+        CONTEXTS,
+        STRANDS
+    };
+
+    //
+    // Worker ‘i’ is pinned to cpus[i], if given.
+    //
+
+    io_context_pool(int workers, mode m, const std::vector<int> &cpus);
+
+    ~io_context_pool(void);
+
+    io_context_pool(const io_context_pool &) = delete;
+
+    io_context_pool &operator=(const io_context_pool &) = delete;
+
+    void run(void);
+
+    void stop(void);
+
+    boost::asio::io_context &get_io_context(void);
+
+private:
+
+    typedef boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard;
+
+    int workers_;
+    std::vector<int> cpus_;
+    std::vector<std::unique_ptr<boost::asio::io_context>> contexts_;
+    std::vector<work_guard> guards_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> next_context_;
+};
+
+#endif /* __IO_CONTEXT_POOL_HPP__ */
@@ -0,0 +1,81 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __LATENCY_HISTOGRAM_HPP__
+#define __LATENCY_HISTOGRAM_HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+//
+// Request latency histograms broken down by processing
+// stage. Series are grouped in families, one family per
+// session, instrument and method, every family has a
+// histogram for each stage.
+//
+// Every thread records into its own buckets without any
+// synchronization, buckets of all threads are merged when
+// metrics are scraped. Buckets are log-linear: two per
+// power of two, from 256 ns to about 17 s.
+//
+
+namespace metrics {
+namespace latency {
+
+enum stage
+{
+    PARSE,
+    HANDLER,
+    PERSIST,
+    SERIALIZE,
+    TOTAL,
+    STAGE_COUNT
+};
+
+constexpr int NO_FAMILY = -1;
+
+//
+// Returns family of given labels, the same for every call
+// with the same labels. Returns NO_FAMILY if metrics service
+// is disabled or there are too many families already.
+//
+
+int get_family(const std::string &market, const std::string &instrument, const std::string &method);
+
+//
+// Hot path. Does nothing for NO_FAMILY.
+//
+
+void record(int family, stage s, std::uint64_t nanos);
+
+inline std::uint64_t now(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//
+// Writes all non-empty histograms in
+// Prometheus text exposition format.
+//
+
+void produce_text_format(std::ostream &out);
+
+} /* namespace latency */
+} /* namespace metrics */
+
+#endif /* __LATENCY_HISTOGRAM_HPP__ */
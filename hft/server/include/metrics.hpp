@@ -17,7 +17,12 @@
 #ifndef __METRICS_HPP__
 #define __METRICS_HPP__
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include <boost/asio.hpp>
 
 namespace metrics {
@@ -26,9 +31,119 @@ namespace metrics {
 
     bool is_service_enabled(void);
 
-    void setup_percentage_use_of_margin(const std::string &market, const std::string &instrument, double value);
+    //
+    // Label set as name/value pairs, order does not matter.
+    //
 
-    void setup_opened_positions(const std::string &market, const std::string &instrument, int value);
+    typedef std::vector<std::pair<std::string, std::string> > labels;
+
+    //
+    // Metric handles. Series is looked up once, when handle
+    // is created, then every update is a single atomic op
+    // on series storage. Handles are cheap to copy and stay
+    // valid for the lifetime of the process. Handle created
+    // while metrics service is disabled, as well as default
+    // constructed one, ignores updates.
+    //
+
+    class counter
+    {
+    public:
+
+        counter(void) : value_ {nullptr} {}
+
+        void increment(std::uint64_t n = 1)
+        {
+            if (value_)
+            {
+                value_ -> fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+
+        friend counter make_counter(const std::string &, const std::string &, const labels &);
+
+        explicit counter(std::atomic<std::uint64_t> *value) : value_ {value} {}
+
+        std::atomic<std::uint64_t> *value_;
+    };
+
+    class gauge
+    {
+    public:
+
+        gauge(void) : value_ {nullptr} {}
+
+        void set(double value)
+        {
+            if (value_)
+            {
+                value_ -> store(value, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+
+        friend gauge make_gauge(const std::string &, const std::string &, const labels &);
+
+        explicit gauge(std::atomic<double> *value) : value_ {value} {}
+
+        std::atomic<double> *value_;
+    };
+
+    struct histogram_data;
+
+    class histogram
+    {
+    public:
+
+        histogram(void) : data_ {nullptr} {}
+
+        //
+        // One atomic increment of the bucket, plus
+        // compare-and-swap adding value to the sum.
+        //
+
+        void observe(double value);
+
+    private:
+
+        friend histogram make_histogram(const std::string &, const std::string &, const std::vector<double> &, const labels &);
+
+        explicit histogram(histogram_data *data) : data_ {data} {}
+
+        histogram_data *data_;
+    };
+
+    //
+    // Registration. Name must be valid Prometheus metric
+    // name and keep its type (and buckets, for histogram)
+    // in every registration, std::runtime_error is thrown
+    // otherwise. Registering the same series again gives
+    // handle of the existing one.
+    //
+
+    counter make_counter(const std::string &name, const std::string &help, const labels &lbs);
+
+    gauge make_gauge(const std::string &name, const std::string &help, const labels &lbs);
+
+    histogram make_histogram(const std::string &name, const std::string &help,
+                             const std::vector<double> &upper_bounds, const labels &lbs);
+
+    //
+    // Label value escaped as exposition format requires,
+    // shared by every producer of series text.
+    //
+
+    std::string escape_label_value(const std::string &value);
+
+    //
+    // Every series in exposition text
+    // format, as served on /metrics.
+    //
+
+    std::string produce_text_format(void);
 
 } // namespace metrics
 
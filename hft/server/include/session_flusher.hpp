@@ -0,0 +1,90 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __SESSION_FLUSHER_HPP__
+#define __SESSION_FLUSHER_HPP__
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+class session_state;
+
+//
+// Background thread flushing session states, which do not
+// commit on every request. Session is flushed when its
+// interval elapses or on request. Writes of all sessions
+// are done by this one thread, off the request path.
+//
+
+class session_flusher
+{
+public:
+
+    static session_flusher &instance(void);
+
+    ~session_flusher(void);
+
+    session_flusher(const session_flusher &) = delete;
+
+    session_flusher &operator=(const session_flusher &) = delete;
+
+    //
+    // Zero interval means session is flushed on request only.
+    //
+
+    void attach(session_state *pss, std::chrono::milliseconds interval);
+
+    //
+    // Once returned, session is not flushed
+    // by the background thread anymore.
+    //
+
+    void detach(session_state *pss);
+
+    void request(session_state *pss);
+
+private:
+
+    session_flusher(void);
+
+    void run(void);
+
+    struct entry
+    {
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point deadline;
+        bool requested;
+    };
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::map<session_state *, entry> sessions_;
+
+    //
+    // Session being flushed right now, flush
+    // runs with the mutex released.
+    //
+
+    session_state *flushing_;
+
+    bool terminate_;
+    std::thread thread_;
+};
+
+#endif /* __SESSION_FLUSHER_HPP__ */
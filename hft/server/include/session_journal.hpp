@@ -0,0 +1,142 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __SESSION_JOURNAL_HPP__
+#define __SESSION_JOURNAL_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+//
+// Append-only journal of session variable changes. Every
+// record is framed by its length and CRC-32, so the tail
+// torn by crash in the middle of write is detected on
+// replay and cut off. Journal complements snapshot of
+// session state, it is reset once snapshot is written.
+//
+// Record layout, little endian:
+//
+//   u32 body length, u32 CRC-32 of body,
+//   body: u16 scope length, scope, u16 name length,
+//         name, u32 value length, value
+//
+// Journal reset after compaction starts with generation
+// record, of empty scope, whose value is the generation
+// in decimal. Snapshot names the generation of journal
+// that applies on top of it, so journal left behind by
+// crash right after snapshot was written is not replayed
+// over newer values. Journal without generation record
+// is of generation 0.
+//
+
+class session_journal
+{
+public:
+
+    enum
+    {
+        //
+        // Scope and name length is u16.
+        //
+
+        MAX_KEY_LENGTH = 0xffff
+    };
+
+    typedef std::function<void (const std::string &scope, const std::string &name, const std::string &value)> apply_handler;
+
+    //
+    // Journal opened ‘read_only’ is only replayed, missing
+    // file is taken for empty one and damaged tail is left
+    // where it is.
+    //
+
+    explicit session_journal(const std::string &file_name, bool read_only = false);
+
+    ~session_journal(void);
+
+    session_journal(const session_journal &) = delete;
+
+    session_journal &operator=(const session_journal &) = delete;
+
+    //
+    // Passes every intact record to ‘apply’, in order. Returns
+    // number of records. Anything after the first damaged
+    // record is removed from the file.
+    //
+
+    std::size_t replay(const apply_handler &apply);
+
+    //
+    // Whether journal file has any change record,
+    // generation record alone does not count.
+    //
+
+    static bool has_records(const std::string &file_name);
+
+    //
+    // Decodes records of journal held in memory, stops at the
+    // first damaged one. Returns number of records, ‘consumed’
+    // is the size of intact part.
+    //
+
+    static std::size_t decode(const char *data, std::size_t size, const apply_handler &apply, std::size_t &consumed);
+
+    //
+    // Appends encoded record to ‘batch’. Throws if scope
+    // or name is longer than MAX_KEY_LENGTH.
+    //
+
+    static void encode(std::string &batch, const std::string &scope, const std::string &name, const std::string &value);
+
+    //
+    // Writes batch of records with single write(2).
+    //
+
+    void append(const std::string &batch);
+
+    //
+    // Makes appended records survive power loss.
+    //
+
+    void sync(void);
+
+    //
+    // Drops every record and starts journal
+    // of given generation.
+    //
+
+    void reset(std::uint64_t generation);
+
+    std::uint64_t generation(void) const { return generation_; }
+
+    //
+    // Size of change records, without generation record.
+    //
+
+    std::uint64_t size(void) const { return size_ - base_; }
+
+private:
+
+    const std::string file_name_;
+    const bool read_only_;
+    int fd_;
+    std::uint64_t size_;
+    std::uint64_t base_;
+    std::uint64_t generation_;
+};
+
+#endif /* __SESSION_JOURNAL_HPP__ */
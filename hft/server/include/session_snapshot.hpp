@@ -0,0 +1,103 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __SESSION_SNAPSHOT_HPP__
+#define __SESSION_SNAPSHOT_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+//
+// Binary image of session taken at checkpoint, for warm
+// restart. Holds every variable and opaque state of
+// handlers, each in its own section. Session settings
+// are not there, they come from JSON snapshot. Image
+// is mapped on load, sections are used in place.
+//
+// Layout, native endian:
+//
+//   header, 32 bytes: magic ‘HFTWARM1’, u32 version,
+//                     u32 section count, u64 creation time
+//                     in ms since epoch, 8 bytes reserved
+//   sections, 8 byte aligned: u32 kind, u32 name length,
+//                     u64 payload length, u32 CRC-32 of name
+//                     and payload, u32 reserved, name, payload
+//
+
+class session_snapshot
+{
+public:
+
+    enum class section
+    {
+        VARIABLES = 2,
+        HANDLER = 3
+    };
+
+    class writer
+    {
+    public:
+
+        writer(void);
+
+        void add(section kind, const std::string &name, std::string_view payload);
+
+        //
+        // Image replaces the file atomically.
+        //
+
+        void write(const std::string &file_name, bool sync);
+
+    private:
+
+        std::string image_;
+        std::uint32_t section_count_;
+    };
+
+    //
+    // Maps the image, throws if it is damaged.
+    //
+
+    explicit session_snapshot(const std::string &file_name);
+
+    ~session_snapshot(void);
+
+    session_snapshot(const session_snapshot &) = delete;
+
+    session_snapshot &operator=(const session_snapshot &) = delete;
+
+    //
+    // View stays valid as long as the object.
+    //
+
+    bool find(section kind, const std::string &name, std::string_view &payload) const;
+
+    std::uint64_t get_creation_time(void) const { return created_; }
+
+private:
+
+    const char *base_;
+    std::size_t size_;
+    std::uint64_t created_;
+
+    std::map<std::pair<section, std::string>, std::string_view> sections_;
+};
+
+#endif /* __SESSION_SNAPSHOT_HPP__ */
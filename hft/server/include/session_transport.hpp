@@ -20,7 +20,11 @@
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
-#include <iostream>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
@@ -30,29 +34,85 @@
 
 #include <deallocator.hpp>
 #include <hft_request.hpp>
+#include <hft_response.hpp>
+#include <latency_histogram.hpp>
+#include <metrics.hpp>
+#include <shm_channel.hpp>
 
-using boost::asio::ip::tcp;
+//
+// Transport layer of the HFT session. Requests are
+// newline-delimited. In lockstep mode (default) next
+// request is not read until response for the previous
+// one is written. When client declares pipeline depth
+// N during init, transport keeps reading requests while
+// up to N responses are still waiting to be written,
+// then writes all of them in single gathered write.
+//
+// Ordering of responses is guaranteed per instrument
+// only, so pipelining clients should match responses
+// by the correlation id (‘cid’) attribute.
+//
+// Client may also negotiate binary framing during
+// init (see hft_binary_protocol.hpp), all requests
+// following init are then fixed-layout frames.
+//
+// Handler may defer its response (see defer_response())
+// and complete it later from another thread. Deferred
+// requests count as outstanding until completed.
+//
+// Session is carried either by stream socket (TCP or
+// AF_UNIX) or by shared memory slot.
+//
 
 class session_transport : public deallocator
 {
 public:
 
+    //
+    // Socket is bound to its own strand, so all completion
+    // handlers of the session are serialized even when
+    // io_context is run by multiple threads.
+    //
+
     session_transport(boost::asio::io_service &io_service)
-        : socket_(io_service), request_time_(0,0,0,0)
+        : socket_(boost::asio::make_strand(io_service)), lookahead_offset_(0), scan_offset_(0),
+          pending_count_(0), writing_count_(0), deferred_count_(0), request_time_(0,0,0,0),
+          read_time_(0), timing_(metrics::is_service_enabled()), write_start_(0),
+          pipeline_depth_(1), binary_framing_(false), switch_to_binary_(false),
+          reading_(false), writing_(false), closing_(false), deferred_(false)
     {
          el::Loggers::getLogger("transport", true);
     }
 
     virtual ~session_transport(void) = default;
 
-    tcp::socket &socket(void)
+    typedef boost::asio::generic::stream_protocol::socket socket_type;
+
+    socket_type &socket(void)
     {
         return socket_;
     }
 
     void start(void)
     {
-        boost::asio::async_read_until(socket_, input_buffer_, '\n', boost::bind(&session_transport::handle_read, this, _1));
+        //
+        // Acceptor may run on another thread than
+        // the session, so jump onto session strand.
+        //
+
+        boost::asio::post(socket_.get_executor(), [this](void) { do_read(); });
+    }
+
+    //
+    // Starts session over shared memory slot
+    // accepted by basic_shm_server.
+    //
+
+    void start(hft::ipc::segment_ptr segment, hft::ipc::slot &slot)
+    {
+        shm_.reset(new shm_channel(socket_.get_executor(), segment, slot));
+
+        start();
     }
 
 protected:
@@ -66,23 +126,192 @@ protected:
     // Methods to be implemented in hft_session class.
     //
 
-    virtual void handle_init_request(const hft::protocol::request::init &msg, std::string &response_payload) = 0;
-    virtual void handle_sync_request(const hft::protocol::request::sync &msg, std::string &response_payload) = 0;
-    virtual void handle_tick_request(const hft::protocol::request::tick &msg, std::string &response_payload) = 0;
-    virtual void handle_open_notify_request(const hft::protocol::request::open_notify &msg, std::string &response_payload) = 0;
-    virtual void handle_close_notify_request(const hft::protocol::request::close_notify &msg, std::string &response_payload) = 0;
+    virtual void handle_init_request(const hft::protocol::request::init &msg, hft::protocol::response &resp) = 0;
+    virtual void handle_sync_request(const hft::protocol::request::sync &msg, hft::protocol::response &resp) = 0;
+    virtual void handle_tick_request(const hft::protocol::request::tick &msg, hft::protocol::response &resp) = 0;
+    virtual void handle_open_notify_request(const hft::protocol::request::open_notify &msg, hft::protocol::response &resp) = 0;
+    virtual void handle_close_notify_request(const hft::protocol::request::close_notify &msg, hft::protocol::response &resp) = 0;
+
+    //
+    // Called by handler instead of filling the response,
+    // which is then passed to complete_deferred(). Deferred
+    // responses of the same instrument must be completed
+    // in order of requests.
+    //
+
+    void defer_response(void) { deferred_ = true; }
+
+    //
+    // Tick conflation. Tick of conflating instrument, which
+    // has a newer tick of the same instrument already waiting
+    // in input, is acknowledged without calling handler.
+    //
+
+    virtual bool is_conflating(int /*instrument_id*/) const { return false; }
+    virtual void on_tick_conflated(const hft::protocol::request::tick &/*msg*/) {}
+
+    //
+    // Latency histogram family of request, NO_FAMILY
+    // before init. Safe to call from any thread.
+    //
+
+    int latency_family(int opcode, int instrument_id) const
+    {
+        std::size_t index = (instrument_id + 1) * METHOD_COUNT + opcode;
+
+        return (index < latency_families_.size() ? latency_families_[index] : metrics::latency::NO_FAMILY);
+    }
+
+    //
+    // Thread safe. Error makes the session terminate.
+    //
+
+    void complete_deferred(const hft::protocol::response &resp, std::exception_ptr error);
 
 private:
 
+    enum { METHOD_COUNT = 5 };
+
+    //
+    // Response travelling towards socket, stamped
+    // with arrival time of its request.
+    //
+
+    struct latency_stamp
+    {
+        int family;
+        std::uint64_t start;
+    };
+
+    void do_read(void);
+
+    void do_write(void);
+
     void handle_read(const boost::system::error_code &error);
 
     void handle_write(const boost::system::error_code &error);
 
-    tcp::socket socket_;
-    boost::asio::streambuf input_buffer_;
-    std::string response_data_;
+    bool process_input(void);
+
+    void process_request(const char *line, std::size_t length);
+
+    void process_frame(const char *frame);
+
+    void dispatch_request(hft::protocol::response &resp);
+
+    bool newer_tick_waiting(int instrument_id);
+
+    void consume_lookahead(void);
+
+    void reset_lookahead(void);
+
+    void handle_deferred(const hft::protocol::response &resp, std::exception_ptr error);
+
+    void continue_processing(void);
+
+    void enqueue_response(const hft::protocol::response &resp, const latency_stamp &stamp);
+
+    void complete_request(hft::protocol::response &resp, std::uint64_t parse_start, std::uint64_t parse_end);
+
+    void setup_latency_families(const std::string &sessid, const std::vector<std::string> &instruments);
+
+    void terminate(void);
+
+    void release_if_idle(void);
+
+    std::size_t outstanding_responses(void) const
+    {
+        return pending_count_ + writing_count_ + deferred_count_;
+    }
+
+    socket_type socket_;
+    std::unique_ptr<shm_channel> shm_;
+    std::string input_buffer_;
+
+    //
+    // Parser and storage for incoming request,
+    // both reused for every request of session.
+    //
+
+    hft::protocol::request_parser parser_;
+    hft::protocol::request::holder request_;
+
+    //
+    // Input offset right behind request being processed.
+    // Requests buffered behind it are classified at most
+    // once, when looking for newer tick, by own parser so
+    // that parser_ state is left alone. Input up to scan
+    // offset is classified, buffered ticks in that range
+    // are counted per instrument.
+    //
+
+    std::size_t lookahead_offset_;
+    std::size_t scan_offset_;
+    std::vector<std::size_t> waiting_ticks_;
+    hft::protocol::request_parser lookahead_parser_;
+    hft::protocol::request::holder lookahead_;
+
+    //
+    // Serialized responses waiting for write and responses
+    // being currently written by async_write. Buffers are
+    // swapped on every write and reused for the lifetime
+    // of session.
+    //
+
+    std::string output_buffer_;
+    std::string writing_buffer_;
+    std::size_t pending_count_;
+    std::size_t writing_count_;
+
+    //
+    // Response being encoded, moved to output
+    // buffer only once it is complete.
+    //
+
+    std::string response_buffer_;
+
+    //
+    // Requests deferred by handlers, not completed yet.
+    //
+
+    std::size_t deferred_count_;
 
     boost::posix_time::time_duration request_time_;
+
+    //
+    // Latency accounting, used only when metrics service
+    // is enabled. Families are indexed by instrument id + 1
+    // and opcode. Stamps of deferred requests wait per
+    // instrument, so they pair with completions in order.
+    //
+
+    std::vector<int> latency_families_;
+    std::vector<latency_stamp> pending_stamps_;
+    std::vector<latency_stamp> writing_stamps_;
+    std::vector<std::deque<latency_stamp> > deferred_stamps_;
+    std::uint64_t read_time_;
+    bool timing_;
+
+    //
+    // When write in progress was issued, for tracing.
+    //
+
+    std::uint64_t write_start_;
+
+    //
+    // Instruments declared in init, binary frames
+    // refer to them by position in this list.
+    //
+
+    std::vector<std::string> instruments_;
+
+    std::size_t pipeline_depth_;
+    bool binary_framing_;
+    bool switch_to_binary_;
+    bool reading_;
+    bool writing_;
+    bool closing_;
+    bool deferred_;
 };
 
 #endif /* __SESSION_TRANSPORT_HPP__ */
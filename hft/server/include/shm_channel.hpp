@@ -0,0 +1,108 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __SHM_CHANNEL_HPP__
+#define __SHM_CHANNEL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/asio.hpp>
+
+#include <hft_shm_ring.hpp>
+
+//
+// Server end of shared memory slot, stands in for socket
+// of session. Reading is done by dedicated thread, which
+// sleeps on request ring. Writing is done in place while
+// response ring has room, rest of data is left to writer
+// thread, which sleeps on response ring. Caller's thread
+// never waits for client. Completion handlers are always
+// posted to session executor, the same way socket
+// completions are.
+//
+
+class shm_channel
+{
+public:
+
+    typedef std::function<void (const boost::system::error_code &)> completion_handler;
+
+    shm_channel(const boost::asio::any_io_executor &executor, hft::ipc::segment_ptr segment, hft::ipc::slot &slot);
+
+    ~shm_channel(void);
+
+    shm_channel(const shm_channel &) = delete;
+
+    shm_channel &operator=(const shm_channel &) = delete;
+
+    //
+    // Appends at least one byte to ‘buffer’, which
+    // must not be touched until handler is called.
+    //
+
+    void async_read(std::string &buffer, completion_handler handler);
+
+    //
+    // Writes whole ‘data’, which must not be touched
+    // until handler is called. At most one write may
+    // be pending, so the ring has single producer.
+    //
+
+    void async_write(const std::string &data, completion_handler handler);
+
+    //
+    // Pending read and write complete
+    // with operation_aborted.
+    //
+
+    void close(void);
+
+private:
+
+    void run_reader(void);
+
+    void run_writer(void);
+
+    bool peer_gone(void) const;
+
+    boost::asio::any_io_executor executor_;
+    hft::ipc::segment_ptr segment_;
+    hft::ipc::slot &slot_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::string *read_buffer_;
+    completion_handler read_handler_;
+    bool read_pending_;
+
+    std::condition_variable write_cv_;
+    const std::string *write_data_;
+    std::size_t write_done_;
+    completion_handler write_handler_;
+    bool write_pending_;
+
+    std::atomic<bool> closing_;
+
+    std::thread reader_;
+    std::thread writer_;
+};
+
+#endif /* __SHM_CHANNEL_HPP__ */
@@ -18,20 +18,92 @@
 #define __SVR_HPP__
 
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <boost/variant2/variant.hpp>
+
+//
+// Storage of single session variable. Knows its scope
+// and name, so that the change can be journaled.
+//
+// Integers and booleans are kept in type they were set
+// with. Doubles are kept as text of std::to_string(),
+// as they always were, so that value read back and text
+// saved do not change. Number parsed out of text is
+// cached, so it is parsed once, double set is cached
+// right away and never parsed.
+//
+
+struct session_variable
+{
+    typedef boost::variant2::variant<std::string, std::int64_t, bool> value_type;
+
+    session_variable(const std::string &s, const std::string &n)
+        : scope {s}, name {n}, value {std::string()}, parsed {0}, as_int {0}, as_double {0.0}, dirty {false} {}
+
+    //
+    // Text form, as journaled and saved in snapshot.
+    //
+
+    std::string text(void) const;
+
+    void assign_text(const std::string &v);
+
+    std::string scope;
+    std::string name;
+    value_type value;
+
+    //
+    // Cache of numbers parsed out of text value,
+    // ‘parsed’ tells which one is valid.
+    //
+
+    enum { PARSED_INT = 1, PARSED_DOUBLE = 2 };
+
+    unsigned char parsed;
+    std::int64_t as_int;
+    double as_double;
+
+    //
+    // Already on the list of changes
+    // waiting for the next save.
+    //
+
+    bool dirty;
+};
 
 //
 // Class svr – Session Variable Reference.
 //
+// Handle resolved once, by name, through session_variable()
+// of instrument handler, get() and set() go straight to the
+// storage. get() takes the lock of session state only when
+// handlers of session run on separate instrument lanes,
+// otherwise the only writer is the caller itself. set()
+// takes it also when state is saved in background, so it
+// is atomic with respect to saving the state. Sequence of
+// get() and set() is not atomic, concurrent writers of
+// global variable are resolved as last writer wins.
+//
+// Setting the same value, even as another type with the
+// same text form, does not count as change.
+//
+// Supported types are int, std::int64_t, double, bool and
+// std::string. Reading value of other type converts its
+// text, as when every value was kept as text.
+//
 
 class svr
 {
 public:
 
     svr(void)
-        : changed_ {nullptr}, value_ {nullptr} {}
-    svr(bool &changed, std::string &v)
-        : changed_ {&changed}, value_ {&v} {}
+        : mtx_ {nullptr}, lock_reads_ {false}, lock_writes_ {false}, changed_ {nullptr}, var_ {nullptr} {}
+    svr(std::mutex &mtx, bool lock_reads, bool lock_writes, std::vector<session_variable *> &changed, session_variable &v)
+        : mtx_ {&mtx}, lock_reads_ {lock_reads}, lock_writes_ {lock_writes}, changed_ {&changed}, var_ {&v} {}
 
     template <typename T>
     T get(void) const;
@@ -41,8 +113,25 @@ public:
 
 private:
 
-    bool *changed_;
-    std::string *value_;
+    void assign(session_variable::value_type &&v);
+    void assign_double(std::string_view text);
+    void mark_changed(void);
+
+    std::unique_lock<std::mutex> read_lock(void) const
+    {
+        return lock_reads_ ? std::unique_lock<std::mutex>(*mtx_) : std::unique_lock<std::mutex>();
+    }
+
+    std::unique_lock<std::mutex> write_lock(void) const
+    {
+        return lock_writes_ ? std::unique_lock<std::mutex>(*mtx_) : std::unique_lock<std::mutex>();
+    }
+
+    std::mutex *mtx_;
+    bool lock_reads_;
+    bool lock_writes_;
+    std::vector<session_variable *> *changed_;
+    session_variable *var_;
 };
 
 #endif /* __SVR_HPP__ */
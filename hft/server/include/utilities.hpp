@@ -27,6 +27,14 @@ std::string file_get_contents(const std::string &filename);
 
 void file_put_contents(const std::string &filename, const std::string &content);
 
+//
+// Replaces file content through temporary file and rename,
+// so readers see either old or new content, never a part.
+// With ‘sync’ data and rename reach the disk before return.
+//
+
+void file_put_contents_atomic(const std::string &filename, const std::string &content, bool sync);
+
 unsigned long get_current_timestamp(void);
 
 unsigned long ptime2timestamp(const boost::posix_time::ptime &t);
@@ -14,14 +14,27 @@
 **                                                                    **
 \**********************************************************************/
 
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+
+#include <sys/stat.h>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/json.hpp>
 #include <boost/dll.hpp>
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
 
 #include <sms_alert.hpp>
 #include <utilities.hpp>
 #include <hft_session.hpp>
 #include <hft_ih_dummy.hpp>
+#include <easylogging++.h>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "session")
 
 int instrument_handler::floating2pips(double price) const
 {
@@ -48,7 +61,7 @@ std::string instrument_handler::uid(void)
                          'W', 'X', 'Y', 'Z', '0', '1', '2', '3',
                          '4', '5', '6', '7', '8', '9'};
 
-    static int index = 0;
+    static std::atomic<unsigned int> index {0};
 
     auto millis = hft::utils::get_current_timestamp();
 
@@ -255,6 +268,35 @@ const boost::json::object &instrument_handler::json_get_object_attribute(const b
     return attr_v.get_object();
 }
 
+//
+// Metrics.
+//
+
+metrics::counter instrument_handler::register_counter(const std::string &name, const std::string &help) const
+{
+    return metrics::make_counter(name, help, metric_labels(handler_informations_));
+}
+
+metrics::gauge instrument_handler::register_gauge(const std::string &name, const std::string &help) const
+{
+    return metrics::make_gauge(name, help, metric_labels(handler_informations_));
+}
+
+metrics::histogram instrument_handler::register_histogram(const std::string &name, const std::string &help,
+                                                          const std::vector<double> &upper_bounds) const
+{
+    return metrics::make_histogram(name, help, upper_bounds, metric_labels(handler_informations_));
+}
+
+std::string_view instrument_handler::get_warm_state(void) const
+{
+    std::string_view state;
+
+    handler_informations_.pss -> get_warm_state(get_ticker_fmt2(), handler_informations_.manifest_checksum, state);
+
+    return state;
+}
+
 //
 // Extra.
 //
@@ -268,65 +310,109 @@ std::string instrument_handler::file_get_contents(const std::string &filename)
 {
     std::string full_path = get_work_dir() + std::string("/") + filename;
 
-    return hft::utils::file_get_contents(full_path);
+    return handler_informations_.pss -> get_file(full_path);
 }
 
 void instrument_handler::file_put_contents(const std::string &filename, const std::string &content)
 {
     std::string full_path = get_work_dir() + std::string("/") + filename;
 
-    hft::utils::file_put_contents(full_path, content);
+    //
+    // Written along with session state,
+    // according to its durability policy.
+    //
+
+    handler_informations_.pss -> put_file(full_path, content);
 }
 
 //
 // Plugin support.
 //
 
-static std::map<std::string, boost::dll::shared_library> ih_plugins;
+namespace {
 
-static instrument_handler_ptr import_instrument_handler_from_plugin(const std::string &name, const instrument_handler::init_info &handler_info)
-{
-    if (ih_plugins.find(name) == ih_plugins.end())
-    {
-        std::string file_name = std::string("/var/lib/hft/instrument-handlers/lib")
-                                + name + std::string(".so");
+//
+// Parsed manifest of instrument handler. Parsed once,
+// again only when the file changes.
+//
 
-        ih_plugins[name] = boost::dll::shared_library(file_name);
+//
+// Identity of file content as far as stat(2) tells. Time of
+// last write is taken with nanoseconds, seconds alone miss
+// edits of the same size made within one second. Inode
+// changes when file is replaced by rename.
+//
 
-        if (! ih_plugins[name].has("create_plugin"))
-        {
-             ih_plugins.erase(name);
+struct file_stamp
+{
+    std::int64_t mtime_ns = 0;
+    std::uint64_t size = 0;
+    std::uint64_t inode = 0;
 
-             std::string error_msg = std::string("Invalid instrument handler plugin ‘")
-                                     + file_name + std::string("’ - no factory function");
+    bool operator==(const file_stamp &other) const
+    {
+        return mtime_ns == other.mtime_ns && size == other.size && inode == other.inode;
+    }
+};
 
-             throw std::runtime_error(error_msg);
-        }
+bool get_file_stamp(const std::string &file_name, file_stamp &stamp)
+{
+    struct stat st;
+
+    if (stat(file_name.c_str(), &st) != 0)
+    {
+        return false;
     }
 
-    return ih_plugins[name].get<instrument_handler_ptr(const instrument_handler::init_info &handler_info)>("create_plugin")(handler_info);
+    stamp.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    stamp.size = st.st_size;
+    stamp.inode = st.st_ino;
+
+    return true;
 }
 
-//
-// Instrument handler factory routine.
-//
+struct handler_manifest
+{
+    file_stamp stamp;
+    std::uint32_t checksum;
 
-instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state> pss, const std::string &instrument)
+    std::string instrument;
+    std::string description;
+    int pips_digit;
+    trade_time_frame ttf;
+    bool conflate;
+    std::string handler;
+    boost::json::object handler_options;
+};
+
+typedef std::shared_ptr<const handler_manifest> handler_manifest_ptr;
+
+std::mutex ih_plugins_mtx;
+std::map<std::string, boost::dll::shared_library> ih_plugins;
+
+std::mutex manifests_mtx;
+std::map<std::string, handler_manifest_ptr> manifests;
+
+double seconds_since(std::chrono::steady_clock::time_point start)
 {
-    using namespace boost::json;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
-    instrument_handler::init_info handler_info;
+handler_manifest_ptr parse_manifest(const std::string &manifest, const file_stamp &stamp)
+{
+    using namespace boost::json;
 
-    handler_info.ticker = instrument;
-    handler_info.ticker_fmt2 = boost::erase_all_copy(instrument, "/");
-    handler_info.work_dir = hft_session::get_session_dir(pss -> get_session_id()) + std::string("/") + handler_info.ticker_fmt2;
-    handler_info.session_name = pss -> get_session_id();
-    handler_info.pss = pss;
+    std::shared_ptr<handler_manifest> m(new handler_manifest);
 
-    std::string manifest = handler_info.work_dir + std::string("/manifest.json");
+    m -> stamp = stamp;
+    m -> conflate = false;
 
     std::string json_data = hft::utils::file_get_contents(manifest);
 
+    boost::crc_32_type crc;
+    crc.process_bytes(json_data.data(), json_data.size());
+    m -> checksum = crc.checksum();
+
     value jv;
 
     try
@@ -372,17 +458,7 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
         throw std::runtime_error(error_message);
     }
 
-    std::string instr = instrument_v.get_string().c_str();
-
-    if (instr != instrument)
-    {
-        std::string error_message = std::string("Missmatch ‘instrument’ attribute (")
-                                    + instr + std::string(" != ") + instrument
-                                    + std::string(") type in manifest file ")
-                                    + manifest;
-
-        throw std::runtime_error(error_message);
-    }
+    m -> instrument = instrument_v.get_string().c_str();
 
     //
     // Get instrument description.
@@ -404,7 +480,7 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
         throw std::runtime_error(error_message);
     }
 
-    handler_info.description = description_v.get_string().c_str();
+    m -> description = description_v.get_string().c_str();
 
     //
     // Get pips digit.
@@ -426,12 +502,12 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
         throw std::runtime_error(error_message);
     }
 
-    handler_info.pips_digit = pips_digit_v.get_int64();
+    m -> pips_digit = pips_digit_v.get_int64();
 
-    if (handler_info.pips_digit <= 0 || handler_info.pips_digit >= 10)
+    if (m -> pips_digit <= 0 || m -> pips_digit >= 10)
     {
         std::string error_message = std::string("Illegal value ‘")
-                                    + std::to_string(handler_info.pips_digit)
+                                    + std::to_string(m -> pips_digit)
                                     + std::string("’ of ‘pips_digit’ attribute in manifest file ")
                                     + manifest;
 
@@ -455,7 +531,25 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
 
         object const &ttf_obj = ttf_v.get_object();
 
-        handler_info.ttf.init_from_json_object(ttf_obj);
+        m -> ttf.init_from_json_object(ttf_obj);
+    }
+
+    //
+    // Get tick conflation mode - presence not mandatory.
+    //
+
+    if (obj.contains("conflate"))
+    {
+        value const &conflate_v = obj.at("conflate");
+
+        if (conflate_v.kind() != kind::bool_)
+        {
+            std::string error_message = std::string("Invalid ‘conflate’ attribute type in manifest file ") + manifest;
+
+            throw std::runtime_error(error_message);
+        }
+
+        m -> conflate = conflate_v.get_bool();
     }
 
     //
@@ -478,7 +572,7 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
         throw std::runtime_error(error_message);
     }
 
-    std::string handler = handler_v.get_string().c_str();
+    m -> handler = handler_v.get_string().c_str();
 
     //
     // Get handler_options.
@@ -500,17 +594,178 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
         throw std::runtime_error(error_message);
     }
 
-    instrument_handler_ptr ih = nullptr;
+    m -> handler_options = handler_options_v.get_object();
+
+    return m;
+}
+
+//
+// Manifest changed on disk since it was cached is parsed again.
+//
+
+handler_manifest_ptr get_manifest(const std::string &manifest)
+{
+    file_stamp stamp;
+    bool have_stamp = get_file_stamp(manifest, stamp);
+
+    {
+        std::lock_guard<std::mutex> lck(manifests_mtx);
+
+        auto it = manifests.find(manifest);
+
+        if (have_stamp && it != manifests.end() && it -> second -> stamp == stamp)
+        {
+            return it -> second;
+        }
+    }
+
+    handler_manifest_ptr m = parse_manifest(manifest, stamp);
+
+    std::lock_guard<std::mutex> lck(manifests_mtx);
+
+    manifests[manifest] = m;
+
+    return m;
+}
+
+boost::dll::shared_library &load_plugin(const std::string &name)
+{
+    std::lock_guard<std::mutex> lck(ih_plugins_mtx);
+
+    auto it = ih_plugins.find(name);
+
+    if (it != ih_plugins.end())
+    {
+        return it -> second;
+    }
+
+    std::string file_name = std::string("/var/lib/hft/instrument-handlers/lib")
+                            + name + std::string(".so");
+
+    auto start = std::chrono::steady_clock::now();
+
+    boost::dll::shared_library plugin(file_name);
+
+    if (! plugin.has("create_plugin"))
+    {
+         std::string error_msg = std::string("Invalid instrument handler plugin ‘")
+                                 + file_name + std::string("’ - no factory function");
+
+         throw std::runtime_error(error_msg);
+    }
+
+    double elapsed = seconds_since(start);
+
+    metrics::make_gauge("hft_plugin_load_seconds", "Time it took to load instrument handler plugin.", {{"plugin", name}}).set(elapsed);
+
+    hft_log(INFO) << "Loaded plugin ‘" << file_name << "’ in " << 1000.0 * elapsed << " ms";
+
+    return ih_plugins.emplace(name, std::move(plugin)).first -> second;
+}
+
+} /* namespace */
+
+void preload_instrument_handlers(void)
+{
+    using namespace boost::filesystem;
+
+    el::Loggers::getLogger("session", true);
+
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+
+    boost::system::error_code ec;
+    path sessions_dir = hft_session::get_session_dir("");
+
+    if (! is_directory(sessions_dir, ec))
+    {
+        return;
+    }
+
+    for (auto &session : directory_iterator(sessions_dir, ec))
+    {
+        if (! is_directory(session.status()))
+        {
+            continue;
+        }
+
+        for (auto &instrument : directory_iterator(session.path(), ec))
+        {
+            path manifest = instrument.path() / "manifest.json";
+
+            if (! exists(manifest, ec))
+            {
+                continue;
+            }
+
+            try
+            {
+                handler_manifest_ptr m = get_manifest(manifest.string());
+
+                if (m -> handler != "dummy")
+                {
+                    load_plugin(m -> handler);
+                }
+
+                count++;
+            }
+            catch (const std::exception &e)
+            {
+                hft_log(WARNING) << "Unable to preload handler of ‘" << manifest.string()
+                                 << "’: " << e.what();
+            }
+        }
+    }
+
+    hft_log(INFO) << "Preloaded " << count << " instrument handlers in "
+                  << 1000.0 * seconds_since(start) << " ms";
+}
+
+//
+// Instrument handler factory routine.
+//
+
+instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state> pss, const std::string &instrument)
+{
+    instrument_handler::init_info handler_info;
+
+    handler_info.ticker = instrument;
+    handler_info.ticker_fmt2 = boost::erase_all_copy(instrument, "/");
+    handler_info.work_dir = hft_session::get_session_dir(pss -> get_session_id()) + std::string("/") + handler_info.ticker_fmt2;
+    handler_info.session_name = pss -> get_session_id();
+    handler_info.pss = pss;
+
+    std::string manifest = handler_info.work_dir + std::string("/manifest.json");
+
+    handler_manifest_ptr m = get_manifest(manifest);
+
+    if (m -> instrument != instrument)
+    {
+        std::string error_message = std::string("Missmatch ‘instrument’ attribute (")
+                                    + m -> instrument + std::string(" != ") + instrument
+                                    + std::string(") type in manifest file ")
+                                    + manifest;
+
+        throw std::runtime_error(error_message);
+    }
+
+    handler_info.description = m -> description;
+    handler_info.pips_digit = m -> pips_digit;
+    handler_info.ttf = m -> ttf;
+    handler_info.conflate = m -> conflate;
+    handler_info.manifest_checksum = m -> checksum;
 
-    object const &handler_options_obj = handler_options_v.get_object();
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<instrument_handler> ih;
 
     //
     // Create specific handler.
     //
 
-    if (handler == "dummy")
+    if (m -> handler == "dummy")
     {
-        ih = new hft_ih_dummy(handler_info);
+        ih.reset(new hft_ih_dummy(handler_info));
     }
     else
     {
@@ -519,10 +774,20 @@ instrument_handler_ptr create_instrument_handler(std::shared_ptr<session_state>
         // handlers, trying to import from plugin.
         //
 
-        ih = import_instrument_handler_from_plugin(handler, handler_info);
+        ih.reset(load_plugin(m -> handler).get<instrument_handler_ptr(const instrument_handler::init_info &handler_info)>("create_plugin")(handler_info));
     }
 
-    ih -> init_handler(handler_options_obj);
+    ih -> init_handler(m -> handler_options);
+
+    double elapsed = seconds_since(start);
+
+    static const std::vector<double> init_buckets = {0.0001, 0.001, 0.01, 0.1, 1.0, 10.0};
+
+    metrics::make_histogram("hft_handler_init_seconds", "Time it took to create and initialize instrument handler.",
+                            init_buckets, {{"plugin", m -> handler}}).observe(elapsed);
+
+    hft_log(INFO) << "Handler ‘" << m -> handler << "’ of ‘" << instrument << "’ initialized in "
+                  << 1000.0 * elapsed << " ms";
 
-    return ih;
+    return ih.release();
 }
@@ -0,0 +1,162 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <stdexcept>
+
+#include <instrument_lane.hpp>
+
+instrument_lane::instrument_lane(std::size_t capacity, job_handler on_job, completion_handler on_complete,
+                                 job_handler on_conflate)
+    : slots_(capacity), head_ {0}, tail_ {0}, queued_ticks_ {0},
+      spin_count_ {std::thread::hardware_concurrency() > 1 ? SPIN_COUNT : 0},
+      sleeping_ {false}, terminate_ {false},
+      on_job_ {on_job}, on_complete_ {on_complete}, on_conflate_ {on_conflate}
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("Instrument lane requires non-zero capacity");
+    }
+
+    thread_ = std::thread(&instrument_lane::run, this);
+}
+
+instrument_lane::~instrument_lane(void)
+{
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        terminate_ = true;
+        cv_.notify_one();
+    }
+
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+hft::protocol::request::holder &instrument_lane::prepare(void)
+{
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+    {
+        throw std::runtime_error("Instrument lane overflow");
+    }
+
+    return slots_[tail % slots_.size()];
+}
+
+void instrument_lane::commit(void)
+{
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+    //
+    // Counted before publishing, so worker never
+    // sees the tick without seeing it counted.
+    //
+
+    if (on_conflate_ && slots_[tail % slots_.size()].opcode == hft::protocol::request::tick::OPCODE)
+    {
+        queued_ticks_.fetch_add(1);
+    }
+
+    tail_.store(tail + 1);
+
+    //
+    // Worker sets the flag before checking the ring under
+    // the mutex, so either it sees the new slot or we see
+    // it sleeping and wake it up.
+    //
+
+    if (sleeping_.load())
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        cv_.notify_one();
+    }
+}
+
+void instrument_lane::run(void)
+{
+    while (! terminate_)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            //
+            // Ticks come in bursts, spin shortly before
+            // paying for sleep and wakeup. Pointless
+            // on single CPU, producer cannot progress.
+            //
+
+            bool arrived = false;
+
+            for (int i = 0; i < spin_count_ && ! arrived; i++)
+            {
+                arrived = (head != tail_.load(std::memory_order_acquire));
+            }
+
+            if (arrived)
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lck(mtx_);
+
+            sleeping_ = true;
+            cv_.wait(lck, [this, head](void) { return terminate_ || tail_.load() != head; });
+            sleeping_ = false;
+
+            continue;
+        }
+
+        hft::protocol::response resp;
+        std::exception_ptr error;
+
+        auto &job = slots_[head % slots_.size()];
+        bool conflated = false;
+
+        if (on_conflate_ && job.opcode == hft::protocol::request::tick::OPCODE)
+        {
+            conflated = (queued_ticks_.fetch_sub(1) > 1);
+        }
+
+        try
+        {
+            if (conflated)
+            {
+                on_conflate_(job, resp);
+            }
+            else
+            {
+                on_job_(job, resp);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        //
+        // Slot is released before completion, response
+        // does not refer to the request.
+        //
+
+        head_.store(head + 1, std::memory_order_release);
+
+        on_complete_(resp, error);
+    }
+}
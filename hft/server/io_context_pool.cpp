@@ -0,0 +1,110 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <pthread.h>
+#include <cstring>
+#include <stdexcept>
+
+#include <io_context_pool.hpp>
+
+#include <easylogging++.h>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "server")
+
+io_context_pool::io_context_pool(int workers, mode m, const std::vector<int> &cpus)
+    : workers_ {workers}, cpus_ {cpus}, next_context_ {0}
+{
+    if (workers_ <= 0)
+    {
+        throw std::invalid_argument("Worker pool requires at least one worker");
+    }
+
+    int n_contexts = (m == mode::CONTEXTS ? workers_ : 1);
+
+    for (int i = 0; i < n_contexts; i++)
+    {
+        //
+        // Concurrency hint 1 lets single threaded
+        // context skip internal locking.
+        //
+
+        contexts_.emplace_back(new boost::asio::io_context(m == mode::CONTEXTS ? 1 : workers_));
+        guards_.emplace_back(contexts_.back() -> get_executor());
+    }
+}
+
+io_context_pool::~io_context_pool(void)
+{
+    stop();
+}
+
+void io_context_pool::run(void)
+{
+    for (int i = 0; i < workers_; i++)
+    {
+        boost::asio::io_context &ioctx = *contexts_[i % contexts_.size()];
+
+        threads_.emplace_back([&ioctx](void) { ioctx.run(); });
+
+        if (i < static_cast<int>(cpus_.size()))
+        {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(cpus_[i], &cpuset);
+
+            int ret = pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpu_set_t), &cpuset);
+
+            if (ret != 0)
+            {
+                hft_log(WARNING) << "Failed to pin worker " << i << " to CPU "
+                                 << cpus_[i] << ": " << strerror(ret);
+            }
+            else
+            {
+                hft_log(INFO) << "Worker " << i << " pinned to CPU " << cpus_[i];
+            }
+        }
+    }
+
+    hft_log(INFO) << "Started " << workers_ << " session worker(s) on "
+                  << contexts_.size() << " event loop(s)";
+}
+
+void io_context_pool::stop(void)
+{
+    guards_.clear();
+
+    for (auto &ioctx : contexts_)
+    {
+        ioctx -> stop();
+    }
+
+    for (auto &t : threads_)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+
+    threads_.clear();
+}
+
+boost::asio::io_context &io_context_pool::get_io_context(void)
+{
+    return *contexts_[next_context_++ % contexts_.size()];
+}
@@ -0,0 +1,376 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <easylogging++.h>
+
+#include <latency_histogram.hpp>
+#include <metrics.hpp>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "metrics")
+
+namespace metrics {
+namespace latency {
+
+namespace {
+
+enum
+{
+    MIN_OCTAVE = 8,   /* 256 ns */
+    OCTAVES = 26,
+    BUCKET_COUNT = 1 + 2 * OCTAVES + 1,
+    MAX_FAMILIES = 1024
+};
+
+const char *stage_names[STAGE_COUNT] = {
+    "parse",
+    "handler",
+    "persist",
+    "serialize",
+    "total"
+};
+
+//
+// Bucket 0 holds everything below 256 ns, last one
+// everything above the range. Octave [2^k, 2^(k+1))
+// is split in halves at 1.5 * 2^k.
+//
+
+inline int bucket_index(std::uint64_t nanos)
+{
+    if (nanos < (1ull << MIN_OCTAVE))
+    {
+        return 0;
+    }
+
+    int k = 63 - __builtin_clzll(nanos);
+
+    if (k >= MIN_OCTAVE + OCTAVES)
+    {
+        return BUCKET_COUNT - 1;
+    }
+
+    return 1 + 2 * (k - MIN_OCTAVE) + ((nanos >> (k - 1)) & 1);
+}
+
+//
+// Upper bound of bucket in seconds.
+//
+
+double bucket_bound(int index)
+{
+    if (index == 0)
+    {
+        return (1ull << MIN_OCTAVE) * 1e-9;
+    }
+
+    int k = MIN_OCTAVE + (index - 1) / 2;
+
+    return ((index - 1) % 2 == 0 ? 1.5 : 2.0) * (1ull << k) * 1e-9;
+}
+
+//
+// Counters have single writer, the owning thread. Relaxed
+// atomics only keep scraping thread away from torn reads.
+//
+
+struct family_counters
+{
+    std::atomic<std::uint64_t> buckets[STAGE_COUNT][BUCKET_COUNT];
+    std::atomic<std::uint64_t> sum_nanos[STAGE_COUNT];
+};
+
+struct family_totals
+{
+    std::uint64_t buckets[STAGE_COUNT][BUCKET_COUNT];
+    std::uint64_t sum_nanos[STAGE_COUNT];
+};
+
+class shard;
+
+class registry
+{
+public:
+
+    int get_family(const std::string &market, const std::string &instrument, const std::string &method)
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        auto key = std::make_tuple(market, instrument, method);
+        auto it = families_.find(key);
+
+        if (it != families_.end())
+        {
+            return it -> second;
+        }
+
+        if (labels_.size() == MAX_FAMILIES)
+        {
+            hft_log(WARNING) << "Too many latency histograms, ‘" << market << "’ ‘"
+                             << instrument << "’ ‘" << method << "’ not recorded";
+
+            return NO_FAMILY;
+        }
+
+        int family = labels_.size();
+
+        families_[key] = family;
+        labels_.push_back(key);
+
+        return family;
+    }
+
+    void attach(shard *s)
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        shards_.insert(s);
+    }
+
+    //
+    // Thread is going away, its counts
+    // are kept in retired totals.
+    //
+
+    void detach(shard *s);
+
+    void produce_text_format(std::ostream &out);
+
+private:
+
+    std::mutex mtx_;
+    std::map<std::tuple<std::string, std::string, std::string>, int> families_;
+    std::vector<std::tuple<std::string, std::string, std::string> > labels_;
+    std::set<shard *> shards_;
+    std::vector<std::unique_ptr<family_totals> > retired_;
+};
+
+registry &get_registry(void)
+{
+    static registry r;
+
+    return r;
+}
+
+class shard
+{
+public:
+
+    shard(void)
+    {
+        for (auto &f : families_)
+        {
+            f.store(nullptr);
+        }
+
+        get_registry().attach(this);
+    }
+
+    ~shard(void)
+    {
+        get_registry().detach(this);
+
+        for (auto &f : families_)
+        {
+            delete f.load();
+        }
+    }
+
+    family_counters *get(int family)
+    {
+        family_counters *fc = families_[family].load(std::memory_order_acquire);
+
+        if (fc == nullptr)
+        {
+            fc = new family_counters {};
+            families_[family].store(fc, std::memory_order_release);
+        }
+
+        return fc;
+    }
+
+    const family_counters *peek(int family) const
+    {
+        return families_[family].load(std::memory_order_acquire);
+    }
+
+private:
+
+    std::array<std::atomic<family_counters *>, MAX_FAMILIES> families_;
+};
+
+thread_local shard local_shard;
+
+void registry::detach(shard *s)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    for (std::size_t family = 0; family < labels_.size(); family++)
+    {
+        const family_counters *fc = s -> peek(family);
+
+        if (fc == nullptr)
+        {
+            continue;
+        }
+
+        if (retired_.size() <= family)
+        {
+            retired_.resize(family + 1);
+        }
+
+        if (! retired_[family])
+        {
+            retired_[family].reset(new family_totals {});
+        }
+
+        for (int st = 0; st < STAGE_COUNT; st++)
+        {
+            for (int b = 0; b < BUCKET_COUNT; b++)
+            {
+                retired_[family] -> buckets[st][b] += fc -> buckets[st][b].load(std::memory_order_relaxed);
+            }
+
+            retired_[family] -> sum_nanos[st] += fc -> sum_nanos[st].load(std::memory_order_relaxed);
+        }
+    }
+
+    shards_.erase(s);
+}
+
+void registry::produce_text_format(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    bool header = false;
+
+    for (std::size_t family = 0; family < labels_.size(); family++)
+    {
+        family_totals totals {};
+
+        if (family < retired_.size() && retired_[family])
+        {
+            totals = *retired_[family];
+        }
+
+        for (auto s : shards_)
+        {
+            const family_counters *fc = s -> peek(family);
+
+            if (fc == nullptr)
+            {
+                continue;
+            }
+
+            for (int st = 0; st < STAGE_COUNT; st++)
+            {
+                for (int b = 0; b < BUCKET_COUNT; b++)
+                {
+                    totals.buckets[st][b] += fc -> buckets[st][b].load(std::memory_order_relaxed);
+                }
+
+                totals.sum_nanos[st] += fc -> sum_nanos[st].load(std::memory_order_relaxed);
+            }
+        }
+
+        for (int st = 0; st < STAGE_COUNT; st++)
+        {
+            std::uint64_t count = 0;
+
+            for (int b = 0; b < BUCKET_COUNT; b++)
+            {
+                count += totals.buckets[st][b];
+            }
+
+            if (count == 0)
+            {
+                continue;
+            }
+
+            if (! header)
+            {
+                out << "# HELP hft_request_latency_seconds Request latency by method and processing stage." << std::endl
+                    << "# TYPE hft_request_latency_seconds histogram" << std::endl;
+
+                header = true;
+            }
+
+            std::string lbs = "market=\"" + metrics::escape_label_value(std::get<0>(labels_[family]))
+                              + "\",instrument=\"" + metrics::escape_label_value(std::get<1>(labels_[family]))
+                              + "\",method=\"" + metrics::escape_label_value(std::get<2>(labels_[family]))
+                              + "\",stage=\"" + stage_names[st] + "\"";
+
+            std::uint64_t cumulative = 0;
+
+            for (int b = 0; b < BUCKET_COUNT - 1; b++)
+            {
+                cumulative += totals.buckets[st][b];
+
+                out << "hft_request_latency_seconds_bucket{" << lbs << ",le=\""
+                    << bucket_bound(b) << "\"} " << cumulative << std::endl;
+            }
+
+            out << "hft_request_latency_seconds_bucket{" << lbs << ",le=\"+Inf\"} " << count << std::endl
+                << "hft_request_latency_seconds_sum{" << lbs << "} " << totals.sum_nanos[st] * 1e-9 << std::endl
+                << "hft_request_latency_seconds_count{" << lbs << "} " << count << std::endl;
+        }
+    }
+}
+
+} /* namespace */
+
+int get_family(const std::string &market, const std::string &instrument, const std::string &method)
+{
+    if (! metrics::is_service_enabled())
+    {
+        return NO_FAMILY;
+    }
+
+    return get_registry().get_family(market, instrument, method);
+}
+
+void record(int family, stage s, std::uint64_t nanos)
+{
+    if (family == NO_FAMILY)
+    {
+        return;
+    }
+
+    family_counters *fc = local_shard.get(family);
+
+    auto &bucket = fc -> buckets[s][bucket_index(nanos)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    auto &sum = fc -> sum_nanos[s];
+    sum.store(sum.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+}
+
+void produce_text_format(std::ostream &out)
+{
+    get_registry().produce_text_format(out);
+}
+
+} /* namespace latency */
+} /* namespace metrics */
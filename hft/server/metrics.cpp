@@ -15,6 +15,7 @@
 \**********************************************************************/
 
 #include <metrics.hpp>
+#include <latency_histogram.hpp>
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
@@ -23,9 +24,14 @@
 #include <boost/asio/strand.hpp>
 #include <boost/config.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <thread>
 #include <vector>
 #include <utility>
@@ -44,6 +50,31 @@
 #define hft_log(__X__) \
     CLOG(__X__, "metrics")
 
+namespace metrics {
+
+//
+// Histogram buckets are not cumulative here, the
+// last one counts values above all upper bounds.
+//
+
+struct histogram_data
+{
+    explicit histogram_data(const std::vector<double> &bounds)
+        : upper_bounds {bounds}, buckets {new std::atomic<std::uint64_t>[bounds.size() + 1]}, sum {0.0}
+    {
+        for (std::size_t i = 0; i <= bounds.size(); i++)
+        {
+            buckets[i].store(0);
+        }
+    }
+
+    const std::vector<double> upper_bounds;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+    std::atomic<double> sum;
+};
+
+} // namespace metrics
+
 namespace {
 
 namespace beast = boost::beast;
@@ -51,95 +82,214 @@ namespace http  = beast::http;
 
 using tcp = boost::asio::ip::tcp;
 
-class
+//
+// Metric registry. Series are created under the mutex and
+// never destroyed, handles point straight to their storage,
+// so updates from session workers need no lock. Series are
+// indexed by precomputed hash of name and label set.
+//
+
+enum class metric_type
 {
-public:
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
 
-    void setup_percentage_use_of_margin_metric(const std::string &market, const std::string &instrument, double value)
+struct series
+{
+    std::string key;
+    std::atomic<std::uint64_t> counter_value {0};
+    std::atomic<double> gauge_value {0.0};
+    std::unique_ptr<metrics::histogram_data> histogram;
+};
+
+struct family
+{
+    std::string help;
+    metric_type type;
+    std::vector<double> upper_bounds;
+    std::vector<std::unique_ptr<series> > members;
+};
+
+std::uint64_t fnv1a(const std::string &s)
+{
+    std::uint64_t h = 14695981039346656037ull;
+
+    for (unsigned char c : s)
     {
-        labels lbs{market, instrument};
+        h = (h ^ c) * 1099511628211ull;
+    }
 
-        for (auto &item : percentage_use_of_margin_metrics_)
-        {
-            if (item.first == lbs)
-            {
-                item.second = value;
+    return h;
+}
 
-                return;
-            }
+bool is_valid_metric_name(const std::string &name)
+{
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+    {
+        return false;
+    }
+
+    return std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == ':'; });
+}
+
+//
+// Canonical label set text, sorted by label name,
+// values escaped as exposition format requires.
+//
+
+std::string format_labels(metrics::labels lbs)
+{
+    std::sort(lbs.begin(), lbs.end());
+
+    std::string text;
+
+    for (auto &l : lbs)
+    {
+        if (! is_valid_metric_name(l.first) || l.first.find(':') != std::string::npos)
+        {
+            throw std::runtime_error("Invalid metric label name ‘" + l.first + "’");
         }
 
-        percentage_use_of_margin_metrics_.emplace_back(lbs, value);
+        text += (text.empty() ? "" : ",") + l.first + "=\"" + metrics::escape_label_value(l.second) + "\"";
     }
 
-    void setup_opened_positions_metric(const std::string &market, const std::string &instrument, int value)
+    return text;
+}
+
+void produce_family(std::ostream &out, const std::string &name, const family &f)
+{
+    static const char *type_names[] = {"counter", "gauge", "histogram"};
+
+    out << "# HELP " << name << " " << f.help << std::endl
+        << "# TYPE " << name << " " << type_names[static_cast<int>(f.type)] << std::endl;
+
+    for (const auto &s : f.members)
     {
-        labels lbs{market, instrument};
+        //
+        // Key is ‘name{labels}’, or just ‘name’ without labels.
+        // Labels part is reused for histogram series with ‘le’
+        // appended.
+        //
 
-        for (auto &item : opened_positions_metrics_)
+        switch (f.type)
         {
-            if (item.first == lbs)
-            {
-                item.second = value;
-
-                return;
-            }
+            case metric_type::COUNTER:
+                 out << s -> key << " " << s -> counter_value.load(std::memory_order_relaxed) << std::endl;
+                 break;
+            case metric_type::GAUGE:
+                 out << s -> key << " " << s -> gauge_value.load(std::memory_order_relaxed) << std::endl;
+                 break;
+            case metric_type::HISTOGRAM:
+                 {
+                     std::string lbs = (s -> key.length() > name.length() ? s -> key.substr(name.length() + 1, s -> key.length() - name.length() - 2) : "");
+                     std::string sep = (lbs.empty() ? "" : ",");
+                     std::uint64_t cumulative = 0;
+
+                     for (std::size_t i = 0; i < f.upper_bounds.size(); i++)
+                     {
+                         cumulative += s -> histogram -> buckets[i].load(std::memory_order_relaxed);
+
+                         out << name << "_bucket{" << lbs << sep << "le=\"" << f.upper_bounds[i] << "\"} "
+                             << cumulative << std::endl;
+                     }
+
+                     cumulative += s -> histogram -> buckets[f.upper_bounds.size()].load(std::memory_order_relaxed);
+
+                     out << name << "_bucket{" << lbs << sep << "le=\"+Inf\"} " << cumulative << std::endl
+                         << name << "_sum{" << lbs << "} " << s -> histogram -> sum.load(std::memory_order_relaxed) << std::endl
+                         << name << "_count{" << lbs << "} " << cumulative << std::endl;
+                 }
+                 break;
         }
-
-        opened_positions_metrics_.emplace_back(lbs, value);
     }
+}
 
-    std::string produce_metrics_text_format(void) const
+class
+{
+public:
+
+    series *get_series(const std::string &name, const std::string &help, metric_type type,
+                       const std::vector<double> &upper_bounds, const metrics::labels &lbs)
     {
-        std::ostringstream out;
+        if (! is_valid_metric_name(name))
+        {
+            throw std::runtime_error("Invalid metric name ‘" + name + "’");
+        }
+
+        std::string key = (lbs.empty() ? name : name + "{" + format_labels(lbs) + "}");
+        std::uint64_t hash = fnv1a(key);
+
+        std::lock_guard<std::mutex> lck(mtx_);
 
-        if (percentage_use_of_margin_metrics_.size())
+        //
+        // Checked before existing series is returned, for
+        // every registration with the same labels as well.
+        //
+
+        auto &f = families_[name];
+
+        if (! f)
+        {
+            f.reset(new family {help, type, upper_bounds, {}});
+        }
+        else if (f -> type != type || f -> upper_bounds != upper_bounds)
         {
-            out << "# HELP hft_percentage_use_of_margin How many in percentage money is used by instrument." << std::endl
-                << "# TYPE hft_percentage_use_of_margin gauge" << std::endl;
+            throw std::runtime_error("Metric ‘" + name + "’ already registered with different type or buckets");
+        }
+
+        auto range = index_.equal_range(hash);
 
-            for (const auto &item : percentage_use_of_margin_metrics_)
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it -> second -> key == key)
             {
-                out << "hft_percentage_use_of_margin{market=\"" << item.first.market_
-                    << "\",instrument=\"" << item.first.instrument_ << "\"} "
-                    << item.second << std::endl;
+                return it -> second;
             }
         }
 
-        if (opened_positions_metrics_.size())
+        series *s = new series;
+        s -> key = key;
+
+        if (type == metric_type::HISTOGRAM)
+        {
+            s -> histogram.reset(new metrics::histogram_data(upper_bounds));
+        }
+
+        f -> members.emplace_back(s);
+        index_.emplace(hash, s);
+
+        return s;
+    }
+
+    std::string produce_metrics_text_format(void) const
+    {
+        std::ostringstream out;
+
         {
-            out << "# HELP hft_opened_positions Total number of opened position by instrument." << std::endl
-                << "# TYPE hft_opened_positions gauge" << std::endl;
+            std::lock_guard<std::mutex> lck(mtx_);
 
-            for (const auto &item : opened_positions_metrics_)
+            for (const auto &item : families_)
             {
-                out << "hft_opened_positions{market=\"" << item.first.market_
-                    << "\",instrument=\"" << item.first.instrument_ << "\"} "
-                    << item.second << std::endl;
+                produce_family(out, item.first, *item.second);
             }
         }
 
+        metrics::latency::produce_text_format(out);
+
         return out.str();
     }
 
 private:
 
-    struct labels
-    {
-        labels(const std::string &market, const std::string &instrument)
-            : market_{market}, instrument_{instrument} {}
-
-        friend bool operator==(const labels &lhs, const labels &rhs)
-        {
-            return (lhs.market_ == rhs.market_) && (lhs.instrument_ == rhs.instrument_);
-        }
-
-        std::string market_;
-        std::string instrument_;
-    };
+    //
+    // Sorted by name, so output is stable.
+    //
 
-    std::vector<std::pair<labels, double>> percentage_use_of_margin_metrics_;
-    std::vector<std::pair<labels, int>> opened_positions_metrics_;
+    std::map<std::string, std::unique_ptr<family> > families_;
+    std::unordered_multimap<std::uint64_t, series *> index_;
+    mutable std::mutex mtx_;
 } m;
 
 bool metrics_service_enabled = false;
@@ -567,19 +717,84 @@ bool is_service_enabled(void)
     return metrics_service_enabled;
 }
 
-void setup_percentage_use_of_margin(const std::string &market, const std::string &instrument, double value)
+std::string escape_label_value(const std::string &value)
 {
-    if (metrics_service_enabled)
+    std::string text;
+
+    text.reserve(value.length());
+
+    for (char c : value)
     {
-        m.setup_percentage_use_of_margin_metric(market, instrument, value);
+        switch (c)
+        {
+            case '\\': text += "\\\\"; break;
+            case '"':  text += "\\\""; break;
+            case '\n': text += "\\n"; break;
+            default:   text += c;
+        }
     }
+
+    return text;
 }
 
-void setup_opened_positions(const std::string &market, const std::string &instrument, int value)
+std::string produce_text_format(void)
 {
-    if (metrics_service_enabled)
+    return m.produce_metrics_text_format();
+}
+
+counter make_counter(const std::string &name, const std::string &help, const labels &lbs)
+{
+    if (! metrics_service_enabled)
+    {
+        return counter();
+    }
+
+    return counter(&m.get_series(name, help, metric_type::COUNTER, {}, lbs) -> counter_value);
+}
+
+gauge make_gauge(const std::string &name, const std::string &help, const labels &lbs)
+{
+    if (! metrics_service_enabled)
+    {
+        return gauge();
+    }
+
+    return gauge(&m.get_series(name, help, metric_type::GAUGE, {}, lbs) -> gauge_value);
+}
+
+histogram make_histogram(const std::string &name, const std::string &help,
+                         const std::vector<double> &upper_bounds, const labels &lbs)
+{
+    if (! std::is_sorted(upper_bounds.begin(), upper_bounds.end())
+            || std::adjacent_find(upper_bounds.begin(), upper_bounds.end()) != upper_bounds.end())
+    {
+        throw std::runtime_error("Buckets of histogram ‘" + name + "’ must be strictly increasing");
+    }
+
+    if (! metrics_service_enabled)
+    {
+        return histogram();
+    }
+
+    return histogram(m.get_series(name, help, metric_type::HISTOGRAM, upper_bounds, lbs) -> histogram.get());
+}
+
+void histogram::observe(double value)
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+
+    std::size_t index = std::lower_bound(data_ -> upper_bounds.begin(), data_ -> upper_bounds.end(), value)
+                        - data_ -> upper_bounds.begin();
+
+    data_ -> buckets[index].fetch_add(1, std::memory_order_relaxed);
+
+    double sum = data_ -> sum.load(std::memory_order_relaxed);
+
+    while (! data_ -> sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
     {
-        m.setup_opened_positions_metric(market, instrument, value);
     }
 }
 
@@ -0,0 +1,146 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <session_flusher.hpp>
+#include <hft_session_state.hpp>
+#include <easylogging++.h>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "session_state")
+
+session_flusher &session_flusher::instance(void)
+{
+    static session_flusher flusher;
+
+    return flusher;
+}
+
+session_flusher::session_flusher(void)
+    : flushing_ {nullptr}, terminate_ {false}
+{
+    el::Loggers::getLogger("session_state", true);
+
+    thread_ = std::thread(&session_flusher::run, this);
+}
+
+session_flusher::~session_flusher(void)
+{
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        terminate_ = true;
+        cv_.notify_all();
+    }
+
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void session_flusher::attach(session_state *pss, std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    sessions_[pss] = entry {interval, std::chrono::steady_clock::now() + interval, false};
+    cv_.notify_all();
+}
+
+void session_flusher::detach(session_state *pss)
+{
+    std::unique_lock<std::mutex> lck(mtx_);
+
+    sessions_.erase(pss);
+
+    cv_.wait(lck, [this, pss](void) { return flushing_ != pss; });
+}
+
+void session_flusher::request(session_state *pss)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    auto it = sessions_.find(pss);
+
+    if (it != sessions_.end() && ! it -> second.requested)
+    {
+        it -> second.requested = true;
+        cv_.notify_all();
+    }
+}
+
+void session_flusher::run(void)
+{
+    std::unique_lock<std::mutex> lck(mtx_);
+
+    while (! terminate_)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto wake_up = std::chrono::steady_clock::time_point::max();
+        session_state *due = nullptr;
+
+        for (auto &item : sessions_)
+        {
+            entry &e = item.second;
+
+            if (e.requested || (e.interval.count() > 0 && e.deadline <= now))
+            {
+                due = item.first;
+                e.requested = false;
+
+                if (e.interval.count() > 0)
+                {
+                    e.deadline = now + e.interval;
+                }
+
+                break;
+            }
+
+            if (e.interval.count() > 0 && e.deadline < wake_up)
+            {
+                wake_up = e.deadline;
+            }
+        }
+
+        if (due == nullptr)
+        {
+            if (wake_up == std::chrono::steady_clock::time_point::max())
+            {
+                cv_.wait(lck);
+            }
+            else
+            {
+                cv_.wait_until(lck, wake_up);
+            }
+
+            continue;
+        }
+
+        flushing_ = due;
+        lck.unlock();
+
+        try
+        {
+            due -> flush();
+        }
+        catch (const std::exception &e)
+        {
+            hft_log(ERROR) << "Failed to flush session ‘" << due -> get_session_id() << "’: " << e.what();
+        }
+
+        lck.lock();
+        flushing_ = nullptr;
+        cv_.notify_all();
+    }
+}
@@ -0,0 +1,444 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <session_journal.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/crc.hpp>
+
+#include <easylogging++.h>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "session_state")
+
+namespace {
+
+constexpr std::size_t HEADER_SIZE = 8;
+
+//
+// Guards against allocating garbage
+// length read from damaged record.
+//
+
+constexpr std::uint32_t MAX_RECORD_SIZE = 64 * 1024 * 1024;
+
+void put_u16(std::string &out, std::uint16_t v)
+{
+    out.push_back(static_cast<char>(v & 0xff));
+    out.push_back(static_cast<char>(v >> 8));
+}
+
+void put_u32(std::string &out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+std::uint32_t get_u32(const char *p)
+{
+    const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+
+    return u[0] | (u[1] << 8) | (u[2] << 16) | (static_cast<std::uint32_t>(u[3]) << 24);
+}
+
+std::uint16_t get_u16(const char *p)
+{
+    const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+
+    return u[0] | (u[1] << 8);
+}
+
+std::uint32_t crc32(const char *data, std::size_t length)
+{
+    boost::crc_32_type crc;
+
+    crc.process_bytes(data, length);
+
+    return crc.checksum();
+}
+
+//
+// Reads length-prefixed string at ‘pos’ of record body,
+// returns false if it does not fit in the body.
+//
+
+bool get_string(const char *body, std::size_t body_size, std::size_t &pos, std::size_t length_size, std::string &out)
+{
+    if (pos + length_size > body_size)
+    {
+        return false;
+    }
+
+    std::size_t length = (length_size == 2 ? get_u16(body + pos) : get_u32(body + pos));
+    pos += length_size;
+
+    if (pos + length > body_size)
+    {
+        return false;
+    }
+
+    out.assign(body + pos, length);
+    pos += length;
+
+    return true;
+}
+
+bool read_at(int fd, char *data, std::size_t length, off_t offset)
+{
+    std::size_t total = 0;
+
+    while (total < length)
+    {
+        ssize_t n = pread(fd, data + total, length - total, offset + total);
+
+        if (n == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            return false;
+        }
+
+        total += n;
+    }
+
+    return true;
+}
+
+const char *GENERATION_NAME = "generation";
+
+//
+// Generation record is small, anything
+// bigger is not taken for one.
+//
+
+constexpr std::uint32_t MAX_GENERATION_RECORD_SIZE = 64;
+
+//
+// Reads generation record at the start of journal, if
+// there is one. ‘record_size’ is its size in the file.
+//
+
+bool read_generation(int fd, std::uint64_t file_size, std::uint64_t &generation, std::uint64_t &record_size)
+{
+    char header[HEADER_SIZE];
+
+    if (file_size < HEADER_SIZE || ! read_at(fd, header, HEADER_SIZE, 0))
+    {
+        return false;
+    }
+
+    std::uint32_t length = get_u32(header);
+
+    if (length > MAX_GENERATION_RECORD_SIZE || HEADER_SIZE + length > file_size)
+    {
+        return false;
+    }
+
+    std::string data(HEADER_SIZE + length, '\0');
+
+    if (! read_at(fd, &data[0], data.size(), 0))
+    {
+        return false;
+    }
+
+    bool found = false;
+    std::size_t consumed;
+
+    session_journal::decode(data.data(), data.size(),
+                            [&](const std::string &scope, const std::string &name, const std::string &value)
+                            {
+                                if (scope.empty() && name == GENERATION_NAME)
+                                {
+                                    generation = std::strtoull(value.c_str(), nullptr, 10);
+                                    found = true;
+                                }
+                            }, consumed);
+
+    record_size = consumed;
+
+    return found;
+}
+
+} /* namespace */
+
+session_journal::session_journal(const std::string &file_name, bool read_only)
+    : file_name_ {file_name}, read_only_ {read_only}, fd_ {-1}, size_ {0}, base_ {0}, generation_ {0}
+{
+    if (read_only_)
+    {
+        fd_ = open(file_name_.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    else
+    {
+        fd_ = open(file_name_.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    }
+
+    if (fd_ == -1)
+    {
+        if (read_only_ && errno == ENOENT)
+        {
+            return;
+        }
+
+        throw std::runtime_error("Unable to open journal ‘" + file_name_ + "’: " + strerror(errno));
+    }
+
+    off_t end = lseek(fd_, 0, SEEK_END);
+
+    size_ = (end > 0 ? end : 0);
+
+    if (! read_generation(fd_, size_, generation_, base_))
+    {
+        generation_ = 0;
+        base_ = 0;
+    }
+}
+
+bool session_journal::has_records(const std::string &file_name)
+{
+    int fd = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    off_t end = lseek(fd, 0, SEEK_END);
+    std::uint64_t size = (end > 0 ? end : 0);
+    std::uint64_t generation, base = 0;
+
+    if (! read_generation(fd, size, generation, base))
+    {
+        base = 0;
+    }
+
+    close(fd);
+
+    return size > base;
+}
+
+session_journal::~session_journal(void)
+{
+    if (fd_ != -1)
+    {
+        close(fd_);
+    }
+}
+
+std::size_t session_journal::replay(const apply_handler &apply)
+{
+    //
+    // Generation record is not a change,
+    // records start right behind it.
+    //
+
+    std::string data(size_ - base_, '\0');
+
+    if (! read_at(fd_, &data[0], data.size(), base_))
+    {
+        throw std::runtime_error("Unable to read journal ‘" + file_name_ + "’");
+    }
+
+    std::size_t pos = 0;
+    std::size_t records = decode(data.data(), data.size(), apply, pos);
+
+    if (pos < data.size())
+    {
+        hft_log(WARNING) << "Journal ‘" << file_name_ << "’ damaged at offset " << base_ + pos
+                         << (read_only_ ? ", ignoring last " : ", dropping last ") << (data.size() - pos) << " bytes";
+
+        if (read_only_)
+        {
+            return records;
+        }
+
+        if (ftruncate(fd_, base_ + pos) == -1)
+        {
+            throw std::runtime_error("Unable to truncate journal ‘" + file_name_ + "’: " + strerror(errno));
+        }
+
+        size_ = base_ + pos;
+    }
+
+    return records;
+}
+
+std::size_t session_journal::decode(const char *data, std::size_t size, const apply_handler &apply, std::size_t &consumed)
+{
+    std::size_t pos = 0;
+    std::size_t records = 0;
+    std::string scope, name, value;
+
+    while (pos + HEADER_SIZE <= size)
+    {
+        std::uint32_t length = get_u32(data + pos);
+        std::uint32_t checksum = get_u32(data + pos + 4);
+
+        if (length > MAX_RECORD_SIZE || pos + HEADER_SIZE + length > size
+                || crc32(data + pos + HEADER_SIZE, length) != checksum)
+        {
+            break;
+        }
+
+        const char *body = data + pos + HEADER_SIZE;
+        std::size_t body_pos = 0;
+
+        if (! get_string(body, length, body_pos, 2, scope) || ! get_string(body, length, body_pos, 2, name)
+                || ! get_string(body, length, body_pos, 4, value) || body_pos != length)
+        {
+            break;
+        }
+
+        apply(scope, name, value);
+
+        pos += HEADER_SIZE + length;
+        records++;
+    }
+
+    consumed = pos;
+
+    return records;
+}
+
+void session_journal::encode(std::string &batch, const std::string &scope, const std::string &name, const std::string &value)
+{
+    if (scope.size() > MAX_KEY_LENGTH || name.size() > MAX_KEY_LENGTH
+            || 8 + scope.size() + name.size() + value.size() > MAX_RECORD_SIZE)
+    {
+        throw std::runtime_error("Variable ‘" + name + "’ does not fit journal record");
+    }
+
+    std::size_t header_pos = batch.size();
+
+    put_u32(batch, 0);
+    put_u32(batch, 0);
+
+    std::size_t body_pos = batch.size();
+
+    put_u16(batch, scope.size());
+    batch += scope;
+    put_u16(batch, name.size());
+    batch += name;
+    put_u32(batch, value.size());
+    batch += value;
+
+    std::uint32_t length = batch.size() - body_pos;
+    std::uint32_t checksum = crc32(&batch[body_pos], length);
+
+    for (int i = 0; i < 4; i++)
+    {
+        batch[header_pos + i] = static_cast<char>((length >> (8 * i)) & 0xff);
+        batch[header_pos + 4 + i] = static_cast<char>((checksum >> (8 * i)) & 0xff);
+    }
+}
+
+void session_journal::append(const std::string &batch)
+{
+    if (read_only_)
+    {
+        throw std::runtime_error("Journal ‘" + file_name_ + "’ is read only");
+    }
+
+    const char *data = batch.data();
+    std::size_t left = batch.size();
+
+    while (left > 0)
+    {
+        ssize_t n = write(fd_, data, left);
+
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            //
+            // Torn record must not stay in front
+            // of records appended later.
+            //
+
+            int error = errno;
+
+            if (ftruncate(fd_, size_) == -1)
+            {
+                hft_log(ERROR) << "Unable to cut torn record off journal ‘" << file_name_ << "’";
+            }
+
+            throw std::runtime_error("Unable to write journal ‘" + file_name_ + "’: " + strerror(error));
+        }
+
+        data += n;
+        left -= n;
+    }
+
+    size_ += batch.size();
+}
+
+void session_journal::sync(void)
+{
+    if (read_only_)
+    {
+        throw std::runtime_error("Journal ‘" + file_name_ + "’ is read only");
+    }
+
+    if (fdatasync(fd_) == -1)
+    {
+        throw std::runtime_error("Unable to sync journal ‘" + file_name_ + "’: " + strerror(errno));
+    }
+}
+
+void session_journal::reset(std::uint64_t generation)
+{
+    if (read_only_)
+    {
+        throw std::runtime_error("Journal ‘" + file_name_ + "’ is read only");
+    }
+
+    if (ftruncate(fd_, 0) == -1)
+    {
+        throw std::runtime_error("Unable to truncate journal ‘" + file_name_ + "’: " + strerror(errno));
+    }
+
+    size_ = 0;
+    base_ = 0;
+    generation_ = generation;
+
+    //
+    // Truncated journal without generation record
+    // is older than snapshot, which is all right,
+    // there is nothing in it to replay.
+    //
+
+    std::string record;
+
+    encode(record, "", GENERATION_NAME, std::to_string(generation));
+    append(record);
+
+    base_ = record.size();
+}
@@ -0,0 +1,208 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <session_snapshot.hpp>
+#include <utilities.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/crc.hpp>
+
+namespace {
+
+constexpr char MAGIC[8] = {'H', 'F', 'T', 'W', 'A', 'R', 'M', '1'};
+constexpr std::uint32_t VERSION = 1;
+
+struct image_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t section_count;
+    std::uint64_t created;
+    char reserved[8];
+};
+
+struct section_header
+{
+    std::uint32_t kind;
+    std::uint32_t name_length;
+    std::uint64_t payload_length;
+    std::uint32_t checksum;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(image_header) == 32, "Header size mismatch");
+static_assert(sizeof(section_header) == 24, "Section header size mismatch");
+
+std::size_t align8(std::size_t n)
+{
+    return (n + 7) & ~static_cast<std::size_t>(7);
+}
+
+} /* namespace */
+
+session_snapshot::writer::writer(void)
+    : image_(sizeof(image_header), '\0'), section_count_ {0}
+{
+}
+
+void session_snapshot::writer::add(section kind, const std::string &name, std::string_view payload)
+{
+    boost::crc_32_type crc;
+
+    crc.process_bytes(name.data(), name.size());
+    crc.process_bytes(payload.data(), payload.size());
+
+    section_header sh {};
+
+    sh.kind = static_cast<std::uint32_t>(kind);
+    sh.name_length = name.size();
+    sh.payload_length = payload.size();
+    sh.checksum = crc.checksum();
+
+    image_.append(reinterpret_cast<const char *>(&sh), sizeof(sh));
+    image_ += name;
+    image_.append(payload.data(), payload.size());
+    image_.resize(align8(image_.size()), '\0');
+
+    section_count_++;
+}
+
+void session_snapshot::writer::write(const std::string &file_name, bool sync)
+{
+    image_header header {};
+
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.section_count = section_count_;
+    header.created = hft::utils::get_current_timestamp();
+
+    memcpy(&image_[0], &header, sizeof(header));
+
+    hft::utils::file_put_contents_atomic(file_name, image_, sync);
+}
+
+session_snapshot::session_snapshot(const std::string &file_name)
+    : base_ {nullptr}, size_ {0}, created_ {0}
+{
+    int fd = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        throw std::runtime_error("Unable to open snapshot ‘" + file_name + "’: " + strerror(errno));
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(image_header))
+    {
+        close(fd);
+
+        throw std::runtime_error("Bad snapshot ‘" + file_name + "’");
+    }
+
+    void *base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map snapshot ‘" + file_name + "’: " + strerror(error));
+    }
+
+    base_ = static_cast<const char *>(base);
+    size_ = st.st_size;
+
+    image_header header;
+
+    memcpy(&header, base_, sizeof(header));
+
+    bool valid = (memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION);
+    std::size_t pos = sizeof(image_header);
+
+    for (std::uint32_t i = 0; valid && i < header.section_count; i++)
+    {
+        section_header sh;
+
+        if (pos + sizeof(sh) > size_)
+        {
+            valid = false;
+            break;
+        }
+
+        memcpy(&sh, base_ + pos, sizeof(sh));
+        pos += sizeof(sh);
+
+        if (sh.name_length > size_ - pos || sh.payload_length > size_ - pos - sh.name_length)
+        {
+            valid = false;
+            break;
+        }
+
+        boost::crc_32_type crc;
+
+        crc.process_bytes(base_ + pos, sh.name_length + sh.payload_length);
+
+        if (crc.checksum() != sh.checksum)
+        {
+            valid = false;
+            break;
+        }
+
+        std::string name(base_ + pos, sh.name_length);
+        std::string_view payload(base_ + pos + sh.name_length, sh.payload_length);
+
+        sections_[std::make_pair(static_cast<section>(sh.kind), name)] = payload;
+
+        pos = align8(pos + sh.name_length + sh.payload_length);
+    }
+
+    if (! valid)
+    {
+        munmap(const_cast<char *>(base_), size_);
+
+        throw std::runtime_error("Bad snapshot ‘" + file_name + "’");
+    }
+
+    created_ = header.created;
+}
+
+session_snapshot::~session_snapshot(void)
+{
+    munmap(const_cast<char *>(base_), size_);
+}
+
+bool session_snapshot::find(section kind, const std::string &name, std::string_view &payload) const
+{
+    auto it = sections_.find(std::make_pair(kind, name));
+
+    if (it == sections_.end())
+    {
+        return false;
+    }
+
+    payload = it -> second;
+
+    return true;
+}
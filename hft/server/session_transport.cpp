@@ -14,97 +14,710 @@
 **                                                                    **
 \**********************************************************************/
 
+#include <algorithm>
 #include <ctime>
 #include <cstdio>
+#include <utility>
+
+#include <boost/algorithm/string/erase.hpp>
 
 #include <session_transport.hpp>
-#include <hft_response.hpp>
+#include <hft_binary_protocol.hpp>
+#include <hft_trace.hpp>
 
 #define hft_log(__X__) \
     CLOG(__X__, "transport")
 
+namespace {
+
+int request_instrument_id(const hft::protocol::request::holder &req)
+{
+    switch (req.opcode)
+    {
+        case hft::protocol::request::sync::OPCODE:
+             return req.sync_msg.instrument_id;
+        case hft::protocol::request::tick::OPCODE:
+             return req.tick_msg.instrument_id;
+        case hft::protocol::request::open_notify::OPCODE:
+             return req.open_notify_msg.instrument_id;
+        case hft::protocol::request::close_notify::OPCODE:
+             return req.close_notify_msg.instrument_id;
+        default:
+             return hft::protocol::request::NO_INSTRUMENT;
+    }
+}
+
+} /* namespace */
+
+void session_transport::do_read(void)
+{
+    reading_ = true;
+
+    if (shm_)
+    {
+        shm_ -> async_read(input_buffer_, [this](const boost::system::error_code &error) { handle_read(error); });
+    }
+    else if (binary_framing_)
+    {
+        boost::asio::async_read(socket_, boost::asio::dynamic_buffer(input_buffer_), boost::asio::transfer_at_least(1),
+                                boost::bind(&session_transport::handle_read, this, boost::asio::placeholders::error));
+    }
+    else
+    {
+        boost::asio::async_read_until(socket_, boost::asio::dynamic_buffer(input_buffer_), '\n',
+                                      boost::bind(&session_transport::handle_read, this, boost::asio::placeholders::error));
+    }
+}
+
+void session_transport::do_write(void)
+{
+    if (writing_ || pending_count_ == 0)
+    {
+        return;
+    }
+
+    //
+    // All queued responses go out in single write. Buffers
+    // are swapped rather than copied, both keep capacity.
+    //
+
+    writing_buffer_.clear();
+    std::swap(output_buffer_, writing_buffer_);
+
+    writing_stamps_.clear();
+    std::swap(pending_stamps_, writing_stamps_);
+    writing_count_ = pending_count_;
+    pending_count_ = 0;
+
+    writing_ = true;
+
+    HFT_TRACE_STAMP(write_start_);
+
+    if (shm_)
+    {
+        shm_ -> async_write(writing_buffer_, [this](const boost::system::error_code &error) { handle_write(error); });
+
+        return;
+    }
+
+    boost::asio::async_write(socket_, boost::asio::buffer(writing_buffer_),
+                             boost::bind(&session_transport::handle_write, this, boost::asio::placeholders::error));
+}
+
 void session_transport::handle_read(const boost::system::error_code &error)
 {
-    if (! error)
+    reading_ = false;
+
+    HFT_TRACE_INSTANT(READ, -1, input_buffer_.size());
+
+    if (timing_)
+    {
+        read_time_ = metrics::latency::now();
+    }
+
+    if (closing_)
+    {
+        release_if_idle();
+
+        return;
+    }
+
+    if (error)
+    {
+        hft_log(WARNING) << "Destroying session because of error ("
+                         << error.value() << "): " << error.message();
+
+        terminate();
+
+        return;
+    }
+
+    if (! process_input())
+    {
+        return;
+    }
+
+    do_write();
+
+    if (outstanding_responses() < pipeline_depth_)
+    {
+        do_read();
+    }
+}
+
+void session_transport::handle_write(const boost::system::error_code &error)
+{
+    writing_ = false;
+    writing_count_ = 0;
+
+    HFT_TRACE_END(write_start_, WRITE, -1, writing_buffer_.size());
+
+    if (closing_)
+    {
+        release_if_idle();
+
+        return;
+    }
+
+    if (error)
+    {
+        hft_log(WARNING) << "Destroying session because of error ("
+                         << error.value() << "): " << error.message();
+
+        terminate();
+
+        return;
+    }
+
+    if (! writing_stamps_.empty())
+    {
+        std::uint64_t now = metrics::latency::now();
+
+        for (auto &stamp : writing_stamps_)
+        {
+            metrics::latency::record(stamp.family, metrics::latency::TOTAL, now - stamp.start);
+        }
+
+        writing_stamps_.clear();
+    }
+
+    continue_processing();
+}
+
+void session_transport::continue_processing(void)
+{
+    //
+    // Input buffer must not be touched while read
+    // operation is in progress. Read is issued only
+    // when there is no complete request in buffer,
+    // so there is nothing to process anyway.
+    //
+
+    if (reading_)
     {
-        //
-        // Extract the newline-delimited message from the buffer.
-        //
+        do_write();
 
-        std::string line;
-        std::istream is(&input_buffer_);
-        std::getline(is, line);
+        return;
+    }
+
+    if (! process_input())
+    {
+        return;
+    }
+
+    do_write();
+
+    if (outstanding_responses() < pipeline_depth_)
+    {
+        do_read();
+    }
+}
 
+void session_transport::complete_deferred(const hft::protocol::response &resp, std::exception_ptr error)
+{
+    //
+    // Completions are posted to session strand in order
+    // of calls, so per-instrument order is preserved.
+    //
+
+    boost::asio::post(socket_.get_executor(), [this, resp, error](void) { handle_deferred(resp, error); });
+}
+
+void session_transport::handle_deferred(const hft::protocol::response &resp, std::exception_ptr error)
+{
+    deferred_count_--;
+
+    latency_stamp stamp {metrics::latency::NO_FAMILY, 0};
+    std::size_t instrument_id = resp.get_instrument_id();
+
+    if (instrument_id < deferred_stamps_.size() && ! deferred_stamps_[instrument_id].empty())
+    {
+        stamp = deferred_stamps_[instrument_id].front();
+        deferred_stamps_[instrument_id].pop_front();
+    }
+
+    if (closing_)
+    {
+        release_if_idle();
+
+        return;
+    }
+
+    if (error)
+    {
         try
         {
-            hft::protocol::request::generic msg = hft::protocol::parse_request_payload(line);
+            std::rethrow_exception(error);
+        }
+        catch (const std::exception &e)
+        {
+            hft_log(ERROR) << "Error occured: " << e.what()
+                           << ". Going to close the session";
+        }
+        catch (...)
+        {
+            hft_log(ERROR) << "Unknown error occured. Going to close the session";
+        }
+
+        terminate();
+
+        return;
+    }
+
+    //
+    // Runs straight on the socket executor, so nothing
+    // may escape into io_context::run from here.
+    //
+
+    try
+    {
+        enqueue_response(resp, stamp);
+    }
+    catch (const std::exception &e)
+    {
+        hft_log(ERROR) << "Error occured: " << e.what()
+                       << ". Going to close the session";
+
+        terminate();
+
+        return;
+    }
+
+    continue_processing();
+}
 
-            switch (msg.index())
+bool session_transport::process_input(void)
+{
+    std::size_t consumed = 0;
+
+    try
+    {
+        while (outstanding_responses() < pipeline_depth_)
+        {
+            if (binary_framing_)
+            {
+                const char *frame = input_buffer_.data() + consumed;
+                std::size_t available = input_buffer_.length() - consumed;
+                std::size_t n = hft::protocol::binary::frame_size(frame, available);
+
+                if (n == 0 || n > available)
+                {
+                    break;
+                }
+
+                consumed += n;
+                lookahead_offset_ = consumed;
+
+                process_frame(frame);
+            }
+            else
             {
-                case hft::protocol::request::init::OPCODE:
-                     handle_init_request(boost::variant2::get<hft::protocol::request::init::OPCODE>(msg), response_data_);
-                     break;
-                case hft::protocol::request::sync::OPCODE:
-                     handle_sync_request(boost::variant2::get<hft::protocol::request::sync::OPCODE>(msg), response_data_);
-                     break;
-                case hft::protocol::request::tick::OPCODE:
-                     handle_tick_request(boost::variant2::get<hft::protocol::request::tick::OPCODE>(msg), response_data_);
-                     break;
-                case hft::protocol::request::open_notify::OPCODE:
-                     handle_open_notify_request(boost::variant2::get<hft::protocol::request::open_notify::OPCODE>(msg), response_data_);
-                     break;
-                case hft::protocol::request::close_notify::OPCODE:
-                     handle_close_notify_request(boost::variant2::get<hft::protocol::request::close_notify::OPCODE>(msg), response_data_);
-                     break;
-                default:
-                    throw std::runtime_error("Transport error");
+                std::size_t eol = input_buffer_.find('\n', consumed);
+
+                if (eol == std::string::npos)
+                {
+                    break;
+                }
+
+                const char *line = input_buffer_.data() + consumed;
+                std::size_t length = eol - consumed;
+                consumed = eol + 1;
+                lookahead_offset_ = consumed;
+
+                process_request(line, length);
             }
         }
-        catch (const hft::protocol::request::violation_error &e)
+    }
+    catch (const std::exception &e)
+    {
+        hft_log(ERROR) << "Error occured: " << e.what()
+                       << ". Going to close the session";
+
+        terminate();
+
+        return false;
+    }
+
+    input_buffer_.erase(0, consumed);
+    scan_offset_ = (scan_offset_ > consumed ? scan_offset_ - consumed : 0);
+
+    return true;
+}
+
+void session_transport::process_request(const char *line, std::size_t length)
+{
+    hft::protocol::response resp;
+
+    std::uint64_t parse_start = (timing_ ? metrics::latency::now() : 0);
+
+    HFT_TRACE_BEGIN(trace_start);
+
+    if (parser_.parse(line, length, request_))
+    {
+        std::uint64_t parse_end = (timing_ ? metrics::latency::now() : 0);
+
+        HFT_TRACE_END(trace_start, PARSE, request_instrument_id(request_), request_.opcode);
+
+        consume_lookahead();
+
+        dispatch_request(resp);
+        complete_request(resp, parse_start, parse_end);
+    }
+    else
+    {
+        hft_log(ERROR) << "Protocol violation error: " << parser_.get_error_message()
+                       << ". Client request: ‘" << std::string(line, length) << "’";
+
+        resp.error(parser_.get_error_message());
+
+        enqueue_response(resp, latency_stamp {metrics::latency::NO_FAMILY, 0});
+    }
+
+    //
+    // Response for init is always JSON, framing
+    // negotiated in init applies to what follows.
+    //
+
+    if (switch_to_binary_)
+    {
+        binary_framing_ = true;
+        switch_to_binary_ = false;
+
+        reset_lookahead();
+    }
+}
+
+void session_transport::process_frame(const char *frame)
+{
+    hft::protocol::response resp;
+
+    std::uint64_t parse_start = (timing_ ? metrics::latency::now() : 0);
+
+    HFT_TRACE_BEGIN(trace_start);
+
+    try
+    {
+        hft::protocol::binary::decode_request(frame, instruments_, request_);
+
+        std::uint64_t parse_end = (timing_ ? metrics::latency::now() : 0);
+
+        HFT_TRACE_END(trace_start, PARSE, request_instrument_id(request_), request_.opcode);
+
+        consume_lookahead();
+
+        dispatch_request(resp);
+        complete_request(resp, parse_start, parse_end);
+    }
+    catch (const hft::protocol::request::violation_error &e)
+    {
+        hft_log(ERROR) << "Protocol violation error: " << e.what()
+                       << ". Client sent binary frame";
+
+        resp = hft::protocol::response();
+        resp.error(e.what());
+
+        enqueue_response(resp, latency_stamp {metrics::latency::NO_FAMILY, 0});
+    }
+}
+
+void session_transport::complete_request(hft::protocol::response &resp, std::uint64_t parse_start, std::uint64_t parse_end)
+{
+    latency_stamp stamp {metrics::latency::NO_FAMILY, read_time_};
+    int instrument_id = request_instrument_id(request_);
+
+    if (timing_)
+    {
+        stamp.family = latency_family(request_.opcode, instrument_id);
+        metrics::latency::record(stamp.family, metrics::latency::PARSE, parse_end - parse_start);
+    }
+
+    if (deferred_)
+    {
+        deferred_ = false;
+        deferred_count_++;
+
+        if (instrument_id >= 0 && instrument_id < static_cast<int>(deferred_stamps_.size()))
+        {
+            deferred_stamps_[instrument_id].push_back(stamp);
+        }
+    }
+    else
+    {
+        enqueue_response(resp, stamp);
+    }
+}
+
+void session_transport::dispatch_request(hft::protocol::response &resp)
+{
+    switch (request_.opcode)
+    {
+        case hft::protocol::request::init::OPCODE:
+             {
+                 auto &req = request_.init_msg;
+                 resp.set_cid(req.cid);
+                 handle_init_request(req, resp);
+
+                 if (! resp.is_error())
+                 {
+                     if (timing_)
+                     {
+                         setup_latency_families(req.sessid, req.instruments);
+                     }
+
+                     instruments_ = req.instruments;
+                     parser_.set_instruments(instruments_);
+                     lookahead_parser_.set_instruments(instruments_);
+                     reset_lookahead();
+                     pipeline_depth_ = req.pipeline_depth;
+                     switch_to_binary_ = req.binary_framing;
+                 }
+             }
+             break;
+        case hft::protocol::request::sync::OPCODE:
+             {
+                 auto &req = request_.sync_msg;
+                 resp.set_cid(req.cid);
+                 handle_sync_request(req, resp);
+             }
+             break;
+        case hft::protocol::request::tick::OPCODE:
+             {
+                 auto &req = request_.tick_msg;
+                 resp.set_cid(req.cid);
+
+                 if (is_conflating(req.instrument_id) && newer_tick_waiting(req.instrument_id))
+                 {
+                     resp.set_instrument(req.instrument_id, req.instrument);
+                     on_tick_conflated(req);
+                 }
+                 else
+                 {
+                     handle_tick_request(req, resp);
+                 }
+             }
+             break;
+        case hft::protocol::request::open_notify::OPCODE:
+             {
+                 auto &req = request_.open_notify_msg;
+                 resp.set_cid(req.cid);
+                 handle_open_notify_request(req, resp);
+             }
+             break;
+        case hft::protocol::request::close_notify::OPCODE:
+             {
+                 auto &req = request_.close_notify_msg;
+                 resp.set_cid(req.cid);
+                 handle_close_notify_request(req, resp);
+             }
+             break;
+        default:
+            throw std::runtime_error("Transport error");
+    }
+}
+
+bool session_transport::newer_tick_waiting(int instrument_id)
+{
+    if (instrument_id < 0 || instrument_id >= static_cast<int>(waiting_ticks_.size()))
+    {
+        return false;
+    }
+
+    if (waiting_ticks_[instrument_id] > 0)
+    {
+        return true;
+    }
+
+    //
+    // Only complete requests already buffered count. Scan
+    // resumes where previous one stopped and stops at the
+    // first matching tick, so every buffered request is
+    // classified once however long the burst is.
+    //
+
+    scan_offset_ = std::max(scan_offset_, lookahead_offset_);
+
+    while (scan_offset_ < input_buffer_.length())
+    {
+        const char *data = input_buffer_.data() + scan_offset_;
+        int tick_of = -1;
+
+        if (binary_framing_)
         {
-            hft_log(ERROR) << "Protocol violation error: " << e.what()
-                           << ". Client request: ‘" << line << "’";
+            std::size_t available = input_buffer_.length() - scan_offset_;
+            std::size_t n = hft::protocol::binary::frame_size(data, available);
 
+            if (n == 0 || n > available)
+            {
+                return false;
+            }
 
-            hft::protocol::response resp;
-            resp.error(e.what());
-            response_data_ = resp.serialize();
+            tick_of = hft::protocol::binary::tick_instrument(data);
+            scan_offset_ += n;
         }
-        catch (const std::exception &e)
+        else
         {
-            hft_log(ERROR) << "Error occured: " << e.what()
-                           << ". Going to close the session";
+            std::size_t eol = input_buffer_.find('\n', scan_offset_);
 
-            //  Wcześniej było źle raczej: socket_.close();
-            delete this;
+            if (eol == std::string::npos)
+            {
+                return false;
+            }
 
-            return;
+            if (lookahead_parser_.parse(data, eol - scan_offset_, lookahead_)
+                    && lookahead_.opcode == hft::protocol::request::tick::OPCODE)
+            {
+                tick_of = lookahead_.tick_msg.instrument_id;
+            }
+
+            scan_offset_ = eol + 1;
         }
 
-        boost::asio::async_write(socket_,
-                                 boost::asio::buffer(response_data_.c_str(), response_data_.length()),
-                                 boost::bind(&session_transport::handle_write, this, boost::asio::placeholders::error));
+        if (tick_of >= 0 && tick_of < static_cast<int>(waiting_ticks_.size()))
+        {
+            waiting_ticks_[tick_of]++;
+
+            if (tick_of == instrument_id)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void session_transport::consume_lookahead(void)
+{
+    //
+    // Request just parsed was counted by earlier scan
+    // when it ends within classified input.
+    //
+
+    if (lookahead_offset_ > scan_offset_ || request_.opcode != hft::protocol::request::tick::OPCODE)
+    {
+        return;
+    }
+
+    int instrument_id = request_.tick_msg.instrument_id;
+
+    if (instrument_id >= 0 && instrument_id < static_cast<int>(waiting_ticks_.size())
+            && waiting_ticks_[instrument_id] > 0)
+    {
+        waiting_ticks_[instrument_id]--;
+    }
+}
+
+void session_transport::reset_lookahead(void)
+{
+    //
+    // Framing or instruments changed, input behind current
+    // request has to be classified again.
+    //
+
+    scan_offset_ = lookahead_offset_;
+    waiting_ticks_.assign(instruments_.size(), 0);
+}
+
+void session_transport::enqueue_response(const hft::protocol::response &resp, const latency_stamp &stamp)
+{
+    std::uint64_t serialize_start = (stamp.family != metrics::latency::NO_FAMILY ? metrics::latency::now() : 0);
+
+    HFT_TRACE_SCOPE(SERIALIZE, resp.get_instrument_id());
+
+    //
+    // Encoding may throw, nothing is queued
+    // nor counted until response is complete.
+    //
+
+    response_buffer_.clear();
+
+    if (! binary_framing_)
+    {
+        resp.serialize(response_buffer_);
     }
     else
     {
-        hft_log(WARNING) << "Destroying session because of error ("
-                         << error.value() << "): " << error.message();
+        std::uint16_t instrument_index = hft::protocol::binary::NO_INSTRUMENT;
 
-        delete this;
+        if (resp.get_instrument_id() != hft::protocol::request::NO_INSTRUMENT)
+        {
+            instrument_index = resp.get_instrument_id();
+        }
+
+        hft::protocol::binary::encode_response(resp, instrument_index, response_buffer_);
+    }
+
+    output_buffer_.append(response_buffer_);
+    pending_count_++;
+
+    if (stamp.family != metrics::latency::NO_FAMILY)
+    {
+        metrics::latency::record(stamp.family, metrics::latency::SERIALIZE, metrics::latency::now() - serialize_start);
+
+        pending_stamps_.push_back(stamp);
+    }
+}
+
+void session_transport::setup_latency_families(const std::string &sessid, const std::vector<std::string> &instruments)
+{
+    static const char *methods[METHOD_COUNT] = {
+        "init",
+        "sync",
+        "tick",
+        "open_notify",
+        "close_notify"
+    };
+
+    //
+    // Init has no instrument, the rest has always one.
+    //
+
+    latency_families_.assign((instruments.size() + 1) * METHOD_COUNT, metrics::latency::NO_FAMILY);
+    latency_families_[hft::protocol::request::init::OPCODE] = metrics::latency::get_family(sessid, "", methods[hft::protocol::request::init::OPCODE]);
+
+    for (std::size_t i = 0; i < instruments.size(); i++)
+    {
+        std::string instrument = boost::erase_all_copy(instruments[i], "/");
+
+        for (int opcode = hft::protocol::request::sync::OPCODE; opcode < METHOD_COUNT; opcode++)
+        {
+            latency_families_[(i + 1) * METHOD_COUNT + opcode] = metrics::latency::get_family(sessid, instrument, methods[opcode]);
+        }
     }
+
+    deferred_stamps_.assign(instruments.size(), std::deque<latency_stamp>());
 }
 
-void session_transport::handle_write(const boost::system::error_code& error)
+void session_transport::terminate(void)
 {
-    if (! error)
+    closing_ = true;
+
+    if (shm_)
     {
-        boost::asio::async_read_until(socket_, input_buffer_, '\n', boost::bind(&session_transport::handle_read, this, _1));
+        shm_ -> close();
     }
     else
     {
-        hft_log(WARNING) << "Destroying session because of error ("
-                         << error.value() << "): " << error.message();
+        boost::system::error_code ec;
 
+        socket_.shutdown(socket_type::shutdown_both, ec);
+        socket_.close(ec);
+    }
+
+    release_if_idle();
+}
+
+void session_transport::release_if_idle(void)
+{
+    //
+    // Pending asynchronous operations are cancelled by
+    // closing the socket, session can be destroyed only
+    // after all of their handlers have been invoked and
+    // all deferred requests have been completed.
+    //
+
+    if (! reading_ && ! writing_ && deferred_count_ == 0)
+    {
         delete this;
     }
 }
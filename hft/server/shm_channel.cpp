@@ -0,0 +1,229 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <shm_channel.hpp>
+
+shm_channel::shm_channel(const boost::asio::any_io_executor &executor, hft::ipc::segment_ptr segment, hft::ipc::slot &slot)
+    : executor_ {executor}, segment_ {segment}, slot_ {slot},
+      read_buffer_ {nullptr}, read_pending_ {false},
+      write_data_ {nullptr}, write_done_ {0}, write_pending_ {false}, closing_ {false}
+{
+    reader_ = std::thread(&shm_channel::run_reader, this);
+    writer_ = std::thread(&shm_channel::run_writer, this);
+}
+
+shm_channel::~shm_channel(void)
+{
+    close();
+
+    if (reader_.joinable())
+    {
+        reader_.join();
+    }
+
+    if (writer_.joinable())
+    {
+        writer_.join();
+    }
+
+    hft::ipc::close_slot(segment_.get(), slot_, ! peer_gone());
+}
+
+void shm_channel::async_read(std::string &buffer, completion_handler handler)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    read_buffer_ = &buffer;
+    read_handler_ = std::move(handler);
+    read_pending_ = true;
+
+    cv_.notify_one();
+}
+
+void shm_channel::async_write(const std::string &data, completion_handler handler)
+{
+    std::size_t done = hft::ipc::ring_write(slot_.response, data.data(), data.length());
+
+    if (done == data.length())
+    {
+        boost::asio::post(executor_, [handler](void) { handler(boost::system::error_code()); });
+
+        return;
+    }
+
+    //
+    // Response ring is full, client is slow or stalled.
+    // Rest is written by writer thread as the client
+    // drains the ring.
+    //
+
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    write_data_ = &data;
+    write_done_ = done;
+    write_handler_ = std::move(handler);
+    write_pending_ = true;
+
+    write_cv_.notify_one();
+}
+
+void shm_channel::close(void)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    closing_ = true;
+
+    //
+    // Reader may sleep on request ring and writer on
+    // response ring, bumping their futex words wakes
+    // them.
+    //
+
+    hft::ipc::notify(slot_.request.seq, slot_.request.waiters);
+    hft::ipc::notify(slot_.response.seq, slot_.response.waiters);
+
+    cv_.notify_one();
+    write_cv_.notify_one();
+}
+
+bool shm_channel::peer_gone(void) const
+{
+    return slot_.state.load() != hft::ipc::SLOT_SERVED
+               || ! hft::ipc::process_alive(slot_.client_pid.load());
+}
+
+void shm_channel::run_reader(void)
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+
+        cv_.wait(lck, [this](void) { return read_pending_ || closing_; });
+
+        if (! read_pending_)
+        {
+            break;
+        }
+
+        std::string &buffer = *read_buffer_;
+
+        lck.unlock();
+
+        boost::system::error_code ec;
+
+        while (true)
+        {
+            if (closing_)
+            {
+                ec = boost::asio::error::operation_aborted;
+
+                break;
+            }
+
+            if (hft::ipc::ring_read(slot_.request, buffer) != 0)
+            {
+                break;
+            }
+
+            if (peer_gone())
+            {
+                //
+                // Client may have written its last
+                // request just before closing.
+                //
+
+                if (hft::ipc::ring_read(slot_.request, buffer) == 0)
+                {
+                    ec = boost::asio::error::eof;
+                }
+
+                break;
+            }
+
+            hft::ipc::wait(slot_.request.seq, slot_.request.waiters,
+                           [this](void) { return hft::ipc::readable(slot_.request) != 0 || closing_; },
+                           hft::ipc::WAIT_TIMEOUT_MS);
+        }
+
+        lck.lock();
+
+        completion_handler handler = std::move(read_handler_);
+        read_pending_ = false;
+
+        lck.unlock();
+
+        boost::asio::post(executor_, [handler, ec](void) { handler(ec); });
+    }
+}
+
+void shm_channel::run_writer(void)
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+
+        write_cv_.wait(lck, [this](void) { return write_pending_ || closing_; });
+
+        if (! write_pending_)
+        {
+            break;
+        }
+
+        const std::string &data = *write_data_;
+        std::size_t done = write_done_;
+
+        lck.unlock();
+
+        boost::system::error_code ec;
+
+        while (true)
+        {
+            done += hft::ipc::ring_write(slot_.response, data.data() + done, data.length() - done);
+
+            if (done == data.length())
+            {
+                break;
+            }
+
+            if (closing_)
+            {
+                ec = boost::asio::error::operation_aborted;
+
+                break;
+            }
+
+            if (peer_gone())
+            {
+                ec = boost::asio::error::broken_pipe;
+
+                break;
+            }
+
+            hft::ipc::wait(slot_.response.seq, slot_.response.waiters,
+                           [this](void) { return hft::ipc::writable(slot_.response) != 0 || closing_; },
+                           hft::ipc::WAIT_TIMEOUT_MS);
+        }
+
+        lck.lock();
+
+        completion_handler handler = std::move(write_handler_);
+        write_pending_ = false;
+
+        lck.unlock();
+
+        boost::asio::post(executor_, [handler, ec](void) { handler(ec); });
+    }
+}
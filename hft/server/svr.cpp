@@ -16,88 +16,270 @@
 
 #include <svr.hpp>
 
+#include <charconv>
+#include <climits>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+//
+// Caller holds the lock.
+//
+
+std::int64_t to_int(session_variable &v)
+{
+    using boost::variant2::get_if;
+
+    if (auto *i = get_if<std::int64_t>(&v.value)) return *i;
+
+    const std::string *text = get_if<std::string>(&v.value);
+
+    if (text == nullptr)
+    {
+        //
+        // Boolean, its text is not a number.
+        //
+
+        throw std::invalid_argument("stoll");
+    }
+
+    if (text -> empty())
+    {
+        return 0;
+    }
+
+    if (! (v.parsed & session_variable::PARSED_INT))
+    {
+        v.as_int = std::stoll(*text);
+        v.parsed |= session_variable::PARSED_INT;
+    }
+
+    return v.as_int;
+}
+
+double to_double(session_variable &v)
+{
+    using boost::variant2::get_if;
+
+    if (auto *i = get_if<std::int64_t>(&v.value)) return static_cast<double>(*i);
+
+    const std::string *text = get_if<std::string>(&v.value);
+
+    if (text == nullptr)
+    {
+        throw std::invalid_argument("stod");
+    }
+
+    if (text -> empty())
+    {
+        return 0.0;
+    }
+
+    if (! (v.parsed & session_variable::PARSED_DOUBLE))
+    {
+        v.as_double = std::stod(*text);
+        v.parsed |= session_variable::PARSED_DOUBLE;
+    }
+
+    return v.as_double;
+}
+
+bool to_bool(const session_variable &v)
+{
+    using boost::variant2::get_if;
+
+    if (auto *b = get_if<bool>(&v.value)) return *b;
+    if (auto *i = get_if<std::int64_t>(&v.value)) return *i == 1;
+
+    const std::string &text = *get_if<std::string>(&v.value);
+
+    return (text == "true" || text == "TRUE" || text == "True" || text == "1");
+}
+
+std::string value_text(const session_variable::value_type &value)
+{
+    using boost::variant2::get_if;
+
+    if (auto *s = get_if<std::string>(&value)) return *s;
+    if (auto *i = get_if<std::int64_t>(&value)) return std::to_string(*i);
+
+    return *get_if<bool>(&value) ? "true" : "false";
+}
+
+} /* namespace */
+
+std::string session_variable::text(void) const
+{
+    return value_text(value);
+}
+
+void session_variable::assign_text(const std::string &v)
+{
+    value = v;
+    parsed = 0;
+}
+
 template<> std::string svr::get<std::string>() const
 {
-    return *value_;
+    auto lck = read_lock();
+
+    return var_ -> text();
 }
 
 template<> int svr::get<int>() const
 {
-    if (value_ -> empty())
+    auto lck = read_lock();
+
+    std::int64_t v = to_int(*var_);
+
+    if (v < INT_MIN || v > INT_MAX)
     {
-        return 0;
+        throw std::out_of_range("stoi");
     }
 
-    return std::stoi(*value_);
+    return static_cast<int>(v);
+}
+
+template<> std::int64_t svr::get<std::int64_t>() const
+{
+    auto lck = read_lock();
+
+    return to_int(*var_);
 }
 
 template<> double svr::get<double>() const
 {
-    if (value_ -> empty())
-    {
-        return 0.0;
-    }
+    auto lck = read_lock();
 
-    return std::stod(*value_);
+    return to_double(*var_);
 }
 
 template<> bool svr::get<bool>() const
 {
-    if (*value_ == "true" || *value_ == "TRUE" || *value_ == "True" || *value_ == "1")
+    auto lck = read_lock();
+
+    return to_bool(*var_);
+}
+
+//
+// Caller holds the lock.
+//
+
+void svr::assign(session_variable::value_type &&v)
+{
+    if (v.index() == var_ -> value.index())
     {
-        return true;
+        if (v == var_ -> value)
+        {
+            return;
+        }
     }
+    else if (value_text(v) == var_ -> text())
+    {
+        //
+        // Same value of another type, typically text loaded
+        // from disk set again as number. Journal would get
+        // the same text, so it is not a change, but the new
+        // type is kept, so that next set compares directly.
+        //
 
-    return false;
+        var_ -> value = std::move(v);
+        var_ -> parsed = 0;
+
+        return;
+    }
+
+    var_ -> value = std::move(v);
+    var_ -> parsed = 0;
+
+    mark_changed();
 }
 
-template<> void svr::set<std::string>(std::string v)
+//
+// Caller holds the lock. Text stays in the same
+// string, so its capacity is reused.
+//
+
+void svr::assign_double(std::string_view text)
 {
-    if (v != *value_)
+    auto *s = boost::variant2::get_if<std::string>(&var_ -> value);
+
+    if (s != nullptr && *s == text)
+    {
+        return;
+    }
+
+    if (s != nullptr)
+    {
+        s -> assign(text.data(), text.size());
+    }
+    else
     {
-        *changed_ = true;
-        *value_ = v;
+        var_ -> value = std::string(text);
     }
+
+    std::from_chars(text.data(), text.data() + text.size(), var_ -> as_double);
+    var_ -> parsed = session_variable::PARSED_DOUBLE;
+
+    mark_changed();
 }
 
-template<> void svr::set<char const *>(char const *v)
+void svr::mark_changed(void)
 {
-    if (strcmp(v, value_ -> c_str()) != 0)
+    if (! var_ -> dirty)
     {
-        *changed_ = true;
-        *value_ = v;
+        var_ -> dirty = true;
+        changed_ -> push_back(var_);
     }
 }
 
+template<> void svr::set<std::string>(std::string v)
+{
+    auto lck = write_lock();
+
+    assign(std::move(v));
+}
+
+template<> void svr::set<char const *>(char const *v)
+{
+    auto lck = write_lock();
+
+    assign(std::string(v));
+}
+
 template<> void svr::set<int>(int v)
 {
-    std::string x = std::to_string(v);
+    auto lck = write_lock();
 
-    if (x != *value_)
-    {
-        *changed_ = true;
-        *value_ = x;
-    }
+    assign(static_cast<std::int64_t>(v));
+}
+
+template<> void svr::set<std::int64_t>(std::int64_t v)
+{
+    auto lck = write_lock();
+
+    assign(v);
 }
 
 template<> void svr::set<double>(double v)
 {
-    std::string x = std::to_string(v);
+    //
+    // Same text as std::to_string(), without allocation.
+    //
 
-    if (x != *value_)
-    {
-        *changed_ = true;
-        *value_ = x;
-    }
+    char buffer[std::numeric_limits<double>::max_exponent10 + 20];
+
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), v, std::chars_format::fixed, 6);
+
+    auto lck = write_lock();
+
+    assign_double(std::string_view(buffer, result.ptr - buffer));
 }
 
 template<> void svr::set<bool>(bool v)
 {
-    std::string x = (v ? "true" : "false");
+    auto lck = write_lock();
 
-    if (x != *value_)
-    {
-        *changed_ = true;
-        *value_ = x;
-    }
+    assign(v);
 }
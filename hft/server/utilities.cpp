@@ -16,9 +16,15 @@
 
 #include <stdexcept>
 #include <cstdlib>
+#include <cstdio>
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/xpressive/xpressive.hpp>
@@ -71,6 +77,85 @@ void file_put_contents(const std::string &filename, const std::string &content)
     out_stream.close();
 }
 
+void file_put_contents_atomic(const std::string &filename, const std::string &content, bool sync)
+{
+    std::string tmp_filename = filename + ".tmp";
+
+    int fd = open(tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd == -1)
+    {
+        throw std::runtime_error("Unable to open file: " + tmp_filename + ": " + strerror(errno));
+    }
+
+    const char *data = content.data();
+    std::size_t left = content.size();
+
+    while (left > 0)
+    {
+        ssize_t n = write(fd, data, left);
+
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            int error = errno;
+            close(fd);
+
+            throw std::runtime_error("Unable to write file: " + tmp_filename + ": " + strerror(error));
+        }
+
+        data += n;
+        left -= n;
+    }
+
+    if (sync && fsync(fd) == -1)
+    {
+        int error = errno;
+        close(fd);
+
+        throw std::runtime_error("Unable to sync file: " + tmp_filename + ": " + strerror(error));
+    }
+
+    close(fd);
+
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        throw std::runtime_error("Unable to rename " + tmp_filename + ": " + strerror(errno));
+    }
+
+    if (! sync)
+    {
+        return;
+    }
+
+    //
+    // Rename is durable once directory is synced.
+    //
+
+    std::string dir = boost::filesystem::path(filename).parent_path().string();
+
+    int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (dir_fd == -1)
+    {
+        throw std::runtime_error("Unable to open directory: " + dir + ": " + strerror(errno));
+    }
+
+    int status = fsync(dir_fd);
+    int error = errno;
+
+    close(dir_fd);
+
+    if (status == -1)
+    {
+        throw std::runtime_error("Unable to sync directory: " + dir + ": " + strerror(error));
+    }
+}
+
 unsigned long get_current_timestamp(void)
 {
     auto now = std::chrono::system_clock::now();
@@ -0,0 +1,102 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <csv_data_supplier.hpp>
+#include <tick_store.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct tick_convert_options_type
+{
+    std::string input_file_name;
+    std::string output_file_name;
+
+} tick_convert_options;
+
+#define hftOption(__X__) \
+    tick_convert_options.__X__
+
+int hft_tick_convert_main(int argc, char *argv[])
+{
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("tick-convert", "")
+    ;
+
+    prog_opts::options_description desc("Options for tick-convert");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("input,i", prog_opts::value<std::string>(&hftOption(input_file_name)) -> default_value(""), "CSV file or file with list of CSV files, ticks of all go into one store")
+        ("output,o", prog_opts::value<std::string>(&hftOption(output_file_name)) -> default_value(""), "Tick store file name. Input file name with ‘.ticks’ suffix if not given")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    if (hftOption(input_file_name).empty())
+    {
+        std::cerr << "Input file is required\n";
+
+        return 1;
+    }
+
+    if (hftOption(output_file_name).empty())
+    {
+        hftOption(output_file_name) = boost::filesystem::path(hftOption(input_file_name)).replace_extension(".ticks").string();
+    }
+
+    try
+    {
+        csv_data_supplier input(hftOption(input_file_name));
+        tick_store::writer output(hftOption(output_file_name));
+        csv_data_supplier::csv_record rec;
+
+        while (input.get_record(rec))
+        {
+            output.append(rec);
+        }
+
+        output.close();
+
+        std::cout << "Ticks: " << output.get_record_count() << "\n";
+        std::cout << "Written ‘" << hftOption(output_file_name) << "’\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System ® ≣≡=-              **
+**                                                                    **
+**          Copyright © 2017 - 2026 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual property             **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <hft_trace.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct trace_convert_options_type
+{
+    std::string input_file_name;
+    std::string output_file_name;
+
+} trace_convert_options;
+
+#define hftOption(__X__) \
+    trace_convert_options.__X__
+
+//
+// Chrome trace event format, understood by Perfetto
+// and chrome://tracing. Timestamps are microseconds,
+// counted from the oldest event in the dump.
+//
+
+static std::string microseconds(std::uint64_t nanos)
+{
+    char buffer[32];
+
+    std::snprintf(buffer, sizeof(buffer), "%.3f", nanos / 1000.0);
+
+    return buffer;
+}
+
+static std::size_t write_chrome_trace(const std::vector<hft::trace::thread_events> &threads, std::ostream &out)
+{
+    std::uint64_t origin = std::numeric_limits<std::uint64_t>::max();
+
+    for (auto &te : threads)
+    {
+        for (auto &e : te.events)
+        {
+            origin = std::min(origin, e.start);
+        }
+    }
+
+    std::size_t count = 0;
+    const char *separator = "\n";
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    for (auto &te : threads)
+    {
+        out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << te.tid
+            << ",\"args\":{\"name\":\"thread " << te.tid << "\"}}";
+
+        separator = ",\n";
+
+        for (auto &e : te.events)
+        {
+            out << separator << "{\"name\":\"" << hft::trace::event_name(e.id) << "\",\"cat\":\"hft\"";
+
+            if (e.duration == 0)
+            {
+                out << ",\"ph\":\"i\",\"s\":\"t\"";
+            }
+            else
+            {
+                out << ",\"ph\":\"X\",\"dur\":" << microseconds(e.duration);
+            }
+
+            out << ",\"ts\":" << microseconds(e.start - origin) << ",\"pid\":1,\"tid\":" << te.tid
+                << ",\"args\":{\"instrument_id\":" << e.instrument_id << ",\"payload\":" << e.payload << "}}";
+
+            count++;
+        }
+    }
+
+    out << "\n]}\n";
+
+    return count;
+}
+
+int hft_trace_convert_main(int argc, char *argv[])
+{
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("trace-convert", "")
+    ;
+
+    prog_opts::options_description desc("Options for trace-convert");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("input,i", prog_opts::value<std::string>(&hftOption(input_file_name)) -> default_value(""), "Trace dump written by server on SIGUSR2")
+        ("output,o", prog_opts::value<std::string>(&hftOption(output_file_name)) -> default_value(""), "Chrome trace JSON file. Input file name with ‘.json’ suffix if not given")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    if (hftOption(input_file_name).empty())
+    {
+        std::cerr << "Trace dump file is required\n";
+
+        return 1;
+    }
+
+    if (hftOption(output_file_name).empty())
+    {
+        hftOption(output_file_name) = hftOption(input_file_name) + ".json";
+    }
+
+    try
+    {
+        auto threads = hft::trace::load(hftOption(input_file_name));
+
+        std::ofstream out(hftOption(output_file_name));
+
+        if (! out)
+        {
+            std::string err_msg = "Unable to create file ‘" + hftOption(output_file_name) + "’";
+
+            throw std::runtime_error(err_msg.c_str());
+        }
+
+        std::size_t count = write_chrome_trace(threads, out);
+
+        if (! out)
+        {
+            std::string err_msg = "Failed to write file ‘" + hftOption(output_file_name) + "’";
+
+            throw std::runtime_error(err_msg.c_str());
+        }
+
+        std::cout << "Threads: " << threads.size() << ", events: " << count << "\n";
+        std::cout << "Written ‘" << hftOption(output_file_name) << "’, open it in Perfetto UI\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+
+        return 1;
+    }
+
+    return 0;
+}
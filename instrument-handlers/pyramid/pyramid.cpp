@@ -301,7 +301,7 @@ void pyramid::on_tick(const hft::protocol::request::tick &msg, hft::protocol::re
     {
         auto pos_id = uid();
         market.open_long(pos_id, contracts_);
-        gcells_[index].attach_position(pos_id, hft::utils::ptime2timestamp(msg.request_time), active_gcells_);
+        gcells_[index].attach_position(pos_id, msg.request_time.millis(), active_gcells_);
 
         hft_log(INFO) << "Opening position ‘"
                       << pos_id << "’ in cell #"
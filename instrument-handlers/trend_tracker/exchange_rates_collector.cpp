@@ -1,5 +1,8 @@
 #include <exchange_rates_collector.hpp>
 
+#include <cstdint>
+#include <cstring>
+
 #include <easylogging++.h>
 
 #define hft_log(__X__) \
@@ -23,20 +26,6 @@ exchange_rates_collector::exchange_rates_collector(const std::string &logger_id,
     exchange_rates_[interval_t::I_H6] = std::vector<int>();
     exchange_rates_[interval_t::I_H8] = std::vector<int>();
     exchange_rates_[interval_t::I_H12] = std::vector<int>();
-
-    load_data();
-}
-
-exchange_rates_collector::~exchange_rates_collector(void)
-{
-    try
-    {
-        save_data();
-    }
-    catch (const std::exception &e)
-    {
-        hft_log(ERROR) << "exchange_rates_collector: Unable to save data!";
-    }
 }
 
 void exchange_rates_collector::tick(int ask_pips, int bid_pips, boost::posix_time::ptime pt)
@@ -101,59 +90,155 @@ void exchange_rates_collector::register_invalidable(interval_t interval, invalid
     observers_[interval].insert(obj);
 }
 
-void exchange_rates_collector::load_data(void)
+//
+// State layout, native endian: u32 version, i32 last hour,
+// i32 last minute, then for every interval: u32 interval,
+// u32 number of rates, i32 rates.
+//
+
+namespace {
+
+constexpr std::uint32_t STATE_VERSION = 1;
+
+//
+// Rates kept per interval.
+//
+
+constexpr int MAX_STORE_SIZE = 1000;
+
+template <typename T>
+void put(std::string &out, T v)
 {
-    // NOT IMPLEMENTED.
+    out.append(reinterpret_cast<const char *>(&v), sizeof(v));
 }
 
-void exchange_rates_collector::save_data(void)
+template <typename T>
+bool get(std::string_view &in, T &v)
 {
-    interval_t intervals[] = { interval_t::I_M1,  interval_t::I_M2,
-                               interval_t::I_M5,  interval_t::I_M10,
-                               interval_t::I_M15, interval_t::I_M20,
-                               interval_t::I_M30, interval_t::I_H1,
-                               interval_t::I_H2,  interval_t::I_H3,
-                               interval_t::I_H4,  interval_t::I_H6,
-                               interval_t::I_H8,  interval_t::I_H12
-                             };
+    if (in.size() < sizeof(v))
+    {
+        return false;
+    }
+
+    memcpy(&v, in.data(), sizeof(v));
+    in.remove_prefix(sizeof(v));
+
+    return true;
+}
+
+} /* namespace */
+
+void exchange_rates_collector::checkpoint(std::string &state) const
+{
+    put<std::uint32_t>(state, STATE_VERSION);
+    put<std::int32_t>(state, last_hour_);
+    put<std::int32_t>(state, last_minute_);
 
-    for (auto i : intervals)
+    for (auto &item : exchange_rates_)
     {
-        save_data(i);
+        put<std::uint32_t>(state, static_cast<std::uint32_t>(item.first));
+        put<std::uint32_t>(state, item.second.size());
+
+        for (int rate : item.second)
+        {
+            put<std::int32_t>(state, rate);
+        }
     }
 }
 
-void exchange_rates_collector::save_data(interval_t interval)
+bool exchange_rates_collector::restore(std::string_view state)
 {
-    // NOT IMPLEMENTED.
+    std::uint32_t version, interval, count;
+    std::int32_t last_hour, last_minute, rate;
+    std::map<interval_t, std::vector<int>> exchange_rates;
+
+    if (! get(state, version) || version != STATE_VERSION
+            || ! get(state, last_hour) || last_hour < 0 || last_hour > 23
+            || ! get(state, last_minute) || last_minute < 0 || last_minute > 59)
+    {
+        return false;
+    }
+
+    while (! state.empty())
+    {
+        if (! get(state, interval) || exchange_rates_.count(static_cast<interval_t>(interval)) == 0
+                || exchange_rates.count(static_cast<interval_t>(interval)) != 0
+                || ! get(state, count) || state.size() < static_cast<std::size_t>(count) * sizeof(rate))
+        {
+            return false;
+        }
+
+        //
+        // History taken with bigger store, only
+        // the latest rates are kept.
+        //
+
+        if (count > MAX_STORE_SIZE)
+        {
+            state.remove_prefix((count - MAX_STORE_SIZE) * sizeof(rate));
+            count = MAX_STORE_SIZE;
+        }
+
+        std::vector<int> &store = exchange_rates[static_cast<interval_t>(interval)];
+
+        store.reserve(count);
+
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            get(state, rate);
+            store.push_back(rate);
+        }
+    }
+
+    for (auto &item : exchange_rates)
+    {
+        exchange_rates_[item.first].swap(item.second);
+    }
+
+    last_hour_ = last_hour;
+    last_minute_ = last_minute;
+
+    //
+    // Everything computed from
+    // old history is stale.
+    //
+
+    parameters_.clear();
+
+    for (auto &item : observers_)
+    {
+        for (auto &x : item.second)
+        {
+            x -> invalidate();
+        }
+    }
+
+    return true;
 }
 
 void exchange_rates_collector::on_interval(interval_t interval, int ask_pips, int bid_pips)
 {
-    const int max_store_size = 1000;
     std::vector<int> &store = exchange_rates_[interval];
     int price = (ask_pips + bid_pips) >> 1;
 
     //
-    // Update store & save.
+    // Update store.
     //
 
-    if (store.size() < max_store_size)
+    if (store.size() < MAX_STORE_SIZE)
     {
         store.push_back(price);
     }
     else
     {
-        for (int i = 1; i < max_store_size; i++)
+        for (int i = 1; i < MAX_STORE_SIZE; i++)
         {
             store[i - 1] = store[i];
         }
 
-        store[max_store_size - 1] = price;
+        store[MAX_STORE_SIZE - 1] = price;
     }
 
-    save_data(interval);
-
     //
     // Clear params table.
     //
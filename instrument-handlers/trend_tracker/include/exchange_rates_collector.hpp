@@ -5,6 +5,8 @@
 #include <map>
 #include <set>
 #include <chrono>
+#include <string>
+#include <string_view>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <interval_type.hpp>
@@ -34,7 +36,6 @@ public:
     exchange_rates_collector(exchange_rates_collector &&) = delete;
 
     exchange_rates_collector(const std::string &logger_id, const std::string &work_dir);
-    ~exchange_rates_collector(void);
 
     void tick(int ask_pips, int bid_pips, boost::posix_time::ptime pt);
 
@@ -42,11 +43,14 @@ public:
 
     void register_invalidable(interval_t interval, invalidable *obj);
 
-private:
+    //
+    // Rate history for warm restart.
+    //
+
+    void checkpoint(std::string &state) const;
+    bool restore(std::string_view state);
 
-    void load_data(void);
-    void save_data(void);
-    void save_data(interval_t interval);
+private:
 
     const std::string logger_id_;
     const std::string work_dir_;
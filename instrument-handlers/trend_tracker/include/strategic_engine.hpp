@@ -24,6 +24,9 @@ public:
 
     void tick(int ask_pips, int bid_pips, boost::posix_time::ptime pt);
 
+    void checkpoint(std::string &state) const { erc_.checkpoint(state); }
+    bool restore(std::string_view state) { return erc_.restore(state); }
+
 private:
 
     const std::string logger_id_;
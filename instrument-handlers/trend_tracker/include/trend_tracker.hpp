@@ -28,6 +28,8 @@ public:
     virtual void on_position_open(const hft::protocol::request::open_notify &msg, hft::protocol::response &market);
     virtual void on_position_close(const hft::protocol::request::close_notify &msg, hft::protocol::response &market);
 
+    virtual bool checkpoint(std::string &state);
+
 private:
 
     enum class state
@@ -230,6 +230,23 @@ void trend_tracker::init_handler(const boost::json::object &specific_config)
             strategy_ -> configure_processors(interval_t::I_H12, depths, pips_limits);
         }
 
+        //
+        // Rate history left by previous session.
+        //
+
+        std::string_view warm_state = get_warm_state();
+
+        if (! warm_state.empty())
+        {
+            if (strategy_ -> restore(warm_state))
+            {
+                hft_log(INFO) << "init: Restored exchange rates history";
+            }
+            else
+            {
+                hft_log(WARNING) << "init: Unable to restore exchange rates history, starting empty";
+            }
+        }
     }
     catch (const std::runtime_error &e)
     {
@@ -244,6 +261,18 @@ void trend_tracker::init_handler(const boost::json::object &specific_config)
     }
 }
 
+bool trend_tracker::checkpoint(std::string &state)
+{
+    if (! strategy_)
+    {
+        return false;
+    }
+
+    strategy_ -> checkpoint(state);
+
+    return true;
+}
+
 void trend_tracker::on_sync(const hft::protocol::request::sync &msg, hft::protocol::response &market)
 {
     if (position_confirmed_)
@@ -290,7 +290,7 @@ void xgrid::on_tick(const hft::protocol::request::tick &msg, hft::protocol::resp
     int ask_pips = floating2pips(msg.ask);
     int bid_pips = floating2pips(msg.bid);
     int spread   = ask_pips - bid_pips;
-    unsigned long request_timestamp = hft::utils::ptime2timestamp(msg.request_time);
+    unsigned long request_timestamp = msg.request_time.millis();
 
     if ((tick_counter_++ % 60) == 0)
     {